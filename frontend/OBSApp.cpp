@@ -297,6 +297,10 @@ void OBSApp::InitUserConfigDefaults()
 
 	config_set_default_bool(userConfig, "BasicWindow", "MultiviewDrawAreas", true);
 
+	config_set_default_int(userConfig, "BasicWindow", "MultiviewRefreshDivisor", 1);
+
+	config_set_default_int(userConfig, "BasicWindow", "DisplayMaxFPS", 0);
+
 	config_set_default_bool(userConfig, "BasicWindow", "MediaControlsCountdownTimer", true);
 
 	config_set_default_int(userConfig, "Appearance", "FontScale", 10);
@@ -996,7 +1000,13 @@ static bool StartupOBS(const char *locale, profiler_name_store_t *store)
 	if (GetAppConfigPath(path, sizeof(path), "obs-studio/plugin_config") <= 0)
 		return false;
 
-	return obs_startup(locale, path, store);
+	if (!obs_startup(locale, path, store))
+		return false;
+
+	if (GetAppConfigPath(path, sizeof(path), "obs-studio/shader-cache") > 0)
+		obs_set_shader_cache_path(path);
+
+	return true;
 }
 
 inline void OBSApp::ResetHotkeyState(bool inFocus)
@@ -4,6 +4,9 @@
 #include <widgets/OBSBasic.hpp>
 
 #include <obs-frontend-api.h>
+#include <util/platform.h>
+
+#include <algorithm>
 
 Multiview::Multiview()
 {
@@ -12,12 +15,16 @@ Multiview::Multiview()
 
 Multiview::~Multiview()
 {
+	LogRenderTimes();
+
 	for (OBSWeakSource &weakSrc : multiviewScenes) {
 		OBSSource src = OBSGetStrongRef(weakSrc);
 		if (src)
 			obs_source_dec_showing(src);
 	}
 
+	ClearTextures();
+
 	obs_enter_graphics();
 	gs_vertexbuffer_destroy(actionSafeMargin);
 	gs_vertexbuffer_destroy(graphicsSafeMargin);
@@ -28,6 +35,81 @@ Multiview::~Multiview()
 	obs_leave_graphics();
 }
 
+void Multiview::ClearTextures()
+{
+	obs_enter_graphics();
+	for (gs_texrender_t *texrender : multiviewTextures)
+		gs_texrender_destroy(texrender);
+	gs_texrender_destroy(previewTexture);
+	previewTexture = nullptr;
+	multiviewTextures.clear();
+	multiviewRenderTimes.clear();
+	obs_leave_graphics();
+}
+
+uint64_t Multiview::GetCellRenderTime(size_t idx)
+{
+	uint64_t renderTime = 0;
+
+	obs_enter_graphics();
+	if (idx < multiviewRenderTimes.size() && multiviewRenderTimes[idx].count)
+		renderTime = multiviewRenderTimes[idx].total / multiviewRenderTimes[idx].count;
+	obs_leave_graphics();
+
+	return renderTime;
+}
+
+void Multiview::LogRenderTimes()
+{
+	bool first = true;
+
+	for (size_t i = 0; i < multiviewScenes.size(); i++) {
+		uint64_t renderTime = GetCellRenderTime(i);
+		if (!renderTime)
+			continue;
+
+		if (first) {
+			blog(LOG_INFO, "Multiview scene render times (average per refresh):");
+			first = false;
+		}
+
+		OBSSource src = OBSGetStrongRef(multiviewScenes[i]);
+		blog(LOG_INFO, "\t%s: %.3f ms", src ? obs_source_get_name(src) : "(removed)",
+		     (double)renderTime / 1000000.0);
+	}
+}
+
+gs_texture_t *Multiview::RenderThumbnail(gs_texrender_t *&texrender, obs_source_t *src, uint32_t cx, uint32_t cy,
+					 bool refresh, CellRenderTime *renderTime)
+{
+	if (!texrender)
+		texrender = gs_texrender_create(GS_RGBA, GS_ZS_NONE);
+
+	gs_texture_t *tex = gs_texrender_get_texture(texrender);
+	if (tex && !refresh && gs_texture_get_width(tex) == cx && gs_texture_get_height(tex) == cy)
+		return tex;
+
+	uint64_t start = os_gettime_ns();
+
+	gs_texrender_reset(texrender);
+	if (gs_texrender_begin(texrender, cx, cy)) {
+		vec4 clearColor;
+		vec4_zero(&clearColor);
+
+		gs_clear(GS_CLEAR_COLOR, &clearColor, 0.0f, 0);
+		gs_ortho(0.0f, fw, 0.0f, fh, -100.0f, 100.0f);
+		obs_source_video_render(src);
+		gs_texrender_end(texrender);
+	}
+
+	if (renderTime) {
+		renderTime->total += os_gettime_ns() - start;
+		renderTime->count++;
+	}
+
+	return gs_texrender_get_texture(texrender);
+}
+
 static OBSSource CreateLabel(const char *name, size_t h)
 {
 	OBSDataAutoRelease settings = obs_data_create();
@@ -64,14 +146,18 @@ static OBSSource CreateLabel(const char *name, size_t h)
 	return txtSource.Get();
 }
 
-void Multiview::Update(MultiviewLayout multiviewLayout, bool drawLabel, bool drawSafeArea)
+void Multiview::Update(MultiviewLayout multiviewLayout, bool drawLabel, bool drawSafeArea, uint32_t refreshDivisor)
 {
 	this->multiviewLayout = multiviewLayout;
 	this->drawLabel = drawLabel;
 	this->drawSafeArea = drawSafeArea;
+	this->refreshDivisor = std::max(refreshDivisor, 1u);
+
+	LogRenderTimes();
 
 	multiviewScenes.clear();
 	multiviewLabels.clear();
+	ClearTextures();
 
 	struct obs_video_info ovi;
 	obs_get_video_info(&ovi);
@@ -175,6 +261,11 @@ void Multiview::Update(MultiviewLayout multiviewLayout, bool drawLabel, bool dra
 	}
 
 	obs_frontend_source_list_free(&scenes);
+
+	obs_enter_graphics();
+	multiviewTextures.resize(numSrcs, nullptr);
+	multiviewRenderTimes.resize(numSrcs);
+	obs_leave_graphics();
 }
 
 static inline uint32_t labelOffset(MultiviewLayout multiviewLayout, obs_source_t *label, uint32_t cx)
@@ -375,6 +466,48 @@ void Multiview::Render(uint32_t cx, uint32_t cy)
 		gs_matrix_pop();
 	};
 
+	// Draws a thumbnail over the full base resolution area, scaled by the
+	// current matrix just like obs_source_video_render would be
+	auto drawTexture = [&](gs_texture_t *tex) {
+		gs_effect_t *effect = obs_get_base_effect(OBS_EFFECT_DEFAULT);
+		gs_eparam_t *image = gs_effect_get_param_by_name(effect, "image");
+
+		const bool previous = gs_framebuffer_srgb_enabled();
+		gs_enable_framebuffer_srgb(true);
+		gs_blend_state_push();
+		gs_blend_function(GS_BLEND_ONE, GS_BLEND_INVSRCALPHA);
+
+		gs_effect_set_texture_srgb(image, tex);
+		while (gs_effect_loop(effect, "Draw"))
+			gs_draw_sprite(tex, 0, targetCX, targetCY);
+
+		gs_blend_state_pop();
+		gs_enable_framebuffer_srgb(previous);
+	};
+
+	auto pixelSize = [&](float size) {
+		return std::max(uint32_t(size * scale), 1u);
+	};
+
+	bool scenesOnly = multiviewLayout == MultiviewLayout::SCENES_ONLY_4_SCENES ||
+			  multiviewLayout == MultiviewLayout::SCENES_ONLY_9_SCENES ||
+			  multiviewLayout == MultiviewLayout::SCENES_ONLY_16_SCENES ||
+			  multiviewLayout == MultiviewLayout::SCENES_ONLY_25_SCENES;
+
+	// Scene thumbnails other than program and preview are only refreshed
+	// every refreshDivisor frames.  With a divisor of 1 there is nothing to
+	// cache, so those scenes are rendered straight into their cells.
+	bool useThumbnails = refreshDivisor > 1;
+	bool refresh = (frameCount++ % refreshDivisor) == 0;
+
+	// The studio mode preview is rendered once at preview cell resolution
+	// and shared with its scene cell.  Program always comes from the main
+	// mix texture.
+	gs_texture_t *previewTex = nullptr;
+	if (studioMode && !scenesOnly && previewSrc)
+		previewTex = RenderThumbnail(previewTexture, previewSrc, pixelSize(ppiCX), pixelSize(ppiCY), true,
+					     nullptr);
+
 	// Define the whole usable region for the multiview
 	startRegion(x, y, targetCX * scale, targetCY * scale, 0.0f, fw, 0.0f, fh);
 
@@ -411,11 +544,33 @@ void Multiview::Render(uint32_t cx, uint32_t cy)
 		/* ----------- */
 
 		// Render the source
+		gs_texture_t *tex = nullptr;
+		bool isProgram = src == programSrc || (!studioMode && src == previewSrc);
+
+		CellRenderTime *renderTime = i < multiviewRenderTimes.size() ? &multiviewRenderTimes[i] : nullptr;
+
+		if (src && !isProgram && src == previewSrc && previewTex)
+			tex = previewTex;
+		else if (src && !isProgram && useThumbnails && i < multiviewTextures.size())
+			tex = RenderThumbnail(multiviewTextures[i], src, pixelSize(siCX), pixelSize(siCY), refresh,
+					      renderTime);
+
 		gs_matrix_push();
 		gs_matrix_translate3f(siX, siY, 0.0f);
 		gs_matrix_scale3f(siScaleX, siScaleY, 1.0f);
 		setRegion(siX, siY, siCX, siCY);
-		obs_source_video_render(src);
+		if (src && isProgram) {
+			obs_render_main_texture();
+		} else if (tex) {
+			drawTexture(tex);
+		} else if (src) {
+			uint64_t start = os_gettime_ns();
+			obs_source_video_render(src);
+			if (renderTime) {
+				renderTime->total += os_gettime_ns() - start;
+				renderTime->count++;
+			}
+		}
 		endRegion();
 		gs_matrix_pop();
 
@@ -442,10 +597,7 @@ void Multiview::Render(uint32_t cx, uint32_t cy)
 		gs_matrix_pop();
 	}
 
-	if (multiviewLayout == MultiviewLayout::SCENES_ONLY_4_SCENES ||
-	    multiviewLayout == MultiviewLayout::SCENES_ONLY_9_SCENES ||
-	    multiviewLayout == MultiviewLayout::SCENES_ONLY_16_SCENES ||
-	    multiviewLayout == MultiviewLayout::SCENES_ONLY_25_SCENES) {
+	if (scenesOnly) {
 		endRegion();
 		return;
 	}
@@ -465,7 +617,9 @@ void Multiview::Render(uint32_t cx, uint32_t cy)
 	gs_matrix_translate3f(sourceX, sourceY, 0.0f);
 	gs_matrix_scale3f(ppiScaleX, ppiScaleY, 1.0f);
 	setRegion(sourceX, sourceY, ppiCX, ppiCY);
-	if (studioMode)
+	if (previewTex)
+		drawTexture(previewTex);
+	else if (studioMode)
 		obs_source_video_render(previewSrc);
 	else
 		obs_render_main_texture();
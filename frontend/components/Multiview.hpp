@@ -21,14 +21,21 @@ class Multiview {
 public:
 	Multiview();
 	~Multiview();
-	void Update(MultiviewLayout multiviewLayout, bool drawLabel, bool drawSafeArea);
+	void Update(MultiviewLayout multiviewLayout, bool drawLabel, bool drawSafeArea, uint32_t refreshDivisor = 1);
 	void Render(uint32_t cx, uint32_t cy);
 	OBSSource GetSourceByPosition(int x, int y);
 
+	// Average time (in nanoseconds) spent rendering a scene cell since the
+	// last Update.  Zero for cells that reuse the program or preview
+	// textures.
+	uint64_t GetCellRenderTime(size_t idx);
+
 private:
 	bool drawLabel, drawSafeArea;
 	MultiviewLayout multiviewLayout;
 	size_t maxSrcs, numSrcs;
+	uint32_t refreshDivisor = 1;
+	uint64_t frameCount = 0;
 	gs_vertbuffer_t *actionSafeMargin = nullptr;
 	gs_vertbuffer_t *graphicsSafeMargin = nullptr;
 	gs_vertbuffer_t *fourByThreeSafeMargin = nullptr;
@@ -39,6 +46,22 @@ private:
 	std::vector<OBSWeakSource> multiviewScenes;
 	std::vector<OBSSource> multiviewLabels;
 
+	struct CellRenderTime {
+		uint64_t total = 0;
+		uint64_t count = 0;
+	};
+
+	// Scene thumbnails, rendered at cell resolution when refreshDivisor is
+	// above 1
+	std::vector<gs_texrender_t *> multiviewTextures;
+	std::vector<CellRenderTime> multiviewRenderTimes;
+	gs_texrender_t *previewTexture = nullptr;
+
+	void ClearTextures();
+	void LogRenderTimes();
+	gs_texture_t *RenderThumbnail(gs_texrender_t *&texrender, obs_source_t *src, uint32_t cx, uint32_t cy,
+				      bool refresh, CellRenderTime *renderTime);
+
 	// Multiview position helpers
 	float thickness = 6;
 	float offset, thicknessx2 = thickness * 2, pvwprgCX, pvwprgCY, sourceX, sourceY, labelX, labelY, scenesCX,
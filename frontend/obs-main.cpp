@@ -36,6 +36,7 @@
 #include <QProcess>
 #include <curl/curl.h>
 
+#include <cinttypes>
 #include <fstream>
 #include <iostream>
 #include <sstream>
@@ -64,6 +65,7 @@ static bool disable_shutdown_check = false;
 static bool multi = false;
 static bool log_verbose = false;
 static bool unfiltered_log = false;
+static bool thread_cache_alloc = false;
 bool opt_start_streaming = false;
 bool opt_start_recording = false;
 bool opt_studio_mode = false;
@@ -842,6 +844,31 @@ static inline bool arg_is(const char *arg, const char *long_form, const char *sh
 	return (long_form && strcmp(arg, long_form) == 0) || (short_form && strcmp(arg, short_form) == 0);
 }
 
+static void enable_thread_cache_alloc(int argc, char *argv[])
+{
+	for (int i = 1; i < argc; i++) {
+		if (arg_is(argv[i], "--thread-cache-alloc", nullptr)) {
+			thread_cache_alloc = base_set_allocator(bmem_get_cache_allocator());
+			return;
+		}
+	}
+}
+
+static void log_thread_cache_stats(void)
+{
+	struct bmem_cache_stats stats;
+	bmem_get_cache_stats(&stats);
+
+	blog(LOG_INFO, "Thread cache allocator:");
+	for (size_t i = 0; i < BMEM_CACHE_SIZE_CLASSES; i++) {
+		uint64_t allocs = stats.allocs[i];
+		double hit_rate = allocs ? (double)stats.cache_hits[i] * 100.0 / (double)allocs : 0.0;
+
+		blog(LOG_INFO, "\t%5d bytes: %" PRIu64 " allocations, %.1f%% from cache", 32 << i, allocs, hit_rate);
+	}
+	blog(LOG_INFO, "\t   larger: %" PRIu64 " allocations", stats.allocs[BMEM_CACHE_SIZE_CLASSES]);
+}
+
 static void check_safe_mode_sentinel(void)
 {
 #ifndef NDEBUG
@@ -911,6 +938,9 @@ static bool vc_runtime_outdated()
 
 int main(int argc, char *argv[])
 {
+	/* Has to happen before anything is allocated */
+	enable_thread_cache_alloc(argc, argv);
+
 #ifndef _WIN32
 	signal(SIGPIPE, SIG_IGN);
 
@@ -1057,7 +1087,8 @@ int main(int argc, char *argv[])
 				"--always-on-top: Start in 'always on top' mode.\n\n"
 				"--unfiltered_log: Make log unfiltered.\n\n"
 				"--disable-updater: Disable built-in updater (Windows/Mac only)\n\n"
-				"--disable-missing-files-check: Disable the missing files dialog which can appear on startup.\n\n";
+				"--disable-missing-files-check: Disable the missing files dialog which can appear on startup.\n\n"
+				"--thread-cache-alloc: Use the experimental thread caching allocator.\n\n";
 
 #ifdef _WIN32
 			MessageBoxA(NULL, help.c_str(), "Help", MB_OK | MB_ICONASTERISK);
@@ -1111,6 +1142,8 @@ int main(int argc, char *argv[])
 
 	delete_safe_mode_sentinel();
 	blog(LOG_INFO, "Number of memory leaks: %ld", bnum_allocs());
+	if (thread_cache_alloc)
+		log_thread_cache_stats();
 	base_set_log_handler(nullptr, nullptr);
 
 	if (restart || restart_safe) {
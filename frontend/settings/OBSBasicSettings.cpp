@@ -351,6 +351,7 @@ OBSBasicSettings::OBSBasicSettings(QWidget *parent)
 	HookWidget(ui->systemTrayAlways,     CHECK_CHANGED,  GENERAL_CHANGED);
 	HookWidget(ui->saveProjectors,       CHECK_CHANGED,  GENERAL_CHANGED);
 	HookWidget(ui->closeProjectors,      CHECK_CHANGED,  GENERAL_CHANGED);
+	HookWidget(ui->displayMaxFPS,        SCROLL_CHANGED, GENERAL_CHANGED);
 	HookWidget(ui->snappingEnabled,      CHECK_CHANGED,  GENERAL_CHANGED);
 	HookWidget(ui->screenSnapping,       CHECK_CHANGED,  GENERAL_CHANGED);
 	HookWidget(ui->centerSnapping,       CHECK_CHANGED,  GENERAL_CHANGED);
@@ -369,6 +370,7 @@ OBSBasicSettings::OBSBasicSettings(QWidget *parent)
 	HookWidget(ui->multiviewDrawNames,   CHECK_CHANGED,  GENERAL_CHANGED);
 	HookWidget(ui->multiviewDrawAreas,   CHECK_CHANGED,  GENERAL_CHANGED);
 	HookWidget(ui->multiviewLayout,      COMBO_CHANGED,  GENERAL_CHANGED);
+	HookWidget(ui->multiviewRefreshDivisor, SCROLL_CHANGED, GENERAL_CHANGED);
 	HookWidget(ui->theme, 		     COMBO_CHANGED,  APPEAR_CHANGED);
 	HookWidget(ui->themeVariant,	     COMBO_CHANGED,  APPEAR_CHANGED);
 	HookWidget(ui->appearanceFontScale,  SLIDER_CHANGED, APPEAR_CHANGED);
@@ -1371,6 +1373,9 @@ void OBSBasicSettings::LoadGeneralSettings()
 	bool closeProjectors = config_get_bool(App()->GetUserConfig(), "BasicWindow", "CloseExistingProjectors");
 	ui->closeProjectors->setChecked(closeProjectors);
 
+	int displayMaxFPS = config_get_int(App()->GetUserConfig(), "BasicWindow", "DisplayMaxFPS");
+	ui->displayMaxFPS->setValue(displayMaxFPS);
+
 	bool snappingEnabled = config_get_bool(App()->GetUserConfig(), "BasicWindow", "SnappingEnabled");
 	ui->snappingEnabled->setChecked(snappingEnabled);
 
@@ -1437,6 +1442,9 @@ void OBSBasicSettings::LoadGeneralSettings()
 	bool multiviewDrawAreas = config_get_bool(App()->GetUserConfig(), "BasicWindow", "MultiviewDrawAreas");
 	ui->multiviewDrawAreas->setChecked(multiviewDrawAreas);
 
+	int multiviewRefreshDivisor = config_get_int(App()->GetUserConfig(), "BasicWindow", "MultiviewRefreshDivisor");
+	ui->multiviewRefreshDivisor->setValue(multiviewRefreshDivisor);
+
 	ui->multiviewLayout->addItem(QTStr("Basic.Settings.General.MultiviewLayout.Horizontal.Top"),
 				     static_cast<int>(MultiviewLayout::HORIZONTAL_TOP_8_SCENES));
 	ui->multiviewLayout->addItem(QTStr("Basic.Settings.General.MultiviewLayout.Horizontal.Bottom"),
@@ -3170,6 +3178,11 @@ void OBSBasicSettings::SaveGeneralSettings()
 		config_set_bool(App()->GetUserConfig(), "BasicWindow", "CloseExistingProjectors",
 				ui->closeProjectors->isChecked());
 
+	if (WidgetChanged(ui->displayMaxFPS)) {
+		config_set_int(App()->GetUserConfig(), "BasicWindow", "DisplayMaxFPS", ui->displayMaxFPS->value());
+		main->UpdateDisplayMaxFPS();
+	}
+
 	if (WidgetChanged(ui->studioPortraitLayout)) {
 		config_set_bool(App()->GetUserConfig(), "BasicWindow", "StudioPortraitLayout",
 				ui->studioPortraitLayout->isChecked());
@@ -3209,6 +3222,12 @@ void OBSBasicSettings::SaveGeneralSettings()
 		multiviewChanged = true;
 	}
 
+	if (WidgetChanged(ui->multiviewRefreshDivisor)) {
+		config_set_int(App()->GetUserConfig(), "BasicWindow", "MultiviewRefreshDivisor",
+			       ui->multiviewRefreshDivisor->value());
+		multiviewChanged = true;
+	}
+
 	if (multiviewChanged)
 		OBSProjector::UpdateMultiviewProjectors();
 }
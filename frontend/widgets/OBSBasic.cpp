@@ -1086,6 +1086,10 @@ void OBSBasic::OBSInit()
 	};
 
 	connect(ui->preview, &OBSQTDisplay::DisplayCreated, addDisplay);
+	UpdateDisplayMaxFPS();
+
+	OBSCanvasAutoRelease mainCanvas = obs_get_main_canvas();
+	ui->preview->SetConsumedCanvas(mainCanvas, OBS_CANVAS_CONSUMER_DISPLAY);
 
 	/* Show the main window, unless the tray icon isn't available
 	 * or neither the setting nor flag for starting minimized is set. */
@@ -1377,6 +1381,11 @@ OBSBasic::~OBSBasic()
 
 	obs_display_remove_draw_callback(ui->preview->GetDisplay(), OBSBasic::RenderMain, this);
 
+	/* the displays themselves are only destroyed after obs_shutdown */
+	ui->preview->SetConsumedCanvas(nullptr, OBS_CANVAS_CONSUMER_DISPLAY);
+	if (program)
+		program->SetConsumedCanvas(nullptr, OBS_CANVAS_CONSUMER_DISPLAY);
+
 	obs_enter_graphics();
 	gs_vertexbuffer_destroy(box);
 	gs_vertexbuffer_destroy(boxLeft);
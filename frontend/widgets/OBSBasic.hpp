@@ -813,6 +813,7 @@ private:
 
 	void UpdateProjectorHideCursor();
 	void UpdateProjectorAlwaysOnTop(bool top);
+	void UpdateDisplayMaxFPS();
 	void ResetProjectors();
 
 	void UpdatePreviewSafeAreas();
@@ -259,7 +259,10 @@ void OBSBasic::on_previewDisabledWidget_customContextMenuRequested()
 
 void OBSBasic::EnablePreviewDisplay(bool enable)
 {
+	OBSCanvasAutoRelease mainCanvas = enable ? obs_get_main_canvas() : nullptr;
+
 	obs_display_set_enabled(ui->preview->GetDisplay(), enable);
+	ui->preview->SetConsumedCanvas(mainCanvas, OBS_CANVAS_CONSUMER_DISPLAY);
 	ui->previewContainer->setVisible(enable);
 	ui->previewDisabledWidget->setVisible(!enable);
 }
@@ -560,6 +563,17 @@ void OBSBasic::UpdateProjectorAlwaysOnTop(bool top)
 		SetAlwaysOnTop(projectors[i], top);
 }
 
+void OBSBasic::UpdateDisplayMaxFPS()
+{
+	double fps = (double)config_get_int(App()->GetUserConfig(), "BasicWindow", "DisplayMaxFPS");
+
+	ui->preview->SetMaxFPS(fps);
+	if (program)
+		program->SetMaxFPS(fps);
+	for (size_t i = 0; i < projectors.size(); i++)
+		projectors[i]->SetMaxFPS(fps);
+}
+
 void OBSBasic::ResetProjectors()
 {
 	OBSDataArrayAutoRelease savedProjectorList = SaveProjectors();
@@ -157,6 +157,7 @@ OBSProjector *OBSBasic::OpenProjector(obs_source_t *source, int monitor, Project
 	}
 
 	OBSProjector *projector = new OBSProjector(nullptr, source, monitor, type);
+	projector->SetMaxFPS((double)config_get_int(App()->GetUserConfig(), "BasicWindow", "DisplayMaxFPS"));
 
 	projectors.emplace_back(projector);
 
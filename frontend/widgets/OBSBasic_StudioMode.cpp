@@ -54,6 +54,11 @@ void OBSBasic::CreateProgramDisplay()
 
 	connect(program.data(), &OBSQTDisplay::DisplayCreated, addDisplay);
 
+	program->SetMaxFPS((double)config_get_int(App()->GetUserConfig(), "BasicWindow", "DisplayMaxFPS"));
+
+	OBSCanvasAutoRelease mainCanvas = obs_get_main_canvas();
+	program->SetConsumedCanvas(mainCanvas, OBS_CANVAS_CONSUMER_DISPLAY);
+
 	program->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
 }
 
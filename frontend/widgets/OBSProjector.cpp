@@ -79,6 +79,12 @@ OBSProjector::OBSProjector(QWidget *widget, obs_source_t *source_, int monitor,
 	connect(this, &OBSQTDisplay::DisplayCreated, addDrawCallback);
 	connect(App(), &QGuiApplication::screenRemoved, this, &OBSProjector::ScreenRemoved);
 
+	// Everything but source and scene projectors draws the main canvas
+	if (type != ProjectorType::Source && type != ProjectorType::Scene) {
+		OBSCanvasAutoRelease mainCanvas = obs_get_main_canvas();
+		SetConsumedCanvas(mainCanvas, OBS_CANVAS_CONSUMER_PROJECTOR);
+	}
+
 	if (type == ProjectorType::Multiview) {
 		multiview = new Multiview();
 
@@ -314,7 +320,10 @@ void OBSProjector::UpdateMultiview()
 
 	transitionOnDoubleClick = config_get_bool(App()->GetUserConfig(), "BasicWindow", "TransitionOnDoubleClick");
 
-	multiview->Update(multiviewLayout, drawLabel, drawSafeArea);
+	uint32_t refreshDivisor =
+		(uint32_t)config_get_int(App()->GetUserConfig(), "BasicWindow", "MultiviewRefreshDivisor");
+
+	multiview->Update(multiviewLayout, drawLabel, drawSafeArea, refreshDivisor);
 }
 
 void OBSProjector::UpdateProjectorTitle(QString name)
@@ -447,6 +456,16 @@ void OBSProjector::closeEvent(QCloseEvent *event)
 	event->accept();
 }
 
+void OBSProjector::changeEvent(QEvent *event)
+{
+	// A minimized projector is only drawn when the window system asks for
+	// it (e.g. for a taskbar thumbnail) instead of on every frame
+	if (event->type() == QEvent::WindowStateChange)
+		SetRedrawOnDemand(isMinimized());
+
+	OBSQTDisplay::changeEvent(event);
+}
+
 bool OBSProjector::IsAlwaysOnTop() const
 {
 	return isAlwaysOnTop;
@@ -27,6 +27,7 @@ private:
 	void mousePressEvent(QMouseEvent *event) override;
 	void mouseDoubleClickEvent(QMouseEvent *event) override;
 	void closeEvent(QCloseEvent *event) override;
+	void changeEvent(QEvent *event) override;
 
 	bool isAlwaysOnTop;
 	bool isAlwaysOnTopOverridden = false;
@@ -108,6 +108,12 @@ OBSQTDisplay::OBSQTDisplay(QWidget *parent, Qt::WindowFlags flags) : QWidget(par
 	windowHandle()->installEventFilter(new SurfaceEventFilter(this));
 }
 
+OBSQTDisplay::~OBSQTDisplay()
+{
+	SetConsumedCanvas(nullptr, consumerType);
+	display = nullptr;
+}
+
 QColor OBSQTDisplay::GetDisplayBackgroundColor() const
 {
 	return rgba_to_color(backgroundColor);
@@ -151,6 +157,8 @@ void OBSQTDisplay::CreateDisplay()
 		return;
 
 	display = obs_display_create(&info, backgroundColor);
+	obs_display_set_max_fps(display, maxFPS);
+	obs_display_set_redraw_on_demand(display, redrawOnDemand);
 
 	emit DisplayCreated(this);
 }
@@ -159,6 +167,9 @@ void OBSQTDisplay::paintEvent(QPaintEvent *event)
 {
 	CreateDisplay();
 
+	if (redrawOnDemand)
+		RequestRedraw();
+
 	QWidget::paintEvent(event);
 }
 
@@ -214,3 +225,32 @@ void OBSQTDisplay::OnDisplayChange()
 	if (display)
 		obs_display_update_color_space(display);
 }
+
+void OBSQTDisplay::SetMaxFPS(double fps)
+{
+	maxFPS = fps;
+	obs_display_set_max_fps(display, fps);
+}
+
+void OBSQTDisplay::SetRedrawOnDemand(bool onDemand)
+{
+	redrawOnDemand = onDemand;
+	obs_display_set_redraw_on_demand(display, onDemand);
+}
+
+void OBSQTDisplay::RequestRedraw()
+{
+	obs_display_request_redraw(display);
+}
+
+void OBSQTDisplay::SetConsumedCanvas(obs_canvas_t *canvas, enum obs_canvas_consumer type)
+{
+	if (consumedCanvas)
+		obs_canvas_remove_consumer(consumedCanvas, consumerType);
+
+	consumedCanvas = canvas;
+	consumerType = type;
+
+	if (consumedCanvas)
+		obs_canvas_add_consumer(consumedCanvas, consumerType);
+}
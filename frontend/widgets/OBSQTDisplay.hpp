@@ -13,6 +13,10 @@ class OBSQTDisplay : public QWidget {
 
 	OBSDisplay display;
 	bool destroying = false;
+	double maxFPS = 0.0;
+	bool redrawOnDemand = false;
+	OBSCanvas consumedCanvas;
+	enum obs_canvas_consumer consumerType = OBS_CANVAS_CONSUMER_DISPLAY;
 
 	virtual void paintEvent(QPaintEvent *event) override;
 	virtual void moveEvent(QMoveEvent *event) override;
@@ -25,7 +29,7 @@ signals:
 
 public:
 	OBSQTDisplay(QWidget *parent = nullptr, Qt::WindowFlags flags = Qt::WindowFlags());
-	~OBSQTDisplay() { display = nullptr; }
+	~OBSQTDisplay();
 
 	virtual QPaintEngine *paintEngine() const override;
 
@@ -45,4 +49,12 @@ public:
 
 	void OnMove();
 	void OnDisplayChange();
+
+	void SetMaxFPS(double fps);
+	void SetRedrawOnDemand(bool onDemand);
+	void RequestRedraw();
+
+	// Registers this display as a consumer of the canvas's texture until
+	// it is destroyed or another canvas (or nullptr) is set
+	void SetConsumedCanvas(obs_canvas_t *canvas, enum obs_canvas_consumer type);
 };
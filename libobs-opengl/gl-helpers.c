@@ -150,3 +150,25 @@ bool update_buffer(GLenum target, GLuint buffer, const void *data, size_t size)
 	gl_bind_buffer(target, 0);
 	return success;
 }
+
+/* a stuck fence is usually a lost device, don't hang the graphics thread on
+ * it forever */
+#define FENCE_TIMEOUT_NS 1000000000ULL
+
+bool gl_wait_fence(GLsync *fence)
+{
+	GLenum result;
+
+	if (!*fence)
+		return true;
+
+	result = glClientWaitSync(*fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT_NS);
+	gl_success("glClientWaitSync");
+
+	glDeleteSync(*fence);
+	*fence = NULL;
+
+	if (result == GL_TIMEOUT_EXPIRED)
+		blog(LOG_WARNING, "gl_wait_fence: Timed out waiting for fence");
+	return result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED;
+}
@@ -0,0 +1,396 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#include <util/platform.h>
+#include "gl-subsystem.h"
+
+/*
+ * Linked programs are stored with glGetProgramBinary in a directory per
+ * driver, so that updating the driver or switching GPUs starts over with an
+ * empty cache.  Each program file is named after the hashes of its two
+ * shaders' GLSL and ends with a checksum of its contents.
+ *
+ * The directory also keeps a list of the shaders that have compiled
+ * successfully before.  Those shaders are only compiled if a program using
+ * them is not in the cache, any other shader is compiled right away as before
+ * so that errors are still reported when the effect is created.
+ *
+ * The cache directory itself is chosen by libobs.  Program files older than
+ * MAX_FILE_AGE are removed when the cache is opened, along with the
+ * directories of drivers that are no longer used, and the oldest programs of
+ * the current driver are removed while they add up to more than
+ * MAX_CACHE_SIZE.
+ */
+
+#define SHADER_INDEX_FILE "shaders"
+/* Increment if the on-disk format changes */
+#define PROGRAM_FILE_EXT ".v1"
+
+#define MAX_FILE_AGE (30 * 24 * 60 * 60)
+#define MAX_CACHE_SIZE (64 * 1024 * 1024)
+
+static uint64_t fnv1a_hash(uint64_t hash, const void *data, size_t size)
+{
+	const uint64_t FNV_PRIME = 1099511628211ULL;
+	const uint8_t *bytes = data;
+
+	for (size_t i = 0; i < size; i++) {
+		hash ^= (uint64_t)bytes[i];
+		hash *= FNV_PRIME;
+	}
+	return hash;
+}
+
+#define FNV_OFFSET 14695981039346656037ULL
+
+uint64_t gl_shader_hash(const char *str)
+{
+	return fnv1a_hash(FNV_OFFSET, str, strlen(str));
+}
+
+static inline uint64_t driver_hash(void)
+{
+	const char *strings[] = {
+		(const char *)glGetString(GL_VENDOR),
+		(const char *)glGetString(GL_RENDERER),
+		(const char *)glGetString(GL_VERSION),
+	};
+	uint64_t hash = FNV_OFFSET;
+
+	for (size_t i = 0; i < sizeof(strings) / sizeof(strings[0]); i++) {
+		if (strings[i])
+			hash = fnv1a_hash(hash, strings[i], strlen(strings[i]) + 1);
+	}
+	return hash;
+}
+
+static int cmp_hash(const void *a, const void *b)
+{
+	uint64_t val_a = *(const uint64_t *)a;
+	uint64_t val_b = *(const uint64_t *)b;
+	return val_a < val_b ? -1 : (val_a > val_b ? 1 : 0);
+}
+
+static void load_shader_index(struct gs_device *device)
+{
+	struct dstr path = {0};
+	int64_t size;
+	FILE *file;
+
+	dstr_printf(&path, "%s/" SHADER_INDEX_FILE, device->program_cache_path);
+
+	size = os_get_file_size(path.array);
+	file = size > 0 ? os_fopen(path.array, "rb") : NULL;
+	if (file) {
+		/* a partially written entry at the end is ignored */
+		size_t num = (size_t)size / sizeof(uint64_t);
+
+		da_resize(device->cached_shaders, num);
+		num = fread(device->cached_shaders.array, sizeof(uint64_t), num, file);
+		da_resize(device->cached_shaders, num);
+		fclose(file);
+
+		qsort(device->cached_shaders.array, num, sizeof(uint64_t), cmp_hash);
+	}
+
+	dstr_free(&path);
+}
+
+struct cache_file {
+	char *path;
+	int64_t size;
+	time_t mtime;
+};
+
+static int cmp_mtime(const void *a, const void *b)
+{
+	const struct cache_file *file_a = a;
+	const struct cache_file *file_b = b;
+	return file_a->mtime < file_b->mtime ? -1 : (file_a->mtime > file_b->mtime ? 1 : 0);
+}
+
+/* Removes expired programs of one driver directory.  The directory of the
+ * current driver is trimmed to MAX_CACHE_SIZE, any other directory is removed
+ * entirely once no programs are left in it. */
+static void prune_driver_dir(const char *dir_path, bool current, time_t now)
+{
+	DARRAY(struct cache_file) files;
+	struct dstr path = {0};
+	struct os_dirent *ent;
+	int64_t total = 0;
+	os_dir_t *dir;
+
+	dir = os_opendir(dir_path);
+	if (!dir)
+		return;
+
+	da_init(files);
+
+	while ((ent = os_readdir(dir)) != NULL) {
+		struct stat st;
+
+		if (ent->directory || strcmp(ent->d_name, SHADER_INDEX_FILE) == 0)
+			continue;
+
+		dstr_printf(&path, "%s/%s", dir_path, ent->d_name);
+		if (os_stat(path.array, &st) != 0)
+			continue;
+
+		if (now - st.st_mtime > MAX_FILE_AGE) {
+			os_unlink(path.array);
+			continue;
+		}
+
+		struct cache_file *file = da_push_back_new(files);
+		file->path = bstrdup(path.array);
+		file->size = (int64_t)st.st_size;
+		file->mtime = st.st_mtime;
+		total += file->size;
+	}
+
+	os_closedir(dir);
+
+	if (current) {
+		qsort(files.array, files.num, sizeof(struct cache_file), cmp_mtime);
+
+		for (size_t i = 0; i < files.num && total > MAX_CACHE_SIZE; i++) {
+			os_unlink(files.array[i].path);
+			total -= files.array[i].size;
+		}
+	} else if (!files.num) {
+		dstr_printf(&path, "%s/" SHADER_INDEX_FILE, dir_path);
+		os_unlink(path.array);
+		os_rmdir(dir_path);
+	}
+
+	for (size_t i = 0; i < files.num; i++)
+		bfree(files.array[i].path);
+	da_free(files);
+	dstr_free(&path);
+}
+
+static void prune_cache(const char *cache_path, const char *current_dir)
+{
+	struct dstr path = {0};
+	struct os_dirent *ent;
+	time_t now = time(NULL);
+	os_dir_t *dir;
+
+	dir = os_opendir(cache_path);
+	if (!dir)
+		return;
+
+	while ((ent = os_readdir(dir)) != NULL) {
+		if (!ent->directory || strncmp(ent->d_name, "gl-", 3) != 0)
+			continue;
+
+		dstr_printf(&path, "%s/%s", cache_path, ent->d_name);
+		prune_driver_dir(path.array, strcmp(ent->d_name, current_dir) == 0, now);
+	}
+
+	os_closedir(dir);
+	dstr_free(&path);
+}
+
+static void gl_program_cache_init(struct gs_device *device, const char *cache_path)
+{
+	GLint num_formats = 0;
+	struct dstr path = {0};
+	char name[32];
+
+	if (!GLAD_GL_VERSION_4_1 && !GLAD_GL_ARB_get_program_binary)
+		return;
+
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_formats);
+	if (!gl_success("glGetIntegerv") || num_formats <= 0) {
+		blog(LOG_INFO, "Driver does not support program binaries, "
+			       "shaders will not be cached");
+		return;
+	}
+
+	snprintf(name, sizeof(name), "gl-%016" PRIx64, driver_hash());
+	dstr_printf(&path, "%s/%s", cache_path, name);
+
+	if (os_mkdirs(path.array) == MKDIR_ERROR) {
+		blog(LOG_WARNING, "Failed to create shader cache directory: %s", path.array);
+		dstr_free(&path);
+		return;
+	}
+
+	prune_cache(cache_path, name);
+
+	device->program_cache_path = path.array;
+	load_shader_index(device);
+}
+
+void gl_program_cache_free(struct gs_device *device)
+{
+	da_free(device->cached_shaders);
+	bfree(device->program_cache_path);
+	device->program_cache_path = NULL;
+}
+
+void device_set_shader_cache_path(gs_device_t *device, const char *path)
+{
+	gl_program_cache_free(device);
+
+	if (path && *path)
+		gl_program_cache_init(device, path);
+}
+
+bool gl_program_cache_has_shader(struct gs_device *device, uint64_t hash)
+{
+	if (!device->program_cache_path)
+		return false;
+
+	return bsearch(&hash, device->cached_shaders.array, device->cached_shaders.num, sizeof(uint64_t),
+		       cmp_hash) != NULL;
+}
+
+void gl_program_cache_add_shader(struct gs_device *device, uint64_t hash)
+{
+	struct dstr path = {0};
+	size_t idx = 0;
+	FILE *file;
+
+	if (!device->program_cache_path)
+		return;
+
+	while (idx < device->cached_shaders.num && device->cached_shaders.array[idx] < hash)
+		idx++;
+	if (idx < device->cached_shaders.num && device->cached_shaders.array[idx] == hash)
+		return;
+
+	da_insert(device->cached_shaders, idx, &hash);
+
+	dstr_printf(&path, "%s/" SHADER_INDEX_FILE, device->program_cache_path);
+
+	file = os_fopen(path.array, "ab");
+	if (file) {
+		fwrite(&hash, sizeof(hash), 1, file);
+		fclose(file);
+	}
+
+	dstr_free(&path);
+}
+
+static inline void get_program_path(struct dstr *path, struct gs_program *program)
+{
+	dstr_printf(path, "%s/%016" PRIx64 "-%016" PRIx64 PROGRAM_FILE_EXT, program->device->program_cache_path,
+		    program->vertex_shader->hash, program->pixel_shader->hash);
+}
+
+/* file layout: binary format, program binary, checksum of both */
+struct program_file_header {
+	uint32_t format;
+};
+
+bool gl_program_cache_load(struct gs_program *program)
+{
+	struct program_file_header header;
+	struct dstr path = {0};
+	uint8_t *data = NULL;
+	uint64_t checksum;
+	GLint linked = GL_FALSE;
+	int64_t size;
+	FILE *file;
+
+	if (!program->device->program_cache_path)
+		return false;
+
+	get_program_path(&path, program);
+
+	size = os_get_file_size(path.array);
+	if (size <= (int64_t)(sizeof(header) + sizeof(checksum)))
+		goto fail;
+
+	file = os_fopen(path.array, "rb");
+	if (!file)
+		goto fail;
+
+	size -= sizeof(header) + sizeof(checksum);
+	data = bmalloc((size_t)size);
+
+	bool valid = fread(&header, sizeof(header), 1, file) == 1 &&
+		     fread(data, 1, (size_t)size, file) == (size_t)size &&
+		     fread(&checksum, sizeof(checksum), 1, file) == 1;
+	fclose(file);
+
+	if (!valid || fnv1a_hash(fnv1a_hash(FNV_OFFSET, &header, sizeof(header)), data, (size_t)size) != checksum) {
+		blog(LOG_WARNING, "Program cache file is damaged: %s", path.array);
+		os_unlink(path.array);
+		goto fail;
+	}
+
+	glProgramBinary(program->obj, header.format, data, (GLsizei)size);
+	gl_success("glProgramBinary");
+
+	glGetProgramiv(program->obj, GL_LINK_STATUS, &linked);
+	gl_success("glGetProgramiv");
+
+	/* drivers can reject binaries at any time, the program is linked from
+	 * source again in that case */
+	if (linked == GL_FALSE) {
+		blog(LOG_DEBUG, "Driver rejected cached program: %s", path.array);
+		os_unlink(path.array);
+		goto fail;
+	}
+
+	bfree(data);
+	dstr_free(&path);
+	return true;
+
+fail:
+	bfree(data);
+	dstr_free(&path);
+	return false;
+}
+
+void gl_program_cache_save(struct gs_program *program)
+{
+	struct program_file_header header;
+	struct dstr path = {0};
+	GLint size = 0;
+	GLenum format;
+	uint8_t *data;
+	uint64_t checksum;
+	FILE *file;
+
+	if (!program->device->program_cache_path)
+		return;
+
+	glGetProgramiv(program->obj, GL_PROGRAM_BINARY_LENGTH, &size);
+	if (!gl_success("glGetProgramiv") || size <= 0)
+		return;
+
+	data = bmalloc(size);
+	glGetProgramBinary(program->obj, size, &size, &format, data);
+	if (!gl_success("glGetProgramBinary") || size <= 0) {
+		bfree(data);
+		return;
+	}
+
+	header.format = format;
+	checksum = fnv1a_hash(fnv1a_hash(FNV_OFFSET, &header, sizeof(header)), data, size);
+
+	get_program_path(&path, program);
+
+	file = os_fopen(path.array, "wb");
+	if (file) {
+		bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+			       fwrite(data, 1, size, file) == (size_t)size &&
+			       fwrite(&checksum, sizeof(checksum), 1, file) == 1;
+		fclose(file);
+
+		if (!written) {
+			blog(LOG_WARNING, "Writing program cache file failed: %s", path.array);
+			os_unlink(path.array);
+		}
+	}
+
+	bfree(data);
+	dstr_free(&path);
+}
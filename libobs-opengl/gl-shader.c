@@ -174,8 +174,7 @@ static inline bool gl_process_attribs(struct gs_shader *shader, struct gl_shader
 	return true;
 }
 
-static bool gl_shader_init(struct gs_shader *shader, struct gl_shader_parser *glsp, const char *file,
-			   char **error_string)
+static bool gl_shader_compile(struct gs_shader *shader, const char *source, const char *file, char **error_string)
 {
 	GLenum type = convert_shader_type(shader->type);
 	int compiled = 0;
@@ -185,7 +184,7 @@ static bool gl_shader_init(struct gs_shader *shader, struct gl_shader_parser *gl
 	if (!gl_success("glCreateShader") || !shader->obj)
 		return false;
 
-	glShaderSource(shader->obj, 1, (const GLchar **)&glsp->gl_string.array, 0);
+	glShaderSource(shader->obj, 1, (const GLchar **)&source, 0);
 	if (!gl_success("glShaderSource"))
 		return false;
 
@@ -197,7 +196,7 @@ static bool gl_shader_init(struct gs_shader *shader, struct gl_shader_parser *gl
 	blog(LOG_DEBUG, "+++++++++++++++++++++++++++++++++++");
 	blog(LOG_DEBUG, "  GL shader string for: %s", file);
 	blog(LOG_DEBUG, "-----------------------------------");
-	blog(LOG_DEBUG, "%s", glsp->gl_string.array);
+	blog(LOG_DEBUG, "%s", source);
 	blog(LOG_DEBUG, "+++++++++++++++++++++++++++++++++++");
 #endif
 
@@ -223,6 +222,26 @@ static bool gl_shader_init(struct gs_shader *shader, struct gl_shader_parser *gl
 	}
 
 	gl_get_shader_info(shader->obj, file, error_string);
+	return success;
+}
+
+static bool gl_shader_init(struct gs_shader *shader, struct gl_shader_parser *glsp, const char *file,
+			   char **error_string)
+{
+	bool success = true;
+
+	shader->hash = gl_shader_hash(glsp->gl_string.array);
+
+	/* a shader that has compiled before only needs to be compiled again if
+	 * a program using it is not in the cache */
+	if (gl_program_cache_has_shader(shader->device, shader->hash)) {
+		dstr_move(&shader->source, &glsp->gl_string);
+		shader->file = bstrdup(file);
+	} else {
+		success = gl_shader_compile(shader, glsp->gl_string.array, file, error_string);
+		if (success)
+			gl_program_cache_add_shader(shader->device, shader->hash);
+	}
 
 	if (success)
 		success = gl_add_params(shader, glsp);
@@ -260,6 +279,23 @@ static struct gs_shader *shader_create(gs_device_t *device, enum gs_shader_type
 	return shader;
 }
 
+bool gl_shader_compile_deferred(struct gs_shader *shader)
+{
+	bool success;
+
+	if (shader->obj)
+		return true;
+
+	success = gl_shader_compile(shader, shader->source.array, shader->file, NULL);
+	if (!success && shader->obj) {
+		glDeleteShader(shader->obj);
+		gl_success("glDeleteShader");
+		shader->obj = 0;
+	}
+
+	return success;
+}
+
 gs_shader_t *device_vertexshader_create(gs_device_t *device, const char *shader, const char *file, char **error_string)
 {
 	struct gs_shader *ptr;
@@ -325,6 +361,8 @@ void gs_shader_destroy(gs_shader_t *shader)
 	da_free(shader->samplers);
 	da_free(shader->params);
 	da_free(shader->attribs);
+	dstr_free(&shader->source);
+	bfree(shader->file);
 	bfree(shader);
 }
 
@@ -430,10 +468,31 @@ static inline bool validate_param(struct program_param *pp, size_t expected_size
 	return true;
 }
 
+/* uniforms keep their values in the program object, so only values that
+ * changed since they were last uploaded to this program need to be sent */
+static inline bool param_value_changed(struct gs_program *program, struct program_param *pp)
+{
+	uint8_t *uploaded = program->uploaded_values.array + pp->value_offset;
+	const void *value = pp->param->cur_value.array;
+
+	/* let validate_param report invalid sizes */
+	if (pp->param->cur_value.num != pp->value_size)
+		return true;
+	if (pp->uploaded && memcmp(uploaded, value, pp->value_size) == 0)
+		return false;
+
+	memcpy(uploaded, value, pp->value_size);
+	pp->uploaded = true;
+	return true;
+}
+
 static void program_set_param_data(struct gs_program *program, struct program_param *pp)
 {
 	void *array = pp->param->cur_value.array;
 
+	if (pp->value_size && !param_value_changed(program, pp))
+		return;
+
 	if (pp->param->type == GS_SHADER_PARAM_BOOL || pp->param->type == GS_SHADER_PARAM_INT) {
 		if (validate_param(pp, sizeof(int))) {
 			glUniform1iv(pp->obj, 1, (int *)array);
@@ -560,6 +619,31 @@ static inline bool assign_program_attribs(struct gs_program *program)
 	return true;
 }
 
+/* size of the values uploaded by program_set_param_data, textures are
+ * always bound again and have no value to compare */
+static size_t get_uniform_size(enum gs_shader_param_type type)
+{
+	switch (type) {
+	case GS_SHADER_PARAM_BOOL:
+	case GS_SHADER_PARAM_INT:
+	case GS_SHADER_PARAM_FLOAT:
+		return sizeof(float);
+	case GS_SHADER_PARAM_INT2:
+	case GS_SHADER_PARAM_VEC2:
+		return sizeof(float) * 2;
+	case GS_SHADER_PARAM_INT3:
+	case GS_SHADER_PARAM_VEC3:
+		return sizeof(float) * 3;
+	case GS_SHADER_PARAM_INT4:
+	case GS_SHADER_PARAM_VEC4:
+		return sizeof(float) * 4;
+	case GS_SHADER_PARAM_MATRIX4X4:
+		return sizeof(float) * 4 * 4;
+	default:
+		return 0;
+	}
+}
+
 static bool assign_program_param(struct gs_program *program, struct gs_shader_param *param)
 {
 	struct program_param info;
@@ -573,7 +657,11 @@ static bool assign_program_param(struct gs_program *program, struct gs_shader_pa
 	}
 
 	info.param = param;
+	info.value_offset = program->uploaded_values.num;
+	info.value_size = get_uniform_size(param->type);
+	info.uploaded = false;
 	da_push_back(program->params, &info);
+	da_resize(program->uploaded_values, program->uploaded_values.num + info.value_size);
 	return true;
 }
 
@@ -598,51 +686,74 @@ static inline bool assign_program_params(struct gs_program *program)
 	return true;
 }
 
-struct gs_program *gs_program_create(struct gs_device *device)
+static bool link_program(struct gs_program *program)
 {
-	struct gs_program *program = bzalloc(sizeof(*program));
 	int linked = false;
 
-	program->device = device;
-	program->vertex_shader = device->cur_vertex_shader;
-	program->pixel_shader = device->cur_pixel_shader;
-
-	program->obj = glCreateProgram();
-	if (!gl_success("glCreateProgram"))
-		goto error_detach_neither;
+	if (!gl_shader_compile_deferred(program->vertex_shader))
+		return false;
+	if (!gl_shader_compile_deferred(program->pixel_shader))
+		return false;
 
 	glAttachShader(program->obj, program->vertex_shader->obj);
 	if (!gl_success("glAttachShader (vertex)"))
-		goto error_detach_neither;
+		return false;
 
 	glAttachShader(program->obj, program->pixel_shader->obj);
 	if (!gl_success("glAttachShader (pixel)"))
-		goto error_detach_vertex;
+		goto detach_vertex;
+
+	if (program->device->program_cache_path) {
+		glProgramParameteri(program->obj, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		gl_success("glProgramParameteri");
+	}
 
 	glLinkProgram(program->obj);
 	if (!gl_success("glLinkProgram"))
-		goto error;
+		goto detach_all;
 
 	glGetProgramiv(program->obj, GL_LINK_STATUS, &linked);
 	if (!gl_success("glGetProgramiv"))
-		goto error;
+		goto detach_all;
 
-	if (linked == GL_FALSE) {
+	if (linked == GL_FALSE)
 		print_link_errors(program->obj);
+
+detach_all:
+	glDetachShader(program->obj, program->pixel_shader->obj);
+	gl_success("glDetachShader (pixel)");
+
+detach_vertex:
+	glDetachShader(program->obj, program->vertex_shader->obj);
+	gl_success("glDetachShader (vertex)");
+
+	if (linked == GL_FALSE)
+		return false;
+
+	gl_program_cache_save(program);
+	return true;
+}
+
+struct gs_program *gs_program_create(struct gs_device *device)
+{
+	struct gs_program *program = bzalloc(sizeof(*program));
+
+	program->device = device;
+	program->vertex_shader = device->cur_vertex_shader;
+	program->pixel_shader = device->cur_pixel_shader;
+
+	program->obj = glCreateProgram();
+	if (!gl_success("glCreateProgram"))
+		goto error;
+
+	if (!gl_program_cache_load(program) && !link_program(program))
 		goto error;
-	}
 
 	if (!assign_program_attribs(program))
 		goto error;
 	if (!assign_program_params(program))
 		goto error;
 
-	glDetachShader(program->obj, program->vertex_shader->obj);
-	gl_success("glDetachShader (vertex)");
-
-	glDetachShader(program->obj, program->pixel_shader->obj);
-	gl_success("glDetachShader (pixel)");
-
 	program->next = device->first_program;
 	program->prev_next = &device->first_program;
 	device->first_program = program;
@@ -652,14 +763,6 @@ struct gs_program *gs_program_create(struct gs_device *device)
 	return program;
 
 error:
-	glDetachShader(program->obj, program->pixel_shader->obj);
-	gl_success("glDetachShader (pixel)");
-
-error_detach_vertex:
-	glDetachShader(program->obj, program->vertex_shader->obj);
-	gl_success("glDetachShader (vertex)");
-
-error_detach_neither:
 	gs_program_destroy(program);
 	return NULL;
 }
@@ -677,6 +780,7 @@ void gs_program_destroy(struct gs_program *program)
 
 	da_free(program->attribs);
 	da_free(program->params);
+	da_free(program->uploaded_values);
 
 	if (program->next)
 		program->next->prev_next = program->prev_next;
@@ -68,6 +68,8 @@ gs_stagesurf_t *device_stagesurface_create(gs_device_t *device, uint32_t width,
 void gs_stagesurface_destroy(gs_stagesurf_t *stagesurf)
 {
 	if (stagesurf) {
+		if (stagesurf->fence)
+			glDeleteSync(stagesurf->fence);
 		if (stagesurf->pack_buffer)
 			gl_delete_buffers(1, &stagesurf->pack_buffer);
 
@@ -106,6 +108,15 @@ static bool can_stage(struct gs_stage_surface *dst, struct gs_texture_2d *src)
 	return true;
 }
 
+static void insert_fence(struct gs_stage_surface *dst)
+{
+	if (dst->fence)
+		glDeleteSync(dst->fence);
+
+	dst->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	gl_success("glFenceSync");
+}
+
 #ifdef __APPLE__
 
 /* Apparently for mac, PBOs won't do an asynchronous transfer unless you use
@@ -138,6 +149,7 @@ void device_stage_texture(gs_device_t *device, gs_stagesurf_t *dst, gs_texture_t
 	if (!gl_success("glReadPixels"))
 		goto failed_unbind_all;
 
+	insert_fence(dst);
 	success = true;
 
 failed_unbind_all:
@@ -170,6 +182,8 @@ void device_stage_texture(gs_device_t *device, gs_stagesurf_t *dst, gs_texture_t
 	if (!gl_success("glGetTexImage"))
 		goto failed;
 
+	insert_fence(dst);
+
 	gl_bind_texture(GL_TEXTURE_2D, 0);
 	gl_bind_buffer(GL_PIXEL_PACK_BUFFER, 0);
 	return;
@@ -199,8 +213,29 @@ enum gs_color_format gs_stagesurface_get_color_format(const gs_stagesurf_t *stag
 	return stagesurf->format;
 }
 
+bool gs_stagesurface_is_ready(gs_stagesurf_t *stagesurf)
+{
+	GLenum result;
+
+	if (!stagesurf->fence)
+		return true;
+
+	/* a timeout of zero only polls the fence */
+	result = glClientWaitSync(stagesurf->fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+	if (!gl_success("glClientWaitSync"))
+		return true;
+	if (result == GL_TIMEOUT_EXPIRED)
+		return false;
+
+	glDeleteSync(stagesurf->fence);
+	stagesurf->fence = NULL;
+	return true;
+}
+
 bool gs_stagesurface_map(gs_stagesurf_t *stagesurf, uint8_t **data, uint32_t *linesize)
 {
+	gl_wait_fence(&stagesurf->fence);
+
 	if (!gl_bind_buffer(GL_PIXEL_PACK_BUFFER, stagesurf->pack_buffer))
 		goto fail;
 
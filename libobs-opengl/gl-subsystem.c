@@ -153,6 +153,8 @@ static bool gl_init_extensions(struct gs_device *device)
 	else
 		device->copy_type = COPY_TYPE_FBO_BLIT;
 
+	device->buffer_storage = GLAD_GL_VERSION_4_4 || GLAD_GL_ARB_buffer_storage;
+
 	return true;
 }
 
@@ -334,6 +336,7 @@ void device_destroy(gs_device_t *device)
 		gl_delete_vertex_arrays(1, &device->empty_vao);
 
 		da_free(device->proj_stack);
+		gl_program_cache_free(device);
 		gl_platform_destroy(device->plat);
 		bfree(device);
 	}
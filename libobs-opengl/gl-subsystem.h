@@ -18,6 +18,7 @@
 #pragma once
 
 #include <util/darray.h>
+#include <util/dstr.h>
 #include <util/threading.h>
 #include <graphics/graphics.h>
 #include <graphics/device-exports.h>
@@ -472,6 +473,12 @@ struct gs_shader {
 	enum gs_shader_type type;
 	GLuint obj;
 
+	/* hash of the GLSL, and the GLSL itself while compiling is deferred
+	 * until the shader is linked into a program that is not cached */
+	uint64_t hash;
+	struct dstr source;
+	char *file;
+
 	struct gs_shader_param *viewproj;
 	struct gs_shader_param *world;
 
@@ -483,6 +490,11 @@ struct gs_shader {
 struct program_param {
 	GLint obj;
 	struct gs_shader_param *param;
+
+	/* last value uploaded to the program, in gs_program::uploaded_values */
+	size_t value_offset;
+	size_t value_size;
+	bool uploaded;
 };
 
 struct gs_program {
@@ -493,6 +505,7 @@ struct gs_program {
 
 	DARRAY(struct program_param) params;
 	DARRAY(GLint) attribs;
+	DARRAY(uint8_t) uploaded_values;
 
 	struct gs_program **prev_next;
 	struct gs_program *next;
@@ -502,6 +515,15 @@ extern struct gs_program *gs_program_create(struct gs_device *device);
 extern void gs_program_destroy(struct gs_program *program);
 extern void program_update_params(struct gs_program *shader);
 
+extern bool gl_shader_compile_deferred(struct gs_shader *shader);
+
+extern uint64_t gl_shader_hash(const char *str);
+extern void gl_program_cache_free(struct gs_device *device);
+extern bool gl_program_cache_has_shader(struct gs_device *device, uint64_t hash);
+extern void gl_program_cache_add_shader(struct gs_device *device, uint64_t hash);
+extern bool gl_program_cache_load(struct gs_program *program);
+extern void gl_program_cache_save(struct gs_program *program);
+
 struct gs_vertex_buffer {
 	GLuint vao;
 	GLuint vertex_buffer;
@@ -551,13 +573,24 @@ struct gs_texture {
 	struct fbo_info *fbo;
 };
 
+/* dynamic textures cycle through several unpack buffers so that writing the
+ * next frame does not have to wait for the previous one to be uploaded */
+#define GS_UNPACK_BUFFERS 3
+
 struct gs_texture_2d {
 	struct gs_texture base;
 
 	uint32_t width;
 	uint32_t height;
 	bool gen_mipmaps;
-	GLuint unpack_buffer;
+
+	GLuint unpack_buffers[GS_UNPACK_BUFFERS];
+	GLsizeiptr unpack_size;
+	size_t cur_unpack_buffer;
+
+	/* only used if the buffers are persistently mapped */
+	uint8_t *unpack_ptrs[GS_UNPACK_BUFFERS];
+	GLsync unpack_fences[GS_UNPACK_BUFFERS];
 };
 
 struct gs_texture_3d {
@@ -588,6 +621,9 @@ struct gs_stage_surface {
 	GLint gl_internal_format;
 	GLenum gl_type;
 	GLuint pack_buffer;
+
+	/* signaled when the last copy to the pack buffer has finished */
+	GLsync fence;
 };
 
 struct gs_zstencil_buffer {
@@ -627,6 +663,7 @@ static inline void fbo_info_destroy(struct fbo_info *fbo)
 struct gs_device {
 	struct gl_platform *plat;
 	enum copy_type copy_type;
+	bool buffer_storage;
 
 	GLuint empty_vao;
 	gs_samplerstate_t *raw_load_sampler;
@@ -646,6 +683,9 @@ struct gs_device {
 
 	struct gs_program *first_program;
 
+	char *program_cache_path;
+	DARRAY(uint64_t) cached_shaders;
+
 	enum gs_cull_mode cur_cull_mode;
 	struct gs_rect cur_viewport;
 
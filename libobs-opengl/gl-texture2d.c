@@ -42,16 +42,43 @@ static bool upload_texture_2d(struct gs_texture_2d *tex, const uint8_t **data)
 	return success;
 }
 
-static bool create_pixel_unpack_buffer(struct gs_texture_2d *tex)
+static bool create_pixel_unpack_buffer(struct gs_texture_2d *tex, size_t idx)
 {
-	GLsizeiptr size;
 	bool success = true;
 
-	if (!gl_gen_buffers(1, &tex->unpack_buffer))
+	if (!gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, tex->unpack_buffers[idx]))
 		return false;
 
-	if (!gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, tex->unpack_buffer))
-		return false;
+	if (tex->base.device->buffer_storage) {
+		/* stays mapped for the lifetime of the texture, so mapping
+		 * costs nothing more than waiting for the upload from the last
+		 * time the buffer was used */
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+		glBufferStorage(GL_PIXEL_UNPACK_BUFFER, tex->unpack_size, 0, flags);
+		if (!gl_success("glBufferStorage"))
+			success = false;
+
+		if (success) {
+			tex->unpack_ptrs[idx] = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, tex->unpack_size, flags);
+			if (!gl_success("glMapBufferRange") || !tex->unpack_ptrs[idx])
+				success = false;
+		}
+	} else {
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, tex->unpack_size, 0, GL_STREAM_DRAW);
+		if (!gl_success("glBufferData"))
+			success = false;
+	}
+
+	if (!gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0))
+		success = false;
+
+	return success;
+}
+
+static bool create_pixel_unpack_buffers(struct gs_texture_2d *tex)
+{
+	GLsizeiptr size;
 
 	size = tex->width * gs_get_format_bpp(tex->base.format);
 	if (!gs_is_compressed_format(tex->base.format)) {
@@ -63,14 +90,29 @@ static bool create_pixel_unpack_buffer(struct gs_texture_2d *tex)
 		size /= 8;
 	}
 
-	glBufferData(GL_PIXEL_UNPACK_BUFFER, size, 0, GL_DYNAMIC_DRAW);
-	if (!gl_success("glBufferData"))
-		success = false;
+	tex->unpack_size = size;
 
-	if (!gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0))
-		success = false;
+	if (!gl_gen_buffers(GS_UNPACK_BUFFERS, tex->unpack_buffers))
+		return false;
 
-	return success;
+	for (size_t i = 0; i < GS_UNPACK_BUFFERS; i++) {
+		if (!create_pixel_unpack_buffer(tex, i))
+			return false;
+	}
+
+	return true;
+}
+
+static void destroy_pixel_unpack_buffers(struct gs_texture_2d *tex)
+{
+	for (size_t i = 0; i < GS_UNPACK_BUFFERS; i++) {
+		if (tex->unpack_fences[i])
+			glDeleteSync(tex->unpack_fences[i]);
+	}
+
+	/* deleting a buffer also unmaps it */
+	if (tex->unpack_buffers[0])
+		gl_delete_buffers(GS_UNPACK_BUFFERS, tex->unpack_buffers);
 }
 
 gs_texture_t *device_texture_create(gs_device_t *device, uint32_t width, uint32_t height,
@@ -97,7 +139,7 @@ gs_texture_t *device_texture_create(gs_device_t *device, uint32_t width, uint32_
 		goto fail;
 
 	if (!tex->base.is_dummy) {
-		if (tex->base.is_dynamic && !create_pixel_unpack_buffer(tex))
+		if (tex->base.is_dynamic && !create_pixel_unpack_buffers(tex))
 			goto fail;
 		if (!upload_texture_2d(tex, data))
 			goto fail;
@@ -138,9 +180,7 @@ void gs_texture_destroy(gs_texture_t *tex)
 
 	if (!tex->is_dummy && tex->is_dynamic) {
 		if (tex->type == GS_TEXTURE_2D) {
-			struct gs_texture_2d *tex2d = (struct gs_texture_2d *)tex;
-			if (tex2d->unpack_buffer)
-				gl_delete_buffers(1, &tex2d->unpack_buffer);
+			destroy_pixel_unpack_buffers((struct gs_texture_2d *)tex);
 		} else if (tex->type == GS_TEXTURE_3D) {
 			struct gs_texture_3d *tex3d = (struct gs_texture_3d *)tex;
 			if (tex3d->unpack_buffer)
@@ -183,6 +223,7 @@ enum gs_color_format gs_texture_get_color_format(const gs_texture_t *tex)
 bool gs_texture_map(gs_texture_t *tex, uint8_t **ptr, uint32_t *linesize)
 {
 	struct gs_texture_2d *tex2d = (struct gs_texture_2d *)tex;
+	size_t idx;
 
 	if (!is_texture_2d(tex, "gs_texture_map"))
 		goto fail;
@@ -192,14 +233,29 @@ bool gs_texture_map(gs_texture_t *tex, uint8_t **ptr, uint32_t *linesize)
 		goto fail;
 	}
 
-	if (!gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, tex2d->unpack_buffer))
-		goto fail;
+	idx = (tex2d->cur_unpack_buffer + 1) % GS_UNPACK_BUFFERS;
 
-	*ptr = glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
-	if (!gl_success("glMapBuffer"))
-		goto fail;
+	if (tex2d->unpack_ptrs[idx]) {
+		/* the upload from this buffer was queued two maps ago, so it
+		 * has almost always finished by now */
+		gl_wait_fence(&tex2d->unpack_fences[idx]);
+		*ptr = tex2d->unpack_ptrs[idx];
 
-	gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	} else {
+		if (!gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, tex2d->unpack_buffers[idx]))
+			goto fail;
+
+		/* invalidating lets the driver hand out fresh storage instead
+		 * of waiting for a pending upload from the same buffer */
+		*ptr = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, tex2d->unpack_size,
+					GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+		gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		if (!gl_success("glMapBufferRange") || !*ptr)
+			goto fail;
+	}
+
+	tex2d->cur_unpack_buffer = idx;
 
 	*linesize = tex2d->width * gs_get_format_bpp(tex->format) / 8;
 	*linesize = (*linesize + 3) & 0xFFFFFFFC;
@@ -213,23 +269,42 @@ fail:
 void gs_texture_unmap(gs_texture_t *tex)
 {
 	struct gs_texture_2d *tex2d = (struct gs_texture_2d *)tex;
+	size_t idx;
+
 	if (!is_texture_2d(tex, "gs_texture_unmap"))
 		goto failed;
 
-	if (!gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, tex2d->unpack_buffer))
-		goto failed;
+	idx = tex2d->cur_unpack_buffer;
 
-	glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
-	if (!gl_success("glUnmapBuffer"))
+	if (!gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, tex2d->unpack_buffers[idx]))
 		goto failed;
 
+	if (!tex2d->unpack_ptrs[idx]) {
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		if (!gl_success("glUnmapBuffer"))
+			goto failed;
+	}
+
 	if (!gl_bind_texture(GL_TEXTURE_2D, tex2d->base.texture))
 		goto failed;
 
-	glTexImage2D(GL_TEXTURE_2D, 0, tex->gl_internal_format, tex2d->width, tex2d->height, 0, tex->gl_format,
-		     tex->gl_type, 0);
-	if (!gl_success("glTexImage2D"))
-		goto failed;
+	/* the storage already exists, only the contents change */
+	if (gs_is_compressed_format(tex->format)) {
+		glCompressedTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, tex2d->width, tex2d->height,
+					  tex->gl_internal_format, (GLsizei)tex2d->unpack_size, 0);
+		if (!gl_success("glCompressedTexSubImage2D"))
+			goto failed;
+	} else {
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, tex2d->width, tex2d->height, tex->gl_format, tex->gl_type,
+				0);
+		if (!gl_success("glTexSubImage2D"))
+			goto failed;
+	}
+
+	if (tex2d->unpack_ptrs[idx]) {
+		tex2d->unpack_fences[idx] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		gl_success("glFenceSync");
+	}
 
 	gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
 	gl_bind_texture(GL_TEXTURE_2D, 0);
@@ -62,19 +62,23 @@ static inline const char *cd_serialize_string(uint8_t **pos)
 static bool cd_getparam(const calldata_t *data, const char *name, uint8_t **pos)
 {
 	size_t name_size;
+	size_t len;
 
 	if (!data->size)
 		return false;
 
 	*pos = data->stack;
+	len = strlen(name) + 1;
 
+	/* names are stored with their sizes, so only names of the same
+	 * length need to be compared */
 	name_size = cd_serialize_size(pos);
 	while (name_size != 0) {
 		const char *param_name = (const char *)*pos;
 		size_t param_size;
 
 		*pos += name_size;
-		if (strcmp(param_name, name) == 0)
+		if (name_size == len && memcmp(param_name, name, len) == 0)
 			return true;
 
 		param_size = cd_serialize_size(pos);
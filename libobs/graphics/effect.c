@@ -15,6 +15,7 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 ******************************************************************************/
 
+#include "../util/profiler.h"
 #include "effect.h"
 #include "graphics-internal.h"
 #include "vec2.h"
@@ -272,11 +273,8 @@ gs_eparam_t *gs_effect_get_param_by_idx(const gs_effect_t *effect, size_t param)
 	return params + param;
 }
 
-gs_eparam_t *gs_effect_get_param_by_name(const gs_effect_t *effect, const char *name)
+static gs_eparam_t *find_param(const gs_effect_t *effect, const char *name)
 {
-	if (!effect)
-		return NULL;
-
 	struct gs_effect_param *params = effect->params.array;
 
 	for (size_t i = 0; i < effect->params.num; i++) {
@@ -289,6 +287,41 @@ gs_eparam_t *gs_effect_get_param_by_name(const gs_effect_t *effect, const char *
 	return NULL;
 }
 
+/* Looking up parameters while rendering shows up in the profiler with the
+ * number of lookups per call of the enclosing scope, which makes it easy to
+ * find code that should look up its parameters once with
+ * gs_effect_get_params instead.  Lookups outside of a scene are not profiled,
+ * as there is no enclosing scope to count them in. */
+static const char *param_lookup_name = "gs_effect_get_param_by_name";
+
+gs_eparam_t *gs_effect_get_param_by_name(const gs_effect_t *effect, const char *name)
+{
+	if (!effect)
+		return NULL;
+
+	graphics_t *graphics = gs_get_context();
+	if (!graphics || !graphics->scene_depth)
+		return find_param(effect, name);
+
+	profile_start(param_lookup_name);
+	gs_eparam_t *param = find_param(effect, name);
+	profile_end(param_lookup_name);
+	return param;
+}
+
+bool gs_effect_get_params(const gs_effect_t *effect, const struct gs_effect_param_ref *refs, size_t count)
+{
+	bool found_all = true;
+
+	for (size_t i = 0; i < count; i++) {
+		*refs[i].param = effect ? find_param(effect, refs[i].name) : NULL;
+		if (!*refs[i].param)
+			found_all = false;
+	}
+
+	return found_all;
+}
+
 size_t gs_param_get_num_annotations(const gs_eparam_t *param)
 {
 	return param ? param->annotations.num : 0;
@@ -218,6 +218,10 @@ struct gs_exports {
 
 	uint32_t (*gs_get_adapter_count)(void);
 
+	bool (*gs_stagesurface_is_ready)(gs_stagesurf_t *stagesurf);
+
+	void (*device_set_shader_cache_path)(gs_device_t *device, const char *path);
+
 #ifdef __APPLE__
 	/* OSX/Cocoa specific functions */
 	gs_texture_t *(*device_texture_create_from_iosurface)(gs_device_t *dev, void *iosurf);
@@ -297,6 +301,15 @@ struct blend_state {
 	enum gs_blend_op_type op;
 };
 
+struct gs_texrender_pool_target {
+	gs_texture_t *target;
+	gs_zstencil_t *zs;
+	uint32_t cx, cy;
+	enum gs_color_format format;
+	enum gs_zstencil_format zsformat;
+	uint64_t last_used_frame;
+};
+
 struct graphics_subsystem {
 	void *module;
 	gs_device_t *device;
@@ -332,4 +345,16 @@ struct graphics_subsystem {
 	DARRAY(struct blend_state) blend_state_stack;
 
 	bool linear_srgb;
+
+	/* used to profile effect parameter lookups while rendering */
+	int scene_depth;
+
+	/* render targets not currently used by pooled texrenders */
+	pthread_mutex_t texrender_pool_mutex;
+	DARRAY(struct gs_texrender_pool_target) texrender_pool;
+	struct gs_texrender_pool_stats texrender_pool_stats;
+	uint64_t texrender_pool_frame;
 };
+
+extern void gs_texrender_pool_begin_frame(graphics_t *graphics);
+extern void gs_texrender_pool_free(graphics_t *graphics);
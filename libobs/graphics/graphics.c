@@ -87,6 +87,18 @@ void gs_enum_adapters(bool (*callback)(void *param, const char *name, uint32_t i
 	callback(param, "Default", 0);
 }
 
+void gs_set_shader_cache_path(const char *path)
+{
+	graphics_t *graphics = thread_graphics;
+
+	if (!gs_valid("gs_set_shader_cache_path"))
+		return;
+
+	/* subsystems without a shader cache ignore this */
+	if (graphics->exports.device_set_shader_cache_path)
+		graphics->exports.device_set_shader_cache_path(graphics->device, path);
+}
+
 extern void gs_init_image_deps(void);
 extern void gs_free_image_deps(void);
 
@@ -176,6 +188,8 @@ static bool graphics_init(struct graphics_subsystem *graphics)
 		return false;
 	if (pthread_mutex_init(&graphics->effect_mutex, NULL) != 0)
 		return false;
+	if (pthread_mutex_init(&graphics->texrender_pool_mutex, NULL) != 0)
+		return false;
 
 	graphics->exports.device_blend_function_separate(graphics->device, GS_BLEND_SRCALPHA, GS_BLEND_INVSRCALPHA,
 							 GS_BLEND_ONE, GS_BLEND_INVSRCALPHA);
@@ -202,6 +216,7 @@ int gs_create(graphics_t **pgraphics, const char *module, uint32_t adapter)
 	graphics_t *graphics = bzalloc(sizeof(struct graphics_subsystem));
 	pthread_mutex_init_value(&graphics->mutex);
 	pthread_mutex_init_value(&graphics->effect_mutex);
+	pthread_mutex_init_value(&graphics->texrender_pool_mutex);
 
 	graphics->module = os_dlopen(module);
 	if (!graphics->module) {
@@ -251,6 +266,8 @@ void gs_destroy(graphics_t *graphics)
 			effect = next;
 		}
 
+		gs_texrender_pool_free(graphics);
+
 		graphics->exports.gs_vertexbuffer_destroy(graphics->subregion_buffer);
 		graphics->exports.gs_vertexbuffer_destroy(graphics->flipped_sprite_buffer);
 		graphics->exports.gs_vertexbuffer_destroy(graphics->sprite_buffer);
@@ -262,6 +279,7 @@ void gs_destroy(graphics_t *graphics)
 
 	pthread_mutex_destroy(&graphics->mutex);
 	pthread_mutex_destroy(&graphics->effect_mutex);
+	pthread_mutex_destroy(&graphics->texrender_pool_mutex);
 	da_free(graphics->matrix_stack);
 	da_free(graphics->viewport_stack);
 	da_free(graphics->blend_state_stack);
@@ -1917,6 +1935,7 @@ void gs_begin_frame(void)
 		return;
 
 	graphics->exports.device_begin_frame(graphics->device);
+	gs_texrender_pool_begin_frame(graphics);
 }
 
 void gs_begin_scene(void)
@@ -1926,6 +1945,7 @@ void gs_begin_scene(void)
 	if (!gs_valid("gs_begin_scene"))
 		return;
 
+	graphics->scene_depth++;
 	graphics->exports.device_begin_scene(graphics->device);
 }
 
@@ -1947,6 +1967,7 @@ void gs_end_scene(void)
 		return;
 
 	graphics->exports.device_end_scene(graphics->device);
+	graphics->scene_depth--;
 }
 
 void gs_load_swapchain(gs_swapchain_t *swapchain)
@@ -2646,6 +2667,20 @@ void gs_stagesurface_unmap(gs_stagesurf_t *stagesurf)
 	graphics->exports.gs_stagesurface_unmap(stagesurf);
 }
 
+bool gs_stagesurface_is_ready(gs_stagesurf_t *stagesurf)
+{
+	graphics_t *graphics = thread_graphics;
+
+	if (!gs_valid_p("gs_stagesurface_is_ready", stagesurf))
+		return false;
+
+	/* without a way to check, mapping is assumed not to wait */
+	if (!graphics->exports.gs_stagesurface_is_ready)
+		return true;
+
+	return graphics->exports.gs_stagesurface_is_ready(stagesurf);
+}
+
 void gs_zstencil_destroy(gs_zstencil_t *zstencil)
 {
 	if (!gs_valid("gs_zstencil_destroy"))
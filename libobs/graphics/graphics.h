@@ -384,6 +384,12 @@ struct gs_effect_param_info {
 
 	float min, max, inc, mul; */
 };
+
+/* name of a parameter and where to store it, for gs_effect_get_params */
+struct gs_effect_param_ref {
+	const char *name;
+	gs_eparam_t **param;
+};
 #endif
 
 EXPORT void gs_effect_destroy(gs_effect_t *effect);
@@ -403,6 +409,9 @@ EXPORT gs_epass_t *gs_technique_get_pass_by_name(const gs_technique_t *technique
 EXPORT size_t gs_effect_get_num_params(const gs_effect_t *effect);
 EXPORT gs_eparam_t *gs_effect_get_param_by_idx(const gs_effect_t *effect, size_t param);
 EXPORT gs_eparam_t *gs_effect_get_param_by_name(const gs_effect_t *effect, const char *name);
+#ifndef SWIG
+EXPORT bool gs_effect_get_params(const gs_effect_t *effect, const struct gs_effect_param_ref *refs, size_t count);
+#endif
 EXPORT size_t gs_param_get_num_annotations(const gs_eparam_t *param);
 EXPORT gs_eparam_t *gs_param_get_annotation_by_idx(const gs_eparam_t *param, size_t annotation);
 EXPORT gs_eparam_t *gs_param_get_annotation_by_name(const gs_eparam_t *param, const char *name);
@@ -446,6 +455,11 @@ EXPORT void gs_effect_set_color(gs_eparam_t *param, uint32_t argb);
  * --------------------------------------------------- */
 
 EXPORT gs_texrender_t *gs_texrender_create(enum gs_color_format format, enum gs_zstencil_format zsformat);
+/* Pooled texrenders borrow their render target from a pool shared with other
+ * pooled texrenders when they are rendered to, and return it when they are
+ * reset or destroyed.  Only use them if the texture is not needed after the
+ * next reset, such as for intermediate textures that are reset every frame. */
+EXPORT gs_texrender_t *gs_texrender_create_pooled(enum gs_color_format format, enum gs_zstencil_format zsformat);
 EXPORT void gs_texrender_destroy(gs_texrender_t *texrender);
 EXPORT bool gs_texrender_begin(gs_texrender_t *texrender, uint32_t cx, uint32_t cy);
 EXPORT bool gs_texrender_begin_with_color_space(gs_texrender_t *texrender, uint32_t cx, uint32_t cy,
@@ -455,6 +469,18 @@ EXPORT void gs_texrender_reset(gs_texrender_t *texrender);
 EXPORT gs_texture_t *gs_texrender_get_texture(const gs_texrender_t *texrender);
 EXPORT enum gs_color_format gs_texrender_get_format(const gs_texrender_t *texrender);
 
+#ifndef SWIG
+struct gs_texrender_pool_stats {
+	uint32_t targets_in_use;
+	uint32_t targets_free;
+	uint64_t bytes_in_use;
+	uint64_t bytes_free;
+	uint64_t peak_bytes;
+};
+
+EXPORT void gs_texrender_pool_get_stats(struct gs_texrender_pool_stats *stats);
+#endif
+
 /* ---------------------------------------------------
  * graphics subsystem
  * --------------------------------------------------- */
@@ -509,6 +535,7 @@ EXPORT uint64_t gs_get_gpu_smem(void);
 EXPORT int gs_get_device_type(void);
 EXPORT uint32_t gs_get_adapter_count(void);
 EXPORT void gs_enum_adapters(bool (*callback)(void *param, const char *name, uint32_t id), void *param);
+EXPORT void gs_set_shader_cache_path(const char *path);
 
 EXPORT int gs_create(graphics_t **graphics, const char *module, uint32_t adapter);
 EXPORT void gs_destroy(graphics_t *graphics);
@@ -757,6 +784,7 @@ EXPORT uint32_t gs_stagesurface_get_height(const gs_stagesurf_t *stagesurf);
 EXPORT enum gs_color_format gs_stagesurface_get_color_format(const gs_stagesurf_t *stagesurf);
 EXPORT bool gs_stagesurface_map(gs_stagesurf_t *stagesurf, uint8_t **data, uint32_t *linesize);
 EXPORT void gs_stagesurface_unmap(gs_stagesurf_t *stagesurf);
+EXPORT bool gs_stagesurface_is_ready(gs_stagesurf_t *stagesurf);
 
 EXPORT void gs_zstencil_destroy(gs_zstencil_t *zstencil);
 
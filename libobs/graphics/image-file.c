@@ -19,6 +19,8 @@
 #include "../util/base.h"
 #include "../util/platform.h"
 #include "../util/dstr.h"
+#include "../util/threading.h"
+#include "../util/task.h"
 #include "vec4.h"
 
 #define blog(level, format, ...) blog(level, "%s: " format, __FUNCTION__, __VA_ARGS__)
@@ -69,10 +71,212 @@ static inline void *alloc_mem(gs_image_file_t *image, uint64_t *mem_usage, size_
 	return bzalloc(size);
 }
 
+/* ------------------------------------------------------------------------- */
+/* Bounded-memory gif decoding                                               */
+
+#define GIF_DECODE_AHEAD 4
+#define GIF_MIN_STREAM_SLOTS (GIF_DECODE_AHEAD + 2)
+
+struct gs_image_gif_stream {
+	gs_image_file_t *image;
+	pthread_mutex_t mutex;
+	volatile bool decode_queued;
+	enum gs_image_alpha_mode alpha_mode;
+
+	size_t frame_size;
+	size_t slot_count;
+	uint8_t *slot_data;
+	int *slot_frame;
+	uint64_t *slot_used;
+	uint64_t use_counter;
+};
+
+/* all streamed gifs share a single decode thread, which only exists while at
+ * least one of them is loaded */
+static struct {
+	pthread_mutex_t mutex;
+	os_task_queue_t *queue;
+	long refs;
+} gif_decode = {.mutex = PTHREAD_MUTEX_INITIALIZER};
+
+static os_task_queue_t *gif_decode_queue_acquire(void)
+{
+	os_task_queue_t *queue;
+
+	pthread_mutex_lock(&gif_decode.mutex);
+	if (!gif_decode.queue)
+		gif_decode.queue = os_task_queue_create();
+	if (gif_decode.queue)
+		gif_decode.refs++;
+	queue = gif_decode.queue;
+	pthread_mutex_unlock(&gif_decode.mutex);
+
+	return queue;
+}
+
+static void gif_decode_queue_release(void)
+{
+	os_task_queue_t *queue = NULL;
+
+	pthread_mutex_lock(&gif_decode.mutex);
+	if (--gif_decode.refs == 0) {
+		queue = gif_decode.queue;
+		gif_decode.queue = NULL;
+	}
+	pthread_mutex_unlock(&gif_decode.mutex);
+
+	os_task_queue_destroy(queue);
+}
+
+static bool decode_frame_image(gs_image_file_t *image, int new_frame, enum gs_image_alpha_mode alpha_mode);
+
+static struct gs_image_gif_stream *gif_stream_create(gs_image_file_t *image, uint64_t *mem_usage, uint64_t budget,
+						     enum gs_image_alpha_mode alpha_mode)
+{
+	struct gs_image_gif_stream *stream = bzalloc(sizeof(*stream));
+	size_t frame_size = (size_t)image->gif.width * image->gif.height * 4;
+	uint64_t slot_count = budget / frame_size;
+
+	if (slot_count < GIF_MIN_STREAM_SLOTS)
+		slot_count = GIF_MIN_STREAM_SLOTS;
+	if (slot_count > image->gif.frame_count)
+		slot_count = image->gif.frame_count;
+
+	if (pthread_mutex_init(&stream->mutex, NULL) != 0) {
+		bfree(stream);
+		return NULL;
+	}
+
+	if (!gif_decode_queue_acquire()) {
+		pthread_mutex_destroy(&stream->mutex);
+		bfree(stream);
+		return NULL;
+	}
+
+	stream->image = image;
+	stream->alpha_mode = alpha_mode;
+	stream->frame_size = frame_size;
+	stream->slot_count = (size_t)slot_count;
+	stream->slot_data = alloc_mem(image, mem_usage, stream->slot_count * frame_size);
+	stream->slot_frame = bmalloc(stream->slot_count * sizeof(int));
+	stream->slot_used = bzalloc(stream->slot_count * sizeof(uint64_t));
+
+	for (size_t i = 0; i < stream->slot_count; i++)
+		stream->slot_frame[i] = -1;
+
+	return stream;
+}
+
+static void gif_stream_destroy(struct gs_image_gif_stream *stream)
+{
+	if (!stream)
+		return;
+
+	/* the shared queue runs tasks in order, so once a task queued after
+	 * this stream's decode has run, the decode is done too */
+	if (os_atomic_load_bool(&stream->decode_queued))
+		os_task_queue_wait(gif_decode.queue);
+
+	gif_decode_queue_release();
+	pthread_mutex_destroy(&stream->mutex);
+	bfree(stream->slot_data);
+	bfree(stream->slot_frame);
+	bfree(stream->slot_used);
+	bfree(stream);
+}
+
+static inline void gif_stream_touch(struct gs_image_gif_stream *stream, const uint8_t *data)
+{
+	size_t slot = (size_t)(data - stream->slot_data) / stream->frame_size;
+	stream->slot_used[slot] = ++stream->use_counter;
+}
+
+/* finds an empty slot, or evicts the least recently used frame.  the frame
+ * currently being displayed is never evicted. */
+static size_t gif_stream_get_slot(struct gs_image_gif_stream *stream)
+{
+	gs_image_file_t *image = stream->image;
+	size_t lru = SIZE_MAX;
+
+	for (size_t i = 0; i < stream->slot_count; i++) {
+		int frame = stream->slot_frame[i];
+
+		if (frame == -1)
+			return i;
+		if (frame == image->cur_frame)
+			continue;
+		if (lru == SIZE_MAX || stream->slot_used[i] < stream->slot_used[lru])
+			lru = i;
+	}
+
+	image->animation_frame_cache[stream->slot_frame[lru]] = NULL;
+	stream->slot_frame[lru] = -1;
+	return lru;
+}
+
+/* must be called with the stream mutex locked */
+static uint8_t *gif_stream_decode_frame(struct gs_image_gif_stream *stream, int frame)
+{
+	gs_image_file_t *image = stream->image;
+	uint8_t *data = image->animation_frame_cache[frame];
+	size_t slot;
+
+	if (data) {
+		gif_stream_touch(stream, data);
+		return data;
+	}
+
+	if (!decode_frame_image(image, frame, stream->alpha_mode))
+		return NULL;
+
+	slot = gif_stream_get_slot(stream);
+	data = stream->slot_data + slot * stream->frame_size;
+	memcpy(data, image->gif.frame_image, stream->frame_size);
+
+	stream->slot_frame[slot] = frame;
+	stream->slot_used[slot] = ++stream->use_counter;
+	image->animation_frame_cache[frame] = data;
+	return data;
+}
+
+static void gif_stream_decode_ahead(void *param)
+{
+	struct gs_image_gif_stream *stream = param;
+	gs_image_file_t *image = stream->image;
+	const int frame_count = (int)image->gif.frame_count;
+
+	/* the lock is released between frames so that the tick is never
+	 * stuck waiting for more than a single frame decode */
+	for (int i = 1; i <= GIF_DECODE_AHEAD; i++) {
+		pthread_mutex_lock(&stream->mutex);
+		int frame = (image->cur_frame + i) % frame_count;
+		if (!image->animation_frame_cache[frame])
+			gif_stream_decode_frame(stream, frame);
+		pthread_mutex_unlock(&stream->mutex);
+	}
+
+	os_atomic_set_bool(&stream->decode_queued, false);
+}
+
+static void gif_stream_set_frame(struct gs_image_gif_stream *stream, int new_frame)
+{
+	pthread_mutex_lock(&stream->mutex);
+	gif_stream_decode_frame(stream, new_frame);
+	stream->image->cur_frame = new_frame;
+	pthread_mutex_unlock(&stream->mutex);
+
+	if (!os_atomic_exchange_bool(&stream->decode_queued, true))
+		os_task_queue_queue_task(gif_decode.queue, gif_stream_decode_ahead, stream);
+}
+
+/* ------------------------------------------------------------------------- */
+
 static bool init_animated_gif(gs_image_file_t *image, const char *path, uint64_t *mem_usage,
-			      enum gs_image_alpha_mode alpha_mode)
+			      enum gs_image_alpha_mode alpha_mode, uint64_t gif_memory_budget,
+			      struct gs_image_gif_stream **stream)
 {
 	bool is_animated_gif = true;
+	bool streamed;
 	gif_result result;
 	uint64_t max_size;
 	size_t size, size_read;
@@ -121,8 +325,9 @@ static bool init_animated_gif(gs_image_file_t *image, const char *path, uint64_t
 	}
 
 	max_size = (uint64_t)image->gif.width * (uint64_t)image->gif.height * (uint64_t)image->gif.frame_count * 4LLU;
+	streamed = gif_memory_budget && max_size > gif_memory_budget;
 
-	if ((uint64_t)get_full_decoded_gif_size(image) != max_size) {
+	if (!streamed && (uint64_t)get_full_decoded_gif_size(image) != max_size) {
 		blog(LOG_WARNING, "Gif '%s' overflowed maximum pointer size", path);
 		goto fail;
 	}
@@ -132,7 +337,19 @@ static bool init_animated_gif(gs_image_file_t *image, const char *path, uint64_t
 		gif_decode_frame(&image->gif, 0);
 
 		image->animation_frame_cache = alloc_mem(image, mem_usage, image->gif.frame_count * sizeof(uint8_t *));
-		image->animation_frame_data = alloc_mem(image, mem_usage, get_full_decoded_gif_size(image));
+
+		if (streamed) {
+			*stream = gif_stream_create(image, mem_usage, gif_memory_budget, alpha_mode);
+			if (!*stream) {
+				blog(LOG_WARNING, "Failed to create gif decode thread for '%s'", path);
+				gif_finalise(&image->gif);
+				bfree(image->animation_frame_cache);
+				image->animation_frame_cache = NULL;
+				goto fail;
+			}
+		} else {
+			image->animation_frame_data = alloc_mem(image, mem_usage, get_full_decoded_gif_size(image));
+		}
 
 		for (unsigned int i = 0; i < image->gif.frame_count; i++) {
 			if (gif_decode_frame(&image->gif, i) != GIF_OK)
@@ -179,7 +396,8 @@ not_animated:
 }
 
 static void gs_image_file_init_internal(gs_image_file_t *image, const char *file, uint64_t *mem_usage,
-					enum gs_color_space *space, enum gs_image_alpha_mode alpha_mode)
+					enum gs_color_space *space, enum gs_image_alpha_mode alpha_mode,
+					uint64_t gif_memory_budget, struct gs_image_gif_stream **stream)
 {
 	size_t len;
 
@@ -194,7 +412,7 @@ static void gs_image_file_init_internal(gs_image_file_t *image, const char *file
 	len = strlen(file);
 
 	if (len > 4 && astrcmpi(file + len - 4, ".gif") == 0) {
-		if (init_animated_gif(image, file, mem_usage, alpha_mode)) {
+		if (init_animated_gif(image, file, mem_usage, alpha_mode, gif_memory_budget, stream)) {
 			return;
 		}
 	}
@@ -216,7 +434,7 @@ static void gs_image_file_init_internal(gs_image_file_t *image, const char *file
 void gs_image_file_init(gs_image_file_t *image, const char *file)
 {
 	enum gs_color_space unused;
-	gs_image_file_init_internal(image, file, NULL, &unused, GS_IMAGE_ALPHA_STRAIGHT);
+	gs_image_file_init_internal(image, file, NULL, &unused, GS_IMAGE_ALPHA_STRAIGHT, 0, NULL);
 }
 
 void gs_image_file_free(gs_image_file_t *image)
@@ -242,23 +460,47 @@ void gs_image_file_free(gs_image_file_t *image)
 void gs_image_file2_init(gs_image_file2_t *if2, const char *file)
 {
 	enum gs_color_space unused;
-	gs_image_file_init_internal(&if2->image, file, &if2->mem_usage, &unused, GS_IMAGE_ALPHA_STRAIGHT);
+	gs_image_file_init_internal(&if2->image, file, &if2->mem_usage, &unused, GS_IMAGE_ALPHA_STRAIGHT, 0, NULL);
 }
 
 void gs_image_file3_init(gs_image_file3_t *if3, const char *file, enum gs_image_alpha_mode alpha_mode)
 {
 	enum gs_color_space unused;
-	gs_image_file_init_internal(&if3->image2.image, file, &if3->image2.mem_usage, &unused, alpha_mode);
+	gs_image_file_init_internal(&if3->image2.image, file, &if3->image2.mem_usage, &unused, alpha_mode, 0, NULL);
 	if3->alpha_mode = alpha_mode;
 }
 
 void gs_image_file4_init(gs_image_file4_t *if4, const char *file, enum gs_image_alpha_mode alpha_mode)
 {
 	gs_image_file_init_internal(&if4->image3.image2.image, file, &if4->image3.image2.mem_usage, &if4->space,
-				    alpha_mode);
+				    alpha_mode, 0, NULL);
 	if4->image3.alpha_mode = alpha_mode;
 }
 
+void gs_image_file5_init(gs_image_file5_t *if5, const char *file, enum gs_image_alpha_mode alpha_mode)
+{
+	gs_image_file5_init_budget(if5, file, alpha_mode, GS_IMAGE_FILE_GIF_MEMORY_BUDGET);
+}
+
+void gs_image_file5_init_budget(gs_image_file5_t *if5, const char *file, enum gs_image_alpha_mode alpha_mode,
+				uint64_t gif_memory_budget)
+{
+	gs_image_file4_t *if4 = &if5->image4;
+
+	if5->gif_stream = NULL;
+	gs_image_file_init_internal(&if4->image3.image2.image, file, &if4->image3.image2.mem_usage, &if4->space,
+				    alpha_mode, gif_memory_budget, &if5->gif_stream);
+	if4->image3.alpha_mode = alpha_mode;
+}
+
+void gs_image_file5_free(gs_image_file5_t *if5)
+{
+	/* stop decoding ahead before the gif itself goes away */
+	gif_stream_destroy(if5->gif_stream);
+	if5->gif_stream = NULL;
+	gs_image_file4_free(&if5->image4);
+}
+
 void gs_image_file_init_texture(gs_image_file_t *image)
 {
 	if (!image->loaded)
@@ -308,43 +550,60 @@ static inline int calculate_new_frame(gs_image_file_t *image, uint64_t elapsed_t
 	return new_frame;
 }
 
-static void decode_new_frame(gs_image_file_t *image, int new_frame, enum gs_image_alpha_mode alpha_mode)
+/* decodes new_frame into gif.frame_image, decoding any frames in between */
+static bool decode_frame_image(gs_image_file_t *image, int new_frame, enum gs_image_alpha_mode alpha_mode)
 {
-	if (!image->animation_frame_cache[new_frame]) {
-		int last_frame;
+	const size_t area = (size_t)image->gif.width * image->gif.height;
+	int last_frame;
 
-		/* if looped, decode frame 0 */
-		last_frame = (new_frame < image->last_decoded_frame) ? 0 : image->last_decoded_frame + 1;
+	/* already decoded (and premultiplied) */
+	if (new_frame == image->last_decoded_frame && new_frame == image->gif.decoded_frame)
+		return true;
 
-		/* decode missed frames */
-		for (int i = last_frame; i < new_frame; i++) {
-			if (gif_decode_frame(&image->gif, i) != GIF_OK)
-				return;
-		}
+	/* if looped, decode frame 0 */
+	last_frame = (new_frame < image->last_decoded_frame) ? 0 : image->last_decoded_frame + 1;
 
-		/* decode actual desired frame */
-		if (gif_decode_frame(&image->gif, new_frame) == GIF_OK) {
-			const size_t area = (size_t)image->gif.width * image->gif.height;
-			size_t pos = new_frame * area * 4;
-			image->animation_frame_cache[new_frame] = image->animation_frame_data + pos;
+	/* decode missed frames */
+	for (int i = last_frame; i < new_frame; i++) {
+		if (gif_decode_frame(&image->gif, i) != GIF_OK)
+			return false;
+	}
 
-			if (alpha_mode == GS_IMAGE_ALPHA_PREMULTIPLY_SRGB) {
-				gs_premultiply_xyza_srgb_loop(image->gif.frame_image, area);
-			} else if (alpha_mode == GS_IMAGE_ALPHA_PREMULTIPLY) {
-				gs_premultiply_xyza_loop(image->gif.frame_image, area);
-			}
+	/* decode actual desired frame */
+	if (gif_decode_frame(&image->gif, new_frame) != GIF_OK)
+		return false;
 
-			memcpy(image->animation_frame_cache[new_frame], image->gif.frame_image, area * 4);
+	if (alpha_mode == GS_IMAGE_ALPHA_PREMULTIPLY_SRGB) {
+		gs_premultiply_xyza_srgb_loop(image->gif.frame_image, area);
+	} else if (alpha_mode == GS_IMAGE_ALPHA_PREMULTIPLY) {
+		gs_premultiply_xyza_loop(image->gif.frame_image, area);
+	}
 
-			image->last_decoded_frame = new_frame;
-		}
+	image->last_decoded_frame = new_frame;
+	return true;
+}
+
+static void decode_new_frame(gs_image_file_t *image, struct gs_image_gif_stream *stream, int new_frame,
+			     enum gs_image_alpha_mode alpha_mode)
+{
+	if (stream) {
+		gif_stream_set_frame(stream, new_frame);
+		return;
+	}
+
+	if (!image->animation_frame_cache[new_frame] && decode_frame_image(image, new_frame, alpha_mode)) {
+		const size_t size = (size_t)image->gif.width * image->gif.height * 4;
+		uint8_t *data = image->animation_frame_data + new_frame * size;
+
+		memcpy(data, image->gif.frame_image, size);
+		image->animation_frame_cache[new_frame] = data;
 	}
 
 	image->cur_frame = new_frame;
 }
 
-static bool gs_image_file_tick_internal(gs_image_file_t *image, uint64_t elapsed_time_ns,
-					enum gs_image_alpha_mode alpha_mode)
+static bool gs_image_file_tick_internal(gs_image_file_t *image, struct gs_image_gif_stream *stream,
+					uint64_t elapsed_time_ns, enum gs_image_alpha_mode alpha_mode)
 {
 	int loops;
 
@@ -359,7 +618,7 @@ static bool gs_image_file_tick_internal(gs_image_file_t *image, uint64_t elapsed
 		int new_frame = calculate_new_frame(image, elapsed_time_ns, loops);
 
 		if (new_frame != image->cur_frame) {
-			decode_new_frame(image, new_frame, alpha_mode);
+			decode_new_frame(image, stream, new_frame, alpha_mode);
 			return true;
 		}
 	}
@@ -369,31 +628,67 @@ static bool gs_image_file_tick_internal(gs_image_file_t *image, uint64_t elapsed
 
 bool gs_image_file_tick(gs_image_file_t *image, uint64_t elapsed_time_ns)
 {
-	return gs_image_file_tick_internal(image, elapsed_time_ns, false);
+	return gs_image_file_tick_internal(image, NULL, elapsed_time_ns, false);
 }
 
 bool gs_image_file2_tick(gs_image_file2_t *if2, uint64_t elapsed_time_ns)
 {
-	return gs_image_file_tick_internal(&if2->image, elapsed_time_ns, false);
+	return gs_image_file_tick_internal(&if2->image, NULL, elapsed_time_ns, false);
 }
 
 bool gs_image_file3_tick(gs_image_file3_t *if3, uint64_t elapsed_time_ns)
 {
-	return gs_image_file_tick_internal(&if3->image2.image, elapsed_time_ns, if3->alpha_mode);
+	return gs_image_file_tick_internal(&if3->image2.image, NULL, elapsed_time_ns, if3->alpha_mode);
 }
 
 bool gs_image_file4_tick(gs_image_file4_t *if4, uint64_t elapsed_time_ns)
 {
-	return gs_image_file_tick_internal(&if4->image3.image2.image, elapsed_time_ns, if4->image3.alpha_mode);
+	return gs_image_file_tick_internal(&if4->image3.image2.image, NULL, elapsed_time_ns, if4->image3.alpha_mode);
+}
+
+bool gs_image_file5_tick(gs_image_file5_t *if5, uint64_t elapsed_time_ns)
+{
+	gs_image_file4_t *if4 = &if5->image4;
+	return gs_image_file_tick_internal(&if4->image3.image2.image, if5->gif_stream, elapsed_time_ns,
+					   if4->image3.alpha_mode);
+}
+
+void gs_image_file5_restart(gs_image_file5_t *if5)
+{
+	gs_image_file_t *image = &if5->image4.image3.image2.image;
+
+	if (!image->is_animated_gif || !image->loaded)
+		return;
+
+	image->cur_loop = 0;
+	image->cur_time = 0;
+
+	/* the decode-ahead task reads cur_frame under the stream mutex */
+	if (if5->gif_stream)
+		gif_stream_set_frame(if5->gif_stream, 0);
+	else
+		image->cur_frame = 0;
 }
 
-static void gs_image_file_update_texture_internal(gs_image_file_t *image, enum gs_image_alpha_mode alpha_mode)
+static void gs_image_file_update_texture_internal(gs_image_file_t *image, struct gs_image_gif_stream *stream,
+						  enum gs_image_alpha_mode alpha_mode)
 {
 	if (!image->is_animated_gif || !image->loaded)
 		return;
 
+	if (stream) {
+		uint8_t *data;
+
+		pthread_mutex_lock(&stream->mutex);
+		data = gif_stream_decode_frame(stream, image->cur_frame);
+		if (data)
+			gs_texture_set_image(image->texture, data, image->gif.width * 4, false);
+		pthread_mutex_unlock(&stream->mutex);
+		return;
+	}
+
 	if (!image->animation_frame_cache[image->cur_frame])
-		decode_new_frame(image, image->cur_frame, alpha_mode);
+		decode_new_frame(image, NULL, image->cur_frame, alpha_mode);
 
 	gs_texture_set_image(image->texture, image->animation_frame_cache[image->cur_frame], image->gif.width * 4,
 			     false);
@@ -401,20 +696,26 @@ static void gs_image_file_update_texture_internal(gs_image_file_t *image, enum g
 
 void gs_image_file_update_texture(gs_image_file_t *image)
 {
-	gs_image_file_update_texture_internal(image, false);
+	gs_image_file_update_texture_internal(image, NULL, false);
 }
 
 void gs_image_file2_update_texture(gs_image_file2_t *if2)
 {
-	gs_image_file_update_texture_internal(&if2->image, false);
+	gs_image_file_update_texture_internal(&if2->image, NULL, false);
 }
 
 void gs_image_file3_update_texture(gs_image_file3_t *if3)
 {
-	gs_image_file_update_texture_internal(&if3->image2.image, if3->alpha_mode);
+	gs_image_file_update_texture_internal(&if3->image2.image, NULL, if3->alpha_mode);
 }
 
 void gs_image_file4_update_texture(gs_image_file4_t *if4)
 {
-	gs_image_file_update_texture_internal(&if4->image3.image2.image, if4->image3.alpha_mode);
+	gs_image_file_update_texture_internal(&if4->image3.image2.image, NULL, if4->image3.alpha_mode);
+}
+
+void gs_image_file5_update_texture(gs_image_file5_t *if5)
+{
+	gs_image_file4_t *if4 = &if5->image4;
+	gs_image_file_update_texture_internal(&if4->image3.image2.image, if5->gif_stream, if4->image3.alpha_mode);
 }
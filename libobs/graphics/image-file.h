@@ -61,10 +61,25 @@ struct gs_image_file4 {
 	enum gs_color_space space;
 };
 
+/* Animated gifs loaded through gs_image_file5 whose fully decoded frames
+ * would take more memory than this are not decoded up front.  Instead, only
+ * the compressed data is kept, and frames are decoded a few at a time ahead
+ * of playback into a fixed number of frame buffers that are recycled in
+ * least-recently-used order. */
+#define GS_IMAGE_FILE_GIF_MEMORY_BUDGET (256ULL * 1024ULL * 1024ULL)
+
+struct gs_image_gif_stream;
+
+struct gs_image_file5 {
+	struct gs_image_file4 image4;
+	struct gs_image_gif_stream *gif_stream;
+};
+
 typedef struct gs_image_file gs_image_file_t;
 typedef struct gs_image_file2 gs_image_file2_t;
 typedef struct gs_image_file3 gs_image_file3_t;
 typedef struct gs_image_file4 gs_image_file4_t;
+typedef struct gs_image_file5 gs_image_file5_t;
 
 EXPORT void gs_image_file_init(gs_image_file_t *image, const char *file);
 EXPORT void gs_image_file_free(gs_image_file_t *image);
@@ -88,6 +103,24 @@ EXPORT void gs_image_file4_init(gs_image_file4_t *if4, const char *file, enum gs
 EXPORT bool gs_image_file4_tick(gs_image_file4_t *if4, uint64_t elapsed_time_ns);
 EXPORT void gs_image_file4_update_texture(gs_image_file4_t *if4);
 
+EXPORT void gs_image_file5_init(gs_image_file5_t *if5, const char *file, enum gs_image_alpha_mode alpha_mode);
+
+/**
+ * Same as gs_image_file5_init, but with a custom limit (in bytes) for the
+ * decoded frames of animated gifs.  A budget of 0 always decodes every frame
+ * up front.
+ */
+EXPORT void gs_image_file5_init_budget(gs_image_file5_t *if5, const char *file, enum gs_image_alpha_mode alpha_mode,
+				       uint64_t gif_memory_budget);
+EXPORT void gs_image_file5_free(gs_image_file5_t *if5);
+
+EXPORT bool gs_image_file5_tick(gs_image_file5_t *if5, uint64_t elapsed_time_ns);
+
+/** Goes back to the first frame and loop of an animated gif, call
+ * gs_image_file5_update_texture afterwards to show it */
+EXPORT void gs_image_file5_restart(gs_image_file5_t *if5);
+EXPORT void gs_image_file5_update_texture(gs_image_file5_t *if5);
+
 static inline void gs_image_file2_free(gs_image_file2_t *if2)
 {
 	gs_image_file_free(&if2->image);
@@ -119,6 +152,11 @@ static inline void gs_image_file4_init_texture(gs_image_file4_t *if4)
 	gs_image_file3_init_texture(&if4->image3);
 }
 
+static inline void gs_image_file5_init_texture(gs_image_file5_t *if5)
+{
+	gs_image_file4_init_texture(&if5->image4);
+}
+
 #ifdef __cplusplus
 }
 #endif
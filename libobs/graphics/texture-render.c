@@ -21,7 +21,11 @@
  */
 
 #include <assert.h>
-#include "graphics.h"
+#include "graphics-internal.h"
+
+/* pooled render targets that have not been used for this many frames are
+ * destroyed */
+#define POOL_MAX_IDLE_FRAMES 120
 
 struct gs_texture_render {
 	gs_texture_t *target, *prev_target;
@@ -34,6 +38,11 @@ struct gs_texture_render {
 	enum gs_zstencil_format zsformat;
 
 	bool rendered;
+
+	/* pooled texrenders only hold a render target from the time they are
+	 * rendered to until they are reset */
+	graphics_t *graphics;
+	bool pooled;
 };
 
 gs_texrender_t *gs_texrender_create(enum gs_color_format format, enum gs_zstencil_format zsformat)
@@ -46,11 +55,208 @@ gs_texrender_t *gs_texrender_create(enum gs_color_format format, enum gs_zstenci
 	return texrender;
 }
 
+gs_texrender_t *gs_texrender_create_pooled(enum gs_color_format format, enum gs_zstencil_format zsformat)
+{
+	struct gs_texture_render *texrender = gs_texrender_create(format, zsformat);
+	texrender->pooled = true;
+	return texrender;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static uint64_t get_zstencil_size(enum gs_zstencil_format zsformat)
+{
+	switch (zsformat) {
+	case GS_Z16:
+		return 2;
+	case GS_Z24_S8:
+	case GS_Z32F:
+		return 4;
+	case GS_Z32F_S8X24:
+		return 8;
+	case GS_ZS_NONE:
+		break;
+	}
+
+	return 0;
+}
+
+static uint64_t get_target_size(const struct gs_texrender_pool_target *pt)
+{
+	const uint64_t pixels = (uint64_t)pt->cx * pt->cy;
+	return pixels * gs_get_format_bpp(pt->format) / 8 + pixels * get_zstencil_size(pt->zsformat);
+}
+
+static inline void destroy_pool_target(struct gs_texrender_pool_target *pt)
+{
+	gs_texture_destroy(pt->target);
+	gs_zstencil_destroy(pt->zs);
+}
+
+static bool pool_acquire(gs_texrender_t *texrender, uint32_t cx, uint32_t cy)
+{
+	graphics_t *graphics = gs_get_context();
+	struct gs_texrender_pool_target pt = {0};
+	bool found = false;
+
+	if (!graphics)
+		return false;
+
+	struct gs_texrender_pool_stats *stats = &graphics->texrender_pool_stats;
+
+	/* the target is returned to the pool it came from even if released
+	 * outside of the graphics context */
+	texrender->graphics = graphics;
+
+	pthread_mutex_lock(&graphics->texrender_pool_mutex);
+
+	/* most recently released targets are at the end */
+	for (size_t i = graphics->texrender_pool.num; i > 0; i--) {
+		struct gs_texrender_pool_target *cur = graphics->texrender_pool.array + (i - 1);
+
+		if (cur->cx == cx && cur->cy == cy && cur->format == texrender->format &&
+		    cur->zsformat == texrender->zsformat) {
+			pt = *cur;
+			da_erase(graphics->texrender_pool, i - 1);
+
+			stats->targets_free--;
+			stats->bytes_free -= get_target_size(&pt);
+			found = true;
+			break;
+		}
+	}
+
+	pthread_mutex_unlock(&graphics->texrender_pool_mutex);
+
+	if (!found) {
+		pt.cx = cx;
+		pt.cy = cy;
+		pt.format = texrender->format;
+		pt.zsformat = texrender->zsformat;
+		pt.target = gs_texture_create(cx, cy, pt.format, 1, NULL, GS_RENDER_TARGET);
+		if (!pt.target)
+			return false;
+
+		if (pt.zsformat != GS_ZS_NONE) {
+			pt.zs = gs_zstencil_create(cx, cy, pt.zsformat);
+			if (!pt.zs) {
+				gs_texture_destroy(pt.target);
+				return false;
+			}
+		}
+	}
+
+	pthread_mutex_lock(&graphics->texrender_pool_mutex);
+	stats->targets_in_use++;
+	stats->bytes_in_use += get_target_size(&pt);
+	if (stats->bytes_in_use + stats->bytes_free > stats->peak_bytes)
+		stats->peak_bytes = stats->bytes_in_use + stats->bytes_free;
+	pthread_mutex_unlock(&graphics->texrender_pool_mutex);
+
+	texrender->target = pt.target;
+	texrender->zs = pt.zs;
+	texrender->cx = cx;
+	texrender->cy = cy;
+	return true;
+}
+
+/* does not need the graphics context, textures are only destroyed when the
+ * pool is trimmed */
+static void pool_release(gs_texrender_t *texrender)
+{
+	graphics_t *graphics = texrender->graphics;
+	struct gs_texrender_pool_target pt = {
+		.target = texrender->target,
+		.zs = texrender->zs,
+		.cx = texrender->cx,
+		.cy = texrender->cy,
+		.format = texrender->format,
+		.zsformat = texrender->zsformat,
+	};
+
+	if (!pt.target)
+		return;
+
+	struct gs_texrender_pool_stats *stats = &graphics->texrender_pool_stats;
+
+	pthread_mutex_lock(&graphics->texrender_pool_mutex);
+	pt.last_used_frame = graphics->texrender_pool_frame;
+	da_push_back(graphics->texrender_pool, &pt);
+
+	stats->targets_in_use--;
+	stats->bytes_in_use -= get_target_size(&pt);
+	stats->targets_free++;
+	stats->bytes_free += get_target_size(&pt);
+	pthread_mutex_unlock(&graphics->texrender_pool_mutex);
+
+	texrender->target = NULL;
+	texrender->zs = NULL;
+	texrender->cx = 0;
+	texrender->cy = 0;
+}
+
+void gs_texrender_pool_begin_frame(graphics_t *graphics)
+{
+	struct gs_texrender_pool_stats *stats = &graphics->texrender_pool_stats;
+	size_t i = 0;
+
+	pthread_mutex_lock(&graphics->texrender_pool_mutex);
+	graphics->texrender_pool_frame++;
+
+	while (i < graphics->texrender_pool.num) {
+		struct gs_texrender_pool_target *pt = graphics->texrender_pool.array + i;
+
+		if (graphics->texrender_pool_frame - pt->last_used_frame > POOL_MAX_IDLE_FRAMES) {
+			stats->targets_free--;
+			stats->bytes_free -= get_target_size(pt);
+			destroy_pool_target(pt);
+			da_erase(graphics->texrender_pool, i);
+		} else {
+			i++;
+		}
+	}
+
+	pthread_mutex_unlock(&graphics->texrender_pool_mutex);
+}
+
+void gs_texrender_pool_free(graphics_t *graphics)
+{
+	const struct gs_texrender_pool_stats *stats = &graphics->texrender_pool_stats;
+
+	if (stats->peak_bytes)
+		blog(LOG_INFO, "Render target pool peak usage: %.1f MB", (double)stats->peak_bytes / (1024.0 * 1024.0));
+	if (stats->targets_in_use)
+		blog(LOG_WARNING, "%u pooled render targets were not released", stats->targets_in_use);
+
+	for (size_t i = 0; i < graphics->texrender_pool.num; i++)
+		destroy_pool_target(graphics->texrender_pool.array + i);
+	da_free(graphics->texrender_pool);
+}
+
+void gs_texrender_pool_get_stats(struct gs_texrender_pool_stats *stats)
+{
+	graphics_t *graphics = gs_get_context();
+
+	memset(stats, 0, sizeof(*stats));
+	if (!graphics)
+		return;
+
+	pthread_mutex_lock(&graphics->texrender_pool_mutex);
+	*stats = graphics->texrender_pool_stats;
+	pthread_mutex_unlock(&graphics->texrender_pool_mutex);
+}
+
+/* ------------------------------------------------------------------------- */
+
 void gs_texrender_destroy(gs_texrender_t *texrender)
 {
 	if (texrender) {
-		gs_texture_destroy(texrender->target);
-		gs_zstencil_destroy(texrender->zs);
+		if (texrender->pooled) {
+			pool_release(texrender);
+		} else {
+			gs_texture_destroy(texrender->target);
+			gs_zstencil_destroy(texrender->zs);
+		}
 		bfree(texrender);
 	}
 }
@@ -60,6 +266,11 @@ static bool texrender_resetbuffer(gs_texrender_t *texrender, uint32_t cx, uint32
 	if (!texrender)
 		return false;
 
+	if (texrender->pooled) {
+		pool_release(texrender);
+		return pool_acquire(texrender, cx, cy);
+	}
+
 	gs_texture_destroy(texrender->target);
 	gs_zstencil_destroy(texrender->zs);
 
@@ -136,8 +347,11 @@ void gs_texrender_end(gs_texrender_t *texrender)
 
 void gs_texrender_reset(gs_texrender_t *texrender)
 {
-	if (texrender)
+	if (texrender) {
 		texrender->rendered = false;
+		if (texrender->pooled)
+			pool_release(texrender);
+	}
 }
 
 gs_texture_t *gs_texrender_get_texture(const gs_texrender_t *texrender)
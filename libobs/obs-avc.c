@@ -18,6 +18,7 @@
 #include "obs-avc.h"
 
 #include "obs.h"
+#include "obs-internal.h"
 #include "obs-nal.h"
 #include "util/array-serializer.h"
 #include "util/bitstream.h"
@@ -92,6 +93,10 @@ void obs_parse_avc_packet(struct encoder_packet *avc_packet, const struct encode
 	struct serializer s;
 	long ref = 1;
 
+	/* another output may already have converted this packet */
+	if (obs_encoder_packet_get_parsed(avc_packet, src))
+		return;
+
 	array_output_serializer_init(&s, &output);
 	*avc_packet = *src;
 
@@ -101,6 +106,8 @@ void obs_parse_avc_packet(struct encoder_packet *avc_packet, const struct encode
 	avc_packet->data = output.bytes.array + sizeof(ref);
 	avc_packet->size = output.bytes.num - sizeof(ref);
 	avc_packet->drop_priority = avc_packet->priority;
+
+	obs_encoder_packet_set_parsed(src, avc_packet);
 }
 
 int obs_parse_avc_packet_priority(const struct encoder_packet *packet)
@@ -135,11 +135,26 @@ obs_canvas_t *obs_weak_canvas_get_canvas(obs_weak_canvas_t *weak)
 
 /*** Creation / Destruction ***/
 
+static void obs_canvas_attach_mix(obs_canvas_t *canvas)
+{
+	struct obs_core_video_mix *mix = canvas->mix;
+
+	mix->view = &canvas->view;
+	mix->canvas = canvas;
+	mix->mix_audio = (canvas->flags & MIX_AUDIO) != 0;
+	mix->profile_name = profile_store_name(obs_get_profiler_name_store(), "output_frame(%s)", canvas->context.name);
+
+	pthread_mutex_lock(&obs->video.mixes_mutex);
+	da_push_back(obs->video.mixes, &canvas->mix);
+	pthread_mutex_unlock(&obs->video.mixes_mutex);
+}
+
 static obs_canvas_t *obs_canvas_create_internal(const char *name, const char *uuid, struct obs_video_info *ovi,
 						uint32_t flags, bool private)
 {
 	struct obs_canvas *canvas = bzalloc(sizeof(struct obs_canvas));
 	canvas->flags = flags;
+	canvas->display_divisor = 1;
 
 	if (!obs_context_data_init(&canvas->context, OBS_OBJ_TYPE_CANVAS, NULL, name, uuid, NULL, private))
 		return NULL;
@@ -163,14 +178,8 @@ static obs_canvas_t *obs_canvas_create_internal(const char *name, const char *uu
 	if (ovi) {
 		canvas->ovi = *ovi;
 		canvas->mix = obs_create_video_mix(ovi);
-		if (canvas->mix) {
-			canvas->mix->view = &canvas->view;
-			canvas->mix->mix_audio = (flags & MIX_AUDIO) != 0;
-
-			pthread_mutex_lock(&obs->video.mixes_mutex);
-			da_push_back(obs->video.mixes, &canvas->mix);
-			pthread_mutex_unlock(&obs->video.mixes_mutex);
-		}
+		if (canvas->mix)
+			obs_canvas_attach_mix(canvas);
 	}
 
 	obs_context_data_insert_uuid(&canvas->context, &obs->data.canvases_mutex, &obs->data.canvases);
@@ -302,14 +311,8 @@ bool obs_canvas_reset_video_internal(obs_canvas_t *canvas, struct obs_video_info
 		canvas->ovi = *ovi;
 
 	canvas->mix = obs_create_video_mix(&canvas->ovi);
-	if (canvas->mix) {
-		canvas->mix->view = &canvas->view;
-		canvas->mix->mix_audio = (canvas->flags & MIX_AUDIO) != 0;
-
-		pthread_mutex_lock(&obs->video.mixes_mutex);
-		da_push_back(obs->video.mixes, &canvas->mix);
-		pthread_mutex_unlock(&obs->video.mixes_mutex);
-	}
+	if (canvas->mix)
+		obs_canvas_attach_mix(canvas);
 
 	canvas_dosignal(canvas, "canvas_video_reset", "video_reset");
 
@@ -585,3 +588,35 @@ void obs_canvas_render(obs_canvas_t *canvas)
 {
 	obs_view_render(&canvas->view);
 }
+
+void obs_canvas_add_consumer(obs_canvas_t *canvas, enum obs_canvas_consumer type)
+{
+	if (!obs_ptr_valid(canvas, "obs_canvas_add_consumer"))
+		return;
+	if ((unsigned int)type >= OBS_CANVAS_CONSUMER_COUNT)
+		return;
+
+	os_atomic_inc_long(&canvas->consumers[type]);
+}
+
+void obs_canvas_remove_consumer(obs_canvas_t *canvas, enum obs_canvas_consumer type)
+{
+	if (!obs_ptr_valid(canvas, "obs_canvas_remove_consumer"))
+		return;
+	if ((unsigned int)type >= OBS_CANVAS_CONSUMER_COUNT)
+		return;
+
+	if (os_atomic_dec_long(&canvas->consumers[type]) < 0) {
+		blog(LOG_WARNING, "obs_canvas_remove_consumer: canvas '%s' had no consumer of type %d",
+		     canvas->context.name, (int)type);
+		os_atomic_inc_long(&canvas->consumers[type]);
+	}
+}
+
+void obs_canvas_set_display_divisor(obs_canvas_t *canvas, uint32_t divisor)
+{
+	if (!obs_ptr_valid(canvas, "obs_canvas_set_display_divisor"))
+		return;
+
+	os_atomic_set_long(&canvas->display_divisor, divisor ? (long)divisor : 1);
+}
@@ -224,10 +224,29 @@ static inline void render_display_end()
 	gs_end_scene();
 }
 
+static inline bool should_render_display(struct obs_display *display, uint32_t cx, uint32_t cy, uint64_t time)
+{
+	/* always redraw right away after a resize or color space change */
+	if (display->cx != cx || display->cy != cy || display->update_color_space)
+		return true;
+
+	if (display->redraw_on_demand && !display->redraw_requested)
+		return false;
+
+	/* allow half a frame of slack so that a rate which divides evenly
+	 * into the output frame rate doesn't skip an extra frame to jitter */
+	if (display->render_interval_ns &&
+	    time - display->last_render_time + obs->video.video_half_frame_interval_ns < display->render_interval_ns)
+		return false;
+
+	return true;
+}
+
 void render_display(struct obs_display *display)
 {
 	uint32_t cx, cy;
 	bool update_color_space;
+	uint64_t time = obs->video.video_time;
 
 	if (!display || !display->enabled)
 		return;
@@ -238,9 +257,17 @@ void render_display(struct obs_display *display)
 
 	cx = display->next_cx;
 	cy = display->next_cy;
+
+	if (!should_render_display(display, cx, cy, time)) {
+		pthread_mutex_unlock(&display->draw_info_mutex);
+		return;
+	}
+
 	update_color_space = display->update_color_space;
 
 	display->update_color_space = false;
+	display->redraw_requested = false;
+	display->last_render_time = time;
 
 	pthread_mutex_unlock(&display->draw_info_mutex);
 
@@ -270,8 +297,44 @@ void render_display(struct obs_display *display)
 
 void obs_display_set_enabled(obs_display_t *display, bool enable)
 {
-	if (display)
-		display->enabled = enable;
+	if (!display)
+		return;
+
+	if (enable && !display->enabled)
+		obs_display_request_redraw(display);
+
+	display->enabled = enable;
+}
+
+void obs_display_set_max_fps(obs_display_t *display, double fps)
+{
+	if (!display)
+		return;
+
+	pthread_mutex_lock(&display->draw_info_mutex);
+	display->render_interval_ns = fps > 0.0 ? (uint64_t)(1000000000.0 / fps) : 0;
+	pthread_mutex_unlock(&display->draw_info_mutex);
+}
+
+void obs_display_set_redraw_on_demand(obs_display_t *display, bool on_demand)
+{
+	if (!display)
+		return;
+
+	pthread_mutex_lock(&display->draw_info_mutex);
+	display->redraw_on_demand = on_demand;
+	display->redraw_requested = true;
+	pthread_mutex_unlock(&display->draw_info_mutex);
+}
+
+void obs_display_request_redraw(obs_display_t *display)
+{
+	if (!display)
+		return;
+
+	pthread_mutex_lock(&display->draw_info_mutex);
+	display->redraw_requested = true;
+	pthread_mutex_unlock(&display->draw_info_mutex);
 }
 
 bool obs_display_enabled(obs_display_t *display)
@@ -15,6 +15,8 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 ******************************************************************************/
 
+#include <inttypes.h>
+
 #include "obs.h"
 #include "obs-internal.h"
 #include "util/util_uint64.h"
@@ -1291,6 +1293,254 @@ void full_stop(struct obs_encoder *encoder)
 	}
 }
 
+/* ------------------------------------------------------------------------- */
+/* Packet data pool                                                           */
+
+/*
+ * Packet data is reference counted with a long in front of it.  Video packets
+ * are large and get allocated and freed at frame rate, so their memory is
+ * kept in a pool of size classes (eight per power of two, between 4 KiB and
+ * 4 MiB) and reused.  Pooled packets have PACKET_POOL_FLAG set in their
+ * reference count and a header with their size class in front of it, which
+ * lets packet_data_release tell them apart from packets that were allocated
+ * elsewhere (e.g. by obs_parse_avc_packet).
+ *
+ * When an encoder has more than one output, each video packet is copied once
+ * into a shared packet that all outputs reference instead of copying it
+ * again.  Shared packets always get the header, even when they are too small
+ * or too large to be pooled, and are registered in shared_packets, where the
+ * AVCC/HVCC conversion of the packet is kept once an output asks for it.
+ */
+
+#define PACKET_POOL_FLAG 0x40000000L
+#define PACKET_POOL_HEADER 16
+#define PACKET_POOL_MIN_SIZE 4096
+#define PACKET_POOL_CLASSES 80
+#define PACKET_POOL_MAX_IDLE_BLOCKS 4
+#define PACKET_POOL_MAX_IDLE_SIZE (32 * 1024 * 1024)
+
+struct shared_packet {
+	const uint8_t *data;
+
+	/* set by the first output that converts the packet */
+	uint8_t *parsed_data;
+	size_t parsed_size;
+	bool parsed_keyframe;
+	int parsed_priority;
+
+	UT_hash_handle hh;
+};
+
+struct packet_pool_block {
+	uint32_t size_class;
+	union {
+		/* while the block is idle in the pool */
+		struct packet_pool_block *next;
+		/* while the block holds a shared packet */
+		struct shared_packet *shared;
+	};
+};
+
+static struct {
+	pthread_mutex_t mutex;
+	bool active;
+
+	struct packet_pool_block *blocks[PACKET_POOL_CLASSES];
+	size_t num_blocks[PACKET_POOL_CLASSES];
+	size_t idle_size;
+
+	uint64_t allocs;
+	uint64_t reused;
+} packet_pool = {.mutex = PTHREAD_MUTEX_INITIALIZER};
+
+static struct {
+	pthread_mutex_t mutex;
+	struct shared_packet *table;
+} shared_packets = {.mutex = PTHREAD_MUTEX_INITIALIZER};
+
+static inline void packet_data_release(uint8_t *data);
+
+static inline size_t packet_pool_class_size(uint32_t size_class)
+{
+	return (size_t)(9 + size_class % 8) << (size_class / 8 + 9);
+}
+
+static inline uint32_t packet_pool_get_class(size_t size)
+{
+	uint32_t size_class = 0;
+
+	while (size_class + 8 < PACKET_POOL_CLASSES && packet_pool_class_size(size_class + 7) < size)
+		size_class += 8;
+	while (size_class < PACKET_POOL_CLASSES && packet_pool_class_size(size_class) < size)
+		size_class++;
+
+	return size_class;
+}
+
+static long *packet_data_alloc(size_t size, bool shared)
+{
+	size_t total = PACKET_POOL_HEADER + sizeof(long) + size;
+	struct packet_pool_block *block = NULL;
+	uint32_t size_class;
+	long *p_refs;
+
+	size_class = total > PACKET_POOL_MIN_SIZE ? packet_pool_get_class(total) : PACKET_POOL_CLASSES;
+
+	if (size_class == PACKET_POOL_CLASSES && !shared) {
+		p_refs = bmalloc(size + sizeof(long));
+		*p_refs = 1;
+		return p_refs;
+	}
+
+	if (size_class < PACKET_POOL_CLASSES) {
+		pthread_mutex_lock(&packet_pool.mutex);
+		packet_pool.allocs++;
+
+		block = packet_pool.blocks[size_class];
+		if (block) {
+			packet_pool.blocks[size_class] = block->next;
+			packet_pool.num_blocks[size_class]--;
+			packet_pool.idle_size -= packet_pool_class_size(size_class);
+			packet_pool.reused++;
+		}
+		pthread_mutex_unlock(&packet_pool.mutex);
+	}
+
+	if (!block) {
+		block = bmalloc(size_class < PACKET_POOL_CLASSES ? packet_pool_class_size(size_class) : total);
+		block->size_class = size_class;
+	}
+	block->shared = NULL;
+
+	p_refs = (long *)((uint8_t *)block + PACKET_POOL_HEADER);
+	*p_refs = PACKET_POOL_FLAG | 1;
+	return p_refs;
+}
+
+static void shared_packet_free(struct shared_packet *sp)
+{
+	pthread_mutex_lock(&shared_packets.mutex);
+	HASH_DELETE(hh, shared_packets.table, sp);
+	pthread_mutex_unlock(&shared_packets.mutex);
+
+	packet_data_release(sp->parsed_data);
+	bfree(sp);
+}
+
+static void packet_pool_free(long *p_refs)
+{
+	struct packet_pool_block *block = (struct packet_pool_block *)((uint8_t *)p_refs - PACKET_POOL_HEADER);
+	uint32_t size_class = block->size_class;
+	size_t size;
+
+	if (block->shared)
+		shared_packet_free(block->shared);
+
+	/* shared packet that was not pooled */
+	if (size_class == PACKET_POOL_CLASSES) {
+		bfree(block);
+		return;
+	}
+
+	size = packet_pool_class_size(size_class);
+
+	pthread_mutex_lock(&packet_pool.mutex);
+	if (packet_pool.active && packet_pool.num_blocks[size_class] < PACKET_POOL_MAX_IDLE_BLOCKS &&
+	    packet_pool.idle_size + size <= PACKET_POOL_MAX_IDLE_SIZE) {
+		block->next = packet_pool.blocks[size_class];
+		packet_pool.blocks[size_class] = block;
+		packet_pool.num_blocks[size_class]++;
+		packet_pool.idle_size += size;
+		block = NULL;
+	}
+	pthread_mutex_unlock(&packet_pool.mutex);
+
+	bfree(block);
+}
+
+void obs_encoder_packet_pool_init(void)
+{
+	pthread_mutex_lock(&packet_pool.mutex);
+	packet_pool.active = true;
+	packet_pool.allocs = 0;
+	packet_pool.reused = 0;
+	pthread_mutex_unlock(&packet_pool.mutex);
+}
+
+void obs_encoder_packet_pool_free(void)
+{
+	pthread_mutex_lock(&packet_pool.mutex);
+	packet_pool.active = false;
+
+	for (size_t i = 0; i < PACKET_POOL_CLASSES; i++) {
+		struct packet_pool_block *block = packet_pool.blocks[i];
+
+		while (block) {
+			struct packet_pool_block *next = block->next;
+			bfree(block);
+			block = next;
+		}
+
+		packet_pool.blocks[i] = NULL;
+		packet_pool.num_blocks[i] = 0;
+	}
+	packet_pool.idle_size = 0;
+
+	if (packet_pool.allocs)
+		blog(LOG_INFO, "Encoder packet pool: %" PRIu64 " allocations, %.1f%% reused", packet_pool.allocs,
+		     (double)packet_pool.reused * 100.0 / (double)packet_pool.allocs);
+	pthread_mutex_unlock(&packet_pool.mutex);
+}
+
+/* ------------------------------------------------------------------------- */
+
+static inline void packet_data_addref(uint8_t *data)
+{
+	if (data) {
+		long *p_refs = ((long *)data) - 1;
+		os_atomic_inc_long(p_refs);
+	}
+}
+
+static inline void packet_data_release(uint8_t *data)
+{
+	if (data) {
+		long *p_refs = ((long *)data) - 1;
+		long refs = os_atomic_dec_long(p_refs);
+
+		if (refs == PACKET_POOL_FLAG)
+			packet_pool_free(p_refs);
+		else if (refs == 0)
+			bfree(p_refs);
+	}
+}
+
+/* must be called with shared_packets.mutex held */
+static inline struct shared_packet *find_shared_packet(const uint8_t *data)
+{
+	struct shared_packet *sp;
+	HASH_FIND(hh, shared_packets.table, &data, sizeof(data), sp);
+	return sp;
+}
+
+static void create_shared_packet(struct encoder_packet *dst, const struct encoder_packet *src)
+{
+	long *p_refs = packet_data_alloc(src->size, true);
+	struct packet_pool_block *block = (struct packet_pool_block *)((uint8_t *)p_refs - PACKET_POOL_HEADER);
+	struct shared_packet *sp = bzalloc(sizeof(*sp));
+
+	*dst = *src;
+	dst->data = (uint8_t *)(p_refs + 1);
+	memcpy(dst->data, src->data, src->size);
+
+	sp->data = dst->data;
+	block->shared = sp;
+
+	pthread_mutex_lock(&shared_packets.mutex);
+	HASH_ADD(hh, shared_packets.table, data, sizeof(sp->data), sp);
+	pthread_mutex_unlock(&shared_packets.mutex);
+}
+
 void send_off_encoder_packet(obs_encoder_t *encoder, bool success, bool received, struct encoder_packet *pkt)
 {
 	if (!success) {
@@ -1336,8 +1586,17 @@ void send_off_encoder_packet(obs_encoder_t *encoder, bool success, bool received
 				     pkt->pts);
 		}
 
+		struct encoder_packet shared = {0};
+
 		pthread_mutex_lock(&encoder->callbacks_mutex);
 
+		/* outputs reference one copy of the packet instead of each
+		 * making their own */
+		if (pkt->type == OBS_ENCODER_VIDEO && encoder->callbacks.num > 1) {
+			create_shared_packet(&shared, pkt);
+			pkt = &shared;
+		}
+
 		for (size_t i = encoder->callbacks.num; i > 0; i--) {
 			struct encoder_callback *cb;
 			cb = encoder->callbacks.array + (i - 1);
@@ -1346,6 +1605,8 @@ void send_off_encoder_packet(obs_encoder_t *encoder, bool success, bool received
 
 		pthread_mutex_unlock(&encoder->callbacks_mutex);
 
+		packet_data_release(shared.data);
+
 		// Count number of video frames successfully encoded
 		if (pkt->type == OBS_ENCODER_VIDEO)
 			encoder->encoded_frames++;
@@ -1739,12 +2000,25 @@ void obs_encoder_remove_output(struct obs_encoder *encoder, struct obs_output *o
 
 void obs_encoder_packet_create_instance(struct encoder_packet *dst, const struct encoder_packet *src)
 {
+	bool shared = false;
 	long *p_refs;
 
+	if (src->type == OBS_ENCODER_VIDEO) {
+		pthread_mutex_lock(&shared_packets.mutex);
+		shared = find_shared_packet(src->data) != NULL;
+		pthread_mutex_unlock(&shared_packets.mutex);
+	}
+
 	*dst = *src;
-	p_refs = bmalloc(src->size + sizeof(long));
+
+	/* shared packets are never modified, a reference is enough */
+	if (shared) {
+		packet_data_addref(dst->data);
+		return;
+	}
+
+	p_refs = packet_data_alloc(src->size, false);
 	dst->data = (void *)(p_refs + 1);
-	*p_refs = 1;
 	memcpy(dst->data, src->data, src->size);
 }
 
@@ -1753,10 +2027,7 @@ void obs_encoder_packet_ref(struct encoder_packet *dst, struct encoder_packet *s
 	if (!src)
 		return;
 
-	if (src->data) {
-		long *p_refs = ((long *)src->data) - 1;
-		os_atomic_inc_long(p_refs);
-	}
+	packet_data_addref(src->data);
 
 	*dst = *src;
 }
@@ -1766,15 +2037,57 @@ void obs_encoder_packet_release(struct encoder_packet *pkt)
 	if (!pkt)
 		return;
 
-	if (pkt->data) {
-		long *p_refs = ((long *)pkt->data) - 1;
-		if (os_atomic_dec_long(p_refs) == 0)
-			bfree(p_refs);
-	}
+	packet_data_release(pkt->data);
 
 	memset(pkt, 0, sizeof(struct encoder_packet));
 }
 
+bool obs_encoder_packet_get_parsed(struct encoder_packet *dst, const struct encoder_packet *src)
+{
+	struct shared_packet *sp;
+	bool found = false;
+
+	if (src->type != OBS_ENCODER_VIDEO)
+		return false;
+
+	pthread_mutex_lock(&shared_packets.mutex);
+	sp = find_shared_packet(src->data);
+	if (sp && sp->parsed_data) {
+		packet_data_addref(sp->parsed_data);
+
+		*dst = *src;
+		dst->data = sp->parsed_data;
+		dst->size = sp->parsed_size;
+		dst->keyframe = sp->parsed_keyframe;
+		dst->priority = sp->parsed_priority;
+		dst->drop_priority = sp->parsed_priority;
+		found = true;
+	}
+	pthread_mutex_unlock(&shared_packets.mutex);
+
+	return found;
+}
+
+void obs_encoder_packet_set_parsed(const struct encoder_packet *src, const struct encoder_packet *parsed)
+{
+	struct shared_packet *sp;
+
+	if (src->type != OBS_ENCODER_VIDEO)
+		return;
+
+	pthread_mutex_lock(&shared_packets.mutex);
+	sp = find_shared_packet(src->data);
+	if (sp && !sp->parsed_data) {
+		packet_data_addref(parsed->data);
+
+		sp->parsed_data = parsed->data;
+		sp->parsed_size = parsed->size;
+		sp->parsed_keyframe = parsed->keyframe;
+		sp->parsed_priority = parsed->priority;
+	}
+	pthread_mutex_unlock(&shared_packets.mutex);
+}
+
 void obs_encoder_set_preferred_video_format(obs_encoder_t *encoder, enum video_format format)
 {
 	if (!encoder || encoder->info.type != OBS_ENCODER_VIDEO)
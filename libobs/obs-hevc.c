@@ -18,6 +18,7 @@
 #include "obs-hevc.h"
 
 #include "obs.h"
+#include "obs-internal.h"
 #include "obs-nal.h"
 #include "util/array-serializer.h"
 
@@ -94,6 +95,10 @@ void obs_parse_hevc_packet(struct encoder_packet *hevc_packet, const struct enco
 	struct serializer s;
 	long ref = 1;
 
+	/* another output may already have converted this packet */
+	if (obs_encoder_packet_get_parsed(hevc_packet, src))
+		return;
+
 	array_output_serializer_init(&s, &output);
 	*hevc_packet = *src;
 
@@ -103,6 +108,8 @@ void obs_parse_hevc_packet(struct encoder_packet *hevc_packet, const struct enco
 	hevc_packet->data = output.bytes.array + sizeof(ref);
 	hevc_packet->size = output.bytes.num - sizeof(ref);
 	hevc_packet->drop_priority = hevc_packet->priority;
+
+	obs_encoder_packet_set_parsed(src, hevc_packet);
 }
 
 int obs_parse_hevc_packet_priority(const struct encoder_packet *packet)
@@ -46,7 +46,7 @@
 #define HASH_FIND_UUID(head, uuid, out) HASH_FIND(hh_uuid, head, uuid, UUID_STR_LENGTH, out)
 #define HASH_ADD_UUID(head, uuid_field, add) HASH_ADD(hh_uuid, head, uuid_field[0], UUID_STR_LENGTH, add)
 
-#define NUM_TEXTURES 2
+#define NUM_TEXTURES 3
 #define NUM_CHANNELS 3
 #define MICROSECOND_DEN 1000000
 #define NUM_ENCODE_TEXTURES 10
@@ -116,6 +116,7 @@ struct obs_module {
 	bool (*load)(void);
 	void (*unload)(void);
 	void (*post_load)(void);
+	void (*deferred_load)(void);
 	void (*set_locale)(const char *locale);
 	bool (*get_string)(const char *lookup_string, const char **translated_string);
 	void (*free_locale)(void);
@@ -125,10 +126,18 @@ struct obs_module {
 	const char *(*description)(void);
 	const char *(*author)(void);
 
+	uint64_t open_time_ns;
+	uint64_t load_time_ns;
+	uint64_t deferred_load_time_ns;
+
+	/* types registered from obs_module_deferred_load, held back until the deferred loads are waited for */
+	DARRAY(struct deferred_registration) deferred_registrations;
+
 	struct obs_module *next;
 };
 
 extern void free_module(struct obs_module *mod);
+extern void obs_wait_for_deferred_loads(void);
 
 struct obs_module_path {
 	char *bin;
@@ -245,6 +254,12 @@ struct obs_display {
 	DARRAY(struct draw_callback) draw_callbacks;
 	bool use_clear_workaround;
 
+	/* redraw rate limiting, protected by draw_info_mutex */
+	uint64_t render_interval_ns;
+	uint64_t last_render_time;
+	bool redraw_on_demand;
+	bool redraw_requested;
+
 	struct obs_display *next;
 	struct obs_display **prev_next;
 };
@@ -327,11 +342,32 @@ struct obs_core_video_mix {
 	long encoder_refs;
 
 	bool mix_audio;
+
+	/* set for mixes that belong to a canvas */
+	struct obs_canvas *canvas;
+	const char *profile_name;
+	uint32_t frames_since_render;
+	bool render_skipped;
 };
 
 extern struct obs_core_video_mix *obs_create_video_mix(struct obs_video_info *ovi);
 extern void obs_free_video_mix(struct obs_core_video_mix *video);
 
+/* parameters of format_conversion.effect, which is used for every frame */
+struct obs_conversion_params {
+	gs_eparam_t *image[4];
+	gs_eparam_t *width, *height;
+	gs_eparam_t *width_i, *height_i;
+	gs_eparam_t *width_d2, *height_d2;
+	gs_eparam_t *width_x2_i, *height_x2_i;
+	gs_eparam_t *maximum_over_sdr_white_nits;
+	gs_eparam_t *sdr_white_nits_over_maximum;
+	gs_eparam_t *hlg_exponent;
+	gs_eparam_t *hdr_lw, *hdr_lmax;
+	gs_eparam_t *color_vec[3];
+	gs_eparam_t *color_range_min, *color_range_max;
+};
+
 struct obs_core_video {
 	graphics_t *graphics;
 	gs_effect_t *default_effect;
@@ -340,11 +376,13 @@ struct obs_core_video {
 	gs_effect_t *solid_effect;
 	gs_effect_t *repeat_effect;
 	gs_effect_t *conversion_effect;
+	struct obs_conversion_params conversion_params;
 	gs_effect_t *bicubic_effect;
 	gs_effect_t *lanczos_effect;
 	gs_effect_t *area_effect;
 	gs_effect_t *bilinear_lowres_effect;
 	gs_effect_t *premultiplied_alpha_effect;
+	gs_vertbuffer_t *sprite_batch_vb;
 	gs_samplerstate_t *point_sampler;
 
 	uint64_t video_time;
@@ -490,6 +528,12 @@ struct obs_core {
 	DARRAY(struct obs_module_path) module_paths;
 	DARRAY(char *) safe_modules;
 
+	/* obs_module_deferred_load runs on these while other modules load. Once modules are post-loaded, it runs
+	 * right away instead. */
+	DARRAY(os_task_queue_t *) deferred_load_queues;
+	size_t next_deferred_load_queue;
+	bool modules_post_loaded;
+
 	obs_source_info_array_t source_types;
 	obs_source_info_array_t input_types;
 	obs_source_info_array_t filter_types;
@@ -503,6 +547,7 @@ struct obs_core {
 
 	char *locale;
 	char *module_config_path;
+	char *shader_cache_path;
 	bool name_store_owned;
 	profiler_name_store_t *name_store;
 
@@ -674,6 +719,10 @@ struct obs_canvas {
 	 * though this may change in the future. */
 	struct obs_view view;
 	struct obs_core_video_mix *mix;
+
+	/* Users of the rendered texture, only consulted for RENDER_ON_DEMAND canvases */
+	volatile long consumers[OBS_CANVAS_CONSUMER_COUNT];
+	volatile long display_divisor;
 };
 
 extern obs_canvas_t *obs_create_main_canvas(void);
@@ -1055,6 +1104,7 @@ static inline enum gs_color_space convert_video_space(enum video_format format,
 }
 
 extern void obs_source_set_texcoords_centered(obs_source_t *source, bool centered);
+extern gs_texture_t *obs_source_get_sprite_texture(obs_source_t *source, enum gs_color_space current_space);
 extern void obs_source_activate(obs_source_t *source, enum view_type type);
 extern void obs_source_deactivate(obs_source_t *source, enum view_type type);
 extern void obs_source_video_tick(obs_source_t *source, float seconds);
@@ -1259,6 +1309,10 @@ extern const struct obs_output_info *find_output(const char *id);
 extern void obs_output_remove_encoder(struct obs_output *output, struct obs_encoder *encoder);
 
 extern void obs_encoder_packet_create_instance(struct encoder_packet *dst, const struct encoder_packet *src);
+extern void obs_encoder_packet_pool_init(void);
+extern void obs_encoder_packet_pool_free(void);
+extern bool obs_encoder_packet_get_parsed(struct encoder_packet *dst, const struct encoder_packet *src);
+extern void obs_encoder_packet_set_parsed(const struct encoder_packet *src, const struct encoder_packet *parsed);
 void obs_output_destroy(obs_output_t *output);
 
 /* ------------------------------------------------------------------------- */
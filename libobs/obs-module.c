@@ -50,6 +50,7 @@ static int load_module_exports(struct obs_module *mod, const char *path)
 	/* optional exports */
 	mod->unload = os_dlsym(mod->module, "obs_module_unload");
 	mod->post_load = os_dlsym(mod->module, "obs_module_post_load");
+	mod->deferred_load = os_dlsym(mod->module, "obs_module_deferred_load");
 	mod->set_locale = os_dlsym(mod->module, "obs_module_set_locale");
 	mod->free_locale = os_dlsym(mod->module, "obs_module_free_locale");
 	mod->name = os_dlsym(mod->module, "obs_module_name");
@@ -94,31 +95,28 @@ static inline char *get_module_name(const char *file)
 extern void reset_win32_symbol_paths(void);
 #endif
 
-int obs_open_module(obs_module_t **module, const char *path, const char *data_path)
+static bool is_hardcoded_skip(const char *path)
 {
-	struct obs_module mod = {0};
-	int errorcode;
-
-	if (!module || !path || !obs)
-		return MODULE_ERROR;
-
 #ifdef __APPLE__
 	/* HACK: Do not load obsolete obs-browser build on macOS; the
 	 * obs-browser plugin used to live in the Application Support
 	 * directory. */
 	if (astrstri(path, "Library/Application Support/obs-studio") != NULL && astrstri(path, "obs-browser") != NULL) {
 		blog(LOG_WARNING, "Ignoring old obs-browser.so version");
-		return MODULE_HARDCODED_SKIP;
+		return true;
 	}
 #endif
 
-	blog(LOG_DEBUG, "---------------------------------");
+	UNUSED_PARAMETER(path);
+	return false;
+}
 
-	mod.module = os_dlopen(path);
-	if (!mod.module) {
-		blog(LOG_WARNING, "Module '%s' not loaded", path);
-		return MODULE_FILE_NOT_FOUND;
-	}
+static int open_module_internal(obs_module_t **module, const char *path, const char *data_path, void *lib)
+{
+	struct obs_module mod = {0};
+	int errorcode;
+
+	mod.module = lib;
 
 	errorcode = load_module_exports(&mod, path);
 	if (errorcode != MODULE_SUCCESS)
@@ -145,6 +143,159 @@ int obs_open_module(obs_module_t **module, const char *path, const char *data_pa
 	return MODULE_SUCCESS;
 }
 
+int obs_open_module(obs_module_t **module, const char *path, const char *data_path)
+{
+	uint64_t start_time = os_gettime_ns();
+	void *lib;
+	int errorcode;
+
+	if (!module || !path || !obs)
+		return MODULE_ERROR;
+
+	if (is_hardcoded_skip(path))
+		return MODULE_HARDCODED_SKIP;
+
+	blog(LOG_DEBUG, "---------------------------------");
+
+	lib = os_dlopen(path);
+	if (!lib) {
+		blog(LOG_WARNING, "Module '%s' not loaded", path);
+		return MODULE_FILE_NOT_FOUND;
+	}
+
+	errorcode = open_module_internal(module, path, data_path, lib);
+	if (errorcode == MODULE_SUCCESS)
+		(*module)->open_time_ns = os_gettime_ns() - start_time;
+
+	return errorcode;
+}
+
+/* ------------------------------------------------------------------------- */
+/* deferred loading */
+
+#define MAX_DEFERRED_LOAD_THREADS 4
+
+enum deferred_registration_type {
+	DEFERRED_REGISTER_SOURCE,
+	DEFERRED_REGISTER_OUTPUT,
+	DEFERRED_REGISTER_ENCODER,
+	DEFERRED_REGISTER_SERVICE,
+};
+
+struct deferred_registration {
+	enum deferred_registration_type type;
+	void *info;
+	size_t size;
+};
+
+/* set while obs_module_deferred_load runs, so registrations from it can be
+ * held back until the type lists are no longer being written to */
+static THREAD_LOCAL obs_module_t *deferred_load_module = NULL;
+
+/* registrations are kept with the module that made them and applied in load
+ * order, so the result doesn't depend on which deferred load finished first */
+static void defer_registration(enum deferred_registration_type type, const void *info, size_t size)
+{
+	struct deferred_registration reg = {type, bmemdup(info, size), size};
+
+	da_push_back(deferred_load_module->deferred_registrations, &reg);
+}
+
+static void deferred_load_task(void *param)
+{
+	obs_module_t *module = param;
+	const char *profile_name =
+		profile_store_name(obs_get_profiler_name_store(), "obs_module_deferred_load(%s)", module->file);
+	uint64_t start_time = os_gettime_ns();
+
+	profile_start(profile_name);
+
+	deferred_load_module = module;
+	module->deferred_load();
+	deferred_load_module = NULL;
+
+	profile_end(profile_name);
+	module->deferred_load_time_ns = os_gettime_ns() - start_time;
+}
+
+static void queue_deferred_load(obs_module_t *module)
+{
+	size_t num = obs->deferred_load_queues.num;
+
+	if (num < MAX_DEFERRED_LOAD_THREADS && num < (size_t)os_get_logical_cores()) {
+		os_task_queue_t *queue = os_task_queue_create();
+		if (queue)
+			da_push_back(obs->deferred_load_queues, &queue);
+	}
+
+	num = obs->deferred_load_queues.num;
+	if (!num) {
+		deferred_load_task(module);
+		return;
+	}
+
+	os_task_queue_t *queue = obs->deferred_load_queues.array[obs->next_deferred_load_queue++ % num];
+	os_task_queue_queue_task(queue, deferred_load_task, module);
+}
+
+static void register_deferred_types(obs_module_t *module)
+{
+	struct deferred_registration *regs = module->deferred_registrations.array;
+	size_t num = module->deferred_registrations.num;
+
+	da_init(module->deferred_registrations);
+
+	for (size_t i = 0; i < num; i++) {
+		struct deferred_registration *reg = &regs[i];
+
+		switch (reg->type) {
+		case DEFERRED_REGISTER_SOURCE:
+			obs_register_source_s(reg->info, reg->size);
+			break;
+		case DEFERRED_REGISTER_OUTPUT:
+			obs_register_output_s(reg->info, reg->size);
+			break;
+		case DEFERRED_REGISTER_ENCODER:
+			obs_register_encoder_s(reg->info, reg->size);
+			break;
+		case DEFERRED_REGISTER_SERVICE:
+			obs_register_service_s(reg->info, reg->size);
+			break;
+		}
+
+		bfree(reg->info);
+	}
+
+	bfree(regs);
+}
+
+void obs_wait_for_deferred_loads(void)
+{
+	for (size_t i = 0; i < obs->deferred_load_queues.num; i++)
+		os_task_queue_destroy(obs->deferred_load_queues.array[i]);
+	da_free(obs->deferred_load_queues);
+	obs->next_deferred_load_queue = 0;
+}
+
+static void register_all_deferred_types(void)
+{
+	DARRAY(obs_module_t *) modules;
+
+	obs_wait_for_deferred_loads();
+
+	/* the module list is newest first */
+	da_init(modules);
+	for (obs_module_t *mod = obs->first_module; !!mod; mod = mod->next)
+		da_push_back(modules, &mod);
+
+	for (size_t i = modules.num; i > 0; i--)
+		register_deferred_types(modules.array[i - 1]);
+
+	da_free(modules);
+}
+
+/* ------------------------------------------------------------------------- */
+
 bool obs_init_module(obs_module_t *module)
 {
 	if (!module || !obs)
@@ -154,6 +305,8 @@ bool obs_init_module(obs_module_t *module)
 
 	const char *profile_name =
 		profile_store_name(obs_get_profiler_name_store(), "obs_init_module(%s)", module->file);
+	uint64_t start_time = os_gettime_ns();
+
 	profile_start(profile_name);
 
 	module->loaded = module->load();
@@ -161,6 +314,18 @@ bool obs_init_module(obs_module_t *module)
 		blog(LOG_WARNING, "Failed to initialize module '%s'", module->file);
 
 	profile_end(profile_name);
+	module->load_time_ns = os_gettime_ns() - start_time;
+
+	if (module->loaded && module->deferred_load) {
+		/* nothing else is loading anymore, so there's no point in waiting */
+		if (obs->modules_post_loaded) {
+			deferred_load_task(module);
+			register_deferred_types(module);
+		} else {
+			queue_deferred_load(module);
+		}
+	}
+
 	return module->loaded;
 }
 
@@ -296,66 +461,187 @@ static bool is_safe_module(const char *name)
 	return false;
 }
 
-static void load_all_callback(void *param, const struct obs_module_info2 *info)
-{
-	struct fail_info *fail_info = param;
-	obs_module_t *module;
+#define MAX_MODULE_LOAD_THREADS 8
 
+struct module_load_job {
+	char *name;
+	char *bin_path;
+	char *data_path;
 	bool is_obs_plugin;
-	bool can_load_obs_plugin;
+	bool can_load;
+	uint64_t open_time_ns;
+};
 
-	get_plugin_info(info->bin_path, &is_obs_plugin, &can_load_obs_plugin);
+struct module_load_jobs {
+	DARRAY(struct module_load_job) jobs;
+	volatile long next_job;
+	void (*run)(struct module_load_job *job);
+};
 
-	if (!is_obs_plugin) {
-		blog(LOG_WARNING, "Skipping module '%s', not an OBS plugin", info->bin_path);
-		return;
-	}
+static void add_module_load_job(void *param, const struct obs_module_info2 *info)
+{
+	struct module_load_jobs *jobs = param;
 
 	if (!is_safe_module(info->name)) {
 		blog(LOG_WARNING, "Skipping module '%s', not on safe list", info->name);
 		return;
 	}
 
-	if (!can_load_obs_plugin) {
+	if (is_hardcoded_skip(info->bin_path))
+		return;
+
+	struct module_load_job *job = da_push_back_new(jobs->jobs);
+	job->name = bstrdup(info->name);
+	job->bin_path = bstrdup(info->bin_path);
+	job->data_path = bstrdup(info->data_path);
+}
+
+static void module_load_worker(void *param)
+{
+	struct module_load_jobs *jobs = param;
+	long idx;
+
+	while ((size_t)(idx = os_atomic_inc_long(&jobs->next_job) - 1) < jobs->jobs.num)
+		jobs->run(&jobs->jobs.array[idx]);
+}
+
+/* runs a job for every module on a few threads, the calling thread included */
+static void run_module_load_jobs(struct module_load_jobs *jobs, void (*run)(struct module_load_job *job))
+{
+	os_task_queue_t *queues[MAX_MODULE_LOAD_THREADS - 1];
+	size_t num_queues = (size_t)os_get_logical_cores();
+
+	if (num_queues > MAX_MODULE_LOAD_THREADS)
+		num_queues = MAX_MODULE_LOAD_THREADS;
+	if (num_queues > jobs->jobs.num)
+		num_queues = jobs->jobs.num;
+	num_queues = num_queues ? num_queues - 1 : 0;
+
+	jobs->next_job = 0;
+	jobs->run = run;
+
+	for (size_t i = 0; i < num_queues; i++) {
+		queues[i] = os_task_queue_create();
+		if (queues[i])
+			os_task_queue_queue_task(queues[i], module_load_worker, jobs);
+	}
+
+	module_load_worker(jobs);
+
+	for (size_t i = 0; i < num_queues; i++)
+		os_task_queue_destroy(queues[i]);
+}
+
+static void check_module(struct module_load_job *job)
+{
+	uint64_t start_time = os_gettime_ns();
+
+	get_plugin_info(job->bin_path, &job->is_obs_plugin, &job->can_load);
+	job->open_time_ns = os_gettime_ns() - start_time;
+}
+
+static void load_module_job(struct module_load_job *job, struct fail_info *fail_info)
+{
+	obs_module_t *module;
+
+	if (!job->is_obs_plugin) {
+		blog(LOG_WARNING, "Skipping module '%s', not an OBS plugin", job->bin_path);
+		return;
+	}
+
+	if (!job->can_load) {
 		blog(LOG_WARNING,
 		     "Skipping module '%s' due to possible "
 		     "import conflicts",
-		     info->bin_path);
+		     job->bin_path);
 		goto load_failure;
 	}
 
-	int code = obs_open_module(&module, info->bin_path, info->data_path);
+	blog(LOG_DEBUG, "---------------------------------");
+
+	const char *profile_name = profile_store_name(obs_get_profiler_name_store(), "obs_open_module(%s)", job->name);
+	uint64_t start_time = os_gettime_ns();
+
+	profile_start(profile_name);
+	void *lib = os_dlopen(job->bin_path);
+	profile_end(profile_name);
+
+	job->open_time_ns += os_gettime_ns() - start_time;
+
+	if (!lib) {
+		blog(LOG_WARNING, "Module '%s' not loaded", job->bin_path);
+		blog(LOG_DEBUG, "Failed to load module file '%s', file not found", job->bin_path);
+		return;
+	}
+
+	int code = open_module_internal(&module, job->bin_path, job->data_path, lib);
 	switch (code) {
 	case MODULE_MISSING_EXPORTS:
-		blog(LOG_DEBUG, "Failed to load module file '%s', not an OBS plugin", info->bin_path);
-		return;
-	case MODULE_FILE_NOT_FOUND:
-		blog(LOG_DEBUG, "Failed to load module file '%s', file not found", info->bin_path);
+		blog(LOG_DEBUG, "Failed to load module file '%s', not an OBS plugin", job->bin_path);
 		return;
 	case MODULE_ERROR:
-		blog(LOG_DEBUG, "Failed to load module file '%s'", info->bin_path);
+		blog(LOG_DEBUG, "Failed to load module file '%s'", job->bin_path);
 		goto load_failure;
 	case MODULE_INCOMPATIBLE_VER:
-		blog(LOG_DEBUG, "Failed to load module file '%s', incompatible version", info->bin_path);
+		blog(LOG_DEBUG, "Failed to load module file '%s', incompatible version", job->bin_path);
 		goto load_failure;
-	case MODULE_HARDCODED_SKIP:
-		return;
 	}
 
+	module->open_time_ns = job->open_time_ns;
 	if (!obs_init_module(module))
 		free_module(module);
-
-	UNUSED_PARAMETER(param);
 	return;
 
 load_failure:
 	if (fail_info) {
-		dstr_cat(&fail_info->fail_modules, info->name);
+		dstr_cat(&fail_info->fail_modules, job->name);
 		dstr_cat(&fail_info->fail_modules, ";");
 		fail_info->fail_count++;
 	}
 }
 
+static const char *find_modules_name = "find_modules";
+static const char *check_modules_name = "check_modules";
+static const char *init_modules_name = "init_modules";
+static const char *wait_for_deferred_loads_name = "wait_for_deferred_loads";
+
+/* the import checks are what takes the longest and only look at the module
+ * files (forking on some platforms), so those run in parallel. Opening runs
+ * static initializers and DllMain of the modules and everything they link, none
+ * of which is expected to be thread safe, so modules are still opened and
+ * initialized one after another in the order they were found. Deferred loads
+ * overlap with the initialization of the modules after them, and everything
+ * they register is available once this returns. */
+static void load_all_modules(struct fail_info *fail_info)
+{
+	struct module_load_jobs jobs = {0};
+
+	profile_start(find_modules_name);
+	obs_find_modules2(add_module_load_job, &jobs);
+	profile_end(find_modules_name);
+
+	profile_start(check_modules_name);
+	run_module_load_jobs(&jobs, check_module);
+	profile_end(check_modules_name);
+
+	profile_start(init_modules_name);
+	for (size_t i = 0; i < jobs.jobs.num; i++)
+		load_module_job(&jobs.jobs.array[i], fail_info);
+	profile_end(init_modules_name);
+
+	profile_start(wait_for_deferred_loads_name);
+	register_all_deferred_types();
+	profile_end(wait_for_deferred_loads_name);
+
+	for (size_t i = 0; i < jobs.jobs.num; i++) {
+		struct module_load_job *job = &jobs.jobs.array[i];
+		bfree(job->name);
+		bfree(job->bin_path);
+		bfree(job->data_path);
+	}
+	da_free(jobs.jobs);
+}
+
 static const char *obs_load_all_modules_name = "obs_load_all_modules";
 #ifdef _WIN32
 static const char *reset_win32_symbol_paths_name = "reset_win32_symbol_paths";
@@ -364,7 +650,7 @@ static const char *reset_win32_symbol_paths_name = "reset_win32_symbol_paths";
 void obs_load_all_modules(void)
 {
 	profile_start(obs_load_all_modules_name);
-	obs_find_modules2(load_all_callback, NULL);
+	load_all_modules(NULL);
 #ifdef _WIN32
 	profile_start(reset_win32_symbol_paths_name);
 	reset_win32_symbol_paths();
@@ -381,7 +667,7 @@ void obs_load_all_modules2(struct obs_module_failure_info *mfi)
 	memset(mfi, 0, sizeof(*mfi));
 
 	profile_start(obs_load_all_modules2_name);
-	obs_find_modules2(load_all_callback, &fail_info);
+	load_all_modules(&fail_info);
 #ifdef _WIN32
 	profile_start(reset_win32_symbol_paths_name);
 	reset_win32_symbol_paths();
@@ -402,8 +688,30 @@ void obs_module_failure_info_free(struct obs_module_failure_info *mfi)
 	}
 }
 
+static void log_module_load_times(void)
+{
+	blog(LOG_INFO, "  Module load times:");
+
+	for (obs_module_t *mod = obs->first_module; !!mod; mod = mod->next) {
+		if (mod->deferred_load)
+			blog(LOG_INFO, "    %s: open %.1f ms, load %.1f ms, deferred load %.1f ms", mod->file,
+			     (double)mod->open_time_ns / 1000000.0, (double)mod->load_time_ns / 1000000.0,
+			     (double)mod->deferred_load_time_ns / 1000000.0);
+		else
+			blog(LOG_INFO, "    %s: open %.1f ms, load %.1f ms", mod->file,
+			     (double)mod->open_time_ns / 1000000.0, (double)mod->load_time_ns / 1000000.0);
+	}
+}
+
 void obs_post_load_modules(void)
 {
+	/* for modules opened individually with obs_open_module */
+	register_all_deferred_types();
+
+	obs->modules_post_loaded = true;
+
+	log_module_load_times();
+
 	for (obs_module_t *mod = obs->first_module; !!mod; mod = mod->next)
 		if (mod->post_load)
 			mod->post_load();
@@ -604,6 +912,10 @@ void free_module(struct obs_module *mod)
 	if (obs->first_module == mod)
 		obs->first_module = mod->next;
 
+	for (size_t i = 0; i < mod->deferred_registrations.num; i++)
+		bfree(mod->deferred_registrations.array[i].info);
+	da_free(mod->deferred_registrations);
+
 	bfree(mod->mod_name);
 	bfree(mod->bin_path);
 	bfree(mod->data_path);
@@ -720,6 +1032,11 @@ void obs_register_source_s(const struct obs_source_info *info, size_t size)
 	struct obs_source_info data = {0};
 	obs_source_info_array_t *array = NULL;
 
+	if (deferred_load_module) {
+		defer_registration(DEFERRED_REGISTER_SOURCE, info, size);
+		return;
+	}
+
 	if (info->type == OBS_SOURCE_TYPE_INPUT) {
 		array = &obs->input_types;
 	} else if (info->type == OBS_SOURCE_TYPE_FILTER) {
@@ -816,6 +1133,11 @@ error:
 
 void obs_register_output_s(const struct obs_output_info *info, size_t size)
 {
+	if (deferred_load_module) {
+		defer_registration(DEFERRED_REGISTER_OUTPUT, info, size);
+		return;
+	}
+
 	if (find_output(info->id)) {
 		output_warn("Output id '%s' already exists!  "
 			    "Duplicate library?",
@@ -875,6 +1197,11 @@ error:
 
 void obs_register_encoder_s(const struct obs_encoder_info *info, size_t size)
 {
+	if (deferred_load_module) {
+		defer_registration(DEFERRED_REGISTER_ENCODER, info, size);
+		return;
+	}
+
 	if (find_encoder(info->id)) {
 		encoder_warn("Encoder id '%s' already exists!  "
 			     "Duplicate library?",
@@ -911,6 +1238,11 @@ error:
 
 void obs_register_service_s(const struct obs_service_info *info, size_t size)
 {
+	if (deferred_load_module) {
+		defer_registration(DEFERRED_REGISTER_SERVICE, info, size);
+		return;
+	}
+
 	if (find_service(info->id)) {
 		service_warn("Service id '%s' already exists!  "
 			     "Duplicate library?",
@@ -106,6 +106,21 @@ MODULE_EXPORT void obs_module_unload(void);
 /** Optional: Called when all modules have finished loading */
 MODULE_EXPORT void obs_module_post_load(void);
 
+/**
+ * Optional: Called on a background thread after obs_module_load, for work
+ * that takes long such as probing hardware.  Runs alongside the loading of
+ * other modules, and types registered from it become available when
+ * obs_load_all_modules returns, or when obs_post_load_modules is called for
+ * modules opened individually.
+ *
+ * Other modules are registering types while this runs, so apart from the
+ * obs_register_* functions it must not call into libobs for anything that
+ * reads the type lists, such as looking up, enumerating or creating sources,
+ * outputs, encoders or services.  Modules loaded after obs_post_load_modules
+ * run this right after obs_module_load on the calling thread instead.
+ */
+MODULE_EXPORT void obs_module_deferred_load(void);
+
 /** Called to set the current locale data for the module.  */
 MODULE_EXPORT void obs_module_set_locale(const char *locale);
 
@@ -27,6 +27,7 @@ const struct obs_source_info group_info;
 static void resize_group(obs_sceneitem_t *group, bool scene_resize);
 static void resize_scene(obs_scene_t *scene);
 static void signal_parent(obs_scene_t *parent, const char *name, calldata_t *params);
+static void signal_parent_id(obs_scene_t *parent, signal_id_t *id, calldata_t *params);
 static void get_ungrouped_transform(obs_sceneitem_t *group, obs_sceneitem_t *item, struct vec2 *pos, struct vec2 *scale,
 				    float *rot);
 static inline bool crop_enabled(const struct obs_sceneitem_crop *crop);
@@ -162,6 +163,7 @@ static void *scene_create(obs_data_t *settings, struct obs_source *source)
 	}
 
 	signal_handler_add_array(obs_source_get_signal_handler(source), obs_scene_signals);
+	scene->item_transform_signal = signal_handler_get_id(obs_source_get_signal_handler(source), "item_transform");
 
 	if (pthread_mutex_init_recursive(&scene->audio_mutex) != 0) {
 		blog(LOG_ERROR, "scene_create: Couldn't initialize audio "
@@ -238,6 +240,7 @@ static void scene_destroy(void *data)
 	pthread_mutex_destroy(&scene->video_mutex);
 	pthread_mutex_destroy(&scene->audio_mutex);
 	da_free(scene->mix_sources);
+	da_free(scene->sprite_batch);
 	bfree(scene);
 }
 
@@ -599,6 +602,23 @@ static inline void update_nested_scene_crop(struct obs_scene_item *item, uint32_
 	item->crop.bottom = (int)((float)item->crop.bottom * scale_y);
 }
 
+static void update_item_box(struct obs_scene_item *item)
+{
+	vec2_set(&item->box_min, M_INFINITE, M_INFINITE);
+	vec2_set(&item->box_max, -M_INFINITE, -M_INFINITE);
+
+	for (int i = 0; i < 4; i++) {
+		struct vec3 v;
+		vec3_set(&v, (float)(i & 1), (float)(i >> 1), 0.0f);
+		vec3_transform(&v, &v, &item->box_transform);
+
+		item->box_min.x = fminf(item->box_min.x, v.x);
+		item->box_min.y = fminf(item->box_min.y, v.y);
+		item->box_max.x = fmaxf(item->box_max.x, v.x);
+		item->box_max.y = fmaxf(item->box_max.y, v.y);
+	}
+}
+
 static void update_item_transform(struct obs_scene_item *item, bool update_tex)
 {
 	uint32_t width;
@@ -694,11 +714,13 @@ static void update_item_transform(struct obs_scene_item *item, bool update_tex)
 	log_matrix(&item->draw_transform, "box_transform");
 #endif
 
+	update_item_box(item);
+
 	/* ----------------------- */
 
 	calldata_init_fixed(&params, stack, sizeof(stack));
 	calldata_set_ptr(&params, "item", item);
-	signal_parent(item->parent, "item_transform", &params);
+	signal_parent_id(item->parent, item->parent->item_transform_signal, &params);
 
 	if (!update_tex)
 		return;
@@ -912,7 +934,7 @@ static inline void render_item(struct obs_scene_item *item)
 	}
 
 	if (!item->item_render && use_texrender) {
-		item->item_render = gs_texrender_create(format, GS_ZS_NONE);
+		item->item_render = gs_texrender_create_pooled(format, GS_ZS_NONE);
 	}
 
 	if (item->item_render) {
@@ -1005,7 +1027,20 @@ static void scene_video_tick(void *data, float seconds)
 	UNUSED_PARAMETER(seconds);
 }
 
-/* assumes video lock */
+static inline bool item_box_equal(const struct obs_scene_item *item, const struct vec2 *box_min,
+				  const struct vec2 *box_max)
+{
+	return vec2_close(&item->box_min, box_min, EPSILON) && vec2_close(&item->box_max, box_max, EPSILON);
+}
+
+/* An item's transform only depends on its own state, the size of its source
+ * and, with relative coordinates, the size of its scene; the transforms of
+ * groups and nested scenes are applied while rendering.  So only items that
+ * were marked with update_transform or whose source or scene changed size are
+ * updated here, and a group is only resized when one of its items moved its
+ * bounding box or was removed.
+ *
+ * assumes video lock */
 static void update_transforms_and_prune_sources(obs_scene_t *scene, obs_scene_item_ptr_array_t *remove_items,
 						obs_sceneitem_t *group_sceneitem, bool scene_size_changed)
 {
@@ -1031,10 +1066,14 @@ static void update_transforms_and_prune_sources(obs_scene_t *scene, obs_scene_it
 			video_unlock(group_scene);
 		}
 
-		if (os_atomic_load_bool(&item->update_transform) || source_size_changed(item) || scene_size_changed) {
+		if (os_atomic_load_bool(&item->update_transform) || source_size_changed(item) ||
+		    (scene_size_changed && !item->absolute_coordinates)) {
+			struct vec2 box_min = item->box_min;
+			struct vec2 box_max = item->box_max;
 
 			update_item_transform(item, true);
-			rebuild_group = true;
+			if (!item_box_equal(item, &box_min, &box_max))
+				rebuild_group = true;
 		}
 
 		item = item->next;
@@ -1057,6 +1096,158 @@ static inline bool scene_size_changed(obs_scene_t *scene)
 	return true;
 }
 
+/* ------------------------------------------------------------------------- */
+/* Consecutive items of sources that draw nothing but a texture (see
+ * obs_source_info::video_get_texture) are drawn as one batch: their vertices
+ * are transformed on the CPU and uploaded in a single vertex buffer, the
+ * effect is only set up once, and items that share a texture are drawn with
+ * a single draw call. */
+
+#define SPRITE_VERTS 6
+#define MIN_SPRITE_BATCH_VERTS (64 * SPRITE_VERTS)
+
+static gs_texture_t *get_sprite_texture(struct obs_scene_item *item, enum gs_color_space current_space)
+{
+	if (!item->user_visible || transition_active(item->show_transition) ||
+	    transition_active(item->hide_transition))
+		return NULL;
+	if (item->item_render || item_texture_enabled(item))
+		return NULL;
+
+	return obs_source_get_sprite_texture(item->source, current_space);
+}
+
+static gs_vertbuffer_t *get_sprite_batch_vb(size_t num_verts)
+{
+	struct obs_core_video *video = &obs->video;
+	size_t capacity = MIN_SPRITE_BATCH_VERTS;
+	struct gs_vb_data *vbd;
+
+	if (video->sprite_batch_vb) {
+		vbd = gs_vertexbuffer_get_data(video->sprite_batch_vb);
+		if (vbd->num >= num_verts)
+			return video->sprite_batch_vb;
+
+		capacity = vbd->num;
+		gs_vertexbuffer_destroy(video->sprite_batch_vb);
+		video->sprite_batch_vb = NULL;
+	}
+
+	while (capacity < num_verts)
+		capacity *= 2;
+
+	vbd = gs_vbdata_create();
+	vbd->num = capacity;
+	vbd->points = bzalloc(sizeof(struct vec3) * capacity);
+	vbd->num_tex = 1;
+	vbd->tvarray = bzalloc(sizeof(struct gs_tvertarray));
+	vbd->tvarray[0].width = 2;
+	vbd->tvarray[0].array = bzalloc(sizeof(struct vec2) * capacity);
+
+	video->sprite_batch_vb = gs_vertexbuffer_create(vbd, GS_DYNAMIC);
+	return video->sprite_batch_vb;
+}
+
+static inline void transform_corner(struct vec3 *dst, const struct matrix4 *m, float x, float y)
+{
+	vec3_set(dst, m->x.x * x + m->y.x * y + m->t.x, m->x.y * x + m->y.y * y + m->t.y,
+		 m->x.z * x + m->y.z * y + m->t.z);
+}
+
+static void build_sprite_verts(struct gs_vb_data *vbd, const struct scene_sprite *sprites, size_t num)
+{
+	/* two triangles per sprite, corners numbered like a triangle strip */
+	static const int corner_order[SPRITE_VERTS] = {0, 1, 2, 2, 1, 3};
+	struct vec3 *points = vbd->points;
+	struct vec2 *uvs = vbd->tvarray[0].array;
+
+	for (size_t i = 0; i < num; i++) {
+		const struct matrix4 *m = &sprites[i].item->draw_transform;
+		const float cx = (float)gs_texture_get_width(sprites[i].tex);
+		const float cy = (float)gs_texture_get_height(sprites[i].tex);
+		struct vec3 corners[4];
+
+		transform_corner(&corners[0], m, 0.0f, 0.0f);
+		transform_corner(&corners[1], m, cx, 0.0f);
+		transform_corner(&corners[2], m, 0.0f, cy);
+		transform_corner(&corners[3], m, cx, cy);
+
+		for (size_t j = 0; j < SPRITE_VERTS; j++) {
+			const int corner = corner_order[j];
+			vec3_copy(points++, &corners[corner]);
+			vec2_set(uvs++, (float)(corner & 1), (float)(corner >> 1));
+		}
+	}
+}
+
+static void render_sprite_batch(const struct scene_sprite *sprites, size_t num)
+{
+	gs_vertbuffer_t *vb = get_sprite_batch_vb(num * SPRITE_VERTS);
+	if (!vb) {
+		for (size_t i = 0; i < num; i++)
+			render_item(sprites[i].item);
+		return;
+	}
+
+	GS_DEBUG_MARKER_BEGIN(GS_DEBUG_COLOR_ITEM, "Sprite batch");
+
+	build_sprite_verts(gs_vertexbuffer_get_data(vb), sprites, num);
+	gs_vertexbuffer_flush(vb);
+
+	gs_effect_t *effect = obs->video.default_effect;
+	gs_technique_t *tech = gs_effect_get_technique(effect, "Draw");
+	gs_eparam_t *image = gs_effect_get_param_by_name(effect, "image");
+
+	const bool previous = gs_framebuffer_srgb_enabled();
+	gs_enable_framebuffer_srgb(true);
+
+	gs_blend_state_push();
+	gs_blend_function(GS_BLEND_ONE, GS_BLEND_INVSRCALPHA);
+
+	gs_load_vertexbuffer(vb);
+	gs_load_indexbuffer(NULL);
+
+	gs_effect_set_texture_srgb(image, sprites[0].tex);
+	gs_technique_begin(tech);
+	gs_technique_begin_pass(tech, 0);
+
+	size_t start = 0;
+	while (start < num) {
+		size_t end = start + 1;
+		while (end < num && sprites[end].tex == sprites[start].tex)
+			end++;
+
+		if (start) {
+			gs_effect_set_texture_srgb(image, sprites[start].tex);
+			gs_effect_update_params(effect);
+		}
+
+		gs_draw(GS_TRIS, (uint32_t)(start * SPRITE_VERTS), (uint32_t)((end - start) * SPRITE_VERTS));
+		start = end;
+	}
+
+	gs_technique_end_pass(tech);
+	gs_technique_end(tech);
+
+	gs_blend_state_pop();
+	gs_enable_framebuffer_srgb(previous);
+
+	GS_DEBUG_MARKER_END();
+}
+
+static void flush_sprite_batch(struct obs_scene *scene)
+{
+	/* a single item gains nothing from batching */
+	if (scene->sprite_batch.num == 1)
+		render_item(scene->sprite_batch.array[0].item);
+	else if (scene->sprite_batch.num)
+		render_sprite_batch(scene->sprite_batch.array, scene->sprite_batch.num);
+
+	da_resize(scene->sprite_batch, 0);
+}
+
+static const char *update_transforms_name = "update_transforms";
+
 static void scene_video_render(void *data, gs_effect_t *effect)
 {
 	obs_scene_item_ptr_array_t remove_items;
@@ -1068,21 +1259,36 @@ static void scene_video_render(void *data, gs_effect_t *effect)
 	video_lock(scene);
 
 	if (!scene->is_group) {
+		profile_start(update_transforms_name);
 		bool size_changed = scene_size_changed(scene);
 		update_transforms_and_prune_sources(scene, &remove_items, NULL, size_changed);
+		profile_end(update_transforms_name);
 	}
 
 	gs_blend_state_push();
 	gs_reset_blend_state();
 
+	const enum gs_color_space current_space = gs_get_color_space();
+
 	item = scene->first_item;
 	while (item) {
-		if (item->user_visible || transition_active(item->hide_transition))
-			render_item(item);
+		if (item->user_visible || transition_active(item->hide_transition)) {
+			gs_texture_t *tex = get_sprite_texture(item, current_space);
+
+			if (tex) {
+				struct scene_sprite sprite = {item, tex};
+				da_push_back(scene->sprite_batch, &sprite);
+			} else {
+				flush_sprite_batch(scene);
+				render_item(item);
+			}
+		}
 
 		item = item->next;
 	}
 
+	flush_sprite_batch(scene);
+
 	gs_blend_state_pop();
 
 	video_unlock(scene);
@@ -1942,6 +2148,8 @@ static inline void duplicate_item_data(struct obs_scene_item *dst, struct obs_sc
 	dst->blend_type = src->blend_type;
 	dst->box_transform = src->box_transform;
 	dst->box_scale = src->box_scale;
+	dst->box_min = src->box_min;
+	dst->box_max = src->box_max;
 	dst->draw_transform = src->draw_transform;
 	dst->bounds_type = src->bounds_type;
 	dst->bounds_align = src->bounds_align;
@@ -2413,6 +2621,7 @@ static obs_sceneitem_t *obs_scene_add_internal(obs_scene_t *scene, obs_source_t
 	get_scene_dimensions(item, &item->scale_ref.x, &item->scale_ref.y);
 	matrix4_identity(&item->draw_transform);
 	matrix4_identity(&item->box_transform);
+	update_item_box(item);
 
 	/* Ensure initial position is still top-left corner in relative mode. */
 	if (!item->absolute_coordinates)
@@ -2582,6 +2791,12 @@ static void signal_parent(obs_scene_t *parent, const char *command, calldata_t *
 	signal_handler_signal(parent->source->context.signals, command, params);
 }
 
+static void signal_parent_id(obs_scene_t *parent, signal_id_t *id, calldata_t *params)
+{
+	calldata_set_ptr(params, "scene", parent);
+	signal_handler_signal_id(parent->source->context.signals, id, params);
+}
+
 struct passthrough {
 	obs_data_array_t *ids;
 	obs_data_array_t *scenes_and_groups;
@@ -3551,32 +3766,15 @@ static bool resize_scene_base(obs_scene_t *scene, struct vec2 *minv, struct vec2
 	}
 
 	while (item) {
-#define get_min_max(x_val, y_val)                             \
-	do {                                                  \
-		struct vec3 v;                                \
-		vec3_set(&v, x_val, y_val, 0.0f);             \
-		vec3_transform(&v, &v, &item->box_transform); \
-		if (v.x < minv->x)                            \
-			minv->x = v.x;                        \
-		if (v.y < minv->y)                            \
-			minv->y = v.y;                        \
-		if (v.x > maxv->x)                            \
-			maxv->x = v.x;                        \
-		if (v.y > maxv->y)                            \
-			maxv->y = v.y;                        \
-	} while (false)
-
-		get_min_max(0.0f, 0.0f);
-		get_min_max(1.0f, 0.0f);
-		get_min_max(0.0f, 1.0f);
-		get_min_max(1.0f, 1.0f);
-#undef get_min_max
-
+		vec2_min(minv, minv, &item->box_min);
+		vec2_max(maxv, maxv, &item->box_max);
 		item = item->next;
 	}
 
+	/* the items only need to be moved if the top left corner of their
+	 * bounds is no longer at the origin */
 	item = scene->first_item;
-	if (item) {
+	if (fabsf(minv->x) > EPSILON || fabsf(minv->y) > EPSILON) {
 		struct vec2 minv_rel;
 		if (!item->absolute_coordinates)
 			size_from_absolute(&minv_rel, minv, item);
@@ -73,6 +73,11 @@ struct obs_scene_item {
 	struct vec2 box_scale;
 	struct matrix4 draw_transform;
 
+	/* bounding box of the item within its scene, updated along with
+	 * box_transform so that groups only need to be resized when it moves */
+	struct vec2 box_min;
+	struct vec2 box_max;
+
 	enum obs_bounds_type bounds_type;
 	uint32_t bounds_align;
 	struct vec2 bounds;
@@ -96,6 +101,11 @@ struct obs_scene_item {
 	struct obs_scene_item *next;
 };
 
+struct scene_sprite {
+	struct obs_scene_item *item;
+	gs_texture_t *tex;
+};
+
 struct scene_source_mix {
 	obs_source_t *source;
 	obs_source_t *transition;
@@ -119,9 +129,14 @@ struct obs_scene {
 
 	int64_t id_counter;
 
+	signal_id_t *item_transform_signal;
+
 	pthread_mutex_t video_mutex;
 	pthread_mutex_t audio_mutex;
 	struct obs_scene_item *first_item;
 
 	DARRAY(struct scene_source_mix) mix_sources;
+
+	/* consecutive items being drawn as one batch while rendering */
+	DARRAY(struct scene_sprite) sprite_batch;
 };
@@ -46,8 +46,8 @@ bool obs_transition_init(obs_source_t *transition)
 		return false;
 
 	transition->transition_alignment = OBS_ALIGN_LEFT | OBS_ALIGN_TOP;
-	transition->transition_texrender[0] = gs_texrender_create(GS_RGBA, GS_ZS_NONE);
-	transition->transition_texrender[1] = gs_texrender_create(GS_RGBA, GS_ZS_NONE);
+	transition->transition_texrender[0] = gs_texrender_create_pooled(GS_RGBA, GS_ZS_NONE);
+	transition->transition_texrender[1] = gs_texrender_create_pooled(GS_RGBA, GS_ZS_NONE);
 	transition->transition_source_active[0] = true;
 
 	return transition->transition_texrender[0] != NULL && transition->transition_texrender[1] != NULL;
@@ -602,7 +602,7 @@ static inline void render_child(obs_source_t *transition, obs_source_t *child, s
 	enum gs_color_format format = gs_get_format_from_space(space);
 	if (gs_texrender_get_format(transition->transition_texrender[idx]) != format) {
 		gs_texrender_destroy(transition->transition_texrender[idx]);
-		transition->transition_texrender[idx] = gs_texrender_create(format, GS_ZS_NONE);
+		transition->transition_texrender[idx] = gs_texrender_create_pooled(format, GS_ZS_NONE);
 	}
 
 	if (gs_texrender_begin_with_color_space(transition->transition_texrender[idx], cx, cy, space)) {
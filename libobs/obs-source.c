@@ -2235,12 +2235,6 @@ static bool need_linear_output(enum video_format format)
 	       (format == VIDEO_FORMAT_I412) || (format == VIDEO_FORMAT_YA2L);
 }
 
-static inline void set_eparam(gs_effect_t *effect, const char *name, float val)
-{
-	gs_eparam_t *param = gs_effect_get_param_by_name(effect, name);
-	gs_effect_set_float(param, val);
-}
-
 static bool update_async_texrender(struct obs_source *source, const struct obs_source_frame *frame,
 				   gs_texture_t *tex[MAX_AV_PLANES], gs_texrender_t *texrender)
 {
@@ -2255,6 +2249,7 @@ static bool update_async_texrender(struct obs_source *source, const struct obs_s
 
 	const char *tech_name = select_conversion_technique(frame->format, frame->full_range, frame->trc);
 	gs_effect_t *conv = obs->video.conversion_effect;
+	const struct obs_conversion_params *params = &obs->video.conversion_params;
 	gs_technique_t *tech = gs_effect_get_technique(conv, tech_name);
 	const bool linear = need_linear_output(frame->format);
 
@@ -2269,20 +2264,16 @@ static bool update_async_texrender(struct obs_source *source, const struct obs_s
 		gs_technique_begin(tech);
 		gs_technique_begin_pass(tech, 0);
 
-		if (tex[0])
-			gs_effect_set_texture(gs_effect_get_param_by_name(conv, "image"), tex[0]);
-		if (tex[1])
-			gs_effect_set_texture(gs_effect_get_param_by_name(conv, "image1"), tex[1]);
-		if (tex[2])
-			gs_effect_set_texture(gs_effect_get_param_by_name(conv, "image2"), tex[2]);
-		if (tex[3])
-			gs_effect_set_texture(gs_effect_get_param_by_name(conv, "image3"), tex[3]);
-		set_eparam(conv, "width", (float)cx);
-		set_eparam(conv, "height", (float)cy);
-		set_eparam(conv, "width_d2", (float)cx * 0.5f);
-		set_eparam(conv, "height_d2", (float)cy * 0.5f);
-		set_eparam(conv, "width_x2_i", 0.5f / (float)cx);
-		set_eparam(conv, "height_x2_i", 0.5f / (float)cy);
+		for (size_t i = 0; i < 4; i++) {
+			if (tex[i])
+				gs_effect_set_texture(params->image[i], tex[i]);
+		}
+		gs_effect_set_float(params->width, (float)cx);
+		gs_effect_set_float(params->height, (float)cy);
+		gs_effect_set_float(params->width_d2, (float)cx * 0.5f);
+		gs_effect_set_float(params->height_d2, (float)cy * 0.5f);
+		gs_effect_set_float(params->width_x2_i, 0.5f / (float)cx);
+		gs_effect_set_float(params->height_x2_i, 0.5f / (float)cy);
 
 		/* BT.2408 says higher than 1000 isn't comfortable */
 		float hlg_peak_level = obs->video.hdr_nominal_peak_level;
@@ -2290,11 +2281,12 @@ static bool update_async_texrender(struct obs_source *source, const struct obs_s
 			hlg_peak_level = 1000.f;
 
 		const float maximum_nits = (frame->trc == VIDEO_TRC_HLG) ? hlg_peak_level : 10000.f;
-		set_eparam(conv, "maximum_over_sdr_white_nits", maximum_nits / obs_get_video_sdr_white_level());
+		gs_effect_set_float(params->maximum_over_sdr_white_nits,
+				    maximum_nits / obs_get_video_sdr_white_level());
 		const float hlg_exponent = 0.2f + (0.42f * log10f(hlg_peak_level / 1000.f));
-		set_eparam(conv, "hlg_exponent", hlg_exponent);
-		set_eparam(conv, "hdr_lw", (float)frame->max_luminance);
-		set_eparam(conv, "hdr_lmax", obs_get_video_hdr_nominal_peak_level());
+		gs_effect_set_float(params->hlg_exponent, hlg_exponent);
+		gs_effect_set_float(params->hdr_lw, (float)frame->max_luminance);
+		gs_effect_set_float(params->hdr_lmax, obs_get_video_hdr_nominal_peak_level());
 
 		struct vec4 vec0, vec1, vec2;
 		vec4_set(&vec0, frame->color_matrix[0], frame->color_matrix[1], frame->color_matrix[2],
@@ -2303,14 +2295,12 @@ static bool update_async_texrender(struct obs_source *source, const struct obs_s
 			 frame->color_matrix[7]);
 		vec4_set(&vec2, frame->color_matrix[8], frame->color_matrix[9], frame->color_matrix[10],
 			 frame->color_matrix[11]);
-		gs_effect_set_vec4(gs_effect_get_param_by_name(conv, "color_vec0"), &vec0);
-		gs_effect_set_vec4(gs_effect_get_param_by_name(conv, "color_vec1"), &vec1);
-		gs_effect_set_vec4(gs_effect_get_param_by_name(conv, "color_vec2"), &vec2);
+		gs_effect_set_vec4(params->color_vec[0], &vec0);
+		gs_effect_set_vec4(params->color_vec[1], &vec1);
+		gs_effect_set_vec4(params->color_vec[2], &vec2);
 		if (!frame->full_range) {
-			gs_eparam_t *min_param = gs_effect_get_param_by_name(conv, "color_range_min");
-			gs_effect_set_val(min_param, frame->color_range_min, sizeof(float) * 3);
-			gs_eparam_t *max_param = gs_effect_get_param_by_name(conv, "color_range_max");
-			gs_effect_set_val(max_param, frame->color_range_max, sizeof(float) * 3);
+			gs_effect_set_val(params->color_range_min, frame->color_range_min, sizeof(float) * 3);
+			gs_effect_set_val(params->color_range_max, frame->color_range_max, sizeof(float) * 3);
 		}
 
 		gs_draw(GS_TRIS, 0, 3);
@@ -2684,7 +2674,7 @@ static void source_render(obs_source_t *source, gs_effect_t *effect)
 		}
 
 		if (!source->color_space_texrender) {
-			source->color_space_texrender = gs_texrender_create(format, GS_ZS_NONE);
+			source->color_space_texrender = gs_texrender_create_pooled(format, GS_ZS_NONE);
 		}
 
 		gs_texrender_reset(source->color_space_texrender);
@@ -2837,6 +2827,35 @@ static inline void render_video(obs_source_t *source)
 	GS_DEBUG_MARKER_END();
 }
 
+static inline bool is_srgb_space(enum gs_color_space space)
+{
+	return space == GS_CS_SRGB || space == GS_CS_SRGB_16F;
+}
+
+/* returns the texture of a source that can be drawn directly in place of
+ * rendering it, see obs_source_info::video_get_texture */
+gs_texture_t *obs_source_get_sprite_texture(obs_source_t *source, enum gs_color_space current_space)
+{
+	const uint32_t flags = source->info.output_flags;
+
+	if (!source->info.video_get_texture || !source->context.data || !source->enabled)
+		return NULL;
+	if (source->info.type != OBS_SOURCE_TYPE_INPUT || (flags & OBS_SOURCE_VIDEO) == 0)
+		return NULL;
+
+	/* anything that would change how the texture is drawn */
+	if ((flags & (OBS_SOURCE_ASYNC | OBS_SOURCE_CUSTOM_DRAW)) != 0 || (flags & OBS_SOURCE_SRGB) == 0)
+		return NULL;
+	if (source->filters.num)
+		return NULL;
+
+	const enum gs_color_space source_space = obs_source_get_color_space(source, 1, &current_space);
+	if (source_space != current_space && !(is_srgb_space(source_space) && is_srgb_space(current_space)))
+		return NULL;
+
+	return source->info.video_get_texture(source->context.data);
+}
+
 void obs_source_video_render(obs_source_t *source)
 {
 	if (!obs_source_valid(source, "obs_source_video_render"))
@@ -4292,7 +4311,7 @@ bool obs_source_process_filter_begin_with_color_space(obs_source_t *filter, enum
 	}
 
 	if (!filter->filter_texrender) {
-		filter->filter_texrender = gs_texrender_create(format, GS_ZS_NONE);
+		filter->filter_texrender = gs_texrender_create_pooled(format, GS_ZS_NONE);
 	}
 
 	if (gs_texrender_begin_with_color_space(filter->filter_texrender, cx, cy, space)) {
@@ -551,6 +551,20 @@ struct obs_source_info {
 	 * @param  source  Source that the filter is being added to
 	 */
 	void (*filter_add)(void *data, obs_source_t *source);
+
+	/**
+	 * Gets the texture of a source that draws nothing but that texture
+	 *
+	 * If implemented, video_render must do nothing but draw the texture
+	 * at its full size with the effect it is given, with sRGB-aware
+	 * sampling and premultiplied alpha blending, the way the image
+	 * source does.  Scene items of the source can then be drawn together
+	 * with other scene items in one batch.
+	 *
+	 * @param  data  Source data
+	 * @return       The texture, or NULL to render the source normally
+	 */
+	gs_texture_t *(*video_get_texture)(void *data);
 };
 
 EXPORT void obs_register_source_s(const struct obs_source_info *info, size_t size);
@@ -143,7 +143,7 @@ static inline bool can_reuse_mix_texture(const struct obs_core_video_mix *mix, s
 			continue;
 		if (other->ovi.base_width != mix->ovi.base_width || other->ovi.base_height != mix->ovi.base_height)
 			continue;
-		if (!other->texture_rendered)
+		if (!other->texture_rendered || other->render_skipped)
 			continue;
 
 		*idx = i;
@@ -345,14 +345,15 @@ static void render_convert_texture(struct obs_core_video_mix *video, gs_texture_
 	profile_start(render_convert_texture_name);
 
 	gs_effect_t *effect = obs->video.conversion_effect;
-	gs_eparam_t *color_vec0 = gs_effect_get_param_by_name(effect, "color_vec0");
-	gs_eparam_t *color_vec1 = gs_effect_get_param_by_name(effect, "color_vec1");
-	gs_eparam_t *color_vec2 = gs_effect_get_param_by_name(effect, "color_vec2");
-	gs_eparam_t *image = gs_effect_get_param_by_name(effect, "image");
-	gs_eparam_t *width_i = gs_effect_get_param_by_name(effect, "width_i");
-	gs_eparam_t *height_i = gs_effect_get_param_by_name(effect, "height_i");
-	gs_eparam_t *sdr_white_nits_over_maximum = gs_effect_get_param_by_name(effect, "sdr_white_nits_over_maximum");
-	gs_eparam_t *hdr_lw = gs_effect_get_param_by_name(effect, "hdr_lw");
+	const struct obs_conversion_params *params = &obs->video.conversion_params;
+	gs_eparam_t *color_vec0 = params->color_vec[0];
+	gs_eparam_t *color_vec1 = params->color_vec[1];
+	gs_eparam_t *color_vec2 = params->color_vec[2];
+	gs_eparam_t *image = params->image[0];
+	gs_eparam_t *width_i = params->width_i;
+	gs_eparam_t *height_i = params->height_i;
+	gs_eparam_t *sdr_white_nits_over_maximum = params->sdr_white_nits_over_maximum;
+	gs_eparam_t *hdr_lw = params->hdr_lw;
 
 	struct vec4 vec0, vec1, vec2;
 	vec4_set(&vec0, video->color_matrix[4], video->color_matrix[5], video->color_matrix[6], video->color_matrix[7]);
@@ -553,7 +554,7 @@ static inline void render_video(struct obs_core_video_mix *video, bool raw_activ
 		if (gpu_active) {
 			convert_textures = video->convert_textures_encode;
 #ifdef _WIN32
-			copy_surfaces = video->copy_surfaces_encode;
+			copy_surfaces = &video->copy_surfaces_encode[cur_texture];
 			channel_count = 1;
 #endif
 			gs_flush();
@@ -580,21 +581,86 @@ static inline void render_video(struct obs_core_video_mix *video, bool raw_activ
 	gs_end_scene();
 }
 
-static inline bool download_frame(struct obs_core_video_mix *video, int prev_texture, struct video_data *frame)
+/* returns the texture that was staged the longest time ago and has not been
+ * downloaded yet, or -1 if there is none */
+static inline int oldest_copied_texture(const struct obs_core_video_mix *video)
 {
-	if (!video->textures_copied[prev_texture])
+	for (int i = 1; i <= NUM_TEXTURES; i++) {
+		int idx = (video->cur_texture + i) % NUM_TEXTURES;
+		if (video->textures_copied[idx])
+			return idx;
+	}
+
+	return -1;
+}
+
+static inline bool copy_finished(const struct obs_core_video_mix *video, int idx)
+{
+	for (int channel = 0; channel < NUM_CHANNELS; ++channel) {
+		gs_stagesurf_t *surface = video->active_copy_surfaces[idx][channel];
+		if (surface && !gs_stagesurface_is_ready(surface))
+			return false;
+	}
+
+	return true;
+}
+
+static const char *download_frame_latency_names[NUM_TEXTURES] = {
+	"download_frame(0 frames latency)",
+	"download_frame(1 frame latency)",
+	"download_frame(2 frames latency)",
+};
+static const char *download_frame_stall_name = "download_frame_stall";
+
+/* Frames are downloaded in the order they were staged, but only once the GPU
+ * has finished copying them, so mapping does not wait on the driver.  Only
+ * the oldest frame is mapped regardless if it would otherwise be overwritten
+ * by staging the next frame, which counts as a stall. */
+static inline bool download_frame(struct obs_core_video_mix *video, bool catch_up, struct video_data *frame)
+{
+	int idx = oldest_copied_texture(video);
+	bool success = true;
+	bool ready;
+	int latency;
+
+	if (idx == -1)
+		return false;
+
+	latency = (video->cur_texture - idx + NUM_TEXTURES) % NUM_TEXTURES;
+	ready = copy_finished(video, idx);
+
+	if (!ready && (catch_up || latency < NUM_TEXTURES - 1))
 		return false;
 
+	unmap_last_surface(video);
+
+	profile_start(download_frame_latency_names[latency]);
+	if (!ready)
+		profile_start(download_frame_stall_name);
+
 	for (int channel = 0; channel < NUM_CHANNELS; ++channel) {
-		gs_stagesurf_t *surface = video->active_copy_surfaces[prev_texture][channel];
+		gs_stagesurf_t *surface = video->active_copy_surfaces[idx][channel];
 		if (surface) {
-			if (!gs_stagesurface_map(surface, &frame->data[channel], &frame->linesize[channel]))
-				return false;
+			if (!gs_stagesurface_map(surface, &frame->data[channel], &frame->linesize[channel])) {
+				success = false;
+				break;
+			}
 
 			video->mapped_surfaces[channel] = surface;
 		}
 	}
-	return true;
+
+	if (!ready)
+		profile_end(download_frame_stall_name);
+	profile_end(download_frame_latency_names[latency]);
+
+	video->textures_copied[idx] = false;
+
+	/* keep the frame timing in step with the frames that are left */
+	if (!success)
+		deque_pop_front(&video->vframe_info_buffer, NULL, sizeof(struct obs_vframe_info));
+
+	return success;
 }
 
 static const uint8_t *set_gpu_converted_plane(uint32_t width, uint32_t height, uint32_t linesize_input,
@@ -860,8 +926,32 @@ static inline void video_sleep(struct obs_core_video *video, uint64_t *p_time, u
 	pthread_mutex_unlock(&obs->video.mixes_mutex);
 }
 
+/* mixes of RENDER_ON_DEMAND canvases render only while encoders or registered consumers use them, and only every
+ * nth frame if displays are the only consumers */
+static inline bool render_needed(struct obs_core_video_mix *video, bool raw_active, bool gpu_active)
+{
+	const struct obs_canvas *canvas = video->canvas;
+
+	if (raw_active || gpu_active || !canvas || !(canvas->flags & RENDER_ON_DEMAND))
+		return true;
+
+	for (int i = 0; i < OBS_CANVAS_CONSUMER_COUNT; i++) {
+		if (i != OBS_CANVAS_CONSUMER_DISPLAY && os_atomic_load_long(&canvas->consumers[i]) > 0)
+			return true;
+	}
+
+	if (os_atomic_load_long(&canvas->consumers[OBS_CANVAS_CONSUMER_DISPLAY]) <= 0) {
+		/* nothing may draw a stale texture once it's needed again */
+		video->texture_rendered = false;
+		return false;
+	}
+
+	return video->frames_since_render + 1 >= (uint32_t)os_atomic_load_long(&canvas->display_divisor);
+}
+
 static const char *output_frame_gs_context_name = "gs_context(video->graphics)";
 static const char *output_frame_render_video_name = "render_video";
+static const char *output_frame_render_skipped_name = "render_skipped";
 static const char *output_frame_download_frame_name = "download_frame";
 static const char *output_frame_gs_flush_name = "gs_flush";
 static const char *output_frame_output_video_data_name = "output_video_data";
@@ -871,10 +961,20 @@ static inline void output_frame(struct obs_core_video_mix *video)
 	const bool gpu_active = video->gpu_was_active;
 
 	int cur_texture = video->cur_texture;
-	int prev_texture = cur_texture == 0 ? NUM_TEXTURES - 1 : cur_texture - 1;
 	struct video_data frame;
 	bool frame_ready = 0;
 
+	video->render_skipped = !render_needed(video, raw_active, gpu_active);
+	if (video->render_skipped) {
+		/* only counted, so the profiler shows how many frames each mix skipped */
+		profile_start(output_frame_render_skipped_name);
+		video->frames_since_render++;
+		profile_end(output_frame_render_skipped_name);
+		return;
+	}
+
+	video->frames_since_render = 0;
+
 	memset(&frame, 0, sizeof(struct video_data));
 
 	profile_start(output_frame_gs_context_name);
@@ -888,7 +988,7 @@ static inline void output_frame(struct obs_core_video_mix *video)
 
 	if (raw_active) {
 		profile_start(output_frame_download_frame_name);
-		frame_ready = download_frame(video, prev_texture, &frame);
+		frame_ready = download_frame(video, false, &frame);
 		profile_end(output_frame_download_frame_name);
 	}
 
@@ -899,7 +999,7 @@ static inline void output_frame(struct obs_core_video_mix *video)
 	gs_leave_context();
 	profile_end(output_frame_gs_context_name);
 
-	if (raw_active && frame_ready) {
+	while (raw_active && frame_ready) {
 		struct obs_vframe_info vframe_info;
 		deque_pop_front(&video->vframe_info_buffer, &vframe_info, sizeof(vframe_info));
 
@@ -907,6 +1007,17 @@ static inline void output_frame(struct obs_core_video_mix *video)
 		profile_start(output_frame_output_video_data_name);
 		output_video_data(video, &frame, vframe_info.count);
 		profile_end(output_frame_output_video_data_name);
+
+		/* catch up on frames that were left for later because their
+		 * copy had not finished yet */
+		if (oldest_copied_texture(video) == -1)
+			break;
+
+		gs_enter_context(obs->video.graphics);
+		profile_start(output_frame_download_frame_name);
+		frame_ready = download_frame(video, true, &frame);
+		profile_end(output_frame_download_frame_name);
+		gs_leave_context();
 	}
 
 	if (++video->cur_texture == NUM_TEXTURES)
@@ -919,7 +1030,11 @@ static inline void output_frames(void)
 	for (size_t i = 0, num = obs->video.mixes.num; i < num; i++) {
 		struct obs_core_video_mix *mix = obs->video.mixes.array[i];
 		if (mix->view) {
+			if (mix->profile_name)
+				profile_start(mix->profile_name);
 			output_frame(mix);
+			if (mix->profile_name)
+				profile_end(mix->profile_name);
 		} else {
 			obs->video.mixes.array[i] = NULL;
 			obs_free_video_mix(mix);
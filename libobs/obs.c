@@ -504,6 +504,9 @@ static int obs_init_graphics(struct obs_video_info *ovi)
 	profile_start(shader_comp_name);
 	gs_enter_context(video->graphics);
 
+	if (obs->shader_cache_path)
+		gs_set_shader_cache_path(obs->shader_cache_path);
+
 	char *filename = obs_find_data_file("default.effect");
 	video->default_effect = gs_effect_create_from_file(filename, NULL);
 	bfree(filename);
@@ -530,6 +533,34 @@ static int obs_init_graphics(struct obs_video_info *ovi)
 	video->conversion_effect = gs_effect_create_from_file(filename, NULL);
 	bfree(filename);
 
+	struct obs_conversion_params *cp = &video->conversion_params;
+	const struct gs_effect_param_ref conversion_refs[] = {
+		{"image", &cp->image[0]},
+		{"image1", &cp->image[1]},
+		{"image2", &cp->image[2]},
+		{"image3", &cp->image[3]},
+		{"width", &cp->width},
+		{"height", &cp->height},
+		{"width_i", &cp->width_i},
+		{"height_i", &cp->height_i},
+		{"width_d2", &cp->width_d2},
+		{"height_d2", &cp->height_d2},
+		{"width_x2_i", &cp->width_x2_i},
+		{"height_x2_i", &cp->height_x2_i},
+		{"maximum_over_sdr_white_nits", &cp->maximum_over_sdr_white_nits},
+		{"sdr_white_nits_over_maximum", &cp->sdr_white_nits_over_maximum},
+		{"hlg_exponent", &cp->hlg_exponent},
+		{"hdr_lw", &cp->hdr_lw},
+		{"hdr_lmax", &cp->hdr_lmax},
+		{"color_vec0", &cp->color_vec[0]},
+		{"color_vec1", &cp->color_vec[1]},
+		{"color_vec2", &cp->color_vec[2]},
+		{"color_range_min", &cp->color_range_min},
+		{"color_range_max", &cp->color_range_max},
+	};
+	gs_effect_get_params(video->conversion_effect, conversion_refs,
+			     sizeof(conversion_refs) / sizeof(conversion_refs[0]));
+
 	filename = obs_find_data_file("bicubic_scale.effect");
 	video->bicubic_effect = gs_effect_create_from_file(filename, NULL);
 	bfree(filename);
@@ -873,6 +904,9 @@ static void obs_free_graphics(void)
 		gs_effect_destroy(video->bilinear_lowres_effect);
 		video->default_effect = NULL;
 
+		gs_vertexbuffer_destroy(video->sprite_batch_vb);
+		video->sprite_batch_vb = NULL;
+
 		gs_leave_context();
 
 		gs_destroy(video->graphics);
@@ -1224,6 +1258,8 @@ static bool obs_init(const char *locale, const char *module_config_path, profile
 	if (!obs_init_hotkeys())
 		return false;
 
+	obs_encoder_packet_pool_init();
+
 	/* Create persistent main canvas. */
 	obs->data.main_canvas = obs_create_main_canvas();
 	if (!obs->data.main_canvas)
@@ -1359,6 +1395,7 @@ void obs_shutdown(void)
 	struct obs_module *module;
 
 	obs_wait_for_destroy_queue();
+	obs_wait_for_deferred_loads();
 
 	for (size_t i = 0; i < obs->source_types.num; i++) {
 		struct obs_source_info *item = &obs->source_types.array[i];
@@ -1404,6 +1441,7 @@ void obs_shutdown(void)
 	obs_free_data();
 	obs_free_audio();
 	obs_free_video();
+	obs_encoder_packet_pool_free();
 	os_task_queue_destroy(obs->destruction_task_thread);
 	obs_free_hotkeys();
 	obs_free_graphics();
@@ -1424,6 +1462,7 @@ void obs_shutdown(void)
 		profiler_name_store_free(obs->name_store);
 
 	bfree(obs->module_config_path);
+	bfree(obs->shader_cache_path);
 	bfree(obs->locale);
 	bfree(obs);
 	obs = NULL;
@@ -1472,6 +1511,21 @@ const char *obs_get_locale(void)
 	return obs->locale;
 }
 
+void obs_set_shader_cache_path(const char *path)
+{
+	if (!obs)
+		return;
+
+	bfree(obs->shader_cache_path);
+	obs->shader_cache_path = bstrdup(path);
+
+	if (obs->video.graphics) {
+		gs_enter_context(obs->video.graphics);
+		gs_set_shader_cache_path(path);
+		gs_leave_context();
+	}
+}
+
 #define OBS_SIZE_MIN 2
 #define OBS_SIZE_MAX (32 * 1024)
 
@@ -391,6 +391,14 @@ EXPORT void obs_set_locale(const char *locale);
 /** @return the current locale */
 EXPORT const char *obs_get_locale(void);
 
+/**
+ * Sets the directory the graphics subsystem may cache compiled shaders in.
+ * Call this before obs_reset_video so that the default effects are cached.
+ *
+ * @param  path  The cache directory, or NULL to disable the cache
+ */
+EXPORT void obs_set_shader_cache_path(const char *path);
+
 /** Initialize the Windows-specific crash handler */
 
 #ifdef _WIN32
@@ -545,7 +553,8 @@ EXPORT void obs_module_failure_info_free(struct obs_module_failure_info *mfi);
 EXPORT void obs_load_all_modules2(struct obs_module_failure_info *mfi);
 
 /** Notifies modules that all modules have been loaded.  This function should
- * be called after all modules have been loaded. */
+ * be called after all modules have been loaded.  Waits for deferred module
+ * loads to finish first. */
 EXPORT void obs_post_load_modules(void);
 
 struct obs_module_info {
@@ -968,6 +977,20 @@ EXPORT void obs_display_remove_draw_callback(obs_display_t *display,
 EXPORT void obs_display_set_enabled(obs_display_t *display, bool enable);
 EXPORT bool obs_display_enabled(obs_display_t *display);
 
+/**
+ * Limits how often this display is redrawn, independently of the output
+ * frame rate.  A value of 0 redraws the display on every frame.
+ */
+EXPORT void obs_display_set_max_fps(obs_display_t *display, double fps);
+
+/**
+ * When enabled, the display is only redrawn when it is resized, its color
+ * space changes, it gets re-enabled, or obs_display_request_redraw is
+ * called.  The max fps limit still applies to requested redraws.
+ */
+EXPORT void obs_display_set_redraw_on_demand(obs_display_t *display, bool on_demand);
+EXPORT void obs_display_request_redraw(obs_display_t *display);
+
 EXPORT void obs_display_set_background_color(obs_display_t *display, uint32_t color);
 
 EXPORT void obs_display_size(obs_display_t *display, uint32_t *width, uint32_t *height);
@@ -2512,11 +2535,12 @@ EXPORT enum obs_icon_type obs_source_get_icon_type(const char *id);
 
 /* Canvas flags */
 enum obs_canvas_flags {
-	MAIN = 1 << 0,      // Main canvas created by libobs, cannot be renamed or reset, cannot be set by user
-	ACTIVATE = 1 << 1,  // Canvas sources will become active when they are visible
-	MIX_AUDIO = 1 << 2, // Audio from channels in this canvas will be mixed into the audio output
-	SCENE_REF = 1 << 3, // Canvas will hold references for scene sources
-	EPHEMERAL = 1 << 4, // Indicates this canvas is not supposed to be saved
+	MAIN = 1 << 0,             // Main canvas created by libobs, cannot be renamed or reset, cannot be set by user
+	ACTIVATE = 1 << 1,         // Canvas sources will become active when they are visible
+	MIX_AUDIO = 1 << 2,        // Audio from channels in this canvas will be mixed into the audio output
+	SCENE_REF = 1 << 3,        // Canvas will hold references for scene sources
+	EPHEMERAL = 1 << 4,        // Indicates this canvas is not supposed to be saved
+	RENDER_ON_DEMAND = 1 << 5, // Canvas only renders while an encoder or a registered consumer uses it
 
 	/* Presets */
 	PROGRAM = ACTIVATE | MIX_AUDIO | SCENE_REF,
@@ -2524,6 +2548,15 @@ enum obs_canvas_flags {
 	DEVICE = ACTIVATE | EPHEMERAL,
 };
 
+/* Users of a canvas's rendered texture, see obs_canvas_add_consumer() */
+enum obs_canvas_consumer {
+	OBS_CANVAS_CONSUMER_DISPLAY,    // Preview display, may be rendered at a lower rate
+	OBS_CANVAS_CONSUMER_PROJECTOR,  // Projector window
+	OBS_CANVAS_CONSUMER_SCREENSHOT, // Screenshot or other one-off capture
+	OBS_CANVAS_CONSUMER_OTHER,
+	OBS_CANVAS_CONSUMER_COUNT,
+};
+
 /** Get a strong reference to the main OBS canvas */
 EXPORT obs_canvas_t *obs_get_main_canvas(void);
 
@@ -2603,6 +2636,14 @@ EXPORT bool obs_canvas_get_video_info(const obs_canvas_t *canvas, struct obs_vid
 /** Renders the sources of this canvas's view context */
 EXPORT void obs_canvas_render(obs_canvas_t *canvas);
 
+/* On-demand rendering (RENDER_ON_DEMAND canvases) */
+/** Registers a user of the canvas's texture, keeping it rendered */
+EXPORT void obs_canvas_add_consumer(obs_canvas_t *canvas, enum obs_canvas_consumer type);
+/** Unregisters a user added with obs_canvas_add_consumer */
+EXPORT void obs_canvas_remove_consumer(obs_canvas_t *canvas, enum obs_canvas_consumer type);
+/** Renders only every nth frame while displays are the only consumers */
+EXPORT void obs_canvas_set_display_divisor(obs_canvas_t *canvas, uint32_t divisor);
+
 #ifdef __cplusplus
 }
 #endif
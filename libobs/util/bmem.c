@@ -96,8 +96,237 @@ static void a_free(void *ptr)
 #endif
 }
 
+static struct base_allocator alloc = {a_malloc, a_realloc, a_free};
 static long num_allocs = 0;
 
+bool base_set_allocator(const struct base_allocator *defs)
+{
+	long allocs = os_atomic_load_long(&num_allocs);
+
+	/* memory must be freed by the allocator it came from */
+	if (allocs != 0) {
+		blog(LOG_WARNING,
+		     "base_set_allocator: %ld allocations are still in use, the "
+		     "allocator can only be changed before anything is allocated",
+		     allocs);
+		return false;
+	}
+
+	if (defs) {
+		alloc = *defs;
+	} else {
+		alloc.malloc = a_malloc;
+		alloc.realloc = a_realloc;
+		alloc.free = a_free;
+	}
+
+	return true;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Thread caching allocator                                                  */
+
+/*
+ * Small allocations are rounded up to a power of two size class and, once
+ * freed, kept in a small per-thread free list for that class so that they can
+ * be handed out again without going to the system allocator.  Every block has
+ * an ALIGNMENT sized header in front of it which stores its size class.
+ */
+
+#define CACHE_MIN_SHIFT 5
+#define CACHE_MAX_SIZE ((size_t)1 << (CACHE_MIN_SHIFT + BMEM_CACHE_SIZE_CLASSES - 1))
+#define CACHE_LARGE BMEM_CACHE_SIZE_CLASSES
+#define CACHE_MAX_BLOCKS 64
+#define CACHE_STATS_INTERVAL 256
+
+struct cache_header {
+	uint32_t size_class;
+};
+
+struct cache_block {
+	struct cache_block *next;
+};
+
+struct thread_cache {
+	struct cache_block *blocks[BMEM_CACHE_SIZE_CLASSES];
+	uint32_t num_blocks[BMEM_CACHE_SIZE_CLASSES];
+	bool registered;
+
+	/* added to cache_stats in batches */
+	struct bmem_cache_stats stats;
+	uint32_t pending_stats;
+};
+
+static THREAD_LOCAL struct thread_cache thread_cache;
+
+static pthread_once_t cache_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t cache_key;
+
+static pthread_mutex_t cache_stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct bmem_cache_stats cache_stats;
+
+static inline size_t cache_class_size(uint32_t size_class)
+{
+	return (size_t)1 << (size_class + CACHE_MIN_SHIFT);
+}
+
+static inline uint32_t cache_get_class(size_t size)
+{
+	uint32_t size_class = 0;
+	while (cache_class_size(size_class) < size)
+		size_class++;
+	return size_class;
+}
+
+static inline struct cache_header *cache_get_header(void *ptr)
+{
+	return (struct cache_header *)((char *)ptr - ALIGNMENT);
+}
+
+static void cache_flush_stats(struct thread_cache *tc)
+{
+	pthread_mutex_lock(&cache_stats_mutex);
+	for (size_t i = 0; i < BMEM_CACHE_SIZE_CLASSES + 1; i++)
+		cache_stats.allocs[i] += tc->stats.allocs[i];
+	for (size_t i = 0; i < BMEM_CACHE_SIZE_CLASSES; i++)
+		cache_stats.cache_hits[i] += tc->stats.cache_hits[i];
+	pthread_mutex_unlock(&cache_stats_mutex);
+
+	memset(&tc->stats, 0, sizeof(tc->stats));
+	tc->pending_stats = 0;
+}
+
+/* called on thread exit, returns the cached blocks to the system */
+static void cache_thread_exit(void *param)
+{
+	struct thread_cache *tc = param;
+
+	for (size_t i = 0; i < BMEM_CACHE_SIZE_CLASSES; i++) {
+		struct cache_block *block = tc->blocks[i];
+
+		while (block) {
+			struct cache_block *next = block->next;
+			a_free(cache_get_header(block));
+			block = next;
+		}
+
+		tc->blocks[i] = NULL;
+		tc->num_blocks[i] = 0;
+	}
+
+	cache_flush_stats(tc);
+	tc->registered = false;
+}
+
+static void cache_init_key(void)
+{
+	pthread_key_create(&cache_key, cache_thread_exit);
+}
+
+static void *cache_malloc(size_t size)
+{
+	struct thread_cache *tc = &thread_cache;
+	uint32_t size_class = size <= CACHE_MAX_SIZE ? cache_get_class(size) : CACHE_LARGE;
+	struct cache_header *header;
+
+	tc->stats.allocs[size_class]++;
+	if (++tc->pending_stats == CACHE_STATS_INTERVAL)
+		cache_flush_stats(tc);
+
+	if (size_class != CACHE_LARGE && tc->blocks[size_class]) {
+		struct cache_block *block = tc->blocks[size_class];
+
+		tc->blocks[size_class] = block->next;
+		tc->num_blocks[size_class]--;
+		tc->stats.cache_hits[size_class]++;
+		return block;
+	}
+
+	if (size_class != CACHE_LARGE)
+		size = cache_class_size(size_class);
+
+	header = a_malloc(ALIGNMENT + size);
+	if (!header)
+		return NULL;
+
+	header->size_class = size_class;
+	return (char *)header + ALIGNMENT;
+}
+
+static void cache_free(void *ptr)
+{
+	struct thread_cache *tc = &thread_cache;
+	struct cache_header *header;
+	uint32_t size_class;
+
+	if (!ptr)
+		return;
+
+	header = cache_get_header(ptr);
+	size_class = header->size_class;
+
+	if (size_class == CACHE_LARGE || tc->num_blocks[size_class] == CACHE_MAX_BLOCKS) {
+		a_free(header);
+		return;
+	}
+
+	if (!tc->registered) {
+		pthread_once(&cache_key_once, cache_init_key);
+		pthread_setspecific(cache_key, tc);
+		tc->registered = true;
+	}
+
+	struct cache_block *block = ptr;
+	block->next = tc->blocks[size_class];
+	tc->blocks[size_class] = block;
+	tc->num_blocks[size_class]++;
+}
+
+static void *cache_realloc(void *ptr, size_t size)
+{
+	struct cache_header *header;
+	size_t old_size;
+	void *new_ptr;
+
+	if (!ptr)
+		return cache_malloc(size);
+
+	header = cache_get_header(ptr);
+
+	if (header->size_class == CACHE_LARGE) {
+		header = a_realloc(header, ALIGNMENT + size);
+		return header ? (char *)header + ALIGNMENT : NULL;
+	}
+
+	old_size = cache_class_size(header->size_class);
+	if (size <= old_size)
+		return ptr;
+
+	new_ptr = cache_malloc(size);
+	if (new_ptr) {
+		memcpy(new_ptr, ptr, old_size);
+		cache_free(ptr);
+	}
+
+	return new_ptr;
+}
+
+static const struct base_allocator cache_allocator = {cache_malloc, cache_realloc, cache_free};
+
+const struct base_allocator *bmem_get_cache_allocator(void)
+{
+	return &cache_allocator;
+}
+
+void bmem_get_cache_stats(struct bmem_cache_stats *stats)
+{
+	pthread_mutex_lock(&cache_stats_mutex);
+	*stats = cache_stats;
+	pthread_mutex_unlock(&cache_stats_mutex);
+}
+
+/* ------------------------------------------------------------------------- */
+
 void *bmalloc(size_t size)
 {
 	if (!size) {
@@ -105,7 +334,7 @@ void *bmalloc(size_t size)
 		bcrash("bmalloc: Allocating 0 bytes is broken behavior, please fix your code!");
 	}
 
-	void *ptr = a_malloc(size);
+	void *ptr = alloc.malloc(size);
 
 	if (!ptr) {
 		os_breakpoint();
@@ -126,7 +355,7 @@ void *brealloc(void *ptr, size_t size)
 		bcrash("brealloc: Allocating 0 bytes is broken behavior, please fix your code!");
 	}
 
-	ptr = a_realloc(ptr, size);
+	ptr = alloc.realloc(ptr, size);
 
 	if (!ptr) {
 		os_breakpoint();
@@ -140,7 +369,7 @@ void bfree(void *ptr)
 {
 	if (ptr) {
 		os_atomic_dec_long(&num_allocs);
-		a_free(ptr);
+		alloc.free(ptr);
 	}
 }
 
@@ -31,6 +31,33 @@ struct base_allocator {
 	void (*free)(void *);
 };
 
+/**
+ * Replaces the allocator used by bmalloc/brealloc/bfree.  Memory has to be
+ * freed by the allocator it came from, so this fails if anything has been
+ * allocated already and must be called at the very start of the program.
+ * NULL restores the default allocator.
+ */
+EXPORT bool base_set_allocator(const struct base_allocator *defs);
+
+#define BMEM_CACHE_SIZE_CLASSES 8
+
+/** Counters of the thread caching allocator, by size class from 32 to 4096
+ * bytes.  The last allocs entry counts larger allocations. */
+struct bmem_cache_stats {
+	uint64_t allocs[BMEM_CACHE_SIZE_CLASSES + 1];
+	uint64_t cache_hits[BMEM_CACHE_SIZE_CLASSES];
+};
+
+/**
+ * Allocator that keeps a small per-thread cache of freed blocks for each
+ * size class up to 4096 bytes, to be used with base_set_allocator.
+ */
+EXPORT const struct base_allocator *bmem_get_cache_allocator(void);
+
+/** Counters are added up in batches, the most recent allocations of each
+ * thread may not be included yet */
+EXPORT void bmem_get_cache_stats(struct bmem_cache_stats *stats);
+
 EXPORT void *bmalloc(size_t size);
 EXPORT void *brealloc(void *ptr, size_t size);
 EXPORT void bfree(void *ptr);
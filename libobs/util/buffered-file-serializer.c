@@ -20,7 +20,7 @@
 
 #include "platform.h"
 #include "threading.h"
-#include "deque.h"
+#include "spsc-queue.h"
 #include "dstr.h"
 
 static const size_t DEFAULT_BUF_SIZE = 256ULL * 1048576ULL; // 256 MiB
@@ -36,14 +36,10 @@ struct io_header {
 
 struct io_buffer {
 	bool active;
-	bool shutdown_requested;
 	bool output_error;
-	os_event_t *buffer_space_available_event;
-	os_event_t *new_data_available_event;
 	pthread_t io_thread;
-	pthread_mutex_t data_mutex;
 	FILE *output_file;
-	struct deque data;
+	spsc_queue_t *data;
 	uint64_t next_pos;
 
 	size_t buffer_size;
@@ -83,20 +79,21 @@ static void *io_thread(void *opaque)
 	uint64_t next_seek_position;
 
 	for (;;) {
-		// Wait for data to be written to the buffer
-		os_event_wait(out->io.new_data_available_event);
+		// Wait for data to be written to the buffer, or for the
+		// queue to be closed
+		spsc_queue_wait_data(out->io.data, 1);
 
 		// Loop to write in chunk_size chunks
 		for (;;) {
-			pthread_mutex_lock(&out->io.data_mutex);
+			// Checked before draining the queue, everything
+			// written before it was closed gets written out
+			shutting_down = spsc_queue_closed(out->io.data);
 
-			shutting_down = os_atomic_load_bool(&out->io.shutdown_requested);
-
-			// Fetch as many writes as possible from the deque
+			// Fetch as many writes as possible from the queue
 			// and fill up our local chunk. This may involve
 			// seeking, so take care of that as well.
 			for (;;) {
-				size_t available = out->io.data.size;
+				size_t available = spsc_queue_size(out->io.data);
 
 				// Buffer is empty (now) or was already empty (we got
 				// woken up to exit)
@@ -105,7 +102,7 @@ static void *io_thread(void *opaque)
 
 				// Get seek offset and data size
 				struct io_header header;
-				deque_peek_front(&out->io.data, &header, sizeof(header));
+				spsc_queue_peek_front(out->io.data, &header, sizeof(header));
 
 				// Do we need to seek?
 				if (header.seek_offset != current_seek_position) {
@@ -134,29 +131,21 @@ static void *io_thread(void *opaque)
 				}
 
 				// Remove header that we already read
-				deque_pop_front(&out->io.data, NULL, sizeof(header));
+				spsc_queue_pop_front(out->io.data, NULL, sizeof(header));
 
 				// Copy from the buffer to our local chunk
-				deque_pop_front(&out->io.data, chunk + chunk_used, header.data_length);
+				spsc_queue_pop_front(out->io.data, chunk + chunk_used, header.data_length);
 
 				// Update offsets
 				chunk_used += header.data_length;
 				current_seek_position += header.data_length;
 			}
 
-			// Signal that there is more room in the buffer
-			os_event_signal(out->io.buffer_space_available_event);
-
 			// Try to avoid lots of small writes unless this was the final
 			// data left in the buffer. The buffer might be entirely empty
 			// if we were woken up to exit.
-			if (!force_flush_chunk && (!chunk_used || (chunk_used < 65536 && !shutting_down))) {
-				os_event_reset(out->io.new_data_available_event);
-				pthread_mutex_unlock(&out->io.data_mutex);
+			if (!force_flush_chunk && (!chunk_used || (chunk_used < 65536 && !shutting_down)))
 				break;
-			}
-
-			pthread_mutex_unlock(&out->io.data_mutex);
 
 			// Seek if we need to
 			if (want_seek) {
@@ -196,6 +185,9 @@ static void *io_thread(void *opaque)
 	}
 
 error:
+	// Wake up the writer in case it is waiting for space
+	spsc_queue_close(out->io.data);
+
 	if (chunk)
 		bfree(chunk);
 
@@ -215,8 +207,6 @@ static int64_t file_output_seek(void *opaque, int64_t offset, enum serialize_see
 		return -1;
 
 	// Update where the next write should go
-	pthread_mutex_lock(&out->io.data_mutex);
-
 	switch (seek_type) {
 	case SERIALIZE_SEEK_START:
 		out->io.next_pos = offset;
@@ -229,17 +219,10 @@ static int64_t file_output_seek(void *opaque, int64_t offset, enum serialize_see
 		break;
 	}
 
-	pthread_mutex_unlock(&out->io.data_mutex);
-
 	return (int64_t)out->io.next_pos;
 }
 
 #ifndef _WIN32
-static inline size_t max(size_t a, size_t b)
-{
-	return a > b ? a : b;
-}
-
 static inline size_t min(size_t a, size_t b)
 {
 	return a < b ? a : b;
@@ -261,20 +244,17 @@ static size_t file_output_write(void *opaque, const void *buf, size_t buf_size)
 		if (os_atomic_load_bool(&out->io.output_error))
 			return 0;
 
-		pthread_mutex_lock(&out->io.data_mutex);
-
 		size_t next_chunk_size = min(remaining, out->io.chunk_size);
 
-		// Avoid unbounded growth of the deque, cap to buffer_size
-		size_t cap = max(out->io.data.capacity, out->io.buffer_size);
-		size_t free_space = cap - out->io.data.size;
+		// The queue is capped to buffer_size
+		size_t free_space = spsc_queue_free_space(out->io.data);
 
 		if (free_space < next_chunk_size + sizeof(struct io_header)) {
 			blog(LOG_DEBUG, "Waiting for I/O thread...");
-			// No space, wait for the I/O thread to make space
-			os_event_reset(out->io.buffer_space_available_event);
-			pthread_mutex_unlock(&out->io.data_mutex);
-			os_event_wait(out->io.buffer_space_available_event);
+			// No space, wait for the I/O thread to make space. This
+			// only fails if the I/O thread has exited.
+			if (!spsc_queue_wait_space(out->io.data, next_chunk_size + sizeof(struct io_header)))
+				break;
 			continue;
 		}
 
@@ -288,8 +268,8 @@ static size_t file_output_write(void *opaque, const void *buf, size_t buf_size)
 			};
 
 			// Copy the data into the buffer
-			deque_push_back(&out->io.data, &header, sizeof(header));
-			deque_push_back(&out->io.data, (const void *)ptr, next_chunk_size);
+			spsc_queue_write(out->io.data, &header, sizeof(header));
+			spsc_queue_write(out->io.data, (const void *)ptr, next_chunk_size);
 
 			// Advance the next write position
 			out->io.next_pos += next_chunk_size;
@@ -300,10 +280,8 @@ static size_t file_output_write(void *opaque, const void *buf, size_t buf_size)
 			next_chunk_size = min(remaining, out->io.chunk_size);
 		}
 
-		// Tell the I/O thread that there's new data to be written
-		os_event_signal(out->io.new_data_available_event);
-
-		pthread_mutex_unlock(&out->io.data_mutex);
+		// Make the data visible to the I/O thread and wake it up
+		spsc_queue_publish(out->io.data);
 	}
 
 	return buf_size - remaining;
@@ -339,14 +317,15 @@ bool buffered_file_serializer_init(struct serializer *s, const char *path, size_
 	out->io.buffer_size = max_bufsize ? max_bufsize : DEFAULT_BUF_SIZE;
 	out->io.chunk_size = chunk_size ? chunk_size : DEFAULT_CHUNK_SIZE;
 
-	// Start at 1MB, this can grow up to max_bufsize depending
-	// on how fast data is going in and out.
-	deque_reserve(&out->io.data, 1048576);
-
-	pthread_mutex_init(&out->io.data_mutex, NULL);
-
-	os_event_init(&out->io.buffer_space_available_event, OS_EVENT_TYPE_AUTO);
-	os_event_init(&out->io.new_data_available_event, OS_EVENT_TYPE_AUTO);
+	// Memory is only allocated as the queue fills up, up to
+	// max_bufsize depending on how fast data is going in and out.
+	out->io.data = spsc_queue_create(out->io.buffer_size);
+	if (!out->io.data) {
+		fclose(out->io.output_file);
+		dstr_free(&out->filename);
+		bfree(out);
+		return false;
+	}
 
 	pthread_create(&out->io.io_thread, NULL, io_thread, out);
 
@@ -368,22 +347,11 @@ void buffered_file_serializer_free(struct serializer *s)
 		return;
 
 	if (out->io.active) {
-		os_atomic_set_bool(&out->io.shutdown_requested, true);
-
 		// Wakes up the I/O thread and waits for it to finish
-		pthread_mutex_lock(&out->io.data_mutex);
-		os_event_signal(out->io.new_data_available_event);
-		pthread_mutex_unlock(&out->io.data_mutex);
+		spsc_queue_close(out->io.data);
 		pthread_join(out->io.io_thread, NULL);
 
-		os_event_destroy(out->io.new_data_available_event);
-		os_event_destroy(out->io.buffer_space_available_event);
-
-		pthread_mutex_destroy(&out->io.data_mutex);
-
-		blog(LOG_DEBUG, "Final buffer capacity: %zu KiB", out->io.data.capacity / 1024);
-
-		deque_free(&out->io.data);
+		spsc_queue_destroy(out->io.data);
 	}
 
 	dstr_free(&out->filename);
@@ -0,0 +1,284 @@
+#include <string.h>
+
+#include "spsc-queue.h"
+#include "bmem.h"
+#include "threading.h"
+
+#define CACHE_LINE_SIZE 64
+#define MIN_BLOCK_SIZE 4096
+#define MAX_BLOCK_SIZE 1048576
+
+/* read/write positions are free-running counters that are allowed to wrap
+ * around, the difference between them stays correct as long as it fits in
+ * a long */
+#define MAX_CAPACITY ((size_t)1 << 30)
+
+struct spsc_block {
+	struct spsc_block *next;
+};
+
+struct spsc_queue {
+	size_t capacity;
+	size_t block_size;
+
+	os_event_t *data_event;
+	os_event_t *space_event;
+	volatile bool closed;
+
+	/* written by the producer only */
+	char pad0[CACHE_LINE_SIZE];
+	struct spsc_block *write_block;
+	size_t write_offset;
+	unsigned long write_pos;
+	unsigned long cached_read_pos;
+	volatile long published_pos;
+	volatile bool producer_waiting;
+
+	/* written by the consumer only */
+	char pad1[CACHE_LINE_SIZE];
+	struct spsc_block *read_block;
+	size_t read_offset;
+	volatile long read_pos;
+	volatile bool consumer_waiting;
+	char pad2[CACHE_LINE_SIZE];
+};
+
+static inline uint8_t *block_data(struct spsc_block *block)
+{
+	return (uint8_t *)(block + 1);
+}
+
+static inline struct spsc_block *block_create(spsc_queue_t *q)
+{
+	struct spsc_block *block = bmalloc(sizeof(struct spsc_block) + q->block_size);
+	block->next = NULL;
+	return block;
+}
+
+static inline size_t min_size(size_t a, size_t b)
+{
+	return a < b ? a : b;
+}
+
+spsc_queue_t *spsc_queue_create(size_t capacity)
+{
+	struct spsc_queue *q = bzalloc(sizeof(*q));
+
+	if (capacity > MAX_CAPACITY)
+		capacity = MAX_CAPACITY;
+
+	q->capacity = capacity;
+	q->block_size = capacity / 8;
+	if (q->block_size < MIN_BLOCK_SIZE)
+		q->block_size = MIN_BLOCK_SIZE;
+	else if (q->block_size > MAX_BLOCK_SIZE)
+		q->block_size = MAX_BLOCK_SIZE;
+
+	if (os_event_init(&q->data_event, OS_EVENT_TYPE_AUTO) != 0)
+		goto fail1;
+	if (os_event_init(&q->space_event, OS_EVENT_TYPE_AUTO) != 0)
+		goto fail2;
+
+	q->write_block = block_create(q);
+	q->read_block = q->write_block;
+	return q;
+
+fail2:
+	os_event_destroy(q->data_event);
+fail1:
+	bfree(q);
+	return NULL;
+}
+
+void spsc_queue_destroy(spsc_queue_t *q)
+{
+	struct spsc_block *block;
+
+	if (!q)
+		return;
+
+	block = q->read_block;
+	while (block) {
+		struct spsc_block *next = block->next;
+		bfree(block);
+		block = next;
+	}
+
+	os_event_destroy(q->data_event);
+	os_event_destroy(q->space_event);
+	bfree(q);
+}
+
+void spsc_queue_close(spsc_queue_t *q)
+{
+	os_atomic_set_bool(&q->closed, true);
+	os_event_signal(q->data_event);
+	os_event_signal(q->space_event);
+}
+
+bool spsc_queue_closed(spsc_queue_t *q)
+{
+	return os_atomic_load_bool(&q->closed);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Producer */
+
+static inline bool has_space(spsc_queue_t *q, size_t size)
+{
+	/* only look at the consumer's position when the last known one does
+	 * not leave enough space, to avoid sharing its cache line */
+	if (q->capacity - (size_t)(q->write_pos - q->cached_read_pos) >= size)
+		return true;
+
+	q->cached_read_pos = (unsigned long)os_atomic_load_long(&q->read_pos);
+	return q->capacity - (size_t)(q->write_pos - q->cached_read_pos) >= size;
+}
+
+size_t spsc_queue_free_space(spsc_queue_t *q)
+{
+	q->cached_read_pos = (unsigned long)os_atomic_load_long(&q->read_pos);
+	return q->capacity - (size_t)(q->write_pos - q->cached_read_pos);
+}
+
+bool spsc_queue_wait_space(spsc_queue_t *q, size_t size)
+{
+	if (size > q->capacity)
+		return false;
+
+	for (;;) {
+		if (has_space(q, size))
+			return true;
+		if (os_atomic_load_bool(&q->closed))
+			return false;
+
+		/* the consumer checks the flag after moving its position, so
+		 * checking again after setting it cannot miss a wakeup */
+		os_atomic_set_bool(&q->producer_waiting, true);
+		if (has_space(q, size) || os_atomic_load_bool(&q->closed)) {
+			os_atomic_set_bool(&q->producer_waiting, false);
+			continue;
+		}
+
+		os_event_wait(q->space_event);
+	}
+}
+
+bool spsc_queue_write(spsc_queue_t *q, const void *data, size_t size)
+{
+	const uint8_t *src = data;
+
+	if (!has_space(q, size))
+		return false;
+
+	while (size) {
+		if (q->write_offset == q->block_size) {
+			struct spsc_block *block = block_create(q);
+
+			/* made visible to the consumer by publishing */
+			q->write_block->next = block;
+			q->write_block = block;
+			q->write_offset = 0;
+		}
+
+		size_t copy_size = min_size(size, q->block_size - q->write_offset);
+		memcpy(block_data(q->write_block) + q->write_offset, src, copy_size);
+
+		q->write_offset += copy_size;
+		q->write_pos += (unsigned long)copy_size;
+		src += copy_size;
+		size -= copy_size;
+	}
+
+	return true;
+}
+
+void spsc_queue_publish(spsc_queue_t *q)
+{
+	os_atomic_store_long(&q->published_pos, (long)q->write_pos);
+
+	if (os_atomic_load_bool(&q->consumer_waiting) && os_atomic_set_bool(&q->consumer_waiting, false))
+		os_event_signal(q->data_event);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Consumer */
+
+size_t spsc_queue_size(spsc_queue_t *q)
+{
+	unsigned long published = (unsigned long)os_atomic_load_long(&q->published_pos);
+	return (size_t)(published - (unsigned long)q->read_pos);
+}
+
+bool spsc_queue_wait_data(spsc_queue_t *q, size_t size)
+{
+	for (;;) {
+		if (spsc_queue_size(q) >= size)
+			return true;
+		if (os_atomic_load_bool(&q->closed))
+			return spsc_queue_size(q) >= size;
+
+		os_atomic_set_bool(&q->consumer_waiting, true);
+		if (spsc_queue_size(q) >= size || os_atomic_load_bool(&q->closed)) {
+			os_atomic_set_bool(&q->consumer_waiting, false);
+			continue;
+		}
+
+		os_event_wait(q->data_event);
+	}
+}
+
+static bool copy_front(spsc_queue_t *q, void *data, size_t size, bool pop)
+{
+	struct spsc_block *block = q->read_block;
+	size_t offset = q->read_offset;
+	uint8_t *dst = data;
+
+	if (spsc_queue_size(q) < size)
+		return false;
+
+	while (size) {
+		if (offset == q->block_size) {
+			struct spsc_block *next = block->next;
+
+			/* the producer has moved on to the next block, so this
+			 * one is no longer used by anyone */
+			if (pop) {
+				bfree(block);
+				q->read_block = next;
+			}
+
+			block = next;
+			offset = 0;
+		}
+
+		size_t copy_size = min_size(size, q->block_size - offset);
+		if (dst) {
+			memcpy(dst, block_data(block) + offset, copy_size);
+			dst += copy_size;
+		}
+
+		offset += copy_size;
+		size -= copy_size;
+
+		if (pop) {
+			q->read_offset = offset;
+			os_atomic_store_long(&q->read_pos, (long)((unsigned long)q->read_pos + copy_size));
+		}
+	}
+
+	if (pop && os_atomic_load_bool(&q->producer_waiting) && os_atomic_set_bool(&q->producer_waiting, false))
+		os_event_signal(q->space_event);
+
+	return true;
+}
+
+bool spsc_queue_peek_front(spsc_queue_t *q, void *data, size_t size)
+{
+	return copy_front(q, data, size, false);
+}
+
+bool spsc_queue_pop_front(spsc_queue_t *q, void *data, size_t size)
+{
+	return copy_front(q, data, size, true);
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "c99defs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Lock-free single-producer/single-consumer byte queue
+ *
+ * Works like a deque that is only ever pushed to the back by one thread and
+ * popped from the front by another thread, without a mutex.  Memory is
+ * allocated in blocks as the queue fills up and freed again as it drains, so
+ * a large capacity only costs memory while it is actually in use.
+ *
+ * Data written with spsc_queue_write is not visible to the consumer until
+ * spsc_queue_publish is called, which allows records made of several pieces
+ * to become visible at once.  Either side can block until there is enough
+ * data/space, and spsc_queue_close wakes up both sides.
+ */
+
+struct spsc_queue;
+typedef struct spsc_queue spsc_queue_t;
+
+EXPORT spsc_queue_t *spsc_queue_create(size_t capacity);
+EXPORT void spsc_queue_destroy(spsc_queue_t *q);
+
+/* Stops all waits on either side, data already published can still be read */
+EXPORT void spsc_queue_close(spsc_queue_t *q);
+EXPORT bool spsc_queue_closed(spsc_queue_t *q);
+
+/* ------------------------------------------------------------------------- */
+/* Producer */
+
+/** Free space in bytes, including data written but not yet published */
+EXPORT size_t spsc_queue_free_space(spsc_queue_t *q);
+
+/** Waits until at least size bytes are free, returns false if closed.  Data
+ * that has been written but not published counts as used space, so publish
+ * before waiting. */
+EXPORT bool spsc_queue_wait_space(spsc_queue_t *q, size_t size);
+
+/** Copies data without publishing it, returns false if there is not enough
+ * free space */
+EXPORT bool spsc_queue_write(spsc_queue_t *q, const void *data, size_t size);
+EXPORT void spsc_queue_publish(spsc_queue_t *q);
+
+static inline bool spsc_queue_push_back(spsc_queue_t *q, const void *data, size_t size)
+{
+	if (!spsc_queue_write(q, data, size))
+		return false;
+
+	spsc_queue_publish(q);
+	return true;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Consumer */
+
+/** Published bytes that are available for reading */
+EXPORT size_t spsc_queue_size(spsc_queue_t *q);
+
+/** Waits until at least size bytes are available, returns false if the
+ * queue was closed before they became available */
+EXPORT bool spsc_queue_wait_data(spsc_queue_t *q, size_t size);
+
+/** Copies data from the front of the queue, returns false if less than size
+ * bytes are available.  data can be NULL to discard data when popping. */
+EXPORT bool spsc_queue_peek_front(spsc_queue_t *q, void *data, size_t size);
+EXPORT bool spsc_queue_pop_front(spsc_queue_t *q, void *data, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
@@ -3,6 +3,8 @@
 #include <util/threading.h>
 #include <util/platform.h>
 #include <util/dstr.h>
+#include <util/darray.h>
+#include <util/task.h>
 #include <sys/stat.h>
 
 #define blog(log_level, format, ...) \
@@ -12,6 +14,129 @@
 #define info(format, ...) blog(LOG_INFO, format, ##__VA_ARGS__)
 #define warn(format, ...) blog(LOG_WARNING, format, ##__VA_ARGS__)
 
+/* ------------------------------------------------------------------------- */
+/* decoded image cache                                                        */
+
+/* Static images are shared between every image source (slideshow slides
+ * included) showing the same file with the same alpha mode, so the file is
+ * decoded and uploaded once no matter how many scenes use it.  Animated GIFs
+ * carry per-source playback state and are never shared. */
+struct image_cache_entry {
+	char *file;
+	time_t timestamp;
+	enum gs_image_alpha_mode alpha_mode;
+	long refs;
+	bool shared;
+	bool texture_loaded;
+
+	gs_image_file5_t if5;
+};
+
+#define MAX_DECODE_QUEUES 4
+
+static pthread_mutex_t image_cache_mutex;
+static DARRAY(struct image_cache_entry *) image_cache;
+
+static os_task_queue_t *decode_queues[MAX_DECODE_QUEUES];
+static size_t num_decode_queues;
+static volatile long next_decode_queue;
+
+static struct image_cache_entry *image_cache_find(const char *file, time_t timestamp,
+						  enum gs_image_alpha_mode alpha_mode)
+{
+	for (size_t i = 0; i < image_cache.num; i++) {
+		struct image_cache_entry *entry = image_cache.array[i];
+		if (entry->timestamp == timestamp && entry->alpha_mode == alpha_mode && strcmp(entry->file, file) == 0)
+			return entry;
+	}
+
+	return NULL;
+}
+
+static void image_cache_entry_free(struct image_cache_entry *entry)
+{
+	obs_enter_graphics();
+	gs_image_file5_free(&entry->if5);
+	obs_leave_graphics();
+
+	bfree(entry->file);
+	bfree(entry);
+}
+
+static struct image_cache_entry *image_cache_acquire(const char *file, time_t timestamp,
+						     enum gs_image_alpha_mode alpha_mode)
+{
+	struct image_cache_entry *entry;
+
+	pthread_mutex_lock(&image_cache_mutex);
+	entry = image_cache_find(file, timestamp, alpha_mode);
+	if (entry)
+		entry->refs++;
+	pthread_mutex_unlock(&image_cache_mutex);
+
+	if (entry)
+		return entry;
+
+	/* decode outside of the lock so other files can load in parallel */
+	entry = bzalloc(sizeof(*entry));
+	entry->file = bstrdup(file);
+	entry->timestamp = timestamp;
+	entry->alpha_mode = alpha_mode;
+	entry->refs = 1;
+	gs_image_file5_init(&entry->if5, file, alpha_mode);
+
+	gs_image_file_t *image = &entry->if5.image4.image3.image2.image;
+	if (!image->loaded || image->is_animated_gif)
+		return entry;
+
+	pthread_mutex_lock(&image_cache_mutex);
+	struct image_cache_entry *existing = image_cache_find(file, timestamp, alpha_mode);
+	if (existing) {
+		existing->refs++;
+	} else {
+		entry->shared = true;
+		da_push_back(image_cache, &entry);
+	}
+	pthread_mutex_unlock(&image_cache_mutex);
+
+	/* another source finished decoding the same file first */
+	if (existing) {
+		image_cache_entry_free(entry);
+		entry = existing;
+	}
+
+	return entry;
+}
+
+static void image_cache_load_texture(struct image_cache_entry *entry)
+{
+	pthread_mutex_lock(&image_cache_mutex);
+	if (!entry->texture_loaded) {
+		obs_enter_graphics();
+		gs_image_file5_init_texture(&entry->if5);
+		obs_leave_graphics();
+		entry->texture_loaded = true;
+	}
+	pthread_mutex_unlock(&image_cache_mutex);
+}
+
+static void image_cache_release(struct image_cache_entry *entry)
+{
+	if (!entry)
+		return;
+
+	pthread_mutex_lock(&image_cache_mutex);
+	bool destroy = --entry->refs == 0;
+	if (destroy && entry->shared)
+		da_erase_item(image_cache, &entry);
+	pthread_mutex_unlock(&image_cache_mutex);
+
+	if (destroy)
+		image_cache_entry_free(entry);
+}
+
+/* ------------------------------------------------------------------------- */
+
 struct image_source {
 	obs_source_t *source;
 
@@ -26,10 +151,21 @@ struct image_source {
 	bool restart_gif;
 	volatile bool file_decoded;
 	volatile bool texture_loaded;
+	volatile bool decode_pending;
+	os_task_queue_t *decode_queue;
 
-	gs_image_file4_t if4;
+	/* size of the last decoded image, reported while a decode is pending */
+	uint32_t cx;
+	uint32_t cy;
+
+	struct image_cache_entry *image;
 };
 
+static inline gs_image_file_t *get_image(struct image_source *context)
+{
+	return context->image ? &context->image->if5.image4.image3.image2.image : NULL;
+}
+
 static time_t get_modified_timestamp(const char *filename)
 {
 	struct stat stats;
@@ -51,11 +187,20 @@ void image_source_preload_image(void *data)
 		return;
 
 	context->file_timestamp = get_modified_timestamp(context->file);
-	gs_image_file4_init(&context->if4, context->file,
-			    context->linear_alpha ? GS_IMAGE_ALPHA_PREMULTIPLY_SRGB : GS_IMAGE_ALPHA_PREMULTIPLY);
+	enum gs_image_alpha_mode alpha_mode = context->linear_alpha ? GS_IMAGE_ALPHA_PREMULTIPLY_SRGB
+								    : GS_IMAGE_ALPHA_PREMULTIPLY;
+
+	context->image = image_cache_acquire(context->file, context->file_timestamp, alpha_mode);
 	os_atomic_set_bool(&context->file_decoded, true);
 }
 
+static void image_source_decode_task(void *data)
+{
+	struct image_source *context = data;
+	image_source_preload_image(context);
+	os_atomic_set_bool(&context->decode_pending, false);
+}
+
 static void image_source_load_texture(void *data)
 {
 	struct image_source *context = data;
@@ -64,34 +209,61 @@ static void image_source_load_texture(void *data)
 
 	debug("loading texture '%s'", context->file);
 
-	obs_enter_graphics();
-	gs_image_file4_init_texture(&context->if4);
-	obs_leave_graphics();
+	image_cache_load_texture(context->image);
 
-	if (!context->if4.image3.image2.image.loaded)
+	gs_image_file_t *image = get_image(context);
+	if (!image->loaded)
 		warn("failed to load texture '%s'", context->file);
+	context->cx = image->cx;
+	context->cy = image->cy;
 	context->update_time_elapsed = 0;
 	os_atomic_set_bool(&context->texture_loaded, true);
 }
 
+static void image_source_wait_decode(struct image_source *context)
+{
+	if (os_atomic_load_bool(&context->decode_pending))
+		os_task_queue_wait(context->decode_queue);
+}
+
 static void image_source_unload(void *data)
 {
 	struct image_source *context = data;
+
+	image_source_wait_decode(context);
+
 	os_atomic_set_bool(&context->file_decoded, false);
 	os_atomic_set_bool(&context->texture_loaded, false);
 
 	obs_enter_graphics();
-	gs_image_file4_free(&context->if4);
+	struct image_cache_entry *image = context->image;
+	context->image = NULL;
 	obs_leave_graphics();
+
+	image_cache_release(image);
 }
 
+/* Decoding happens on one of the decode queues; the texture is created on
+ * the next tick once the decoded image is ready.  Until then the source
+ * reports the size of the image it showed before, which is also saved with
+ * its settings.  Sources without a known size (new sources, and private ones
+ * from slideshows, which read their size right away) still load inline. */
 static void image_source_load(struct image_source *context)
 {
 	image_source_unload(context);
 
 	if (context->file && *context->file) {
-		image_source_preload_image(context);
-		image_source_load_texture(context);
+		if (obs_obj_is_private(context->source) || !context->cx || !context->cy) {
+			image_source_preload_image(context);
+			image_source_load_texture(context);
+			return;
+		}
+
+		long idx = os_atomic_inc_long(&next_decode_queue);
+		context->decode_queue = decode_queues[(size_t)idx % num_decode_queues];
+
+		os_atomic_set_bool(&context->decode_pending, true);
+		os_task_queue_queue_task(context->decode_queue, image_source_decode_task, context);
 	}
 }
 
@@ -103,6 +275,9 @@ static void image_source_update(void *data, obs_data_t *settings)
 	const bool linear_alpha = obs_data_get_bool(settings, "linear_alpha");
 	const bool is_slide = obs_data_get_bool(settings, "is_slide");
 
+	/* the decode task reads the file name */
+	image_source_wait_decode(context);
+
 	if (context->file)
 		bfree(context->file);
 	context->file = bstrdup(file);
@@ -146,13 +321,13 @@ static void restart_gif(void *data)
 {
 	struct image_source *context = data;
 
-	if (context->if4.image3.image2.image.is_animated_gif) {
-		context->if4.image3.image2.image.cur_frame = 0;
-		context->if4.image3.image2.image.cur_loop = 0;
-		context->if4.image3.image2.image.cur_time = 0;
+	gs_image_file_t *image = get_image(context);
+
+	if (image && image->is_animated_gif) {
+		gs_image_file5_restart(&context->image->if5);
 
 		obs_enter_graphics();
-		gs_image_file4_update_texture(&context->if4);
+		gs_image_file5_update_texture(&context->image->if5);
 		obs_leave_graphics();
 
 		context->restart_gif = false;
@@ -169,11 +344,21 @@ static void *image_source_create(obs_data_t *settings, obs_source_t *source)
 {
 	struct image_source *context = bzalloc(sizeof(struct image_source));
 	context->source = source;
+	context->cx = (uint32_t)obs_data_get_int(settings, "last_width");
+	context->cy = (uint32_t)obs_data_get_int(settings, "last_height");
 
 	image_source_update(context, settings);
 	return context;
 }
 
+static void image_source_save(void *data, obs_data_t *settings)
+{
+	struct image_source *context = data;
+
+	obs_data_set_int(settings, "last_width", context->cx);
+	obs_data_set_int(settings, "last_height", context->cy);
+}
+
 static void image_source_destroy(void *data)
 {
 	struct image_source *context = data;
@@ -188,13 +373,21 @@ static void image_source_destroy(void *data)
 static uint32_t image_source_getwidth(void *data)
 {
 	struct image_source *context = data;
-	return context->if4.image3.image2.image.cx;
+	if (!os_atomic_load_bool(&context->file_decoded))
+		return context->cx;
+
+	gs_image_file_t *image = get_image(context);
+	return image ? image->cx : 0;
 }
 
 static uint32_t image_source_getheight(void *data)
 {
 	struct image_source *context = data;
-	return context->if4.image3.image2.image.cy;
+	if (!os_atomic_load_bool(&context->file_decoded))
+		return context->cy;
+
+	gs_image_file_t *image = get_image(context);
+	return image ? image->cy : 0;
 }
 
 static void image_source_render(void *data, gs_effect_t *effect)
@@ -203,8 +396,8 @@ static void image_source_render(void *data, gs_effect_t *effect)
 	if (!os_atomic_load_bool(&context->texture_loaded))
 		return;
 
-	struct gs_image_file *const image = &context->if4.image3.image2.image;
-	gs_texture_t *const texture = image->texture;
+	struct gs_image_file *const image = get_image(context);
+	gs_texture_t *const texture = image ? image->texture : NULL;
 	if (!texture)
 		return;
 
@@ -224,6 +417,16 @@ static void image_source_render(void *data, gs_effect_t *effect)
 	gs_enable_framebuffer_srgb(previous);
 }
 
+static gs_texture_t *image_source_get_texture(void *data)
+{
+	struct image_source *context = data;
+	if (!os_atomic_load_bool(&context->texture_loaded))
+		return NULL;
+
+	struct gs_image_file *const image = get_image(context);
+	return image ? image->texture : NULL;
+}
+
 static void image_source_tick(void *data, float seconds)
 {
 	struct image_source *context = data;
@@ -245,13 +448,14 @@ static void image_source_tick(void *data, float seconds)
 
 			if (context->file_timestamp != t) {
 				image_source_load(context);
+				return;
 			}
 		}
 	}
 
 	if (obs_source_showing(context->source)) {
 		if (!context->active) {
-			if (context->if4.image3.image2.image.is_animated_gif)
+			if (get_image(context)->is_animated_gif)
 				context->last_time = frame_time;
 			context->active = true;
 		}
@@ -268,13 +472,13 @@ static void image_source_tick(void *data, float seconds)
 		return;
 	}
 
-	if (context->last_time && context->if4.image3.image2.image.is_animated_gif) {
+	if (context->last_time && get_image(context)->is_animated_gif) {
 		uint64_t elapsed = frame_time - context->last_time;
-		bool updated = gs_image_file4_tick(&context->if4, elapsed);
+		bool updated = gs_image_file5_tick(&context->image->if5, elapsed);
 
 		if (updated) {
 			obs_enter_graphics();
-			gs_image_file4_update_texture(&context->if4);
+			gs_image_file5_update_texture(&context->image->if5);
 			obs_leave_graphics();
 		}
 	}
@@ -316,7 +520,13 @@ static obs_properties_t *image_source_properties(void *data)
 uint64_t image_source_get_memory_usage(void *data)
 {
 	struct image_source *s = data;
-	return s->if4.image3.image2.mem_usage;
+	struct image_cache_entry *image = s->image;
+	if (!image)
+		return 0;
+
+	/* split shared images between their users so totals add up */
+	uint64_t mem_usage = image->if5.image4.image3.image2.mem_usage;
+	return image->shared ? mem_usage / (uint64_t)image->refs : mem_usage;
 }
 
 static void missing_file_callback(void *src, const char *new_path, void *data)
@@ -356,8 +566,8 @@ static enum gs_color_space image_source_get_color_space(void *data, size_t count
 	UNUSED_PARAMETER(preferred_spaces);
 
 	struct image_source *const s = data;
-	gs_image_file4_t *const if4 = &s->if4;
-	return if4->image3.image2.image.texture ? if4->space : GS_CS_SRGB;
+	struct image_cache_entry *const image = s->image;
+	return (image && image->if5.image4.image3.image2.image.texture) ? image->if5.image4.space : GS_CS_SRGB;
 }
 
 static struct obs_source_info image_source_info = {
@@ -368,6 +578,7 @@ static struct obs_source_info image_source_info = {
 	.create = image_source_create,
 	.destroy = image_source_destroy,
 	.update = image_source_update,
+	.save = image_source_save,
 	.get_defaults = image_source_defaults,
 	.show = image_source_show,
 	.hide = image_source_hide,
@@ -380,6 +591,7 @@ static struct obs_source_info image_source_info = {
 	.icon_type = OBS_ICON_TYPE_IMAGE,
 	.activate = image_source_activate,
 	.video_get_color_space = image_source_get_color_space,
+	.video_get_texture = image_source_get_texture,
 };
 
 OBS_DECLARE_MODULE()
@@ -397,6 +609,13 @@ extern struct obs_source_info color_source_info_v3;
 
 bool obs_module_load(void)
 {
+	pthread_mutex_init(&image_cache_mutex, NULL);
+
+	int cores = os_get_logical_cores() / 2;
+	num_decode_queues = cores < 1 ? 1 : (cores > MAX_DECODE_QUEUES ? MAX_DECODE_QUEUES : (size_t)cores);
+	for (size_t i = 0; i < num_decode_queues; i++)
+		decode_queues[i] = os_task_queue_create();
+
 	obs_register_source(&image_source_info);
 	obs_register_source(&color_source_info_v1);
 	obs_register_source(&color_source_info_v2);
@@ -405,3 +624,12 @@ bool obs_module_load(void)
 	obs_register_source(&slideshow_info_mk2);
 	return true;
 }
+
+void obs_module_unload(void)
+{
+	for (size_t i = 0; i < num_decode_queues; i++)
+		os_task_queue_destroy(decode_queues[i]);
+
+	da_free(image_cache);
+	pthread_mutex_destroy(&image_cache_mutex);
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Dynamic bitrate for the SRT & RIST mpegts output, modeled after the RTMP
+ * output's. The protocol stats are turned into a congestion value, where 1.0
+ * or more means the link can't keep up, and what the link currently carries
+ * is used as the estimate of what it can. This only decides the bitrate and
+ * doesn't depend on libobs, so that test/linux/srt-dbr-bench can drive it. */
+
+#define DBR_SEC_TO_NSEC 1000000000ULL
+
+#define DBR_SRT_TRIGGER_MS 200
+#define DBR_RIST_TRIGGER_LOSS_PCT 5
+
+#define DBR_HOLD_TIMER (1ULL * DBR_SEC_TO_NSEC)
+#define DBR_INC_TIMER (4ULL * DBR_SEC_TO_NSEC)
+#define DBR_MIN_BITRATE 50
+
+/* SRT: data that stays unacknowledged in the send buffer for longer than a
+ * round trip plus DBR_SRT_TRIGGER_MS */
+static inline float dbr_srt_congestion(int snd_buf_ms, double rtt_ms)
+{
+	return (float)snd_buf_ms / (float)((int)rtt_ms + DBR_SRT_TRIGGER_MS);
+}
+
+/* RIST: librist has no send buffer stats, so retransmitting more than
+ * DBR_RIST_TRIGGER_LOSS_PCT of the packets counts as congestion instead */
+static inline float dbr_rist_congestion(int quality_pct)
+{
+	return (float)(100 - quality_pct) / (float)DBR_RIST_TRIGGER_LOSS_PCT;
+}
+
+struct dbr_state {
+	long audio_bitrate;
+	long orig_bitrate;
+	long cur_bitrate;
+	long inc_bitrate;
+	uint64_t inc_timeout;
+	uint64_t hold_timeout;
+};
+
+static inline void dbr_state_init(struct dbr_state *dbr, long video_bitrate, long audio_bitrate)
+{
+	dbr->audio_bitrate = audio_bitrate;
+	dbr->orig_bitrate = video_bitrate;
+	dbr->cur_bitrate = video_bitrate;
+	dbr->inc_bitrate = video_bitrate / 10;
+	dbr->inc_timeout = 0;
+	dbr->hold_timeout = 0;
+}
+
+static inline bool dbr_lower_bitrate(struct dbr_state *dbr, long send_rate_kbps, uint64_t t)
+{
+	long est_bitrate = (send_rate_kbps - dbr->audio_bitrate) / 100 * 100;
+	long new_bitrate;
+
+	/* give the encoder and the send buffer time to settle after a change */
+	if (t < dbr->hold_timeout)
+		return false;
+
+	if (est_bitrate > 0 && est_bitrate < dbr->cur_bitrate)
+		new_bitrate = est_bitrate;
+	else
+		new_bitrate = dbr->cur_bitrate - dbr->inc_bitrate;
+
+	if (new_bitrate < DBR_MIN_BITRATE)
+		new_bitrate = DBR_MIN_BITRATE;
+	if (new_bitrate == dbr->cur_bitrate)
+		return false;
+
+	dbr->cur_bitrate = new_bitrate;
+	dbr->inc_timeout = t + DBR_INC_TIMER;
+	dbr->hold_timeout = t + DBR_HOLD_TIMER;
+	return true;
+}
+
+static inline void dbr_raise_bitrate(struct dbr_state *dbr, uint64_t t)
+{
+	dbr->cur_bitrate += dbr->inc_bitrate;
+
+	if (dbr->cur_bitrate >= dbr->orig_bitrate) {
+		dbr->cur_bitrate = dbr->orig_bitrate;
+		dbr->inc_timeout = 0;
+	} else {
+		dbr->inc_timeout = t + DBR_INC_TIMER;
+	}
+
+	dbr->hold_timeout = t + DBR_HOLD_TIMER;
+}
+
+/* returns true if cur_bitrate changed */
+static inline bool dbr_update(struct dbr_state *dbr, float congestion, long send_rate_kbps, uint64_t t)
+{
+	if (congestion >= 1.0f)
+		return dbr_lower_bitrate(dbr, send_rate_kbps, t);
+
+	if (dbr->inc_timeout && t >= dbr->inc_timeout) {
+		dbr_raise_bitrate(dbr, t);
+		return true;
+	}
+
+	return false;
+}
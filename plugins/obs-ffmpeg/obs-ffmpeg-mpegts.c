@@ -38,6 +38,8 @@
 #define info(format, ...) do_log(LOG_INFO, format, ##__VA_ARGS__)
 #define error(format, ...) do_log(LOG_ERROR, format, ##__VA_ARGS__)
 
+#define DBR_CHECK_INTERVAL_MS 100
+
 static void ffmpeg_mpegts_set_last_error(struct ffmpeg_data *data, const char *error)
 {
 	if (data->last_error)
@@ -629,6 +631,8 @@ static void *ffmpeg_mpegts_create(obs_data_t *settings, obs_output_t *output)
 		goto fail;
 	if (os_sem_init(&data->write_sem, 0) != 0)
 		goto fail;
+	if (os_event_init(&data->dbr_stop_event, OS_EVENT_TYPE_MANUAL) != 0)
+		goto fail;
 
 	av_log_set_callback(ffmpeg_mpegts_log_callback);
 
@@ -638,6 +642,7 @@ static void *ffmpeg_mpegts_create(obs_data_t *settings, obs_output_t *output)
 fail:
 	pthread_mutex_destroy(&data->write_mutex);
 	os_event_destroy(data->stop_event);
+	os_sem_destroy(data->write_sem);
 	bfree(data);
 	return NULL;
 }
@@ -657,6 +662,7 @@ static void ffmpeg_mpegts_destroy(void *data)
 		pthread_mutex_destroy(&output->write_mutex);
 		os_sem_destroy(output->write_sem);
 		os_event_destroy(output->stop_event);
+		os_event_destroy(output->dbr_stop_event);
 		bfree(data);
 	}
 }
@@ -728,6 +734,147 @@ end:
 	return ret;
 }
 
+/* ------------------------------------------------------------------------- */
+/* Dynamic bitrate, see obs-ffmpeg-dbr.h. The link is sampled from its own
+ * thread, so that a stalled link is noticed even when no packets get written.
+ * The same measurement is reported as congestion, even with dynamic bitrate
+ * off. */
+
+static void dbr_set_bitrate(struct ffmpeg_output *stream)
+{
+	obs_encoder_t *vencoder = obs_output_get_video_encoder(stream->output);
+	obs_data_t *settings = obs_encoder_get_settings(vencoder);
+
+	obs_data_set_int(settings, "bitrate", stream->dbr.cur_bitrate);
+	obs_encoder_update(vencoder, settings);
+
+	obs_data_release(settings);
+}
+
+static bool dbr_get_congestion(struct ffmpeg_output *stream, float *congestion, long *send_rate_kbps)
+{
+	if (stream->ff_data.config.is_srt) {
+		int snd_buf_ms;
+		double rtt_ms;
+		double send_rate_mbps;
+
+		if (libsrt_get_send_stats(stream->h, &snd_buf_ms, &rtt_ms, &send_rate_mbps) < 0)
+			return false;
+
+		*congestion = dbr_srt_congestion(snd_buf_ms, rtt_ms);
+		*send_rate_kbps = (long)(send_rate_mbps * 1000.0);
+		return true;
+	}
+
+	int quality_pct;
+	int rtt_ms;
+
+	/* the quality of an interval without packets means nothing */
+	if (librist_get_send_stats(stream->h, &quality_pct, &rtt_ms, send_rate_kbps) < 0 || !*send_rate_kbps)
+		return false;
+
+	*congestion = dbr_rist_congestion(quality_pct);
+	return true;
+}
+
+static void dbr_check(struct ffmpeg_output *stream)
+{
+	long prev_bitrate = stream->dbr.cur_bitrate;
+	float congestion;
+	long send_rate_kbps;
+
+	if (!dbr_get_congestion(stream, &congestion, &send_rate_kbps))
+		return;
+
+	stream->congestion = congestion;
+
+	if (!stream->dbr_enabled || !dbr_update(&stream->dbr, congestion, send_rate_kbps, os_gettime_ns()))
+		return;
+
+	if (stream->dbr.cur_bitrate < prev_bitrate)
+		info("bitrate decreased to: %ld", stream->dbr.cur_bitrate);
+	else if (stream->dbr.cur_bitrate == stream->dbr.orig_bitrate)
+		info("bitrate increased to: %ld, done", stream->dbr.cur_bitrate);
+	else
+		info("bitrate increased to: %ld, waiting", stream->dbr.cur_bitrate);
+
+	dbr_set_bitrate(stream);
+}
+
+static void *dbr_thread(void *data)
+{
+	struct ffmpeg_output *stream = data;
+
+	os_set_thread_name("mpegts-dbr");
+
+	while (os_event_timedwait(stream->dbr_stop_event, DBR_CHECK_INTERVAL_MS) == ETIMEDOUT)
+		dbr_check(stream);
+
+	return NULL;
+}
+
+static void dbr_start(struct ffmpeg_output *stream)
+{
+	os_event_reset(stream->dbr_stop_event);
+
+	if (pthread_create(&stream->dbr_thread, NULL, dbr_thread, stream) != 0) {
+		warn("Failed to create dynamic bitrate thread");
+		return;
+	}
+
+	os_atomic_set_bool(&stream->dbr_thread_active, true);
+}
+
+/* stops sampling the link and restores the original bitrate. This has to
+ * happen before the encoder is stopped, so that it doesn't start with the
+ * lowered bitrate next time. */
+static void dbr_stop(struct ffmpeg_output *stream)
+{
+	if (!os_atomic_exchange_bool(&stream->dbr_thread_active, false))
+		return;
+
+	os_event_signal(stream->dbr_stop_event);
+	pthread_join(stream->dbr_thread, NULL);
+
+	if (stream->dbr_enabled && stream->dbr.cur_bitrate != stream->dbr.orig_bitrate) {
+		stream->dbr.cur_bitrate = stream->dbr.orig_bitrate;
+		dbr_set_bitrate(stream);
+	}
+}
+
+static void dbr_init(struct ffmpeg_output *stream, obs_encoder_t *vencoder, const struct ffmpeg_cfg *config)
+{
+	obs_data_t *settings = obs_output_get_settings(stream->output);
+	bool enabled = obs_data_get_bool(settings, "dyn_bitrate");
+	obs_data_release(settings);
+
+	dbr_state_init(&stream->dbr, config->video_bitrate, config->audio_bitrates[0]);
+	stream->congestion = 0.0f;
+	stream->dbr_enabled = false;
+
+	if (!enabled)
+		return;
+
+	if (!config->is_srt && !config->is_rist) {
+		info("Dynamic bitrate disabled. It is only supported with SRT and RIST.");
+		return;
+	}
+
+	if ((obs_encoder_get_caps(vencoder) & OBS_ENCODER_CAP_DYN_BITRATE) == 0) {
+		info("Dynamic bitrate disabled. "
+		     "The encoder does not support on-the-fly bitrate reconfiguration.");
+		return;
+	}
+
+	if (obs_output_get_delay(stream->output) != 0 || stream->dbr.orig_bitrate <= 0)
+		return;
+
+	stream->dbr_enabled = true;
+	info("Dynamic bitrate enabled.");
+}
+
+/* ------------------------------------------------------------------------- */
+
 static void *write_thread(void *data)
 {
 	struct ffmpeg_output *output = data;
@@ -747,6 +894,7 @@ static void *write_thread(void *data)
 			if (ret == -ENOSPC)
 				code = OBS_OUTPUT_NO_SPACE;
 
+			dbr_stop(output);
 			obs_output_signal_stop(output->output, code);
 			ffmpeg_mpegts_deactivate(output);
 			break;
@@ -889,6 +1037,9 @@ static bool set_config(struct ffmpeg_output *stream)
 	// 3.d) set audio frame size
 	config.frame_size = (int)obs_encoder_get_frame_size(aencoders[0]);
 
+	// 3.e) set up dynamic bitrate from the video & audio bitrates
+	dbr_init(stream, vencoder, &config);
+
 	/* 4. Muxer & protocol settings */
 	// This requires some UI to be written for the output.
 	// at the service level unless one can load the output in the settings/stream screen.
@@ -941,6 +1092,8 @@ static bool set_config(struct ffmpeg_output *stream)
 	os_atomic_set_bool(&stream->active, true);
 	stream->write_thread_active = true;
 	stream->total_bytes = 0;
+	if (config.is_srt || config.is_rist)
+		dbr_start(stream);
 	obs_output_begin_data_capture(stream->output, 0);
 
 	return true;
@@ -980,6 +1133,8 @@ static void ffmpeg_mpegts_full_stop(void *data)
 {
 	struct ffmpeg_output *output = data;
 
+	dbr_stop(output);
+
 	if (output->active) {
 		obs_output_end_data_capture(output->output);
 		ffmpeg_mpegts_deactivate(output);
@@ -1005,6 +1160,8 @@ static void ffmpeg_mpegts_stop(void *data, uint64_t ts)
 
 static void ffmpeg_mpegts_deactivate(struct ffmpeg_output *output)
 {
+	dbr_stop(output);
+
 	if (output->write_thread_active) {
 		os_event_signal(output->stop_event);
 		os_sem_post(output->write_sem);
@@ -1027,6 +1184,12 @@ static uint64_t ffmpeg_mpegts_total_bytes(void *data)
 	return output->total_bytes;
 }
 
+static float ffmpeg_mpegts_congestion(void *data)
+{
+	struct ffmpeg_output *output = data;
+	return output->congestion;
+}
+
 static inline int64_t rescale_ts2(AVStream *stream, AVRational codec_time_base, int64_t val)
 {
 	return av_rescale_q_rnd(val / codec_time_base.num, codec_time_base, stream->time_base,
@@ -1152,6 +1315,7 @@ static void ffmpeg_mpegts_data(void *data, struct encoder_packet *packet)
 
 	/* encoder failure */
 	if (!packet) {
+		dbr_stop(stream);
 		obs_output_signal_stop(stream->output, OBS_OUTPUT_ENCODE_ERROR);
 		ffmpeg_mpegts_deactivate(stream);
 		return;
@@ -1198,5 +1362,6 @@ struct obs_output_info ffmpeg_mpegts_muxer = {
 	.stop = ffmpeg_mpegts_stop,
 	.encoded_packet = ffmpeg_mpegts_data,
 	.get_total_bytes = ffmpeg_mpegts_total_bytes,
+	.get_congestion = ffmpeg_mpegts_congestion,
 	.get_properties = ffmpeg_mpegts_properties,
 };
@@ -7,6 +7,7 @@
 #include <libswscale/swscale.h>
 #ifdef NEW_MPEGTS_OUTPUT
 #include "obs-ffmpeg-url.h"
+#include "obs-ffmpeg-dbr.h"
 #endif
 
 struct ffmpeg_cfg {
@@ -114,6 +115,14 @@ struct ffmpeg_output {
 	URLContext *h;
 	AVIOContext *s;
 	bool got_headers;
+
+	/* dynamic bitrate */
+	bool dbr_enabled;
+	struct dbr_state dbr;
+	volatile bool dbr_thread_active;
+	pthread_t dbr_thread;
+	os_event_t *dbr_stop_event;
+	float congestion;
 #endif
 };
 bool ffmpeg_data_init(struct ffmpeg_data *data, struct ffmpeg_cfg *config);
@@ -17,6 +17,7 @@
 
 #pragma once
 #include <obs-module.h>
+#include <util/threading.h>
 #include "obs-ffmpeg-url.h"
 #include <librist/librist.h>
 #include <librist/version.h>
@@ -32,6 +33,11 @@
 
 #define FF_LIBRIST_FIFO_DEFAULT_SHIFT 13
 
+/* sender stats are needed every second for dynamic bitrate, but are only
+ * logged once a minute */
+#define RIST_STATS_INTERVAL_MS 1000
+#define RIST_STATS_LOG_INTERVAL 60
+
 typedef struct RISTContext {
 	int profile;
 	int buffer_size;
@@ -50,6 +56,13 @@ typedef struct RISTContext {
 	struct rist_ctx *ctx;
 	int statsinterval;
 	struct rist_stats_sender_peer *stats_list;
+
+	/* latest sender stats, written from the librist stats thread */
+	int stats_count;
+	volatile bool have_stats;
+	volatile long quality_pct;
+	volatile long rtt_ms;
+	volatile long send_rate_kbps;
 } RISTContext;
 
 static int risterr2ret(int err)
@@ -120,6 +133,25 @@ static int librist_close(URLContext *h)
 static int cb_stats(void *arg, const struct rist_stats *stats_container)
 {
 	RISTContext *s = (RISTContext *)arg;
+
+	if (stats_container->stats_type == RIST_STATS_SENDER_PEER) {
+		const struct rist_stats_sender_peer *peer = &stats_container->stats.sender_peer;
+		size_t bandwidth = 0;
+
+		if (peer->bandwidth > peer->retry_bandwidth)
+			bandwidth = peer->bandwidth - peer->retry_bandwidth;
+
+		os_atomic_set_long(&s->quality_pct, (long)peer->quality);
+		os_atomic_set_long(&s->rtt_ms, (long)peer->rtt);
+		os_atomic_set_long(&s->send_rate_kbps, (long)(bandwidth / 1000));
+		os_atomic_set_bool(&s->have_stats, true);
+	}
+
+	if (s->stats_count++ % RIST_STATS_LOG_INTERVAL != 0) {
+		rist_stats_free(stats_container);
+		return 0;
+	}
+
 	rist_log(&s->logging_settings, RIST_LOG_INFO, "%s\n", stats_container->stats_json);
 	if (stats_container->stats_type == RIST_STATS_SENDER_PEER) {
 		blog(LOG_INFO, "---------------------------------");
@@ -154,7 +186,9 @@ static int librist_open(URLContext *h, const char *uri)
 	s->overrun_nonfatal = 0;
 	s->fifo_shift = FF_LIBRIST_FIFO_DEFAULT_SHIFT;
 	s->logging_settings = (struct rist_logging_settings)LOGGING_SETTINGS_INITIALIZER;
-	s->statsinterval = 60000; // log stats every 60 seconds
+	s->statsinterval = RIST_STATS_INTERVAL_MS;
+	s->stats_count = 0;
+	s->have_stats = false;
 
 	ret = rist_logging_set(&logging_settings, s->log_level, log_cb, h, NULL, NULL);
 	if (ret < 0) {
@@ -251,3 +285,19 @@ static int librist_write(URLContext *h, const uint8_t *buf, int size)
 
 	return ret;
 }
+
+/* Sender state used by the dynamic bitrate logic, as of the last stats
+ * callback: the share of packets that didn't need retransmission, the RTT and
+ * the send rate without retransmissions. */
+static int librist_get_send_stats(URLContext *h, int *quality_pct, int *rtt_ms, long *send_rate_kbps)
+{
+	RISTContext *s = h->priv_data;
+
+	if (!os_atomic_load_bool(&s->have_stats))
+		return -1;
+
+	*quality_pct = (int)os_atomic_load_long(&s->quality_pct);
+	*rtt_ms = (int)os_atomic_load_long(&s->rtt_ms);
+	*send_rate_kbps = os_atomic_load_long(&s->send_rate_kbps);
+	return 0;
+}
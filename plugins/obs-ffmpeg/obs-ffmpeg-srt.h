@@ -782,6 +782,22 @@ static int libsrt_write(URLContext *h, const uint8_t *buf, int size)
 	return ret;
 }
 
+/* Sender state used by the dynamic bitrate logic: the timespan of
+ * unacknowledged data in the send buffer, the RTT and the send rate. */
+static int libsrt_get_send_stats(URLContext *h, int *snd_buf_ms, double *rtt_ms, double *send_rate_mbps)
+{
+	SRTContext *s = (SRTContext *)h->priv_data;
+	SRT_TRACEBSTATS perf = {0};
+
+	if (srt_bstats(s->fd, &perf, 0) < 0)
+		return -1;
+
+	*snd_buf_ms = perf.msSndBuf;
+	*rtt_ms = perf.msRTT;
+	*send_rate_mbps = perf.mbpsSendRate;
+	return 0;
+}
+
 static int libsrt_close(URLContext *h)
 {
 	SRTContext *s = (SRTContext *)h->priv_data;
@@ -359,6 +359,17 @@ bool obs_module_load(void)
 	obs_register_encoder(&pcm32_encoder_info);
 	obs_register_encoder(&alac_encoder_info);
 	obs_register_encoder(&flac_encoder_info);
+
+#if ENABLE_FFMPEG_LOGGING
+	obs_ffmpeg_load_logging();
+#endif
+	return true;
+}
+
+/* checking for hardware encoders can take a while, so it is done off the
+ * loading thread */
+void obs_module_deferred_load(void)
+{
 #ifdef ENABLE_FFMPEG_NVENC
 	bool h264 = false;
 	bool hevc = false;
@@ -410,11 +421,6 @@ bool obs_module_load(void)
 	}
 #endif
 #endif
-
-#if ENABLE_FFMPEG_LOGGING
-	obs_ffmpeg_load_logging();
-#endif
-	return true;
 }
 
 void obs_module_unload(void)
@@ -66,6 +66,7 @@ struct compressor_data {
 
 	float ratio;
 	float threshold;
+	float threshold_mul;
 	float attack_gain;
 	float release_gain;
 	float output_gain;
@@ -191,6 +192,7 @@ static void compressor_update(void *data, obs_data_t *s)
 
 	cd->ratio = (float)obs_data_get_double(s, S_FILTER_RATIO);
 	cd->threshold = (float)obs_data_get_double(s, S_FILTER_THRESHOLD);
+	cd->threshold_mul = db_to_mul(cd->threshold);
 	cd->attack_gain = gain_coefficient(sample_rate, attack_time_ms / MS_IN_S_F);
 	cd->release_gain = gain_coefficient(sample_rate, release_time_ms / MS_IN_S_F);
 	cd->output_gain = db_to_mul(output_gain_db);
@@ -355,16 +357,31 @@ static void analyze_sidechain(struct compressor_data *cd, const uint32_t num_sam
 
 static inline void process_compression(const struct compressor_data *cd, float **samples, uint32_t num_samples)
 {
+	/* The envelope buffer is turned into a gain buffer in place, which is
+	 * then applied to each channel as a separate block. Below threshold
+	 * the gain is unity, and above it the dB domain gain
+	 * slope * (threshold - env_db) is equivalent to
+	 * (threshold_mul / env) ^ slope, which needs a single powf. */
+	float *gain_buf = cd->envelope_buf;
+	const float threshold_mul = cd->threshold_mul;
+	const float slope = cd->slope;
+	const float output_gain = cd->output_gain;
+
 	for (size_t i = 0; i < num_samples; ++i) {
-		const float env_db = mul_to_db(cd->envelope_buf[i]);
-		float gain = cd->slope * (cd->threshold - env_db);
-		gain = db_to_mul(fminf(0, gain));
+		const float env = gain_buf[i];
+		float gain = output_gain;
+		if (env > threshold_mul)
+			gain *= powf(threshold_mul / env, slope);
+		gain_buf[i] = gain;
+	}
 
-		for (size_t c = 0; c < cd->num_channels; ++c) {
-			if (samples[c]) {
-				samples[c][i] *= gain * cd->output_gain;
-			}
-		}
+	for (size_t c = 0; c < cd->num_channels; ++c) {
+		float *channel_samples = samples[c];
+		if (!channel_samples)
+			continue;
+
+		for (size_t i = 0; i < num_samples; ++i)
+			channel_samples[i] *= gain_buf[i];
 	}
 }
 
@@ -96,34 +96,50 @@ static void eq_destroy(void *data)
 
 #define EQ_EPSILON (1.0f / 4294967295.0f)
 
-static inline float eq_process(struct eq_data *eq, struct eq_channel_state *c, float sample)
+/* The channel state and coefficients are copied into locals for the
+ * duration of a block. Since the sample buffer is also float, the compiler
+ * would otherwise have to reload and store the whole state around every
+ * sample it writes back. */
+static void eq_process(const struct eq_data *eq, struct eq_channel_state *state, float *adata, uint32_t frames)
 {
-	float l, m, h;
+	struct eq_channel_state c = *state;
+	const float lf = eq->lf;
+	const float hf = eq->hf;
+	const float low_gain = eq->low_gain;
+	const float mid_gain = eq->mid_gain;
+	const float high_gain = eq->high_gain;
 
-	c->lf_delay0 += eq->lf * (sample - c->lf_delay0) + EQ_EPSILON;
-	c->lf_delay1 += eq->lf * (c->lf_delay0 - c->lf_delay1);
-	c->lf_delay2 += eq->lf * (c->lf_delay1 - c->lf_delay2);
-	c->lf_delay3 += eq->lf * (c->lf_delay2 - c->lf_delay3);
+	for (uint32_t i = 0; i < frames; i++) {
+		const float sample = adata[i];
+		float l, m, h;
 
-	l = c->lf_delay3;
+		c.lf_delay0 += lf * (sample - c.lf_delay0) + EQ_EPSILON;
+		c.lf_delay1 += lf * (c.lf_delay0 - c.lf_delay1);
+		c.lf_delay2 += lf * (c.lf_delay1 - c.lf_delay2);
+		c.lf_delay3 += lf * (c.lf_delay2 - c.lf_delay3);
 
-	c->hf_delay0 += eq->hf * (sample - c->hf_delay0) + EQ_EPSILON;
-	c->hf_delay1 += eq->hf * (c->hf_delay0 - c->hf_delay1);
-	c->hf_delay2 += eq->hf * (c->hf_delay1 - c->hf_delay2);
-	c->hf_delay3 += eq->hf * (c->hf_delay2 - c->hf_delay3);
+		l = c.lf_delay3;
 
-	h = c->sample_delay3 - c->hf_delay3;
-	m = c->sample_delay3 - (h + l);
+		c.hf_delay0 += hf * (sample - c.hf_delay0) + EQ_EPSILON;
+		c.hf_delay1 += hf * (c.hf_delay0 - c.hf_delay1);
+		c.hf_delay2 += hf * (c.hf_delay1 - c.hf_delay2);
+		c.hf_delay3 += hf * (c.hf_delay2 - c.hf_delay3);
 
-	l *= eq->low_gain;
-	m *= eq->mid_gain;
-	h *= eq->high_gain;
+		h = c.sample_delay3 - c.hf_delay3;
+		m = c.sample_delay3 - (h + l);
 
-	c->sample_delay3 = c->sample_delay2;
-	c->sample_delay2 = c->sample_delay1;
-	c->sample_delay1 = sample;
+		l *= low_gain;
+		m *= mid_gain;
+		h *= high_gain;
 
-	return l + m + h;
+		c.sample_delay3 = c.sample_delay2;
+		c.sample_delay2 = c.sample_delay1;
+		c.sample_delay1 = sample;
+
+		adata[i] = l + m + h;
+	}
+
+	*state = c;
 }
 
 static struct obs_audio_data *eq_filter_audio(void *data, struct obs_audio_data *audio)
@@ -131,14 +147,8 @@ static struct obs_audio_data *eq_filter_audio(void *data, struct obs_audio_data
 	struct eq_data *eq = data;
 	const uint32_t frames = audio->frames;
 
-	for (size_t c = 0; c < eq->channels; c++) {
-		float *adata = (float *)audio->data[c];
-		struct eq_channel_state *channel = &eq->eqs[c];
-
-		for (size_t i = 0; i < frames; i++) {
-			adata[i] = eq_process(eq, channel, adata[i]);
-		}
-	}
+	for (size_t c = 0; c < eq->channels; c++)
+		eq_process(eq, &eq->eqs[c], (float *)audio->data[c], frames);
 
 	return audio;
 }
@@ -299,15 +299,15 @@ static void analyze_envelope(struct expander_data *cd, float **samples, const ui
 		float *env_in = cd->env_in;
 
 		if (cd->detector == RMS_DETECT) {
-			runave[0] = rmscoef * cd->runave[chan] + (1 - rmscoef) * powf(samples[chan][0], 2.0f);
+			runave[0] = rmscoef * cd->runave[chan] + (1 - rmscoef) * samples[chan][0] * samples[chan][0];
 			env_in[0] = sqrtf(fmaxf(runave[0], 0));
 			for (uint32_t i = 1; i < num_samples; ++i) {
-				runave[i] = rmscoef * runave[i - 1] + (1 - rmscoef) * powf(samples[chan][i], 2.0f);
+				runave[i] = rmscoef * runave[i - 1] + (1 - rmscoef) * samples[chan][i] * samples[chan][i];
 				env_in[i] = sqrtf(runave[i]);
 			}
 		} else if (cd->detector == PEAK_DETECT) {
 			for (uint32_t i = 0; i < num_samples; ++i) {
-				runave[i] = powf(samples[chan][i], 2);
+				runave[i] = samples[chan][i] * samples[chan][i];
 				env_in[i] = fabsf(samples[chan][i]);
 			}
 		}
@@ -2,15 +2,49 @@
 #include <util/deque.h>
 #include <util/util_uint64.h>
 
+#define do_log(level, format, ...) \
+	blog(level, "[gpu delay: '%s'] " format, obs_source_get_name(f->context), ##__VA_ARGS__)
+
+#define warn(format, ...) do_log(LOG_WARNING, format, ##__VA_ARGS__)
+#define info(format, ...) do_log(LOG_INFO, format, ##__VA_ARGS__)
+
 #define S_DELAY_MS "delay_ms"
+#define S_STORAGE "storage"
+#define S_VRAM_BUDGET "vram_budget_mb"
+#define S_SPILL "spill_to_ram"
+
 #define T_DELAY_MS obs_module_text("DelayMs")
+#define T_STORAGE obs_module_text("GPUDelayFilter.Storage")
+#define T_STORAGE_FULL obs_module_text("GPUDelayFilter.Storage.Full")
+#define T_STORAGE_COMPACT obs_module_text("GPUDelayFilter.Storage.Compact")
+#define T_VRAM_BUDGET obs_module_text("GPUDelayFilter.VRAMBudget")
+#define T_SPILL obs_module_text("GPUDelayFilter.SpillToRAM")
+
+/* frames that are kept in system memory are downloaded through this many
+ * staging surfaces so that reading them back never waits for the GPU */
+#define STAGE_COUNT 3
+
+enum frame_storage {
+	STORAGE_FULL,
+	STORAGE_COMPACT,
+};
 
+/* With compact storage, render holds the luma plane and uv_render the
+ * chroma plane of an NV12 image at half the resolution */
 struct frame {
 	gs_texrender_t *render;
+	gs_texrender_t *uv_render;
 	enum gs_color_space space;
 	uint64_t ts;
 };
 
+struct staged_frame {
+	gs_stagesurf_t *surf;
+	gs_stagesurf_t *uv_surf;
+	enum gs_color_space space;
+	bool pending;
+};
+
 struct gpu_delay_filter_data {
 	obs_source_t *context;
 	struct deque frames;
@@ -20,6 +54,34 @@ struct gpu_delay_filter_data {
 	uint32_t cy;
 	bool target_valid;
 	bool processed_frame;
+
+	enum frame_storage storage;
+	uint64_t vram_budget;
+	bool spill_to_ram;
+	enum gs_color_format format;
+
+	gs_effect_t *effect;
+	gs_eparam_t *param_image;
+	gs_eparam_t *param_image_uv;
+	gs_eparam_t *param_multiplier;
+
+	/* the target is rendered here first when it is converted */
+	gs_texrender_t *capture_render;
+
+	/* frames kept in system memory */
+	bool spilling;
+	struct frame work;
+	struct staged_frame staged[STAGE_COUNT];
+	size_t stage_idx;
+	struct deque ram_frames;
+	size_t ram_delay_frames;
+	gs_texture_t *upload_tex;
+	gs_texture_t *upload_uv_tex;
+	enum gs_color_space upload_space;
+	bool upload_valid;
+
+	uint64_t video_memory;
+	uint64_t system_memory;
 };
 
 static const char *gpu_delay_filter_get_name(void *unused)
@@ -28,16 +90,98 @@ static const char *gpu_delay_filter_get_name(void *unused)
 	return obs_module_text("GPUDelayFilter");
 }
 
+static inline bool compact(const struct gpu_delay_filter_data *f)
+{
+	return f->storage == STORAGE_COMPACT;
+}
+
+static inline uint32_t uv_width(const struct gpu_delay_filter_data *f)
+{
+	return (f->cx + 1) / 2;
+}
+
+static inline uint32_t uv_height(const struct gpu_delay_filter_data *f)
+{
+	return (f->cy + 1) / 2;
+}
+
+static inline uint32_t format_size(enum gs_color_format format)
+{
+	return format == GS_RGBA16F ? 8 : 4;
+}
+
+static inline size_t luma_row_size(const struct gpu_delay_filter_data *f)
+{
+	return compact(f) ? f->cx : (size_t)f->cx * format_size(f->format);
+}
+
+static inline size_t uv_row_size(const struct gpu_delay_filter_data *f)
+{
+	return (size_t)uv_width(f) * 2;
+}
+
+static size_t get_frame_size(const struct gpu_delay_filter_data *f)
+{
+	size_t size = luma_row_size(f) * f->cy;
+	if (compact(f))
+		size += uv_row_size(f) * uv_height(f);
+	return size;
+}
+
+static inline size_t get_record_size(const struct gpu_delay_filter_data *f)
+{
+	return sizeof(enum gs_color_space) + get_frame_size(f);
+}
+
+static inline void destroy_frame(struct frame *frame)
+{
+	gs_texrender_destroy(frame->render);
+	gs_texrender_destroy(frame->uv_render);
+	frame->render = NULL;
+	frame->uv_render = NULL;
+}
+
+static void free_spill_data(struct gpu_delay_filter_data *f)
+{
+	destroy_frame(&f->work);
+
+	for (size_t i = 0; i < STAGE_COUNT; i++) {
+		struct staged_frame *stage = &f->staged[i];
+		gs_stagesurface_destroy(stage->surf);
+		gs_stagesurface_destroy(stage->uv_surf);
+		stage->surf = NULL;
+		stage->uv_surf = NULL;
+		stage->pending = false;
+	}
+
+	gs_texture_destroy(f->upload_tex);
+	gs_texture_destroy(f->upload_uv_tex);
+	f->upload_tex = NULL;
+	f->upload_uv_tex = NULL;
+	f->upload_valid = false;
+
+	deque_free(&f->ram_frames);
+	f->stage_idx = 0;
+	f->spilling = false;
+}
+
 static void free_textures(struct gpu_delay_filter_data *f)
 {
 	obs_enter_graphics();
 	while (f->frames.size) {
 		struct frame frame;
 		deque_pop_front(&f->frames, &frame, sizeof(frame));
-		gs_texrender_destroy(frame.render);
+		destroy_frame(&frame);
 	}
 	deque_free(&f->frames);
+
+	free_spill_data(f);
+	gs_texrender_destroy(f->capture_render);
+	f->capture_render = NULL;
 	obs_leave_graphics();
+
+	f->video_memory = 0;
+	f->system_memory = 0;
 }
 
 static size_t num_frames(struct deque *buf)
@@ -45,6 +189,62 @@ static size_t num_frames(struct deque *buf)
 	return buf->size / sizeof(struct frame);
 }
 
+static inline void create_frame(struct gpu_delay_filter_data *f, struct frame *frame)
+{
+	if (compact(f)) {
+		frame->render = gs_texrender_create(GS_R8, GS_ZS_NONE);
+		frame->uv_render = gs_texrender_create(GS_R8G8, GS_ZS_NONE);
+	} else {
+		frame->render = gs_texrender_create(f->format, GS_ZS_NONE);
+		frame->uv_render = NULL;
+	}
+}
+
+/* Frames go through the GPU as usual but wait out their delay in system
+ * memory: each frame is staged, read back STAGE_COUNT frames later, and
+ * uploaded again when it is due. */
+static void start_spilling(struct gpu_delay_filter_data *f, size_t num)
+{
+	const size_t frame_size = get_frame_size(f);
+	const size_t record_size = get_record_size(f);
+
+	f->spilling = true;
+	f->ram_delay_frames = num - 1 - STAGE_COUNT;
+
+	/* reserved up front so that it never grows past what the delay
+	 * needs */
+	deque_reserve(&f->ram_frames, (f->ram_delay_frames + 1) * record_size);
+
+	obs_enter_graphics();
+
+	for (size_t i = 0; i < STAGE_COUNT; i++) {
+		struct staged_frame *stage = &f->staged[i];
+
+		if (compact(f)) {
+			stage->surf = gs_stagesurface_create(f->cx, f->cy, GS_R8);
+			stage->uv_surf = gs_stagesurface_create(uv_width(f), uv_height(f), GS_R8G8);
+		} else {
+			stage->surf = gs_stagesurface_create(f->cx, f->cy, f->format);
+		}
+	}
+
+	if (compact(f)) {
+		f->work.render = gs_texrender_create_pooled(GS_R8, GS_ZS_NONE);
+		f->work.uv_render = gs_texrender_create_pooled(GS_R8G8, GS_ZS_NONE);
+		f->upload_tex = gs_texture_create(f->cx, f->cy, GS_R8, 1, NULL, GS_DYNAMIC);
+		f->upload_uv_tex = gs_texture_create(uv_width(f), uv_height(f), GS_R8G8, 1, NULL, GS_DYNAMIC);
+	} else {
+		f->work.render = gs_texrender_create_pooled(f->format, GS_ZS_NONE);
+		f->upload_tex = gs_texture_create(f->cx, f->cy, f->format, 1, NULL, GS_DYNAMIC);
+	}
+
+	obs_leave_graphics();
+
+	/* the frame being rendered, the staged frames and the uploaded one */
+	f->video_memory = (uint64_t)frame_size * (STAGE_COUNT + 2);
+	f->system_memory = (uint64_t)f->ram_frames.capacity;
+}
+
 static void update_interval(struct gpu_delay_filter_data *f, uint64_t new_interval_ns)
 {
 	if (!f->target_valid) {
@@ -55,6 +255,35 @@ static void update_interval(struct gpu_delay_filter_data *f, uint64_t new_interv
 	f->interval_ns = new_interval_ns;
 	size_t num = (size_t)(f->delay_ns / new_interval_ns);
 
+	const size_t frame_size = get_frame_size(f);
+	const uint64_t capture_size = compact(f) ? (uint64_t)f->cx * f->cy * 4 : 0;
+	const uint64_t budget = f->vram_budget > capture_size ? f->vram_budget - capture_size : 0;
+	const size_t max_frames = (size_t)(budget / frame_size);
+
+	if (num > max_frames) {
+		if (f->spill_to_ram && num > STAGE_COUNT + 1) {
+			if (!f->spilling || f->ram_delay_frames != num - 1 - STAGE_COUNT) {
+				free_textures(f);
+				start_spilling(f, num);
+				f->video_memory += capture_size;
+
+				info("%zu frames exceed the video memory budget, keeping %.1f MB of frames in "
+				     "system memory",
+				     num, (double)f->system_memory / (1024.0 * 1024.0));
+			}
+			return;
+		}
+
+		warn("%zu frames exceed the video memory budget, delay is limited to %zu frames", num, max_frames);
+		num = max_frames;
+	}
+
+	if (f->spilling) {
+		obs_enter_graphics();
+		free_spill_data(f);
+		obs_leave_graphics();
+	}
+
 	if (num > num_frames(&f->frames)) {
 		size_t prev_num = num_frames(&f->frames);
 
@@ -64,7 +293,7 @@ static void update_interval(struct gpu_delay_filter_data *f, uint64_t new_interv
 
 		for (size_t i = prev_num; i < num; i++) {
 			struct frame *frame = deque_data(&f->frames, i * sizeof(*frame));
-			frame->render = gs_texrender_create(GS_RGBA, GS_ZS_NONE);
+			create_frame(f, frame);
 		}
 
 		obs_leave_graphics();
@@ -75,11 +304,14 @@ static void update_interval(struct gpu_delay_filter_data *f, uint64_t new_interv
 		while (num_frames(&f->frames) > num) {
 			struct frame frame;
 			deque_pop_front(&f->frames, &frame, sizeof(frame));
-			gs_texrender_destroy(frame.render);
+			destroy_frame(&frame);
 		}
 
 		obs_leave_graphics();
 	}
+
+	f->video_memory = (uint64_t)frame_size * num + capture_size;
+	f->system_memory = 0;
 }
 
 static inline void check_interval(struct gpu_delay_filter_data *f)
@@ -134,6 +366,9 @@ static void gpu_delay_filter_update(void *data, obs_data_t *s)
 	struct gpu_delay_filter_data *f = data;
 
 	f->delay_ns = (uint64_t)obs_data_get_int(s, S_DELAY_MS) * 1000000ULL;
+	f->storage = f->effect ? (enum frame_storage)obs_data_get_int(s, S_STORAGE) : STORAGE_FULL;
+	f->vram_budget = (uint64_t)obs_data_get_int(s, S_VRAM_BUDGET) * 1024 * 1024;
+	f->spill_to_ram = obs_data_get_bool(s, S_SPILL);
 
 	/* full reset */
 	f->cx = 0;
@@ -146,17 +381,61 @@ static obs_properties_t *gpu_delay_filter_properties(void *data)
 {
 	obs_properties_t *props = obs_properties_create();
 
-	obs_property_t *p = obs_properties_add_int(props, S_DELAY_MS, T_DELAY_MS, 0, 500, 1);
+	obs_property_t *p = obs_properties_add_int(props, S_DELAY_MS, T_DELAY_MS, 0, 30000, 1);
 	obs_property_int_set_suffix(p, " ms");
 
+	p = obs_properties_add_list(props, S_STORAGE, T_STORAGE, OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_INT);
+	obs_property_list_add_int(p, T_STORAGE_FULL, STORAGE_FULL);
+	obs_property_list_add_int(p, T_STORAGE_COMPACT, STORAGE_COMPACT);
+
+	p = obs_properties_add_int(props, S_VRAM_BUDGET, T_VRAM_BUDGET, 64, 16384, 64);
+	obs_property_int_set_suffix(p, " MB");
+
+	obs_properties_add_bool(props, S_SPILL, T_SPILL);
+
 	UNUSED_PARAMETER(data);
 	return props;
 }
 
+static void gpu_delay_filter_defaults(obs_data_t *settings)
+{
+	obs_data_set_default_int(settings, S_STORAGE, STORAGE_FULL);
+	obs_data_set_default_int(settings, S_VRAM_BUDGET, 2048);
+	obs_data_set_default_bool(settings, S_SPILL, true);
+}
+
+static void get_memory_usage_proc(void *data, calldata_t *cd)
+{
+	struct gpu_delay_filter_data *f = data;
+
+	calldata_set_int(cd, "video_memory", (long long)f->video_memory);
+	calldata_set_int(cd, "system_memory", (long long)f->system_memory);
+}
+
 static void *gpu_delay_filter_create(obs_data_t *settings, obs_source_t *context)
 {
 	struct gpu_delay_filter_data *f = bzalloc(sizeof(*f));
+	char *effect_path = obs_module_file("gpu_delay.effect");
+
 	f->context = context;
+	f->format = GS_RGBA;
+
+	obs_enter_graphics();
+	f->effect = gs_effect_create_from_file(effect_path, NULL);
+	obs_leave_graphics();
+
+	bfree(effect_path);
+
+	/* without the effect, frames are always stored in full quality */
+	if (f->effect) {
+		f->param_image = gs_effect_get_param_by_name(f->effect, "image");
+		f->param_image_uv = gs_effect_get_param_by_name(f->effect, "image_uv");
+		f->param_multiplier = gs_effect_get_param_by_name(f->effect, "multiplier");
+	}
+
+	proc_handler_t *ph = obs_source_get_proc_handler(context);
+	proc_handler_add(ph, "void get_memory_usage(out int video_memory, out int system_memory)",
+			 get_memory_usage_proc, f);
 
 	obs_source_update(context, settings);
 	return f;
@@ -167,6 +446,11 @@ static void gpu_delay_filter_destroy(void *data)
 	struct gpu_delay_filter_data *f = data;
 
 	free_textures(f);
+
+	obs_enter_graphics();
+	gs_effect_destroy(f->effect);
+	obs_leave_graphics();
+
 	bfree(f);
 }
 
@@ -232,67 +516,68 @@ static const char *get_tech_name_and_multiplier(enum gs_color_space current_spac
 
 static void draw_frame(struct gpu_delay_filter_data *f)
 {
-	struct frame frame;
-	deque_peek_front(&f->frames, &frame, sizeof(frame));
+	gs_texture_t *tex;
+	gs_texture_t *uv_tex;
+	enum gs_color_space space;
 
-	const enum gs_color_space current_space = gs_get_color_space();
-	float multiplier;
-	const char *technique = get_tech_name_and_multiplier(current_space, frame.space, &multiplier);
+	if (f->spilling) {
+		if (!f->upload_valid)
+			return;
+
+		tex = f->upload_tex;
+		uv_tex = f->upload_uv_tex;
+		space = f->upload_space;
+	} else {
+		struct frame frame;
+		deque_peek_front(&f->frames, &frame, sizeof(frame));
 
-	gs_effect_t *effect = obs_get_base_effect(OBS_EFFECT_DEFAULT);
-	gs_texture_t *tex = gs_texrender_get_texture(frame.render);
-	if (tex) {
-		const bool previous = gs_framebuffer_srgb_enabled();
-		gs_enable_framebuffer_srgb(true);
+		tex = gs_texrender_get_texture(frame.render);
+		uv_tex = frame.uv_render ? gs_texrender_get_texture(frame.uv_render) : NULL;
+		space = frame.space;
+	}
+
+	if (!tex || (compact(f) && !uv_tex))
+		return;
 
+	const enum gs_color_space current_space = gs_get_color_space();
+	float multiplier;
+	const char *technique = get_tech_name_and_multiplier(current_space, space, &multiplier);
+
+	const bool previous = gs_framebuffer_srgb_enabled();
+	gs_enable_framebuffer_srgb(true);
+
+	gs_effect_t *effect;
+	if (compact(f)) {
+		/* the planes hold sRGB encoded values, which the effect
+		 * decodes after converting them back to RGB */
+		effect = f->effect;
+		gs_effect_set_texture(f->param_image, tex);
+		gs_effect_set_texture(f->param_image_uv, uv_tex);
+		gs_effect_set_float(f->param_multiplier, multiplier);
+	} else {
+		effect = obs_get_base_effect(OBS_EFFECT_DEFAULT);
 		gs_effect_set_texture_srgb(gs_effect_get_param_by_name(effect, "image"), tex);
 		gs_effect_set_float(gs_effect_get_param_by_name(effect, "multiplier"), multiplier);
+	}
 
-		while (gs_effect_loop(effect, technique))
-			gs_draw_sprite(tex, 0, f->cx, f->cy);
+	while (gs_effect_loop(effect, technique))
+		gs_draw_sprite(tex, 0, f->cx, f->cy);
 
-		gs_enable_framebuffer_srgb(previous);
-	}
+	gs_enable_framebuffer_srgb(previous);
 }
 
-static void gpu_delay_filter_render(void *data, gs_effect_t *effect)
+static bool render_target(struct gpu_delay_filter_data *f, gs_texrender_t *render, enum gs_color_space space)
 {
-	struct gpu_delay_filter_data *f = data;
 	obs_source_t *target = obs_filter_get_target(f->context);
 	obs_source_t *parent = obs_filter_get_parent(f->context);
+	bool success = false;
 
-	if (!f->target_valid || !target || !parent || !f->frames.size) {
-		obs_source_skip_video_filter(f->context);
-		return;
-	}
-
-	if (f->processed_frame) {
-		draw_frame(f);
-		return;
-	}
-
-	struct frame frame;
-	deque_pop_front(&f->frames, &frame, sizeof(frame));
-
-	const enum gs_color_space preferred_spaces[] = {
-		GS_CS_SRGB,
-		GS_CS_SRGB_16F,
-		GS_CS_709_EXTENDED,
-	};
-	const enum gs_color_space space =
-		obs_source_get_color_space(target, OBS_COUNTOF(preferred_spaces), preferred_spaces);
-	const enum gs_color_format format = gs_get_format_from_space(space);
-	if (gs_texrender_get_format(frame.render) != format) {
-		gs_texrender_destroy(frame.render);
-		frame.render = gs_texrender_create(format, GS_ZS_NONE);
-	}
-
-	gs_texrender_reset(frame.render);
+	gs_texrender_reset(render);
 
 	gs_blend_state_push();
 	gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
 
-	if (gs_texrender_begin_with_color_space(frame.render, f->cx, f->cy, space)) {
+	if (gs_texrender_begin_with_color_space(render, f->cx, f->cy, space)) {
 		uint32_t parent_flags = obs_source_get_output_flags(target);
 		bool custom_draw = (parent_flags & OBS_SOURCE_CUSTOM_DRAW) != 0;
 		bool async = (parent_flags & OBS_SOURCE_ASYNC) != 0;
@@ -307,14 +592,208 @@ static void gpu_delay_filter_render(void *data, gs_effect_t *effect)
 		else
 			obs_source_video_render(target);
 
-		gs_texrender_end(frame.render);
+		gs_texrender_end(render);
+		success = true;
+	}
+
+	gs_blend_state_pop();
+	return success;
+}
+
+static void render_plane(struct gpu_delay_filter_data *f, gs_texrender_t *render, const char *technique,
+			 gs_texture_t *tex, uint32_t cx, uint32_t cy)
+{
+	gs_texrender_reset(render);
+
+	if (gs_texrender_begin(render, cx, cy)) {
+		gs_ortho(0.0f, (float)cx, 0.0f, (float)cy, -100.0f, 100.0f);
+
+		while (gs_effect_loop(f->effect, technique))
+			gs_draw_sprite(tex, 0, cx, cy);
+
+		gs_texrender_end(render);
+	}
+}
+
+/* Renders the target and stores it in the frame, converted to NV12 with
+ * compact storage */
+static bool capture_frame(struct gpu_delay_filter_data *f, struct frame *frame, enum gs_color_space space)
+{
+	if (!compact(f)) {
+		if (gs_texrender_get_format(frame->render) != f->format) {
+			gs_texrender_destroy(frame->render);
+			frame->render = gs_texrender_create(f->format, GS_ZS_NONE);
+		}
+
+		if (!render_target(f, frame->render, space))
+			return false;
 
-		frame.space = space;
+		frame->space = space;
+		return true;
 	}
 
+	if (!f->capture_render)
+		f->capture_render = gs_texrender_create_pooled(GS_RGBA, GS_ZS_NONE);
+	if (!render_target(f, f->capture_render, GS_CS_SRGB))
+		return false;
+
+	gs_texture_t *tex = gs_texrender_get_texture(f->capture_render);
+	if (!tex)
+		return false;
+
+	const bool previous = gs_framebuffer_srgb_enabled();
+	gs_enable_framebuffer_srgb(false);
+
+	gs_blend_state_push();
+	gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
+
+	gs_effect_set_texture(f->param_image, tex);
+	render_plane(f, frame->render, "ConvertY", tex, f->cx, f->cy);
+	render_plane(f, frame->uv_render, "ConvertUV", tex, uv_width(f), uv_height(f));
+
 	gs_blend_state_pop();
 
+	gs_enable_framebuffer_srgb(previous);
+
+	frame->space = GS_CS_SRGB;
+	return true;
+}
+
+static void push_plane(struct deque *dq, gs_stagesurf_t *surf, size_t row_size, uint32_t rows)
+{
+	uint8_t *data;
+	uint32_t linesize;
+
+	if (!gs_stagesurface_map(surf, &data, &linesize)) {
+		deque_push_back_zero(dq, row_size * rows);
+		return;
+	}
+
+	for (uint32_t y = 0; y < rows; y++)
+		deque_push_back(dq, data + (size_t)y * linesize, row_size);
+
+	gs_stagesurface_unmap(surf);
+}
+
+static void pop_plane(struct deque *dq, gs_texture_t *tex, size_t row_size, uint32_t rows)
+{
+	uint8_t *ptr;
+	uint32_t linesize;
+
+	if (!gs_texture_map(tex, &ptr, &linesize)) {
+		deque_pop_front(dq, NULL, row_size * rows);
+		return;
+	}
+
+	for (uint32_t y = 0; y < rows; y++)
+		deque_pop_front(dq, ptr + (size_t)y * linesize, row_size);
+
+	gs_texture_unmap(tex);
+}
+
+static void read_staged_frame(struct gpu_delay_filter_data *f, struct staged_frame *stage)
+{
+	deque_push_back(&f->ram_frames, &stage->space, sizeof(stage->space));
+	push_plane(&f->ram_frames, stage->surf, luma_row_size(f), f->cy);
+	if (compact(f))
+		push_plane(&f->ram_frames, stage->uv_surf, uv_row_size(f), uv_height(f));
+
+	stage->pending = false;
+}
+
+static void upload_frame(struct gpu_delay_filter_data *f)
+{
+	const size_t record_size = get_record_size(f);
+
+	/* only happens if frames were skipped, catch up */
+	while (f->ram_frames.size / record_size > f->ram_delay_frames + 1)
+		deque_pop_front(&f->ram_frames, NULL, record_size);
+
+	deque_pop_front(&f->ram_frames, &f->upload_space, sizeof(f->upload_space));
+	pop_plane(&f->ram_frames, f->upload_tex, luma_row_size(f), f->cy);
+	if (compact(f))
+		pop_plane(&f->ram_frames, f->upload_uv_tex, uv_row_size(f), uv_height(f));
+
+	f->upload_valid = true;
+}
+
+static void process_spilled_frame(struct gpu_delay_filter_data *f, enum gs_color_space space)
+{
+	struct staged_frame *stage = &f->staged[f->stage_idx];
+
+	/* staged STAGE_COUNT frames ago, so it should be ready by now */
+	if (stage->pending)
+		read_staged_frame(f, stage);
+
+	if (capture_frame(f, &f->work, space)) {
+		gs_stage_texture(stage->surf, gs_texrender_get_texture(f->work.render));
+		if (compact(f))
+			gs_stage_texture(stage->uv_surf, gs_texrender_get_texture(f->work.uv_render));
+
+		stage->space = f->work.space;
+		stage->pending = true;
+	}
+
+	f->stage_idx = (f->stage_idx + 1) % STAGE_COUNT;
+
+	if (f->ram_frames.size / get_record_size(f) > f->ram_delay_frames)
+		upload_frame(f);
+}
+
+static void process_frame(struct gpu_delay_filter_data *f, enum gs_color_space space)
+{
+	struct frame frame;
+	deque_pop_front(&f->frames, &frame, sizeof(frame));
+	capture_frame(f, &frame, space);
 	deque_push_back(&f->frames, &frame, sizeof(frame));
+}
+
+static inline bool has_frames(const struct gpu_delay_filter_data *f)
+{
+	return f->spilling || f->frames.size;
+}
+
+static void gpu_delay_filter_render(void *data, gs_effect_t *effect)
+{
+	struct gpu_delay_filter_data *f = data;
+	obs_source_t *target = obs_filter_get_target(f->context);
+	obs_source_t *parent = obs_filter_get_parent(f->context);
+
+	if (!f->target_valid || !target || !parent || !has_frames(f)) {
+		obs_source_skip_video_filter(f->context);
+		return;
+	}
+
+	if (f->processed_frame) {
+		draw_frame(f);
+		return;
+	}
+
+	/* compact storage only keeps SDR frames */
+	const enum gs_color_space preferred_spaces[] = {
+		GS_CS_SRGB,
+		GS_CS_SRGB_16F,
+		GS_CS_709_EXTENDED,
+	};
+	const size_t num_spaces = compact(f) ? 1 : OBS_COUNTOF(preferred_spaces);
+	const enum gs_color_space space = obs_source_get_color_space(target, num_spaces, preferred_spaces);
+	const enum gs_color_format format = gs_get_format_from_space(space);
+
+	/* the memory budget depends on the format, so start over with the
+	 * new one on the next tick */
+	if (!compact(f) && format != f->format) {
+		f->format = format;
+		f->cx = 0;
+		f->cy = 0;
+		obs_source_skip_video_filter(f->context);
+		return;
+	}
+
+	if (f->spilling)
+		process_spilled_frame(f, space);
+	else
+		process_frame(f, space);
+
 	draw_frame(f);
 	f->processed_frame = true;
 
@@ -328,16 +807,23 @@ static enum gs_color_space gpu_delay_filter_get_color_space(void *data, size_t c
 	obs_source_t *target = obs_filter_get_target(f->context);
 	obs_source_t *parent = obs_filter_get_parent(f->context);
 
-	if (!f->target_valid || !target || !parent || !f->frames.size) {
+	if (!f->target_valid || !target || !parent || !has_frames(f)) {
 		return (count > 0) ? preferred_spaces[0] : GS_CS_SRGB;
 	}
 
-	struct frame frame;
-	deque_peek_front(&f->frames, &frame, sizeof(frame));
-	enum gs_color_space space = frame.space;
+	enum gs_color_space frame_space;
+	if (f->spilling) {
+		frame_space = f->upload_valid ? f->upload_space : GS_CS_SRGB;
+	} else {
+		struct frame frame;
+		deque_peek_front(&f->frames, &frame, sizeof(frame));
+		frame_space = frame.space;
+	}
+
+	enum gs_color_space space = frame_space;
 	for (size_t i = 0; i < count; ++i) {
 		space = preferred_spaces[i];
-		if (space == frame.space)
+		if (space == frame_space)
 			break;
 	}
 
@@ -352,6 +838,7 @@ struct obs_source_info gpu_delay_filter = {
 	.create = gpu_delay_filter_create,
 	.destroy = gpu_delay_filter_destroy,
 	.update = gpu_delay_filter_update,
+	.get_defaults = gpu_delay_filter_defaults,
 	.get_properties = gpu_delay_filter_properties,
 	.video_tick = gpu_delay_filter_tick,
 	.video_render = gpu_delay_filter_render,
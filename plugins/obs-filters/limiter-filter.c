@@ -50,6 +50,7 @@ struct limiter_data {
 	size_t envelope_buf_len;
 
 	float threshold;
+	float threshold_mul;
 	float attack_gain;
 	float release_gain;
 	float output_gain;
@@ -57,7 +58,6 @@ struct limiter_data {
 	size_t num_channels;
 	size_t sample_rate;
 	float envelope;
-	float slope;
 };
 
 /* -------------------------------------------------------- */
@@ -91,13 +91,13 @@ static void limiter_update(void *data, obs_data_t *s)
 	const float output_gain_db = 0;
 
 	cd->threshold = (float)obs_data_get_double(s, S_FILTER_THRESHOLD);
+	cd->threshold_mul = db_to_mul(cd->threshold);
 
 	cd->attack_gain = gain_coefficient(sample_rate, attack_time_ms / MS_IN_S_F);
 	cd->release_gain = gain_coefficient(sample_rate, release_time_ms / MS_IN_S_F);
 	cd->output_gain = db_to_mul(output_gain_db);
 	cd->num_channels = num_channels;
 	cd->sample_rate = sample_rate;
-	cd->slope = 1.0f;
 
 	size_t sample_len = sample_rate * DEFAULT_AUDIO_BUF_MS / MS_IN_S;
 	if (cd->envelope_buf_len == 0)
@@ -152,16 +152,29 @@ static void analyze_envelope(struct limiter_data *cd, float **samples, const uin
 
 static inline void process_compression(const struct limiter_data *cd, float **samples, uint32_t num_samples)
 {
+	/* The envelope buffer is turned into a gain buffer in place, which is
+	 * then applied to each channel as a separate block. A limiter always
+	 * has a slope of 1, so the dB domain gain (threshold - env_db) reduces
+	 * to threshold_mul / env and no log/exp is needed per sample. */
+	float *gain_buf = cd->envelope_buf;
+	const float threshold_mul = cd->threshold_mul;
+	const float output_gain = cd->output_gain;
+
 	for (size_t i = 0; i < num_samples; ++i) {
-		const float env_db = mul_to_db(cd->envelope_buf[i]);
-		float gain = cd->slope * (cd->threshold - env_db);
-		gain = db_to_mul(fminf(0, gain));
+		const float env = gain_buf[i];
+		float gain = output_gain;
+		if (env > threshold_mul)
+			gain *= threshold_mul / env;
+		gain_buf[i] = gain;
+	}
 
-		for (size_t c = 0; c < cd->num_channels; ++c) {
-			if (samples[c]) {
-				samples[c][i] *= gain * cd->output_gain;
-			}
-		}
+	for (size_t c = 0; c < cd->num_channels; ++c) {
+		float *channel_samples = samples[c];
+		if (!channel_samples)
+			continue;
+
+		for (size_t i = 0; i < num_samples; ++i)
+			channel_samples[i] *= gain_buf[i];
 	}
 }
 
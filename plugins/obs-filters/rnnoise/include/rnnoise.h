@@ -61,6 +61,13 @@ RNNOISE_EXPORT void rnnoise_destroy(DenoiseState *st);
 
 RNNOISE_EXPORT float rnnoise_process_frame(DenoiseState *st, float *out, const float *in);
 
+/* Processes one frame of each of several streams, such as the channels of
+ * one signal. The result is identical to calling rnnoise_process_frame()
+ * for each stream, but each network weight is loaded once for two
+ * streams. vad_probs may be NULL. */
+#define RNNOISE_HAS_PROCESS_FRAMES 1
+RNNOISE_EXPORT void rnnoise_process_frames(DenoiseState **st, float **out, const float **in, float *vad_probs, int count);
+
 RNNOISE_EXPORT RNNModel *rnnoise_model_from_file(FILE *f);
 
 RNNOISE_EXPORT void rnnoise_model_free(RNNModel *model);
@@ -453,8 +453,26 @@ void pitch_filter(kiss_fft_cpx *X, const kiss_fft_cpx *P, const float *Ex, const
   }
 }
 
-float rnnoise_process_frame(DenoiseState *st, float *out, const float *in) {
+static void apply_rnn_gains(DenoiseState *st, kiss_fft_cpx *X, const kiss_fft_cpx *P, const float *Ex,
+                            const float *Ep, const float *Exp, float *g) {
   int i;
+  float gf[FREQ_SIZE]={1};
+  pitch_filter(X, P, Ex, Ep, Exp, g);
+  for (i=0;i<NB_BANDS;i++) {
+    float alpha = .6f;
+    g[i] = MAX16(g[i], alpha*st->lastg[i]);
+    st->lastg[i] = g[i];
+  }
+  interp_band_gain(gf, g);
+#if 1
+  for (i=0;i<FREQ_SIZE;i++) {
+    X[i].r *= gf[i];
+    X[i].i *= gf[i];
+  }
+#endif
+}
+
+float rnnoise_process_frame(DenoiseState *st, float *out, const float *in) {
   kiss_fft_cpx X[FREQ_SIZE];
   kiss_fft_cpx P[WINDOW_SIZE];
   float x[FRAME_SIZE];
@@ -462,7 +480,6 @@ float rnnoise_process_frame(DenoiseState *st, float *out, const float *in) {
   float Exp[NB_BANDS];
   float features[NB_FEATURES];
   float g[NB_BANDS];
-  float gf[FREQ_SIZE]={1};
   float vad_prob = 0;
   int silence;
   static const float a_hp[2] = {-1.99599f, 0.99600f};
@@ -472,25 +489,72 @@ float rnnoise_process_frame(DenoiseState *st, float *out, const float *in) {
 
   if (!silence) {
     compute_rnn(&st->rnn, g, &vad_prob, features);
-    pitch_filter(X, P, Ex, Ep, Exp, g);
-    for (i=0;i<NB_BANDS;i++) {
-      float alpha = .6f;
-      g[i] = MAX16(g[i], alpha*st->lastg[i]);
-      st->lastg[i] = g[i];
-    }
-    interp_band_gain(gf, g);
-#if 1
-    for (i=0;i<FREQ_SIZE;i++) {
-      X[i].r *= gf[i];
-      X[i].i *= gf[i];
-    }
-#endif
+    apply_rnn_gains(st, X, P, Ex, Ep, Exp, g);
   }
 
   frame_synthesis(st, out, X);
   return vad_prob;
 }
 
+/* Processes up to RNN_MAX_BATCH streams, running the network for all of
+   them at once. */
+static void process_frame_batch(DenoiseState **st, float **out, const float **in, float *vad_probs, int count) {
+  int c;
+  int n = 0;
+  kiss_fft_cpx X[RNN_MAX_BATCH][FREQ_SIZE];
+  kiss_fft_cpx P[RNN_MAX_BATCH][WINDOW_SIZE];
+  float x[FRAME_SIZE];
+  float Ex[RNN_MAX_BATCH][NB_BANDS], Ep[RNN_MAX_BATCH][NB_BANDS];
+  float Exp[RNN_MAX_BATCH][NB_BANDS];
+  float features[RNN_MAX_BATCH][NB_FEATURES];
+  float g[RNN_MAX_BATCH][NB_BANDS];
+  float vad[RNN_MAX_BATCH];
+  int silence[RNN_MAX_BATCH];
+  RNNState *rnn[RNN_MAX_BATCH];
+  float *gains[RNN_MAX_BATCH];
+  float *vad_out[RNN_MAX_BATCH];
+  const float *rnn_in[RNN_MAX_BATCH];
+  int batched[RNN_MAX_BATCH];
+  static const float a_hp[2] = {-1.99599f, 0.99600f};
+  static const float b_hp[2] = {-2, 1};
+
+  for (c=0;c<count;c++) {
+    vad[c] = 0;
+    biquad(x, st[c]->mem_hp_x, in[c], b_hp, a_hp, FRAME_SIZE);
+    silence[c] = compute_frame_features(st[c], X[c], P[c], Ex[c], Ep[c], Exp[c], features[c], x);
+    batched[c] = !silence[c] && (!n || st[c]->rnn.model == rnn[0]->model);
+    if (batched[c]) {
+      rnn[n] = &st[c]->rnn;
+      gains[n] = g[c];
+      vad_out[n] = &vad[c];
+      rnn_in[n] = features[c];
+      n++;
+    }
+  }
+
+  if (n)
+    compute_rnn_batch(rnn, gains, vad_out, rnn_in, n);
+
+  for (c=0;c<count;c++) {
+    if (!silence[c]) {
+      if (!batched[c])
+        compute_rnn(&st[c]->rnn, g[c], &vad[c], features[c]);
+      apply_rnn_gains(st[c], X[c], P[c], Ex[c], Ep[c], Exp[c], g[c]);
+    }
+    frame_synthesis(st[c], out[c], X[c]);
+    if (vad_probs)
+      vad_probs[c] = vad[c];
+  }
+}
+
+void rnnoise_process_frames(DenoiseState **st, float **out, const float **in, float *vad_probs, int count) {
+  int i;
+  for (i=0;i<count;i+=RNN_MAX_BATCH) {
+    int n = count - i < RNN_MAX_BATCH ? count - i : RNN_MAX_BATCH;
+    process_frame_batch(&st[i], &out[i], &in[i], vad_probs ? &vad_probs[i] : NULL, n);
+  }
+}
+
 #if TRAINING
 
 static float uni_rand() {
@@ -76,103 +76,182 @@ static OPUS_INLINE float relu(float x)
    return x < 0 ? 0 : x;
 }
 
-static void compute_dense(const DenseLayer *layer, float *output, const float *input)
+/* The weight matrices are stored input-major (j*stride + i), so the
+   kernels below accumulate one input row at a time. The inner loops then
+   walk the weights contiguously across neurons and vectorize, while every
+   neuron still sums its terms in the original order (bit-exact). */
+static OPUS_INLINE void accumulate_row(float *sum, const rnn_weight *w, float x, int N)
 {
-   int i, j;
+   int i;
+   for (i=0;i<N;i++)
+      sum[i] += w[i]*x;
+}
+
+/* Two streams per weight load, which halves the weight conversions. */
+static OPUS_INLINE void accumulate_row2(float *sum0, float *sum1, const rnn_weight *w, float x0, float x1, int N)
+{
+   int i;
+   for (i=0;i<N;i++)
+   {
+      float wi = w[i];
+      sum0[i] += wi*x0;
+      sum1[i] += wi*x1;
+   }
+}
+
+static OPUS_INLINE void accumulate_rows(float **sum, int offset, const rnn_weight *w, const float *x, int count, int N)
+{
+   int c;
+   for (c=0;c+1<count;c+=2)
+      accumulate_row2(sum[c] + offset, sum[c+1] + offset, w, x[c], x[c+1], N);
+   if (c<count)
+      accumulate_row(sum[c] + offset, w, x[c], N);
+}
+
+static OPUS_INLINE void accumulate_row_gated(float *sum, const rnn_weight *w, float x, float g, int N)
+{
+   int i;
+   for (i=0;i<N;i++)
+      sum[i] += w[i]*x*g;
+}
+
+static OPUS_INLINE float activation(int type, float x)
+{
+   if (type == ACTIVATION_SIGMOID) return sigmoid_approx(x);
+   else if (type == ACTIVATION_TANH) return tansig_approx(x);
+   else if (type == ACTIVATION_RELU) return relu(x);
+   else *(int*)0=0;
+   return 0;
+}
+
+/* The batched kernels run several independent streams (channels) through
+   the same layer. Each weight row is loaded once and applied to every
+   stream while it is hot in cache, and each stream still sums its terms
+   in the same order as a single stream would (bit-exact). */
+static void compute_dense_batch(const DenseLayer *layer, float **output, const float **input, int count)
+{
+   int i, j, c;
    int N, M;
    int stride;
+   float x[RNN_MAX_BATCH];
    M = layer->nb_inputs;
    N = layer->nb_neurons;
    stride = N;
-   for (i=0;i<N;i++)
+   for (c=0;c<count;c++)
+      for (i=0;i<N;i++)
+         output[c][i] = layer->bias[i];
+   for (j=0;j<M;j++)
    {
-      /* Compute update gate. */
-      float sum = layer->bias[i];
-      for (j=0;j<M;j++)
-         sum += layer->input_weights[j*stride + i]*input[j];
-      output[i] = WEIGHTS_SCALE*sum;
+      for (c=0;c<count;c++)
+         x[c] = input[c][j];
+      accumulate_rows(output, 0, &layer->input_weights[j*stride], x, count, N);
    }
-   if (layer->activation == ACTIVATION_SIGMOID) {
-      for (i=0;i<N;i++)
-         output[i] = sigmoid_approx(output[i]);
-   } else if (layer->activation == ACTIVATION_TANH) {
-      for (i=0;i<N;i++)
-         output[i] = tansig_approx(output[i]);
-   } else if (layer->activation == ACTIVATION_RELU) {
+   for (c=0;c<count;c++)
       for (i=0;i<N;i++)
-         output[i] = relu(output[i]);
-   } else {
-     *(int*)0=0;
-   }
+         output[c][i] = activation(layer->activation, WEIGHTS_SCALE*output[c][i]);
 }
 
-static void compute_gru(const GRULayer *gru, float *state, const float *input)
+static void compute_gru_batch(const GRULayer *gru, float **state, const float **input, int count)
 {
-   int i, j;
+   int i, j, c;
    int N, M;
    int stride;
-   float z[MAX_NEURONS];
-   float r[MAX_NEURONS];
-   float h[MAX_NEURONS];
+   float z[RNN_MAX_BATCH][MAX_NEURONS];
+   float r[RNN_MAX_BATCH][MAX_NEURONS];
+   float sum[RNN_MAX_BATCH][3*MAX_NEURONS];
+   float *sums[RNN_MAX_BATCH];
+   float x[RNN_MAX_BATCH];
    M = gru->nb_inputs;
    N = gru->nb_neurons;
    stride = 3*N;
-   for (i=0;i<N;i++)
+   /* Update gate, reset gate and output share each input row. */
+   for (c=0;c<count;c++)
    {
-      /* Compute update gate. */
-      float sum = gru->bias[i];
-      for (j=0;j<M;j++)
-         sum += gru->input_weights[j*stride + i]*input[j];
-      for (j=0;j<N;j++)
-         sum += gru->recurrent_weights[j*stride + i]*state[j];
-      z[i] = sigmoid_approx(WEIGHTS_SCALE*sum);
+      sums[c] = sum[c];
+      for (i=0;i<3*N;i++)
+         sum[c][i] = gru->bias[i];
    }
-   for (i=0;i<N;i++)
+   for (j=0;j<M;j++)
    {
-      /* Compute reset gate. */
-      float sum = gru->bias[N + i];
-      for (j=0;j<M;j++)
-         sum += gru->input_weights[N + j*stride + i]*input[j];
-      for (j=0;j<N;j++)
-         sum += gru->recurrent_weights[N + j*stride + i]*state[j];
-      r[i] = sigmoid_approx(WEIGHTS_SCALE*sum);
+      for (c=0;c<count;c++)
+         x[c] = input[c][j];
+      accumulate_rows(sums, 0, &gru->input_weights[j*stride], x, count, 3*N);
    }
-   for (i=0;i<N;i++)
+   /* Recurrent contribution to the update and reset gates. */
+   for (j=0;j<N;j++)
    {
-      /* Compute output. */
-      float sum = gru->bias[2*N + i];
-      for (j=0;j<M;j++)
-         sum += gru->input_weights[2*N + j*stride + i]*input[j];
-      for (j=0;j<N;j++)
-         sum += gru->recurrent_weights[2*N + j*stride + i]*state[j]*r[j];
-      if (gru->activation == ACTIVATION_SIGMOID) sum = sigmoid_approx(WEIGHTS_SCALE*sum);
-      else if (gru->activation == ACTIVATION_TANH) sum = tansig_approx(WEIGHTS_SCALE*sum);
-      else if (gru->activation == ACTIVATION_RELU) sum = relu(WEIGHTS_SCALE*sum);
-      else *(int*)0=0;
-      h[i] = z[i]*state[i] + (1-z[i])*sum;
+      for (c=0;c<count;c++)
+         x[c] = state[c][j];
+      accumulate_rows(sums, 0, &gru->recurrent_weights[j*stride], x, count, 2*N);
+   }
+   for (c=0;c<count;c++)
+   {
+      for (i=0;i<N;i++)
+      {
+         z[c][i] = sigmoid_approx(WEIGHTS_SCALE*sum[c][i]);
+         r[c][i] = sigmoid_approx(WEIGHTS_SCALE*sum[c][N + i]);
+      }
+   }
+   /* Recurrent contribution to the output, scaled by the reset gate. */
+   for (j=0;j<N;j++)
+      for (c=0;c<count;c++)
+         accumulate_row_gated(&sum[c][2*N], &gru->recurrent_weights[2*N + j*stride], state[c][j], r[c][j], N);
+   for (c=0;c<count;c++)
+   {
+      /* Compute output. All of the old state was read above, so it can be
+         overwritten in place. */
+      for (i=0;i<N;i++)
+      {
+         float out = activation(gru->activation, WEIGHTS_SCALE*sum[c][2*N + i]);
+         state[c][i] = z[c][i]*state[c][i] + (1-z[c][i])*out;
+      }
    }
-   for (i=0;i<N;i++)
-      state[i] = h[i];
 }
 
 #define INPUT_SIZE 42
 
+void compute_rnn_batch(RNNState **rnn, float **gains, float **vad, const float **input, int count) {
+  int i, c;
+  const RNNModel *model = rnn[0]->model;
+  float dense_out[RNN_MAX_BATCH][MAX_NEURONS];
+  float noise_input[RNN_MAX_BATCH][MAX_NEURONS*3];
+  float denoise_input[RNN_MAX_BATCH][MAX_NEURONS*3];
+  float *dense_ptr[RNN_MAX_BATCH];
+  const float *layer_in[RNN_MAX_BATCH];
+  float *state[RNN_MAX_BATCH];
+
+  for (c=0;c<count;c++) dense_ptr[c] = dense_out[c];
+  compute_dense_batch(model->input_dense, dense_ptr, input, count);
+
+  for (c=0;c<count;c++) {
+    layer_in[c] = dense_out[c];
+    state[c] = rnn[c]->vad_gru_state;
+  }
+  compute_gru_batch(model->vad_gru, state, layer_in, count);
+  for (c=0;c<count;c++) layer_in[c] = rnn[c]->vad_gru_state;
+  compute_dense_batch(model->vad_output, vad, layer_in, count);
+
+  for (c=0;c<count;c++) {
+    for (i=0;i<model->input_dense_size;i++) noise_input[c][i] = dense_out[c][i];
+    for (i=0;i<model->vad_gru_size;i++) noise_input[c][i+model->input_dense_size] = rnn[c]->vad_gru_state[i];
+    for (i=0;i<INPUT_SIZE;i++) noise_input[c][i+model->input_dense_size+model->vad_gru_size] = input[c][i];
+    layer_in[c] = noise_input[c];
+    state[c] = rnn[c]->noise_gru_state;
+  }
+  compute_gru_batch(model->noise_gru, state, layer_in, count);
+
+  for (c=0;c<count;c++) {
+    for (i=0;i<model->vad_gru_size;i++) denoise_input[c][i] = rnn[c]->vad_gru_state[i];
+    for (i=0;i<model->noise_gru_size;i++) denoise_input[c][i+model->vad_gru_size] = rnn[c]->noise_gru_state[i];
+    for (i=0;i<INPUT_SIZE;i++) denoise_input[c][i+model->vad_gru_size+model->noise_gru_size] = input[c][i];
+    layer_in[c] = denoise_input[c];
+    state[c] = rnn[c]->denoise_gru_state;
+  }
+  compute_gru_batch(model->denoise_gru, state, layer_in, count);
+  for (c=0;c<count;c++) layer_in[c] = rnn[c]->denoise_gru_state;
+  compute_dense_batch(model->denoise_output, gains, layer_in, count);
+}
+
 void compute_rnn(RNNState *rnn, float *gains, float *vad, const float *input) {
-  int i;
-  float dense_out[MAX_NEURONS];
-  float noise_input[MAX_NEURONS*3];
-  float denoise_input[MAX_NEURONS*3];
-  compute_dense(rnn->model->input_dense, dense_out, input);
-  compute_gru(rnn->model->vad_gru, rnn->vad_gru_state, dense_out);
-  compute_dense(rnn->model->vad_output, vad, rnn->vad_gru_state);
-  for (i=0;i<rnn->model->input_dense_size;i++) noise_input[i] = dense_out[i];
-  for (i=0;i<rnn->model->vad_gru_size;i++) noise_input[i+rnn->model->input_dense_size] = rnn->vad_gru_state[i];
-  for (i=0;i<INPUT_SIZE;i++) noise_input[i+rnn->model->input_dense_size+rnn->model->vad_gru_size] = input[i];
-  compute_gru(rnn->model->noise_gru, rnn->noise_gru_state, noise_input);
-
-  for (i=0;i<rnn->model->vad_gru_size;i++) denoise_input[i] = rnn->vad_gru_state[i];
-  for (i=0;i<rnn->model->noise_gru_size;i++) denoise_input[i+rnn->model->vad_gru_size] = rnn->noise_gru_state[i];
-  for (i=0;i<INPUT_SIZE;i++) denoise_input[i+rnn->model->vad_gru_size+rnn->model->noise_gru_size] = input[i];
-  compute_gru(rnn->model->denoise_gru, rnn->denoise_gru_state, denoise_input);
-  compute_dense(rnn->model->denoise_output, gains, rnn->denoise_gru_state);
+  compute_rnn_batch(&rnn, &gains, &vad, &input, 1);
 }
@@ -60,6 +60,12 @@ typedef struct {
 
 typedef struct RNNState RNNState;
 
+/* Most streams compute_rnn_batch() runs at once, all of which must use the
+   same model. */
+#define RNN_MAX_BATCH 4
+
 void compute_rnn(RNNState *rnn, float *gains, float *vad, const float *input);
 
+void compute_rnn_batch(RNNState **rnn, float **gains, float **vad, const float **input, int count);
+
 #endif /* _MLP_H_ */
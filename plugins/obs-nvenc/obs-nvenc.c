@@ -10,21 +10,32 @@ MODULE_EXPORT const char *obs_module_description(void)
 	return "NVIDIA Encoder (NVENC) Plugin";
 }
 
+static bool nvenc_loaded = false;
+
 bool obs_module_load(void)
+{
+	return true;
+}
+
+/* the NVENC check loads the driver and opens a session, which can take a
+ * while, so it is done off the loading thread */
+void obs_module_deferred_load(void)
 {
 	if (!nvenc_supported()) {
 		blog(LOG_INFO, "NVENC not supported");
-		return false;
+		return;
 	}
 
 	obs_nvenc_load();
 	obs_cuda_load();
-
-	return true;
+	nvenc_loaded = true;
 }
 
 void obs_module_unload(void)
 {
+	if (!nvenc_loaded)
+		return;
+
 	obs_cuda_unload();
 	obs_nvenc_unload();
 }
@@ -248,7 +248,7 @@ static void build_flv_meta_data(obs_output_t *context, uint8_t **output, size_t
 static inline void write_previous_tag_size_without_header(struct serializer *s, uint32_t header_size)
 {
 	assert(serializer_get_pos(s) >= header_size);
-	assert(serializer_get_pos(s) >= 11);
+	assert(serializer_get_pos(s) - header_size >= 11);
 
 	/*
 	 * From FLV file format specification version 10:
@@ -259,44 +259,40 @@ static inline void write_previous_tag_size_without_header(struct serializer *s,
 	s_wb32(s, (uint32_t)serializer_get_pos(s) - header_size);
 }
 
-static inline void write_previous_tag_size(struct serializer *s)
+/* Tags are appended to the serializer, so the size is relative to where the
+ * tag started rather than to the start of the buffer. */
+static inline void write_previous_tag_size(struct serializer *s, int64_t tag_start)
 {
-	write_previous_tag_size_without_header(s, 0);
+	write_previous_tag_size_without_header(s, (uint32_t)tag_start);
 }
 
-void flv_meta_data(obs_output_t *context, uint8_t **output, size_t *size, bool write_header)
+void flv_meta_data(obs_output_t *context, struct serializer *s, bool write_header)
 {
-	struct array_output_data data;
-	struct serializer s;
 	uint8_t *meta_data = NULL;
 	size_t meta_data_size;
 	uint32_t start_pos;
 
-	array_output_serializer_init(&s, &data);
 	build_flv_meta_data(context, &meta_data, &meta_data_size);
 
 	if (write_header) {
-		s_write(&s, "FLV", 3);
-		s_w8(&s, 1);
-		s_w8(&s, 5);
-		s_wb32(&s, 9);
-		s_wb32(&s, 0);
+		s_write(s, "FLV", 3);
+		s_w8(s, 1);
+		s_w8(s, 5);
+		s_wb32(s, 9);
+		s_wb32(s, 0);
 	}
 
-	start_pos = serializer_get_pos(&s);
+	start_pos = serializer_get_pos(s);
 
-	s_w8(&s, RTMP_PACKET_TYPE_INFO);
+	s_w8(s, RTMP_PACKET_TYPE_INFO);
 
-	s_wb24(&s, (uint32_t)meta_data_size);
-	s_wb32(&s, 0);
-	s_wb24(&s, 0);
-
-	s_write(&s, meta_data, meta_data_size);
+	s_wb24(s, (uint32_t)meta_data_size);
+	s_wb32(s, 0);
+	s_wb24(s, 0);
 
-	write_previous_tag_size_without_header(&s, start_pos);
+	s_write(s, meta_data, meta_data_size);
 
-	*output = data.bytes.array;
-	*size = data.bytes.num;
+	write_previous_tag_size_without_header(s, start_pos);
 
 	bfree(meta_data);
 }
@@ -313,6 +309,7 @@ static void flv_video(struct serializer *s, int32_t dts_offset, struct encoder_p
 	if (!packet->data || !packet->size)
 		return;
 
+	int64_t tag_start = serializer_get_pos(s);
 	s_w8(s, RTMP_PACKET_TYPE_VIDEO);
 
 #ifdef DEBUG_TIMESTAMPS
@@ -335,7 +332,7 @@ static void flv_video(struct serializer *s, int32_t dts_offset, struct encoder_p
 	s_wb24(s, ct_offset_ms);
 	s_write(s, packet->data, packet->size);
 
-	write_previous_tag_size(s);
+	write_previous_tag_size(s, tag_start);
 }
 
 static void flv_audio(struct serializer *s, int32_t dts_offset, struct encoder_packet *packet, bool is_header)
@@ -345,6 +342,7 @@ static void flv_audio(struct serializer *s, int32_t dts_offset, struct encoder_p
 	if (!packet->data || !packet->size)
 		return;
 
+	int64_t tag_start = serializer_get_pos(s);
 	s_w8(s, RTMP_PACKET_TYPE_AUDIO);
 
 #ifdef DEBUG_TIMESTAMPS
@@ -366,33 +364,20 @@ static void flv_audio(struct serializer *s, int32_t dts_offset, struct encoder_p
 	s_w8(s, is_header ? 0 : 1);
 	s_write(s, packet->data, packet->size);
 
-	write_previous_tag_size(s);
+	write_previous_tag_size(s, tag_start);
 }
 
-void flv_packet_mux(struct encoder_packet *packet, int32_t dts_offset, uint8_t **output, size_t *size, bool is_header)
+void flv_packet_mux(struct encoder_packet *packet, int32_t dts_offset, struct serializer *s, bool is_header)
 {
-	struct array_output_data data;
-	struct serializer s;
-
-	array_output_serializer_init(&s, &data);
-
 	if (packet->type == OBS_ENCODER_VIDEO)
-		flv_video(&s, dts_offset, packet, is_header);
+		flv_video(s, dts_offset, packet, is_header);
 	else
-		flv_audio(&s, dts_offset, packet, is_header);
-
-	*output = data.bytes.array;
-	*size = data.bytes.num;
+		flv_audio(s, dts_offset, packet, is_header);
 }
 
-void flv_packet_audio_ex(struct encoder_packet *packet, enum audio_id_t codec_id, int32_t dts_offset, uint8_t **output,
-			 size_t *size, int type, size_t idx)
+void flv_packet_audio_ex(struct encoder_packet *packet, enum audio_id_t codec_id, int32_t dts_offset,
+			 struct serializer *s, int type, size_t idx)
 {
-	struct array_output_data data;
-	struct serializer s;
-
-	array_output_serializer_init(&s, &data);
-
 	assert(packet->type == OBS_ENCODER_AUDIO);
 
 	int32_t time_ms = get_ms_time(packet, packet->dts) - dts_offset;
@@ -406,7 +391,8 @@ void flv_packet_audio_ex(struct encoder_packet *packet, enum audio_id_t codec_id
 	if (is_multitrack)
 		header_metadata_size += 2; // w8 + w8
 
-	s_w8(&s, RTMP_PACKET_TYPE_AUDIO);
+	int64_t tag_start = serializer_get_pos(s);
+	s_w8(s, RTMP_PACKET_TYPE_AUDIO);
 
 #ifdef DEBUG_TIMESTAMPS
 	blog(LOG_DEBUG, "Audio: %lu", time_ms);
@@ -417,36 +403,29 @@ void flv_packet_audio_ex(struct encoder_packet *packet, enum audio_id_t codec_id
 	last_time = time_ms;
 #endif
 
-	s_wb24(&s, (uint32_t)packet->size + header_metadata_size);
-	s_wb24(&s, (uint32_t)time_ms);
-	s_w8(&s, (time_ms >> 24) & 0x7F);
-	s_wb24(&s, 0);
+	s_wb24(s, (uint32_t)packet->size + header_metadata_size);
+	s_wb24(s, (uint32_t)time_ms);
+	s_w8(s, (time_ms >> 24) & 0x7F);
+	s_wb24(s, 0);
 
-	s_w8(&s, AUDIO_HEADER_EX | (is_multitrack ? AUDIO_PACKETTYPE_MULTITRACK : type));
+	s_w8(s, AUDIO_HEADER_EX | (is_multitrack ? AUDIO_PACKETTYPE_MULTITRACK : type));
 	if (is_multitrack) {
-		s_w8(&s, MULTITRACKTYPE_ONE_TRACK | type);
-		s_wa4cc(&s, codec_id);
-		s_w8(&s, (uint8_t)idx);
+		s_w8(s, MULTITRACKTYPE_ONE_TRACK | type);
+		s_wa4cc(s, codec_id);
+		s_w8(s, (uint8_t)idx);
 	} else {
-		s_wa4cc(&s, codec_id);
+		s_wa4cc(s, codec_id);
 	}
 
-	s_write(&s, packet->data, packet->size);
-
-	write_previous_tag_size(&s);
+	s_write(s, packet->data, packet->size);
 
-	*output = data.bytes.array;
-	*size = data.bytes.num;
+	write_previous_tag_size(s, tag_start);
 }
 
 // Y2023 spec
-void flv_packet_ex(struct encoder_packet *packet, enum video_id_t codec_id, int32_t dts_offset, uint8_t **output,
-		   size_t *size, int type, size_t idx)
+void flv_packet_ex(struct encoder_packet *packet, enum video_id_t codec_id, int32_t dts_offset,
+		   struct serializer *s, int type, size_t idx)
 {
-	struct array_output_data data;
-	struct serializer s;
-	array_output_serializer_init(&s, &data);
-
 	assert(packet->type == OBS_ENCODER_VIDEO);
 
 	int32_t time_ms = get_ms_time(packet, packet->dts) - dts_offset;
@@ -462,10 +441,11 @@ void flv_packet_ex(struct encoder_packet *packet, enum video_id_t codec_id, int3
 	if (is_multitrack)
 		header_metadata_size += 2; // w8+w8
 
-	s_w8(&s, RTMP_PACKET_TYPE_VIDEO);
-	s_wb24(&s, (uint32_t)packet->size + header_metadata_size);
-	s_wtimestamp(&s, time_ms);
-	s_wb24(&s, 0); // always 0
+	int64_t tag_start = serializer_get_pos(s);
+	s_w8(s, RTMP_PACKET_TYPE_VIDEO);
+	s_wb24(s, (uint32_t)packet->size + header_metadata_size);
+	s_wtimestamp(s, time_ms);
+	s_wb24(s, 0); // always 0
 
 	uint8_t frame_type = packet->keyframe ? FT_KEY : FT_INTER;
 
@@ -474,74 +454,67 @@ void flv_packet_ex(struct encoder_packet *packet, enum video_id_t codec_id, int3
 	 * The default trackId is 0.
 	 */
 	if (is_multitrack) {
-		s_w8(&s, FRAME_HEADER_EX | PACKETTYPE_MULTITRACK | frame_type);
-		s_w8(&s, MULTITRACKTYPE_ONE_TRACK | type);
-		s_w4cc(&s, codec_id);
+		s_w8(s, FRAME_HEADER_EX | PACKETTYPE_MULTITRACK | frame_type);
+		s_w8(s, MULTITRACKTYPE_ONE_TRACK | type);
+		s_w4cc(s, codec_id);
 		// trackId
-		s_w8(&s, (uint8_t)idx);
+		s_w8(s, (uint8_t)idx);
 	} else {
-		s_w8(&s, FRAME_HEADER_EX | type | frame_type);
-		s_w4cc(&s, codec_id);
+		s_w8(s, FRAME_HEADER_EX | type | frame_type);
+		s_w4cc(s, codec_id);
 	}
 
 	// H.264/HEVC composition time offset
 	if ((codec_id == CODEC_H264 || codec_id == CODEC_HEVC) && type == PACKETTYPE_FRAMES) {
 		int32_t ct_offset_ms = get_ms_time(packet, packet->pts) - get_ms_time(packet, packet->dts);
-		s_wb24(&s, ct_offset_ms);
+		s_wb24(s, ct_offset_ms);
 	}
 
 	// packet data
-	s_write(&s, packet->data, packet->size);
+	s_write(s, packet->data, packet->size);
 
 	// packet tail
-	write_previous_tag_size(&s);
-
-	*output = data.bytes.array;
-	*size = data.bytes.num;
+	write_previous_tag_size(s, tag_start);
 }
 
-void flv_packet_start(struct encoder_packet *packet, enum video_id_t codec, uint8_t **output, size_t *size, size_t idx)
+void flv_packet_start(struct encoder_packet *packet, enum video_id_t codec, struct serializer *s, size_t idx)
 {
-	flv_packet_ex(packet, codec, 0, output, size, PACKETTYPE_SEQ_START, idx);
+	flv_packet_ex(packet, codec, 0, s, PACKETTYPE_SEQ_START, idx);
 }
 
-void flv_packet_frames(struct encoder_packet *packet, enum video_id_t codec, int32_t dts_offset, uint8_t **output,
-		       size_t *size, size_t idx)
+void flv_packet_frames(struct encoder_packet *packet, enum video_id_t codec, int32_t dts_offset, struct serializer *s,
+		       size_t idx)
 {
 	int packet_type = PACKETTYPE_FRAMES;
 	// PACKETTYPE_FRAMESX is an optimization to avoid sending composition
 	// time offsets of 0. See Enhanced RTMP spec.
 	if ((codec == CODEC_H264 || codec == CODEC_HEVC) && packet->dts == packet->pts)
 		packet_type = PACKETTYPE_FRAMESX;
-	flv_packet_ex(packet, codec, dts_offset, output, size, packet_type, idx);
+	flv_packet_ex(packet, codec, dts_offset, s, packet_type, idx);
 }
 
-void flv_packet_end(struct encoder_packet *packet, enum video_id_t codec, uint8_t **output, size_t *size, size_t idx)
+void flv_packet_end(struct encoder_packet *packet, enum video_id_t codec, struct serializer *s, size_t idx)
 {
-	flv_packet_ex(packet, codec, 0, output, size, PACKETTYPE_SEQ_END, idx);
+	flv_packet_ex(packet, codec, 0, s, PACKETTYPE_SEQ_END, idx);
 }
 
-void flv_packet_audio_start(struct encoder_packet *packet, enum audio_id_t codec, uint8_t **output, size_t *size,
-			    size_t idx)
+void flv_packet_audio_start(struct encoder_packet *packet, enum audio_id_t codec, struct serializer *s, size_t idx)
 {
-	flv_packet_audio_ex(packet, codec, 0, output, size, AUDIO_PACKETTYPE_SEQ_START, idx);
+	flv_packet_audio_ex(packet, codec, 0, s, AUDIO_PACKETTYPE_SEQ_START, idx);
 }
 
-void flv_packet_audio_frames(struct encoder_packet *packet, enum audio_id_t codec, int32_t dts_offset, uint8_t **output,
-			     size_t *size, size_t idx)
+void flv_packet_audio_frames(struct encoder_packet *packet, enum audio_id_t codec, int32_t dts_offset,
+			     struct serializer *s, size_t idx)
 {
-	flv_packet_audio_ex(packet, codec, dts_offset, output, size, AUDIO_PACKETTYPE_FRAMES, idx);
+	flv_packet_audio_ex(packet, codec, dts_offset, s, AUDIO_PACKETTYPE_FRAMES, idx);
 }
 
-void flv_packet_metadata(enum video_id_t codec_id, uint8_t **output, size_t *size, int bits_per_raw_sample,
+void flv_packet_metadata(enum video_id_t codec_id, struct serializer *s, int bits_per_raw_sample,
 			 uint8_t color_primaries, int color_trc, int color_space, int min_luminance, int max_luminance,
 			 size_t idx)
 {
 	// metadata array
-	struct array_output_data data;
 	struct array_output_data metadata;
-	struct serializer s;
-	array_output_serializer_init(&s, &data);
 
 	// metadata data array
 	{
@@ -609,35 +582,33 @@ void flv_packet_metadata(enum video_id_t codec_id, uint8_t **output, size_t *siz
 		header_metadata_size += 2;
 	}
 
-	s_w8(&s, RTMP_PACKET_TYPE_VIDEO);
-	s_wb24(&s, (uint32_t)metadata.bytes.num + header_metadata_size);
-	s_wtimestamp(&s, 0);
-	s_wb24(&s, 0); // always 0
+	int64_t tag_start = serializer_get_pos(s);
+	s_w8(s, RTMP_PACKET_TYPE_VIDEO);
+	s_wb24(s, (uint32_t)metadata.bytes.num + header_metadata_size);
+	s_wtimestamp(s, 0);
+	s_wb24(s, 0); // always 0
 
 	// packet ext header
 	// these are the 5 extra bytes mentioned above
-	s_w8(&s, FRAME_HEADER_EX | (is_multitrack ? PACKETTYPE_MULTITRACK : PACKETTYPE_METADATA));
+	s_w8(s, FRAME_HEADER_EX | (is_multitrack ? PACKETTYPE_MULTITRACK : PACKETTYPE_METADATA));
 
 	/*
 	 * We only add explicitly emit trackIds iff idx > 0.
 	 * The default trackId is 0.
 	 */
 	if (is_multitrack) {
-		s_w8(&s, (uint8_t)MULTITRACKTYPE_ONE_TRACK | (uint8_t)PACKETTYPE_METADATA);
-		s_w4cc(&s, codec_id);
+		s_w8(s, (uint8_t)MULTITRACKTYPE_ONE_TRACK | (uint8_t)PACKETTYPE_METADATA);
+		s_w4cc(s, codec_id);
 		// trackId
-		s_w8(&s, (uint8_t)idx);
+		s_w8(s, (uint8_t)idx);
 	} else {
-		s_w4cc(&s, codec_id);
+		s_w4cc(s, codec_id);
 	}
 
 	// packet data
-	s_write(&s, metadata.bytes.array, metadata.bytes.num);
+	s_write(s, metadata.bytes.array, metadata.bytes.num);
 	array_output_serializer_free(&metadata); // must be freed
 
 	// packet tail
-	write_previous_tag_size(&s);
-
-	*output = data.bytes.array;
-	*size = data.bytes.num;
+	write_previous_tag_size(s, tag_start);
 }
@@ -18,6 +18,7 @@
 #pragma once
 
 #include <obs.h>
+#include <util/serializer.h>
 
 #define MILLISECOND_DEN 1000
 
@@ -60,20 +61,22 @@ static int32_t get_ms_time(struct encoder_packet *packet, int64_t val)
 
 extern void write_file_info(FILE *file, int64_t duration_ms, int64_t size);
 
-extern void flv_meta_data(obs_output_t *context, uint8_t **output, size_t *size, bool write_header);
-extern void flv_packet_mux(struct encoder_packet *packet, int32_t dts_offset, uint8_t **output, size_t *size,
-			   bool is_header);
+/*
+ * The FLV tag writers below append a complete tag to the given serializer.
+ * Outputs keep one array serializer for their lifetime and reset it between
+ * tags, so muxing reuses the same buffer rather than allocating per packet.
+ */
+extern void flv_meta_data(obs_output_t *context, struct serializer *s, bool write_header);
+extern void flv_packet_mux(struct encoder_packet *packet, int32_t dts_offset, struct serializer *s, bool is_header);
 // Y2023 spec
-extern void flv_packet_start(struct encoder_packet *packet, enum video_id_t codec, uint8_t **output, size_t *size,
-			     size_t idx);
+extern void flv_packet_start(struct encoder_packet *packet, enum video_id_t codec, struct serializer *s, size_t idx);
 extern void flv_packet_frames(struct encoder_packet *packet, enum video_id_t codec, int32_t dts_offset,
-			      uint8_t **output, size_t *size, size_t idx);
-extern void flv_packet_end(struct encoder_packet *packet, enum video_id_t codec, uint8_t **output, size_t *size,
-			   size_t idx);
-extern void flv_packet_metadata(enum video_id_t codec, uint8_t **output, size_t *size, int bits_per_raw_sample,
+			      struct serializer *s, size_t idx);
+extern void flv_packet_end(struct encoder_packet *packet, enum video_id_t codec, struct serializer *s, size_t idx);
+extern void flv_packet_metadata(enum video_id_t codec, struct serializer *s, int bits_per_raw_sample,
 				uint8_t color_primaries, int color_trc, int color_space, int min_luminance,
 				int max_luminance, size_t idx);
-extern void flv_packet_audio_start(struct encoder_packet *packet, enum audio_id_t codec, uint8_t **output, size_t *size,
+extern void flv_packet_audio_start(struct encoder_packet *packet, enum audio_id_t codec, struct serializer *s,
 				   size_t idx);
 extern void flv_packet_audio_frames(struct encoder_packet *packet, enum audio_id_t codec, int32_t dts_offset,
-				    uint8_t **output, size_t *size, size_t idx);
+				    struct serializer *s, size_t idx);
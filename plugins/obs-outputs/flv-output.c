@@ -25,6 +25,7 @@
 #include "rtmp-av1.h"
 #include <util/platform.h>
 #include <util/dstr.h>
+#include <util/array-serializer.h>
 #include <util/threading.h>
 #include <inttypes.h>
 #include "flv-mux.h"
@@ -50,6 +51,9 @@ struct flv_output {
 
 	pthread_mutex_t mutex;
 
+	struct serializer flv_serializer;
+	struct array_output_data flv_data;
+
 	bool got_first_packet;
 	int32_t start_dts_offset;
 };
@@ -165,6 +169,7 @@ static void flv_output_destroy(void *data)
 
 	pthread_mutex_destroy(&stream->mutex);
 	dstr_free(&stream->path);
+	array_output_serializer_free(&stream->flv_data);
 	bfree(stream);
 }
 
@@ -173,6 +178,7 @@ static void *flv_output_create(obs_data_t *settings, obs_output_t *output)
 	struct flv_output *stream = bzalloc(sizeof(struct flv_output));
 	stream->output = output;
 	pthread_mutex_init(&stream->mutex, NULL);
+	array_output_serializer_init(&stream->flv_serializer, &stream->flv_data);
 
 	UNUSED_PARAMETER(settings);
 	return stream;
@@ -180,15 +186,13 @@ static void *flv_output_create(obs_data_t *settings, obs_output_t *output)
 
 static int write_packet(struct flv_output *stream, struct encoder_packet *packet, bool is_header)
 {
-	uint8_t *data;
-	size_t size;
 	int ret = 0;
 
 	stream->last_packet_ts = get_ms_time(packet, packet->dts);
 
-	flv_packet_mux(packet, is_header ? 0 : stream->start_dts_offset, &data, &size, is_header);
-	fwrite(data, 1, size, stream->file);
-	bfree(data);
+	array_output_serializer_reset(&stream->flv_data);
+	flv_packet_mux(packet, is_header ? 0 : stream->start_dts_offset, &stream->flv_serializer, is_header);
+	fwrite(stream->flv_data.bytes.array, 1, stream->flv_data.bytes.num, stream->file);
 
 	return ret;
 }
@@ -196,20 +200,19 @@ static int write_packet(struct flv_output *stream, struct encoder_packet *packet
 static int write_packet_ex(struct flv_output *stream, struct encoder_packet *packet, bool is_header, bool is_footer,
 			   size_t idx)
 {
-	uint8_t *data;
-	size_t size = 0;
 	int ret = 0;
 
+	array_output_serializer_reset(&stream->flv_data);
 	if (is_header) {
-		flv_packet_start(packet, stream->video_codec[idx], &data, &size, idx);
+		flv_packet_start(packet, stream->video_codec[idx], &stream->flv_serializer, idx);
 	} else if (is_footer) {
-		flv_packet_end(packet, stream->video_codec[idx], &data, &size, idx);
+		flv_packet_end(packet, stream->video_codec[idx], &stream->flv_serializer, idx);
 	} else {
-		flv_packet_frames(packet, stream->video_codec[idx], stream->start_dts_offset, &data, &size, idx);
+		flv_packet_frames(packet, stream->video_codec[idx], stream->start_dts_offset, &stream->flv_serializer,
+				  idx);
 	}
 
-	fwrite(data, 1, size, stream->file);
-	bfree(data);
+	fwrite(stream->flv_data.bytes.array, 1, stream->flv_data.bytes.num, stream->file);
 
 	// manually created packets
 	if (is_header || is_footer)
@@ -222,30 +225,26 @@ static int write_packet_ex(struct flv_output *stream, struct encoder_packet *pac
 
 static int write_audio_packet_ex(struct flv_output *stream, struct encoder_packet *packet, bool is_header, size_t idx)
 {
-	uint8_t *data;
-	size_t size = 0;
 	int ret = 0;
 
+	array_output_serializer_reset(&stream->flv_data);
 	if (is_header) {
-		flv_packet_audio_start(packet, stream->audio_codec[idx], &data, &size, idx);
+		flv_packet_audio_start(packet, stream->audio_codec[idx], &stream->flv_serializer, idx);
 	} else {
-		flv_packet_audio_frames(packet, stream->audio_codec[idx], stream->start_dts_offset, &data, &size, idx);
+		flv_packet_audio_frames(packet, stream->audio_codec[idx], stream->start_dts_offset,
+					&stream->flv_serializer, idx);
 	}
 
-	fwrite(data, 1, size, stream->file);
-	bfree(data);
+	fwrite(stream->flv_data.bytes.array, 1, stream->flv_data.bytes.num, stream->file);
 
 	return ret;
 }
 
 static void write_meta_data(struct flv_output *stream)
 {
-	uint8_t *meta_data;
-	size_t meta_data_size;
-
-	flv_meta_data(stream->output, &meta_data, &meta_data_size, true);
-	fwrite(meta_data, 1, meta_data_size, stream->file);
-	bfree(meta_data);
+	array_output_serializer_reset(&stream->flv_data);
+	flv_meta_data(stream->output, &stream->flv_serializer, true);
+	fwrite(stream->flv_data.bytes.array, 1, stream->flv_data.bytes.num, stream->file);
 }
 
 static bool write_audio_header(struct flv_output *stream, size_t idx)
@@ -335,9 +334,6 @@ static bool write_video_metadata(struct flv_output *stream, size_t idx)
 	if (stream->video_codec[idx] == CODEC_H264)
 		return true;
 
-	uint8_t *data;
-	size_t size;
-
 	enum video_format format = info->format;
 
 	int bits_per_raw_sample;
@@ -392,11 +388,11 @@ static bool write_video_metadata(struct flv_output *stream, size_t idx)
 	else if (trc == OBSCOL_TRC_SMPTE2084)
 		max_luminance = (int)obs_get_video_hdr_nominal_peak_level();
 
-	flv_packet_metadata(stream->video_codec[idx], &data, &size, bits_per_raw_sample, pri, trc, spc, 0,
+	array_output_serializer_reset(&stream->flv_data);
+	flv_packet_metadata(stream->video_codec[idx], &stream->flv_serializer, bits_per_raw_sample, pri, trc, spc, 0,
 			    max_luminance, idx);
 
-	fwrite(data, 1, size, stream->file);
-	bfree(data);
+	fwrite(stream->flv_data.bytes.array, 1, stream->flv_data.bytes.num, stream->file);
 
 	return true;
 }
@@ -145,6 +145,7 @@ static void rtmp_stream_destroy(void *data)
 
 	if (stream->write_buf)
 		bfree(stream->write_buf);
+	array_output_serializer_free(&stream->flv_data);
 	bfree(stream);
 }
 
@@ -153,6 +154,7 @@ static void *rtmp_stream_create(obs_data_t *settings, obs_output_t *output)
 	struct rtmp_stream *stream = bzalloc(sizeof(struct rtmp_stream));
 	stream->output = output;
 	pthread_mutex_init_value(&stream->packets_mutex);
+	array_output_serializer_init(&stream->flv_serializer, &stream->flv_data);
 
 	RTMP_LogSetCallback(log_rtmp);
 	RTMP_LogSetLevel(RTMP_LOGWARNING);
@@ -398,21 +400,21 @@ static int handle_socket_read(struct rtmp_stream *stream)
 
 static int send_packet(struct rtmp_stream *stream, struct encoder_packet *packet, bool is_header)
 {
-	uint8_t *data;
 	size_t size;
 	int ret = 0;
 
 	if (handle_socket_read(stream))
 		return -1;
 
-	flv_packet_mux(packet, is_header ? 0 : stream->start_dts_offset, &data, &size, is_header);
+	array_output_serializer_reset(&stream->flv_data);
+	flv_packet_mux(packet, is_header ? 0 : stream->start_dts_offset, &stream->flv_serializer, is_header);
+	size = stream->flv_data.bytes.num;
 
 #ifdef TEST_FRAMEDROPS
 	droptest_cap_data_rate(stream, size);
 #endif
 
-	ret = RTMP_Write(&stream->rtmp, (char *)data, (int)size, 0);
-	bfree(data);
+	ret = RTMP_Write(&stream->rtmp, (char *)stream->flv_data.bytes.array, (int)size, 0);
 
 	if (is_header)
 		bfree(packet->data);
@@ -426,27 +428,28 @@ static int send_packet(struct rtmp_stream *stream, struct encoder_packet *packet
 static int send_packet_ex(struct rtmp_stream *stream, struct encoder_packet *packet, bool is_header, bool is_footer,
 			  size_t idx)
 {
-	uint8_t *data;
-	size_t size = 0;
+	size_t size;
 	int ret = 0;
 
 	if (handle_socket_read(stream))
 		return -1;
 
+	array_output_serializer_reset(&stream->flv_data);
 	if (is_header) {
-		flv_packet_start(packet, stream->video_codec[idx], &data, &size, idx);
+		flv_packet_start(packet, stream->video_codec[idx], &stream->flv_serializer, idx);
 	} else if (is_footer) {
-		flv_packet_end(packet, stream->video_codec[idx], &data, &size, idx);
+		flv_packet_end(packet, stream->video_codec[idx], &stream->flv_serializer, idx);
 	} else {
-		flv_packet_frames(packet, stream->video_codec[idx], stream->start_dts_offset, &data, &size, idx);
+		flv_packet_frames(packet, stream->video_codec[idx], stream->start_dts_offset, &stream->flv_serializer,
+				  idx);
 	}
+	size = stream->flv_data.bytes.num;
 
 #ifdef TEST_FRAMEDROPS
 	droptest_cap_data_rate(stream, size);
 #endif
 
-	ret = RTMP_Write(&stream->rtmp, (char *)data, (int)size, 0);
-	bfree(data);
+	ret = RTMP_Write(&stream->rtmp, (char *)stream->flv_data.bytes.array, (int)size, 0);
 
 	if (is_header || is_footer) // manually created packets
 		bfree(packet->data);
@@ -459,21 +462,22 @@ static int send_packet_ex(struct rtmp_stream *stream, struct encoder_packet *pac
 
 static int send_audio_packet_ex(struct rtmp_stream *stream, struct encoder_packet *packet, bool is_header, size_t idx)
 {
-	uint8_t *data;
-	size_t size = 0;
+	size_t size;
 	int ret = 0;
 
 	if (handle_socket_read(stream))
 		return -1;
 
+	array_output_serializer_reset(&stream->flv_data);
 	if (is_header) {
-		flv_packet_audio_start(packet, stream->audio_codec[idx], &data, &size, idx);
+		flv_packet_audio_start(packet, stream->audio_codec[idx], &stream->flv_serializer, idx);
 	} else {
-		flv_packet_audio_frames(packet, stream->audio_codec[idx], stream->start_dts_offset, &data, &size, idx);
+		flv_packet_audio_frames(packet, stream->audio_codec[idx], stream->start_dts_offset,
+					&stream->flv_serializer, idx);
 	}
+	size = stream->flv_data.bytes.num;
 
-	ret = RTMP_Write(&stream->rtmp, (char *)data, (int)size, 0);
-	bfree(data);
+	ret = RTMP_Write(&stream->rtmp, (char *)stream->flv_data.bytes.array, (int)size, 0);
 
 	if (is_header)
 		bfree(packet->data);
@@ -746,13 +750,12 @@ static void *send_thread(void *data)
 
 static bool send_meta_data(struct rtmp_stream *stream)
 {
-	uint8_t *meta_data;
-	size_t meta_data_size;
+	struct array_output_data *meta_data = &stream->flv_data;
 	bool success = true;
 
-	flv_meta_data(stream->output, &meta_data, &meta_data_size, false);
-	success = RTMP_Write(&stream->rtmp, (char *)meta_data, (int)meta_data_size, 0) >= 0;
-	bfree(meta_data);
+	array_output_serializer_reset(meta_data);
+	flv_meta_data(stream->output, &stream->flv_serializer, false);
+	success = RTMP_Write(&stream->rtmp, (char *)meta_data->bytes.array, (int)meta_data->bytes.num, 0) >= 0;
 
 	return success;
 }
@@ -846,9 +849,6 @@ static bool send_video_metadata(struct rtmp_stream *stream, size_t idx)
 
 	// Y2023 spec
 	if (stream->video_codec[idx] != CODEC_H264) {
-		uint8_t *data;
-		size_t size;
-
 		video_t *video = obs_get_video();
 		const struct video_output_info *info = video_output_get_info(video);
 		enum video_format format = info->format;
@@ -904,11 +904,12 @@ static bool send_video_metadata(struct rtmp_stream *stream, size_t idx)
 		else if (trc == OBSCOL_TRC_SMPTE2084)
 			max_luminance = (int)obs_get_video_hdr_nominal_peak_level();
 
-		flv_packet_metadata(stream->video_codec[idx], &data, &size, bits_per_raw_sample, pri, trc, spc, 0,
-				    max_luminance, idx);
+		array_output_serializer_reset(&stream->flv_data);
+		flv_packet_metadata(stream->video_codec[idx], &stream->flv_serializer, bits_per_raw_sample, pri, trc,
+				    spc, 0, max_luminance, idx);
+		size_t size = stream->flv_data.bytes.num;
 
-		int ret = RTMP_Write(&stream->rtmp, (char *)data, (int)size, 0);
-		bfree(data);
+		int ret = RTMP_Write(&stream->rtmp, (char *)stream->flv_data.bytes.array, (int)size, 0);
 
 		stream->total_bytes_sent += size;
 		return ret >= 0;
@@ -2,6 +2,7 @@
 #include <util/platform.h>
 #include <util/deque.h>
 #include <util/dstr.h>
+#include <util/array-serializer.h>
 #include <util/threading.h>
 #include <inttypes.h>
 #include "librtmp/rtmp.h"
@@ -116,6 +117,10 @@ struct rtmp_stream {
 	enum audio_id_t audio_codec[MAX_OUTPUT_AUDIO_ENCODERS];
 	enum video_id_t video_codec[MAX_OUTPUT_VIDEO_ENCODERS];
 
+	/* reused for every FLV tag, only touched by the connect/send thread */
+	struct serializer flv_serializer;
+	struct array_output_data flv_data;
+
 	RTMP rtmp;
 
 	bool new_socket_loop;
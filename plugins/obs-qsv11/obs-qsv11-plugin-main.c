@@ -74,6 +74,13 @@ extern struct obs_encoder_info obs_qsv_hevc_encoder_tex;
 extern struct obs_encoder_info obs_qsv_hevc_encoder;
 
 bool obs_module_load(void)
+{
+	return true;
+}
+
+/* checking the adapters opens every GPU (through a helper process on
+ * Windows), so it is done off the loading thread */
+void obs_module_deferred_load(void)
 {
 	adapter_count = MAX_ADAPTERS;
 	check_adapters(adapters, &adapter_count);
@@ -104,6 +111,4 @@ bool obs_module_load(void)
 		obs_register_encoder(&obs_qsv_hevc_encoder);
 	}
 #endif
-
-	return true;
 }
@@ -3,6 +3,10 @@
 
 #include <obs.hpp>
 
+#include <algorithm>
+#include <cinttypes>
+#include <iterator>
+
 /*
  * Sets the maximum size for a video fragment. Effective range is
  * 576-1470, with a lower value equating to more packets created,
@@ -26,6 +30,9 @@ const uint8_t video_payload_type = 96;
 // ~3 seconds of 8.5 Megabit video
 const int video_nack_buffer_size = 4000;
 
+// Same as the RTMP output's default drop threshold
+const int64_t drop_threshold_usec = 700 * 1000;
+
 WHIPOutput::WHIPOutput(obs_data_t *, obs_output_t *output)
 	: output(output),
 	  endpoint_url(),
@@ -38,7 +45,20 @@ WHIPOutput::WHIPOutput(obs_data_t *, obs_output_t *output)
 	  peer_connection(nullptr),
 	  audio_track(nullptr),
 	  video_track(nullptr),
+	  packets_mutex(),
+	  packets_cv(),
+	  packets(),
+	  send_thread(),
+	  send_thread_active(false),
+	  waiting_for_keyframe(false),
+	  last_queued_dts_usec(0),
+	  max_queue_depth(0),
+	  packets_sent(0),
+	  total_send_latency_ns(0),
+	  max_send_latency_ns(0),
 	  total_bytes_sent(0),
+	  dropped_frames(0),
+	  congestion(0.0f),
 	  connect_time_ms(0),
 	  start_time_ns(0),
 	  last_audio_timestamp(0),
@@ -88,15 +108,100 @@ void WHIPOutput::Data(struct encoder_packet *packet)
 		return;
 	}
 
-	if (audio_track && packet->type == OBS_ENCODER_AUDIO) {
-		int64_t duration = packet->dts_usec - last_audio_timestamp;
-		Send(packet->data, packet->size, duration, audio_track, audio_sr_reporter);
-		last_audio_timestamp = packet->dts_usec;
-	} else if (video_track && packet->type == OBS_ENCODER_VIDEO) {
-		int64_t duration = packet->dts_usec - last_video_timestamp;
-		Send(packet->data, packet->size, duration, video_track, video_sr_reporter);
-		last_video_timestamp = packet->dts_usec;
+	if (packet->type == OBS_ENCODER_AUDIO ? !audio_track : !video_track)
+		return;
+
+	/*
+	 * Packetization, SRTP and the socket sends all happen on the send
+	 * thread. Only queue a reference here so that a stalled network
+	 * never backs up into the encoder.
+	 */
+	std::lock_guard<std::mutex> l(packets_mutex);
+	if (!send_thread_active)
+		return;
+
+	if (packet->type == OBS_ENCODER_VIDEO) {
+		CheckToDropFrames();
+
+		if (waiting_for_keyframe) {
+			if (!packet->keyframe) {
+				dropped_frames++;
+				return;
+			}
+			waiting_for_keyframe = false;
+		}
+
+		last_queued_dts_usec = packet->dts_usec;
+	}
+
+	QueuedPacket queued;
+	obs_encoder_packet_ref(&queued.packet, packet);
+	queued.queued_ns = os_gettime_ns();
+	packets.push_back(queued);
+
+	if (packets.size() > max_queue_depth)
+		max_queue_depth = packets.size();
+
+	packets_cv.notify_one();
+}
+
+/*
+ * Works like the RTMP output's frame dropping. Once the queued video spans
+ * more than the drop threshold, all video before the newest queued keyframe
+ * is dropped. If no keyframe is queued, all queued video is dropped and new
+ * video is skipped until the next keyframe, as the receiver can't decode
+ * anything before then. Audio is never dropped.
+ *
+ * Must be called with packets_mutex held.
+ */
+void WHIPOutput::CheckToDropFrames()
+{
+	auto first_video = std::find_if(packets.begin(), packets.end(), [](const QueuedPacket &queued) {
+		return queued.packet.type == OBS_ENCODER_VIDEO;
+	});
+	if (first_video == packets.end()) {
+		congestion = waiting_for_keyframe ? 1.0f : 0.0f;
+		return;
+	}
+
+	int64_t buffer_duration_usec = last_queued_dts_usec - first_video->packet.dts_usec;
+	congestion = (float)buffer_duration_usec / (float)drop_threshold_usec;
+
+	if (buffer_duration_usec <= drop_threshold_usec)
+		return;
+
+	auto keyframe = std::find_if(packets.rbegin(), packets.rend(), [](const QueuedPacket &queued) {
+		return queued.packet.type == OBS_ENCODER_VIDEO && queued.packet.keyframe;
+	});
+	bool found_keyframe = keyframe != packets.rend();
+	auto drop_end = found_keyframe ? std::prev(keyframe.base()) : packets.end();
+
+	int num_frames_dropped = 0;
+	std::deque<QueuedPacket> new_packets;
+	bool dropping = true;
+
+	for (auto it = packets.begin(); it != packets.end(); ++it) {
+		if (it == drop_end)
+			dropping = false;
+
+		if (dropping && it->packet.type == OBS_ENCODER_VIDEO) {
+			obs_encoder_packet_release(&it->packet);
+			num_frames_dropped++;
+		} else {
+			new_packets.push_back(*it);
+		}
+	}
+
+	packets.swap(new_packets);
+
+	if (!found_keyframe) {
+		waiting_for_keyframe = true;
+		congestion = 1.0f;
 	}
+
+	dropped_frames += num_frames_dropped;
+	do_log(LOG_DEBUG, "Dropped %d video frames, buffer duration was %" PRId64 "ms", num_frames_dropped,
+	       buffer_duration_usec / 1000);
 }
 
 void WHIPOutput::ConfigureAudioTrack(std::string media_stream_id, std::string cname)
@@ -524,10 +629,94 @@ void WHIPOutput::StartThread()
 		return;
 	}
 
+	StartSendThread();
 	obs_output_begin_data_capture(output, 0);
 	running = true;
 }
 
+void WHIPOutput::StartSendThread()
+{
+	{
+		std::lock_guard<std::mutex> l(packets_mutex);
+		send_thread_active = true;
+		waiting_for_keyframe = false;
+		last_queued_dts_usec = 0;
+		max_queue_depth = 0;
+		packets_sent = 0;
+		total_send_latency_ns = 0;
+		max_send_latency_ns = 0;
+		dropped_frames = 0;
+		congestion = 0.0f;
+	}
+
+	send_thread = std::thread(&WHIPOutput::SendThread, this);
+}
+
+void WHIPOutput::StopSendThread()
+{
+	{
+		std::lock_guard<std::mutex> l(packets_mutex);
+		send_thread_active = false;
+	}
+
+	packets_cv.notify_all();
+	if (send_thread.joinable())
+		send_thread.join();
+
+	std::lock_guard<std::mutex> l(packets_mutex);
+	for (auto &queued : packets)
+		obs_encoder_packet_release(&queued.packet);
+	packets.clear();
+
+	if (packets_sent) {
+		do_log(LOG_INFO,
+		       "Send queue stats: max depth %zu packets, average send latency %.2fms, "
+		       "max send latency %.2fms, %d frames dropped",
+		       max_queue_depth, (double)total_send_latency_ns / (double)packets_sent / 1000000.0,
+		       (double)max_send_latency_ns / 1000000.0, dropped_frames.load());
+	}
+}
+
+void WHIPOutput::SendThread()
+{
+	os_set_thread_name("whip-output: send thread");
+
+	std::unique_lock<std::mutex> l(packets_mutex);
+
+	for (;;) {
+		packets_cv.wait(l, [this] { return !send_thread_active || !packets.empty(); });
+		if (!send_thread_active)
+			break;
+
+		QueuedPacket queued = packets.front();
+		packets.pop_front();
+		l.unlock();
+
+		SendPacket(&queued.packet);
+		uint64_t latency_ns = os_gettime_ns() - queued.queued_ns;
+		obs_encoder_packet_release(&queued.packet);
+
+		l.lock();
+		packets_sent++;
+		total_send_latency_ns += latency_ns;
+		if (latency_ns > max_send_latency_ns)
+			max_send_latency_ns = latency_ns;
+	}
+}
+
+void WHIPOutput::SendPacket(struct encoder_packet *packet)
+{
+	if (packet->type == OBS_ENCODER_AUDIO) {
+		int64_t duration = packet->dts_usec - last_audio_timestamp;
+		Send(packet->data, packet->size, duration, audio_track, audio_sr_reporter);
+		last_audio_timestamp = packet->dts_usec;
+	} else if (packet->type == OBS_ENCODER_VIDEO) {
+		int64_t duration = packet->dts_usec - last_video_timestamp;
+		Send(packet->data, packet->size, duration, video_track, video_sr_reporter);
+		last_video_timestamp = packet->dts_usec;
+	}
+}
+
 void WHIPOutput::SendDelete()
 {
 	if (resource_url.empty()) {
@@ -581,6 +770,8 @@ void WHIPOutput::SendDelete()
 
 void WHIPOutput::StopThread(bool signal)
 {
+	StopSendThread();
+
 	if (peer_connection != nullptr) {
 		peer_connection->close();
 		peer_connection = nullptr;
@@ -687,6 +878,12 @@ void register_whip_output()
 	info.get_connect_time_ms = [](void *priv_data) -> int {
 		return static_cast<WHIPOutput *>(priv_data)->GetConnectTime();
 	};
+	info.get_dropped_frames = [](void *priv_data) -> int {
+		return static_cast<WHIPOutput *>(priv_data)->GetDroppedFrames();
+	};
+	info.get_congestion = [](void *priv_data) -> float {
+		return static_cast<WHIPOutput *>(priv_data)->GetCongestion();
+	};
 	info.encoded_video_codecs = video_codecs;
 	info.encoded_audio_codecs = audio_codecs;
 	info.protocols = "WHIP";
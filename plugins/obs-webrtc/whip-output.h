@@ -4,10 +4,13 @@
 #include <util/curl/curl-helper.h>
 #include <util/platform.h>
 #include <util/base.h>
+#include <util/threading.h>
 #include <util/dstr.h>
 
 #include <string>
 #include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <mutex>
 #include <thread>
 
@@ -26,6 +29,10 @@ public:
 
 	inline int GetConnectTime() { return connect_time_ms; }
 
+	inline int GetDroppedFrames() { return dropped_frames; }
+
+	inline float GetCongestion() { return congestion; }
+
 private:
 	void ConfigureAudioTrack(std::string media_stream_id, std::string cname);
 	void ConfigureVideoTrack(std::string media_stream_id, std::string cname);
@@ -37,6 +44,12 @@ private:
 	void StopThread(bool signal);
 	void ParseLinkHeader(std::string linkHeader, std::vector<rtc::IceServer> &iceServers);
 
+	void StartSendThread();
+	void StopSendThread();
+	void SendThread();
+	void CheckToDropFrames();
+	void SendPacket(struct encoder_packet *packet);
+
 	void Send(void *data, uintptr_t size, uint64_t duration, std::shared_ptr<rtc::Track> track,
 		  std::shared_ptr<rtc::RtcpSrReporter> rtcp_sr_reporter);
 
@@ -58,7 +71,27 @@ private:
 	std::shared_ptr<rtc::RtcpSrReporter> audio_sr_reporter;
 	std::shared_ptr<rtc::RtcpSrReporter> video_sr_reporter;
 
+	struct QueuedPacket {
+		struct encoder_packet packet;
+		uint64_t queued_ns;
+	};
+
+	std::mutex packets_mutex;
+	std::condition_variable packets_cv;
+	std::deque<QueuedPacket> packets;
+	std::thread send_thread;
+	bool send_thread_active;
+	bool waiting_for_keyframe;
+	int64_t last_queued_dts_usec;
+
+	size_t max_queue_depth;
+	uint64_t packets_sent;
+	uint64_t total_send_latency_ns;
+	uint64_t max_send_latency_ns;
+
 	std::atomic<size_t> total_bytes_sent;
+	std::atomic<int> dropped_frames;
+	std::atomic<float> congestion;
 	std::atomic<int> connect_time_ms;
 	int64_t start_time_ns;
 	int64_t last_audio_timestamp;
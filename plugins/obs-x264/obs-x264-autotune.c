@@ -0,0 +1,208 @@
+#include <util/bmem.h>
+#include <util/darray.h>
+#include <util/platform.h>
+#include <util/threading.h>
+
+#include "obs-x264-autotune.h"
+
+#define do_log(level, format, ...) blog(level, "[x264 auto-tune] " format, ##__VA_ARGS__)
+#define info(format, ...) do_log(LOG_INFO, format, ##__VA_ARGS__)
+
+/* encode times are averaged over roughly a second of frames */
+#define SAMPLE_WINDOW_NS 1000000000ULL
+
+/* wait for every encoder to measure a few windows with new settings before
+ * changing anything else */
+#define CHANGE_COOLDOWN_NS 3000000000ULL
+
+/* fraction of the frame interval an encoder may spend encoding before it is
+ * considered overloaded, and below which all encoders must be before any of
+ * them are slowed down again */
+#define HIGH_LOAD 0.85
+#define LOW_LOAD 0.45
+
+struct x264_autotune {
+	obs_encoder_t *encoder;
+	uint64_t frame_ns;
+	uint64_t pixel_rate;
+	int max_level;
+
+	/* only used by the encode thread */
+	uint64_t window_encode_ns;
+	uint32_t window_frames;
+	uint32_t frames_per_window;
+
+	/* protected by autotune_mutex */
+	uint64_t avg_encode_ns;
+
+	volatile long level;
+};
+
+static pthread_mutex_t autotune_mutex = PTHREAD_MUTEX_INITIALIZER;
+static DARRAY(struct x264_autotune *) tuners;
+static uint64_t last_change_ts = 0;
+
+struct x264_autotune *x264_autotune_create(obs_encoder_t *encoder, uint64_t frame_ns, uint64_t pixel_rate,
+					   int max_level, int *threads)
+{
+	struct x264_autotune *at = bzalloc(sizeof(struct x264_autotune));
+	uint64_t total_pixel_rate = pixel_rate;
+
+	at->encoder = encoder;
+	at->frame_ns = frame_ns ? frame_ns : 1;
+	at->pixel_rate = pixel_rate;
+	at->max_level = max_level;
+	at->frames_per_window = (uint32_t)(SAMPLE_WINDOW_NS / at->frame_ns);
+	if (!at->frames_per_window)
+		at->frames_per_window = 1;
+
+	pthread_mutex_lock(&autotune_mutex);
+
+	*threads = 0;
+
+	/* x264 uses 1.5 threads per logical core by default, which
+	 * oversubscribes the CPU as soon as there are several encoders.  Split
+	 * that amount between the encoders by how many pixels they process.
+	 * Encoders that are already open keep their threads, as x264 cannot
+	 * change thread counts after it has been opened. */
+	if (tuners.num) {
+		int cores = os_get_logical_cores();
+
+		for (size_t i = 0; i < tuners.num; i++)
+			total_pixel_rate += tuners.array[i]->pixel_rate;
+
+		*threads = (int)((double)cores * 1.5 * (double)pixel_rate / (double)total_pixel_rate + 0.5);
+		if (*threads < 1)
+			*threads = 1;
+
+		info("'%s' shares %d logical cores with %zu other encoder(s), using %d threads",
+		     obs_encoder_get_name(encoder), cores, tuners.num, *threads);
+	}
+
+	da_push_back(tuners, &at);
+
+	pthread_mutex_unlock(&autotune_mutex);
+
+	return at;
+}
+
+void x264_autotune_destroy(struct x264_autotune *at)
+{
+	if (!at)
+		return;
+
+	pthread_mutex_lock(&autotune_mutex);
+	da_erase_item(tuners, &at);
+	if (!tuners.num) {
+		da_free(tuners);
+		last_change_ts = 0;
+	}
+	pthread_mutex_unlock(&autotune_mutex);
+
+	bfree(at);
+}
+
+static inline double get_load(const struct x264_autotune *at)
+{
+	return (double)at->avg_encode_ns / (double)at->frame_ns;
+}
+
+static struct x264_autotune *find_heaviest_tunable(void)
+{
+	struct x264_autotune *target = NULL;
+
+	for (size_t i = 0; i < tuners.num; i++) {
+		struct x264_autotune *at = tuners.array[i];
+
+		if (at->level < at->max_level && (!target || at->avg_encode_ns > target->avg_encode_ns))
+			target = at;
+	}
+
+	return target;
+}
+
+static struct x264_autotune *find_most_sped_up(void)
+{
+	struct x264_autotune *target = NULL;
+
+	for (size_t i = 0; i < tuners.num; i++) {
+		struct x264_autotune *at = tuners.array[i];
+
+		if (at->level > 0 && (!target || at->level > target->level))
+			target = at;
+	}
+
+	return target;
+}
+
+static bool all_below_low_load(void)
+{
+	for (size_t i = 0; i < tuners.num; i++) {
+		struct x264_autotune *at = tuners.array[i];
+
+		if (!at->avg_encode_ns || get_load(at) >= LOW_LOAD)
+			return false;
+	}
+
+	return true;
+}
+
+/* the encoder that is overloaded is not necessarily the one that should be
+ * sped up: when one encoder takes most of the CPU, making it faster also
+ * frees up cores for the others */
+static void rebalance(struct x264_autotune *at, uint64_t ts)
+{
+	struct x264_autotune *target;
+
+	if (last_change_ts && ts - last_change_ts < CHANGE_COOLDOWN_NS)
+		return;
+
+	if (get_load(at) > HIGH_LOAD) {
+		target = find_heaviest_tunable();
+		if (!target)
+			return;
+
+		os_atomic_set_long(&target->level, target->level + 1);
+		info("'%s' is spending %.1f ms of its %.1f ms frame time encoding, "
+		     "raising speed level of '%s' to %ld",
+		     obs_encoder_get_name(at->encoder), (double)at->avg_encode_ns / 1000000.0,
+		     (double)at->frame_ns / 1000000.0, obs_encoder_get_name(target->encoder), target->level);
+
+	} else if (all_below_low_load()) {
+		target = find_most_sped_up();
+		if (!target)
+			return;
+
+		os_atomic_set_long(&target->level, target->level - 1);
+		info("all encoders have enough headroom, lowering speed level of '%s' to %ld",
+		     obs_encoder_get_name(target->encoder), target->level);
+
+	} else {
+		return;
+	}
+
+	last_change_ts = ts;
+}
+
+void x264_autotune_add_sample(struct x264_autotune *at, uint64_t encode_ns)
+{
+	if (!at)
+		return;
+
+	at->window_encode_ns += encode_ns;
+	if (++at->window_frames < at->frames_per_window)
+		return;
+
+	pthread_mutex_lock(&autotune_mutex);
+	at->avg_encode_ns = at->window_encode_ns / at->window_frames;
+	rebalance(at, os_gettime_ns());
+	pthread_mutex_unlock(&autotune_mutex);
+
+	at->window_encode_ns = 0;
+	at->window_frames = 0;
+}
+
+int x264_autotune_get_level(struct x264_autotune *at)
+{
+	return at ? (int)os_atomic_load_long(&at->level) : 0;
+}
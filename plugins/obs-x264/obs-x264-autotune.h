@@ -0,0 +1,34 @@
+#pragma once
+
+#include <obs-module.h>
+
+/* Coordinates CPU usage between all x264 encoders that have auto-tuning
+ * enabled.  Each encoder reports how long it takes to encode its frames, and
+ * when any of them gets close to its frame budget the controller picks the
+ * encoder that is using the most CPU time and raises its speed level (one
+ * preset step faster).  Once every encoder has plenty of headroom again the
+ * levels are lowered one step at a time. */
+
+struct x264_autotune;
+
+/**
+ * Registers an encoder with the controller.
+ *
+ * @param       encoder         Encoder, used for logging
+ * @param       frame_ns        Frame interval of the encoder
+ * @param       pixel_rate      Pixels per second the encoder has to process
+ * @param       max_level       Number of preset steps the encoder can be
+ *                              sped up by
+ * @param[out]  threads         Suggested thread count for the encoder if other
+ *                              encoders are already registered, otherwise 0
+ *                              (automatic)
+ */
+extern struct x264_autotune *x264_autotune_create(obs_encoder_t *encoder, uint64_t frame_ns, uint64_t pixel_rate,
+						   int max_level, int *threads);
+extern void x264_autotune_destroy(struct x264_autotune *at);
+
+/** Adds the time it took to encode a frame, called from the encode thread */
+extern void x264_autotune_add_sample(struct x264_autotune *at, uint64_t encode_ns);
+
+/** Returns the speed level the encoder should currently be using */
+extern int x264_autotune_get_level(struct x264_autotune *at);
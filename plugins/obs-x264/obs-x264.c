@@ -21,6 +21,8 @@
 #include <util/dstr.h>
 #include <util/darray.h>
 #include <util/platform.h>
+#include <util/threading.h>
+#include <util/util_uint64.h>
 #include <obs-module.h>
 #include <opts-parser.h>
 
@@ -30,6 +32,8 @@
 
 #include <x264.h>
 
+#include "obs-x264-autotune.h"
+
 #define do_log_enc(level, encoder, format, ...) \
 	blog(level, "[x264 encoder: '%s'] " format, obs_encoder_get_name(encoder), ##__VA_ARGS__)
 #define do_log(level, format, ...) do_log_enc(level, obsx264->encoder, format, ##__VA_ARGS__)
@@ -61,6 +65,11 @@ struct obs_x264 {
 
 	uint32_t roi_increment;
 	float *quant_offsets;
+
+	struct x264_autotune *autotune;
+	int preset_idx;
+	int speed_level;
+	volatile bool speed_level_reset;
 };
 
 /* ------------------------------------------------------------------------- */
@@ -91,6 +100,7 @@ static void obs_x264_destroy(void *data)
 
 	if (obsx264) {
 		os_end_high_performance(obsx264->performance_token);
+		x264_autotune_destroy(obsx264->autotune);
 		clear_data(obsx264);
 		da_free(obsx264->packet_data);
 		bfree(obsx264);
@@ -114,6 +124,7 @@ static void obs_x264_defaults(obs_data_t *settings)
 	obs_data_set_default_string(settings, "tune", "");
 	obs_data_set_default_string(settings, "x264opts", "");
 	obs_data_set_default_bool(settings, "repeat_headers", false);
+	obs_data_set_default_bool(settings, "auto_tune", false);
 }
 
 static inline void add_strings(obs_property_t *list, const char *const *strings)
@@ -136,6 +147,7 @@ static inline void add_strings(obs_property_t *list, const char *const *strings)
 #define TEXT_TUNE obs_module_text("Tune")
 #define TEXT_NONE obs_module_text("None")
 #define TEXT_X264_OPTS obs_module_text("EncoderOptions")
+#define TEXT_AUTO_TUNE obs_module_text("AutoTune")
 
 static bool use_bufsize_modified(obs_properties_t *ppts, obs_property_t *p, obs_data_t *settings)
 {
@@ -214,6 +226,8 @@ static obs_properties_t *obs_x264_props(void *unused)
 	obs_properties_add_bool(props, "vfr", TEXT_VFR);
 #endif
 
+	obs_properties_add_bool(props, "auto_tune", TEXT_AUTO_TUNE);
+
 	obs_properties_add_text(props, "x264opts", TEXT_X264_OPTS, OBS_TEXT_DEFAULT);
 
 	headers = obs_properties_add_bool(props, "repeat_headers", "repeat_headers");
@@ -305,10 +319,23 @@ static inline const char *validate_preset(struct obs_x264 *obsx264, const char *
 	return new_preset ? new_preset : "veryfast";
 }
 
+static int get_preset_idx(const char *preset)
+{
+	for (int i = 0; x264_preset_names[i]; i++) {
+		if (strcmp(x264_preset_names[i], preset) == 0)
+			return i;
+	}
+
+	/* x264 uses "medium" when no preset is given */
+	return get_preset_idx("medium");
+}
+
 static bool reset_x264_params(struct obs_x264 *obsx264, const char *preset, const char *tune)
 {
-	int ret = x264_param_default_preset(&obsx264->params, validate_preset(obsx264, preset),
-					    validate(obsx264, tune, "tune", x264_tune_names));
+	preset = validate_preset(obsx264, preset);
+	obsx264->preset_idx = get_preset_idx(preset);
+
+	int ret = x264_param_default_preset(&obsx264->params, preset, validate(obsx264, tune, "tune", x264_tune_names));
 	return ret == 0;
 }
 
@@ -596,6 +623,10 @@ static bool obs_x264_update(void *data, obs_data_t *settings)
 		ret = x264_encoder_reconfig(obsx264->context, &obsx264->params);
 		if (ret != 0)
 			warn("Failed to reconfigure: %d", ret);
+
+		/* reconfiguring restores the analysis settings of the base
+		 * preset, so the auto-tune speed level has to be reapplied */
+		os_atomic_set_bool(&obsx264->speed_level_reset, true);
 		return ret == 0;
 	}
 
@@ -629,6 +660,20 @@ static void load_headers(struct obs_x264 *obsx264)
 	obsx264->sei_size = sei.num;
 }
 
+static void create_autotune(struct obs_x264 *obsx264, const struct video_output_info *voi)
+{
+	uint64_t frame_ns = util_mul_div64(1000000000ULL, voi->fps_den, voi->fps_num);
+	uint64_t pixel_rate = util_mul_div64((uint64_t)obsx264->params.i_width * obsx264->params.i_height,
+					     voi->fps_num, voi->fps_den);
+	int threads;
+
+	obsx264->autotune = x264_autotune_create(obsx264->encoder, frame_ns, pixel_rate, obsx264->preset_idx, &threads);
+
+	/* only pick the thread count if the user has not set one */
+	if (threads && obsx264->params.i_threads == X264_THREADS_AUTO)
+		obsx264->params.i_threads = threads;
+}
+
 static void *obs_x264_create(obs_data_t *settings, obs_encoder_t *encoder)
 {
 	video_t *video = obs_encoder_video(encoder);
@@ -654,6 +699,9 @@ static void *obs_x264_create(obs_data_t *settings, obs_encoder_t *encoder)
 	obsx264->encoder = encoder;
 
 	if (update_settings(obsx264, settings, false)) {
+		if (obs_data_get_bool(settings, "auto_tune"))
+			create_autotune(obsx264, voi);
+
 		obsx264->context = x264_encoder_open(&obsx264->params);
 
 		if (obsx264->context == NULL)
@@ -665,6 +713,7 @@ static void *obs_x264_create(obs_data_t *settings, obs_encoder_t *encoder)
 	}
 
 	if (!obsx264->context) {
+		x264_autotune_destroy(obsx264->autotune);
 		bfree(obsx264);
 		return NULL;
 	}
@@ -774,6 +823,64 @@ static void add_roi(struct obs_x264 *obsx264, x264_picture_t *pic)
 	obsx264->roi_increment = increment;
 }
 
+#define MIN_PARAM(param) params->param = min_int(params->param, faster->param)
+
+static inline int min_int(int a, int b)
+{
+	return a < b ? a : b;
+}
+
+/* Applies the analysis settings of a faster preset, as far as x264 allows
+ * them to be changed while encoding.  Every setting is only ever lowered, so
+ * a faster level never ends up slower than the user's own options. */
+static void apply_speed_level(struct obs_x264 *obsx264, int level)
+{
+	x264_param_t params_val = obsx264->params;
+	x264_param_t *params = &params_val;
+	const char *preset = x264_preset_names[obsx264->preset_idx - level];
+
+	if (level > 0) {
+		x264_param_t faster_val;
+		x264_param_t *faster = &faster_val;
+
+		if (x264_param_default_preset(faster, preset, NULL) != 0)
+			return;
+
+		MIN_PARAM(i_frame_reference);
+		MIN_PARAM(analyse.i_me_method);
+		MIN_PARAM(analyse.i_me_range);
+		MIN_PARAM(analyse.i_trellis);
+		MIN_PARAM(analyse.b_mixed_references);
+		params->analyse.inter &= faster->analyse.inter;
+		params->analyse.intra &= faster->analyse.intra;
+
+		/* x264 cannot switch away from subme 0 while encoding */
+		if (faster->analyse.i_subpel_refine)
+			MIN_PARAM(analyse.i_subpel_refine);
+	}
+
+	int ret = x264_encoder_reconfig(obsx264->context, params);
+	if (ret != 0) {
+		warn("Failed to apply auto-tune speed level %d: %d", level, ret);
+		return;
+	}
+
+	if (level != obsx264->speed_level)
+		info("auto-tune: using the analysis settings of preset '%s'", preset);
+	obsx264->speed_level = level;
+}
+
+#undef MIN_PARAM
+
+static inline void update_speed_level(struct obs_x264 *obsx264)
+{
+	int level = x264_autotune_get_level(obsx264->autotune);
+	bool reset = os_atomic_exchange_bool(&obsx264->speed_level_reset, false);
+
+	if (level != obsx264->speed_level || (reset && level > 0))
+		apply_speed_level(obsx264, level);
+}
+
 static bool obs_x264_encode(void *data, struct encoder_frame *frame, struct encoder_packet *packet,
 			    bool *received_packet)
 {
@@ -782,6 +889,7 @@ static bool obs_x264_encode(void *data, struct encoder_frame *frame, struct enco
 	int nal_count;
 	int ret;
 	x264_picture_t pic, pic_out;
+	uint64_t start_ts = 0;
 
 	if (!frame || !packet || !received_packet)
 		return false;
@@ -792,12 +900,20 @@ static bool obs_x264_encode(void *data, struct encoder_frame *frame, struct enco
 	if (obs_encoder_has_roi(obsx264->encoder))
 		add_roi(obsx264, &pic);
 
+	if (obsx264->autotune) {
+		update_speed_level(obsx264);
+		start_ts = os_gettime_ns();
+	}
+
 	ret = x264_encoder_encode(obsx264->context, &nals, &nal_count, (frame ? &pic : NULL), &pic_out);
 	if (ret < 0) {
 		warn("encode failed");
 		return false;
 	}
 
+	if (obsx264->autotune)
+		x264_autotune_add_sample(obsx264->autotune, os_gettime_ns() - start_ts);
+
 	*received_packet = (nal_count != 0);
 	parse_packet(obsx264, packet, nals, nal_count, &pic_out);
 
@@ -118,6 +118,8 @@ bool obs_module_load()
 		bfree(config_dir);
 	}
 
+	ft2_atlas_init();
+
 	obs_register_source(&freetype2_source_info_v1);
 	obs_register_source(&freetype2_source_info_v2);
 
@@ -126,6 +128,8 @@ bool obs_module_load()
 
 void obs_module_unload(void)
 {
+	ft2_atlas_free();
+
 	if (plugin_initialized) {
 		free_os_font_list();
 		FT_Done_FreeType(ft2_lib);
@@ -219,17 +223,8 @@ static void ft2_source_destroy(void *data)
 {
 	struct ft2_source *srcdata = data;
 
-	if (srcdata->font_face != NULL) {
-		FT_Done_Face(srcdata->font_face);
-		srcdata->font_face = NULL;
-	}
-
-	for (uint32_t i = 0; i < num_cache_slots; i++) {
-		if (srcdata->cacheglyphs[i] != NULL) {
-			bfree(srcdata->cacheglyphs[i]);
-			srcdata->cacheglyphs[i] = NULL;
-		}
-	}
+	ft2_atlas_release(srcdata->atlas);
+	srcdata->atlas = NULL;
 
 	if (srcdata->font_name != NULL)
 		bfree(srcdata->font_name);
@@ -237,17 +232,11 @@ static void ft2_source_destroy(void *data)
 		bfree(srcdata->font_style);
 	if (srcdata->text != NULL)
 		bfree(srcdata->text);
-	if (srcdata->texbuf != NULL)
-		bfree(srcdata->texbuf);
 	if (srcdata->text_file != NULL)
 		bfree(srcdata->text_file);
 
 	obs_enter_graphics();
 
-	if (srcdata->tex != NULL) {
-		gs_texture_destroy(srcdata->tex);
-		srcdata->tex = NULL;
-	}
 	if (srcdata->vbuf != NULL) {
 		gs_vertexbuffer_destroy(srcdata->vbuf);
 		srcdata->vbuf = NULL;
@@ -268,18 +257,23 @@ static void ft2_source_render(void *data, gs_effect_t *effect)
 	if (srcdata == NULL)
 		return;
 
-	if (srcdata->tex == NULL || srcdata->vbuf == NULL)
+	if (srcdata->atlas == NULL || srcdata->atlas->tex == NULL || srcdata->vbuf == NULL)
 		return;
 	if (srcdata->text == NULL || *srcdata->text == 0)
 		return;
 
+	/* the glyphs moved, wait for the next tick to catch up */
+	if (ft2_atlas_changed(srcdata))
+		return;
+
 	gs_reset_blend_state();
 	if (srcdata->outline_text)
 		draw_outlines(srcdata);
 	if (srcdata->drop_shadow)
 		draw_drop_shadow(srcdata);
 
-	draw_uv_vbuffer(srcdata->vbuf, srcdata->tex, srcdata->draw_effect, (uint32_t)wcslen(srcdata->text) * 6, true);
+	draw_uv_vbuffer(srcdata->vbuf, srcdata->atlas->tex, srcdata->draw_effect, (uint32_t)wcslen(srcdata->text) * 6,
+			true);
 
 	UNUSED_PARAMETER(effect);
 }
@@ -289,6 +283,13 @@ static void ft2_video_tick(void *data, float seconds)
 	struct ft2_source *srcdata = data;
 	if (srcdata == NULL)
 		return;
+
+	/* another source filled the shared atlas and it was cleared */
+	if (ft2_atlas_changed(srcdata) && srcdata->text) {
+		cache_glyphs(srcdata, srcdata->text);
+		set_up_vertex_buffer(srcdata);
+	}
+
 	if (!srcdata->from_file || !srcdata->text_file)
 		return;
 
@@ -323,12 +324,11 @@ static bool init_font(struct ft2_source *srcdata)
 	if (!path)
 		return false;
 
-	if (srcdata->font_face != NULL) {
-		FT_Done_Face(srcdata->font_face);
-		srcdata->font_face = NULL;
-	}
+	struct ft2_atlas *atlas = ft2_atlas_acquire(path, index, srcdata->font_size, get_render_mode(srcdata));
+	ft2_atlas_release(srcdata->atlas);
+	srcdata->atlas = atlas;
 
-	return FT_New_Face(ft2_lib, path, index, &srcdata->font_face) == 0;
+	return atlas != NULL;
 }
 
 static void ft2_source_update(void *data, obs_data_t *settings)
@@ -402,8 +402,6 @@ static void ft2_source_update(void *data, obs_data_t *settings)
 	if (ft2_lib == NULL)
 		goto error;
 
-	const size_t texbuf_size = (size_t)texbuf_w * (size_t)texbuf_h;
-
 	if (srcdata->draw_effect == NULL) {
 		char *effect_file = NULL;
 		char *error_string = NULL;
@@ -426,20 +424,14 @@ static void ft2_source_update(void *data, obs_data_t *settings)
 
 	const bool new_aa_setting = obs_data_get_bool(settings, "antialiasing");
 	const bool aa_changed = srcdata->antialiasing != new_aa_setting;
-	if (aa_changed) {
-		srcdata->antialiasing = new_aa_setting;
-		if (srcdata->texbuf != NULL) {
-			memset(srcdata->texbuf, 0, texbuf_size);
-		}
-		cache_standard_glyphs(srcdata);
-	}
+	srcdata->antialiasing = new_aa_setting;
 
 	srcdata->file_load_failed = false;
 	srcdata->from_file = from_file;
 
 	if (srcdata->font_name != NULL) {
 		if (strcmp(font_name, srcdata->font_name) == 0 && strcmp(font_style, srcdata->font_style) == 0 &&
-		    font_flags == srcdata->font_flags && font_size == srcdata->font_size)
+		    font_flags == srcdata->font_flags && font_size == srcdata->font_size && !aa_changed)
 			goto skip_font_load;
 
 		bfree(srcdata->font_name);
@@ -455,22 +447,12 @@ static void ft2_source_update(void *data, obs_data_t *settings)
 	srcdata->font_size = font_size;
 	srcdata->font_flags = font_flags;
 
-	if (!init_font(srcdata) || srcdata->font_face == NULL) {
+	if (!init_font(srcdata)) {
 		blog(LOG_WARNING, "FT2-text: Failed to load font %s", srcdata->font_name);
 		goto error;
-	} else {
-		FT_Set_Pixel_Sizes(srcdata->font_face, 0, srcdata->font_size);
-		FT_Select_Charmap(srcdata->font_face, FT_ENCODING_UNICODE);
-	}
-
-	if (srcdata->texbuf != NULL) {
-		bfree(srcdata->texbuf);
-		srcdata->texbuf = NULL;
 	}
-	srcdata->texbuf = bzalloc(texbuf_size);
 
-	if (srcdata->font_face)
-		cache_standard_glyphs(srcdata);
+	cache_standard_glyphs(srcdata);
 
 skip_font_load:
 	if (from_file) {
@@ -513,7 +495,7 @@ skip_font_load:
 		os_utf8_to_wcs_ptr(tmp, strlen(tmp), &srcdata->text);
 	}
 
-	if (srcdata->font_face) {
+	if (srcdata->atlas) {
 		cache_glyphs(srcdata, srcdata->text);
 		set_up_vertex_buffer(srcdata);
 	}
@@ -19,9 +19,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <obs-module.h>
 #include <ft2build.h>
+#include FT_FREETYPE_H
 
 #define num_cache_slots 65535
-#define src_glyph srcdata->cacheglyphs[glyph_index]
+#define src_glyph srcdata->atlas->cacheglyphs[glyph_index]
 
 struct glyph_info {
 	float u, v, u2, v2;
@@ -29,6 +30,29 @@ struct glyph_info {
 	FT_Pos xadv;
 };
 
+/* Glyph atlas shared by every source using the same font file, face index,
+ * pixel size and render mode.  Outlines and drop shadows are drawn from the
+ * same glyphs, so they don't need separate atlases. */
+struct ft2_atlas {
+	char *path;
+	FT_Long index;
+	uint16_t size;
+	FT_Render_Mode render_mode;
+	long refs;
+
+	FT_Face face;
+
+	uint8_t *texbuf;
+	gs_texture_t *tex;
+	uint32_t texbuf_x, texbuf_y, max_h;
+
+	/* bumped every time the atlas runs out of space and is cleared, which
+	 * leaves the vertex buffers of every source using it out of date */
+	volatile long generation;
+
+	struct glyph_info *cacheglyphs[num_cache_slots];
+};
+
 struct ft2_source {
 	char *font_name;
 	char *font_style;
@@ -46,18 +70,13 @@ struct ft2_source {
 
 	uint32_t cx, cy, max_h, custom_width;
 	uint32_t outline_width;
-	uint32_t texbuf_x, texbuf_y;
 	uint32_t color[2];
 
 	int32_t cur_scroll, scroll_speed;
 
-	gs_texture_t *tex;
-
-	struct glyph_info *cacheglyphs[num_cache_slots];
+	struct ft2_atlas *atlas;
+	long atlas_generation;
 
-	FT_Face font_face;
-
-	uint8_t *texbuf;
 	gs_vertbuffer_t *vbuf;
 
 	gs_effect_t *draw_effect;
@@ -70,6 +89,12 @@ struct ft2_source {
 
 extern FT_Library ft2_lib;
 
+void ft2_atlas_init(void);
+void ft2_atlas_free(void);
+struct ft2_atlas *ft2_atlas_acquire(const char *path, FT_Long index, uint16_t size, FT_Render_Mode render_mode);
+void ft2_atlas_release(struct ft2_atlas *atlas);
+bool ft2_atlas_changed(struct ft2_source *srcdata);
+
 void draw_outlines(struct ft2_source *srcdata);
 void draw_drop_shadow(struct ft2_source *srcdata);
 
@@ -79,6 +104,7 @@ time_t get_modified_timestamp(char *filename);
 void load_text_from_file(struct ft2_source *srcdata, const char *filename);
 void read_from_end(struct ft2_source *srcdata, const char *filename);
 
+FT_Render_Mode get_render_mode(struct ft2_source *srcdata);
 void cache_standard_glyphs(struct ft2_source *srcdata);
 void cache_glyphs(struct ft2_source *srcdata, wchar_t *cache_glyphs);
 
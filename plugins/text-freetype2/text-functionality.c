@@ -17,6 +17,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <obs-module.h>
 #include <util/platform.h>
+#include <util/threading.h>
+#include <util/darray.h>
 #include <ft2build.h>
 #include FT_FREETYPE_H
 #include <sys/stat.h>
@@ -28,6 +30,115 @@ float offsets[16] = {-2.0f, 0.0f, 0.0f, -2.0f, 2.0f,  0.0f, 2.0f,  0.0f,
 
 extern uint32_t texbuf_w, texbuf_h;
 
+static pthread_mutex_t atlas_mutex;
+static DARRAY(struct ft2_atlas *) atlases;
+
+void ft2_atlas_init(void)
+{
+	pthread_mutex_init(&atlas_mutex, NULL);
+	da_init(atlases);
+}
+
+void ft2_atlas_free(void)
+{
+	if (atlases.num)
+		blog(LOG_WARNING, "FT2-text: %zu glyph atlases still referenced at unload", atlases.num);
+
+	da_free(atlases);
+	pthread_mutex_destroy(&atlas_mutex);
+}
+
+struct ft2_atlas *ft2_atlas_acquire(const char *path, FT_Long index, uint16_t size, FT_Render_Mode render_mode)
+{
+	struct ft2_atlas *atlas = NULL;
+
+	pthread_mutex_lock(&atlas_mutex);
+
+	for (size_t i = 0; i < atlases.num; i++) {
+		struct ft2_atlas *cur = atlases.array[i];
+		if (cur->index == index && cur->size == size && cur->render_mode == render_mode &&
+		    strcmp(cur->path, path) == 0) {
+			atlas = cur;
+			atlas->refs++;
+			goto unlock;
+		}
+	}
+
+	FT_Face face;
+	if (FT_New_Face(ft2_lib, path, index, &face) != 0)
+		goto unlock;
+
+	FT_Set_Pixel_Sizes(face, 0, size);
+	FT_Select_Charmap(face, FT_ENCODING_UNICODE);
+
+	atlas = bzalloc(sizeof(struct ft2_atlas));
+	atlas->path = bstrdup(path);
+	atlas->index = index;
+	atlas->size = size;
+	atlas->render_mode = render_mode;
+	atlas->refs = 1;
+	atlas->face = face;
+	atlas->texbuf = bzalloc((size_t)texbuf_w * (size_t)texbuf_h);
+
+	da_push_back(atlases, &atlas);
+
+unlock:
+	pthread_mutex_unlock(&atlas_mutex);
+	return atlas;
+}
+
+void ft2_atlas_release(struct ft2_atlas *atlas)
+{
+	if (!atlas)
+		return;
+
+	pthread_mutex_lock(&atlas_mutex);
+	bool destroy = --atlas->refs == 0;
+	if (destroy)
+		da_erase_item(atlases, &atlas);
+	pthread_mutex_unlock(&atlas_mutex);
+
+	if (!destroy)
+		return;
+
+	for (uint32_t i = 0; i < num_cache_slots; i++)
+		bfree(atlas->cacheglyphs[i]);
+
+	if (atlas->tex) {
+		obs_enter_graphics();
+		gs_texture_destroy(atlas->tex);
+		obs_leave_graphics();
+	}
+
+	FT_Done_Face(atlas->face);
+	bfree(atlas->texbuf);
+	bfree(atlas->path);
+	bfree(atlas);
+}
+
+bool ft2_atlas_changed(struct ft2_source *srcdata)
+{
+	return srcdata->atlas && os_atomic_load_long(&srcdata->atlas->generation) != srcdata->atlas_generation;
+}
+
+/* Called with atlas_mutex held, when a glyph doesn't fit anymore.  Glyphs
+ * that are no longer displayed are never removed on their own, so start over
+ * with an empty atlas and let the other sources cache their text again. */
+static void reset_atlas(struct ft2_atlas *atlas)
+{
+	for (uint32_t i = 0; i < num_cache_slots; i++) {
+		bfree(atlas->cacheglyphs[i]);
+		atlas->cacheglyphs[i] = NULL;
+	}
+
+	memset(atlas->texbuf, 0, (size_t)texbuf_w * (size_t)texbuf_h);
+	atlas->texbuf_x = 0;
+	atlas->texbuf_y = 0;
+	atlas->max_h = 0;
+
+	os_atomic_inc_long(&atlas->generation);
+}
+
 void draw_outlines(struct ft2_source *srcdata)
 {
 	if (!srcdata->text)
@@ -36,8 +147,8 @@ void draw_outlines(struct ft2_source *srcdata)
 	gs_matrix_push();
 	for (int32_t i = 0; i < 8; i++) {
 		gs_matrix_translate3f(offsets[i * 2], offsets[(i * 2) + 1], 0.0f);
-		draw_uv_vbuffer(srcdata->vbuf, srcdata->tex, srcdata->draw_effect, (uint32_t)wcslen(srcdata->text) * 6,
-				false);
+		draw_uv_vbuffer(srcdata->vbuf, srcdata->atlas->tex, srcdata->draw_effect,
+				(uint32_t)wcslen(srcdata->text) * 6, false);
 	}
 	gs_matrix_identity();
 	gs_matrix_pop();
@@ -50,7 +161,8 @@ void draw_drop_shadow(struct ft2_source *srcdata)
 
 	gs_matrix_push();
 	gs_matrix_translate3f(4.0f, 4.0f, 0.0f);
-	draw_uv_vbuffer(srcdata->vbuf, srcdata->tex, srcdata->draw_effect, (uint32_t)wcslen(srcdata->text) * 6, false);
+	draw_uv_vbuffer(srcdata->vbuf, srcdata->atlas->tex, srcdata->draw_effect, (uint32_t)wcslen(srcdata->text) * 6,
+			false);
 	gs_matrix_identity();
 	gs_matrix_pop();
 }
@@ -61,9 +173,11 @@ void set_up_vertex_buffer(struct ft2_source *srcdata)
 	uint32_t x = 0, space_pos = 0, word_width = 0;
 	size_t len;
 
-	if (!srcdata->text)
+	if (!srcdata->text || !srcdata->atlas)
 		return;
 
+	pthread_mutex_lock(&atlas_mutex);
+
 	if (srcdata->custom_width >= 100)
 		srcdata->cx = srcdata->custom_width;
 	else
@@ -79,6 +193,7 @@ void set_up_vertex_buffer(struct ft2_source *srcdata)
 
 	if (*srcdata->text == 0) {
 		obs_leave_graphics();
+		pthread_mutex_unlock(&atlas_mutex);
 		return;
 	}
 
@@ -114,7 +229,7 @@ void set_up_vertex_buffer(struct ft2_source *srcdata)
 		if (srcdata->text[i] == L' ')
 			space_pos = i;
 	next_char:;
-		glyph_index = FT_Get_Char_Index(srcdata->font_face, srcdata->text[i]);
+		glyph_index = FT_Get_Char_Index(srcdata->atlas->face, srcdata->text[i]);
 		if (src_glyph)
 			word_width += src_glyph->xadv;
 	eos_skip:;
@@ -124,6 +239,8 @@ skip_word_wrap:;
 	fill_vertex_buffer(srcdata);
 	gs_vertexbuffer_flush(srcdata->vbuf);
 	obs_leave_graphics();
+
+	pthread_mutex_unlock(&atlas_mutex);
 }
 
 void fill_vertex_buffer(struct ft2_source *srcdata)
@@ -163,7 +280,7 @@ void fill_vertex_buffer(struct ft2_source *srcdata)
 		if (srcdata->text[i] == L'\r')
 			goto skip_glyph;
 
-		glyph_index = FT_Get_Char_Index(srcdata->font_face, srcdata->text[i]);
+		glyph_index = FT_Get_Char_Index(srcdata->atlas->face, srcdata->text[i]);
 		if (src_glyph == NULL)
 			goto skip_glyph;
 
@@ -193,16 +310,6 @@ void fill_vertex_buffer(struct ft2_source *srcdata)
 
 void cache_standard_glyphs(struct ft2_source *srcdata)
 {
-	for (uint32_t i = 0; i < num_cache_slots; i++) {
-		if (srcdata->cacheglyphs[i] != NULL) {
-			bfree(srcdata->cacheglyphs[i]);
-			srcdata->cacheglyphs[i] = NULL;
-		}
-	}
-
-	srcdata->texbuf_x = 0;
-	srcdata->texbuf_y = 0;
-
 	cache_glyphs(srcdata, L"abcdefghijklmnopqrstuvwxyz"
 			      L"ABCDEFGHIJKLMNOPQRSTUVWXYZ1234567890"
 			      L"!@#$%^&*()-_=+,<.>/?\\|[]{}`~ \'\"\0");
@@ -213,10 +320,10 @@ FT_Render_Mode get_render_mode(struct ft2_source *srcdata)
 	return srcdata->antialiasing ? FT_RENDER_MODE_NORMAL : FT_RENDER_MODE_MONO;
 }
 
-void load_glyph(struct ft2_source *srcdata, const FT_UInt glyph_index, const FT_Render_Mode render_mode)
+void load_glyph(FT_Face face, const FT_UInt glyph_index, const FT_Render_Mode render_mode)
 {
 	const FT_Int32 load_mode = render_mode == FT_RENDER_MODE_MONO ? FT_LOAD_TARGET_MONO : FT_LOAD_DEFAULT;
-	FT_Load_Glyph(srcdata->font_face, glyph_index, load_mode);
+	FT_Load_Glyph(face, glyph_index, load_mode);
 }
 
 struct glyph_info *init_glyph(FT_GlyphSlot slot, const uint32_t dx, const uint32_t dy, const uint32_t g_w,
@@ -248,7 +355,7 @@ uint8_t get_pixel_value(const unsigned char *buf_row, FT_Render_Mode render_mode
 	return pixel_set ? 255 : 0;
 }
 
-void rasterize(struct ft2_source *srcdata, FT_GlyphSlot slot, const FT_Render_Mode render_mode, const uint32_t dx,
+void rasterize(struct ft2_atlas *atlas, FT_GlyphSlot slot, const FT_Render_Mode render_mode, const uint32_t dx,
 	       const uint32_t dy)
 {
 	/**
@@ -266,34 +373,42 @@ void rasterize(struct ft2_source *srcdata, FT_GlyphSlot slot, const FT_Render_Mo
 		for (uint32_t x = 0; x < slot->bitmap.width; x++) {
 			const uint32_t row_pixel_position = dx + x;
 			const uint8_t pixel_value = get_pixel_value(&slot->bitmap.buffer[row_start], render_mode, x);
-			srcdata->texbuf[row_pixel_position + row] = pixel_value;
+			atlas->texbuf[row_pixel_position + row] = pixel_value;
 		}
 	}
 }
 
 void cache_glyphs(struct ft2_source *srcdata, wchar_t *cache_glyphs)
 {
-	if (!srcdata->font_face || !cache_glyphs)
+	struct ft2_atlas *atlas = srcdata->atlas;
+	if (!atlas || !cache_glyphs)
 		return;
 
-	FT_GlyphSlot slot = srcdata->font_face->glyph;
+	pthread_mutex_lock(&atlas_mutex);
 
-	uint32_t dx = srcdata->texbuf_x;
-	uint32_t dy = srcdata->texbuf_y;
+	FT_GlyphSlot slot = atlas->face->glyph;
+
+	uint32_t dx = atlas->texbuf_x;
+	uint32_t dy = atlas->texbuf_y;
 
 	int32_t cached_glyphs = 0;
+	bool reset = false;
 	const size_t len = wcslen(cache_glyphs);
 
-	const FT_Render_Mode render_mode = get_render_mode(srcdata);
+	const FT_Render_Mode render_mode = atlas->render_mode;
 
+restart:
 	for (size_t i = 0; i < len; i++) {
-		const FT_UInt glyph_index = FT_Get_Char_Index(srcdata->font_face, cache_glyphs[i]);
+		const FT_UInt glyph_index = FT_Get_Char_Index(atlas->face, cache_glyphs[i]);
 
+		/* another source may have already added this glyph */
 		if (src_glyph != NULL) {
+			if (srcdata->max_h < (uint32_t)src_glyph->h)
+				srcdata->max_h = src_glyph->h;
 			continue;
 		}
 
-		load_glyph(srcdata, glyph_index, render_mode);
+		load_glyph(atlas->face, glyph_index, render_mode);
 		FT_Render_Glyph(slot, render_mode);
 
 		const uint32_t g_w = slot->bitmap.width;
@@ -302,46 +417,61 @@ void cache_glyphs(struct ft2_source *srcdata, wchar_t *cache_glyphs)
 		if (srcdata->max_h < g_h) {
 			srcdata->max_h = g_h;
 		}
+		if (atlas->max_h < g_h) {
+			atlas->max_h = g_h;
+		}
 
 		if (dx + g_w >= texbuf_w) {
 			dx = 0;
-			dy += srcdata->max_h + 1;
+			dy += atlas->max_h + 1;
 		}
 
 		if (dy + g_h >= texbuf_h) {
-			blog(LOG_WARNING, "Out of space trying to render glyphs");
-			break;
+			if (reset) {
+				blog(LOG_WARNING, "Out of space trying to render glyphs");
+				break;
+			}
+
+			/* everything cached so far went with the old
+			 * contents, so start this text over as well */
+			reset_atlas(atlas);
+			reset = true;
+			dx = 0;
+			dy = 0;
+			cached_glyphs++;
+			goto restart;
 		}
 
 		src_glyph = init_glyph(slot, dx, dy, g_w, g_h);
-		rasterize(srcdata, slot, render_mode, dx, dy);
+		rasterize(atlas, slot, render_mode, dx, dy);
 
 		dx += (g_w + 1);
 		if (dx >= texbuf_w) {
 			dx = 0;
-			dy += srcdata->max_h;
+			dy += atlas->max_h;
 		}
 
 		cached_glyphs++;
 	}
 
-	srcdata->texbuf_x = dx;
-	srcdata->texbuf_y = dy;
+	atlas->texbuf_x = dx;
+	atlas->texbuf_y = dy;
+	srcdata->atlas_generation = atlas->generation;
 
 	if (cached_glyphs > 0) {
 
 		obs_enter_graphics();
 
-		if (srcdata->tex != NULL) {
-			gs_texture_t *tmp_texture = srcdata->tex;
-			srcdata->tex = NULL;
-			gs_texture_destroy(tmp_texture);
-		}
-
-		srcdata->tex = gs_texture_create(texbuf_w, texbuf_h, GS_A8, 1, (const uint8_t **)&srcdata->texbuf, 0);
+		if (atlas->tex != NULL)
+			gs_texture_set_image(atlas->tex, atlas->texbuf, texbuf_w, false);
+		else
+			atlas->tex = gs_texture_create(texbuf_w, texbuf_h, GS_A8, 1, (const uint8_t **)&atlas->texbuf,
+						       GS_DYNAMIC);
 
 		obs_leave_graphics();
 	}
+
+	pthread_mutex_unlock(&atlas_mutex);
 }
 
 time_t get_modified_timestamp(char *filename)
@@ -508,11 +638,11 @@ uint32_t get_ft2_text_width(wchar_t *text, struct ft2_source *srcdata)
 		return 0;
 	}
 
-	FT_GlyphSlot slot = srcdata->font_face->glyph;
+	FT_GlyphSlot slot = srcdata->atlas->face->glyph;
 	uint32_t w = 0, max_w = 0;
 	const size_t len = wcslen(text);
 	for (size_t i = 0; i < len; i++) {
-		const FT_UInt glyph_index = FT_Get_Char_Index(srcdata->font_face, text[i]);
+		const FT_UInt glyph_index = FT_Get_Char_Index(srcdata->atlas->face, text[i]);
 
 		if (text[i] == L'\n')
 			w = 0;
@@ -521,7 +651,7 @@ uint32_t get_ft2_text_width(wchar_t *text, struct ft2_source *srcdata)
 				// Use the cached values.
 				w += src_glyph->xadv;
 			} else {
-				load_glyph(srcdata, glyph_index, get_render_mode(srcdata));
+				load_glyph(srcdata->atlas->face, glyph_index, srcdata->atlas->render_mode);
 				w += slot->advance.x >> 6;
 			}
 			if (w > max_w)
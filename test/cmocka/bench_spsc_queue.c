@@ -0,0 +1,225 @@
+/*
+ * Pushes records from one thread to another through a 1 MiB queue, once
+ * with a deque behind a mutex and two events, the way the buffered file
+ * serializer used to, and once with spsc_queue.  Reports the time per record
+ * for small, medium and large records.
+ *
+ *   ./bench_spsc_queue [MiB per record size]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <util/deque.h>
+#include <util/platform.h>
+#include <util/spsc-queue.h>
+#include <util/threading.h>
+
+#define QUEUE_CAPACITY (1024 * 1024)
+#define MAX_RECORD_SIZE 16384
+
+static const uint32_t record_sizes[] = {64, 1024, 16384};
+
+struct record_header {
+	uint32_t seq;
+	uint32_t size;
+};
+
+struct bench {
+	uint32_t record_size;
+	uint32_t record_count;
+	uint8_t data[MAX_RECORD_SIZE];
+
+	/* mutex + deque */
+	pthread_mutex_t mutex;
+	os_event_t *space_event;
+	os_event_t *data_event;
+	struct deque deque;
+	bool done;
+
+	spsc_queue_t *queue;
+};
+
+/* ------------------------------------------------------------------------- */
+
+static void *deque_producer(void *param)
+{
+	struct bench *b = param;
+
+	for (uint32_t seq = 0; seq < b->record_count; seq++) {
+		struct record_header header = {seq, b->record_size};
+		size_t size = sizeof(header) + header.size;
+
+		for (;;) {
+			pthread_mutex_lock(&b->mutex);
+			if (QUEUE_CAPACITY - b->deque.size >= size)
+				break;
+
+			os_event_reset(b->space_event);
+			pthread_mutex_unlock(&b->mutex);
+			os_event_wait(b->space_event);
+		}
+
+		deque_push_back(&b->deque, &header, sizeof(header));
+		deque_push_back(&b->deque, b->data, header.size);
+		os_event_signal(b->data_event);
+		pthread_mutex_unlock(&b->mutex);
+	}
+
+	pthread_mutex_lock(&b->mutex);
+	b->done = true;
+	os_event_signal(b->data_event);
+	pthread_mutex_unlock(&b->mutex);
+	return NULL;
+}
+
+static uint32_t deque_consume(struct bench *b)
+{
+	uint8_t data[MAX_RECORD_SIZE];
+	uint32_t expected_seq = 0;
+
+	for (;;) {
+		os_event_wait(b->data_event);
+
+		pthread_mutex_lock(&b->mutex);
+
+		while (b->deque.size) {
+			struct record_header header;
+
+			deque_pop_front(&b->deque, &header, sizeof(header));
+			deque_pop_front(&b->deque, data, header.size);
+			if (header.seq == expected_seq)
+				expected_seq++;
+		}
+
+		os_event_signal(b->space_event);
+
+		bool done = b->done;
+		if (!done)
+			os_event_reset(b->data_event);
+		pthread_mutex_unlock(&b->mutex);
+
+		if (done)
+			break;
+	}
+
+	return expected_seq;
+}
+
+static uint64_t run_deque(struct bench *b, uint32_t *received)
+{
+	pthread_t thread;
+	uint64_t start_ns;
+
+	pthread_mutex_init(&b->mutex, NULL);
+	os_event_init(&b->space_event, OS_EVENT_TYPE_MANUAL);
+	os_event_init(&b->data_event, OS_EVENT_TYPE_MANUAL);
+	deque_init(&b->deque);
+	b->done = false;
+
+	start_ns = os_gettime_ns();
+	pthread_create(&thread, NULL, deque_producer, b);
+	*received = deque_consume(b);
+	pthread_join(thread, NULL);
+	uint64_t elapsed_ns = os_gettime_ns() - start_ns;
+
+	deque_free(&b->deque);
+	os_event_destroy(b->data_event);
+	os_event_destroy(b->space_event);
+	pthread_mutex_destroy(&b->mutex);
+	return elapsed_ns;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void *spsc_producer(void *param)
+{
+	struct bench *b = param;
+
+	for (uint32_t seq = 0; seq < b->record_count; seq++) {
+		struct record_header header = {seq, b->record_size};
+
+		if (!spsc_queue_wait_space(b->queue, sizeof(header) + header.size))
+			break;
+
+		spsc_queue_write(b->queue, &header, sizeof(header));
+		spsc_queue_write(b->queue, b->data, header.size);
+		spsc_queue_publish(b->queue);
+	}
+
+	spsc_queue_close(b->queue);
+	return NULL;
+}
+
+static uint32_t spsc_consume(struct bench *b)
+{
+	uint8_t data[MAX_RECORD_SIZE];
+	uint32_t expected_seq = 0;
+
+	while (spsc_queue_wait_data(b->queue, sizeof(struct record_header))) {
+		struct record_header header;
+
+		spsc_queue_pop_front(b->queue, &header, sizeof(header));
+		spsc_queue_pop_front(b->queue, data, header.size);
+		if (header.seq == expected_seq)
+			expected_seq++;
+	}
+
+	return expected_seq;
+}
+
+static uint64_t run_spsc(struct bench *b, uint32_t *received)
+{
+	pthread_t thread;
+	uint64_t start_ns;
+
+	b->queue = spsc_queue_create(QUEUE_CAPACITY);
+
+	start_ns = os_gettime_ns();
+	pthread_create(&thread, NULL, spsc_producer, b);
+	*received = spsc_consume(b);
+	pthread_join(thread, NULL);
+	uint64_t elapsed_ns = os_gettime_ns() - start_ns;
+
+	spsc_queue_destroy(b->queue);
+	return elapsed_ns;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int main(int argc, char *argv[])
+{
+	int mib = argc > 1 ? atoi(argv[1]) : 1024;
+	struct bench *b = bzalloc(sizeof(struct bench));
+	int ret = 0;
+
+	if (mib < 1)
+		mib = 1;
+
+	for (size_t i = 0; i < MAX_RECORD_SIZE; i++)
+		b->data[i] = (uint8_t)(i * 31);
+
+	printf("%d MiB through a %d KiB queue, %d CPUs\n", mib, QUEUE_CAPACITY / 1024, os_get_logical_cores());
+
+	for (size_t i = 0; i < sizeof(record_sizes) / sizeof(record_sizes[0]); i++) {
+		uint32_t deque_received, spsc_received;
+
+		b->record_size = record_sizes[i];
+		b->record_count = (uint32_t)((uint64_t)mib * 1024 * 1024 / b->record_size);
+
+		uint64_t deque_ns = run_deque(b, &deque_received);
+		uint64_t spsc_ns = run_spsc(b, &spsc_received);
+
+		printf("  %5u B records: mutex+deque %7.1f ns, spsc_queue %7.1f ns per record\n", b->record_size,
+		       (double)deque_ns / b->record_count, (double)spsc_ns / b->record_count);
+
+		if (deque_received != b->record_count || spsc_received != b->record_count) {
+			printf("  records lost or out of order\n");
+			ret = 1;
+		}
+	}
+
+	bfree(b);
+	return ret;
+}
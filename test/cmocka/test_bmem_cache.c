@@ -0,0 +1,116 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <util/bmem.h>
+#include <util/threading.h>
+
+#define NUM_THREADS 4
+#define NUM_ROUNDS 20000
+#define NUM_SLOTS 64
+
+static inline bool is_aligned(const void *ptr)
+{
+	return ((uintptr_t)ptr % (uintptr_t)base_get_alignment()) == 0;
+}
+
+static void bmem_cache_alloc_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	uint8_t *ptr;
+
+	/* every size class, plus a large allocation */
+	for (size_t size = 1; size <= 8192; size = size * 2 + 1) {
+		ptr = bmalloc(size);
+		assert_true(is_aligned(ptr));
+		memset(ptr, 0xAB, size);
+		bfree(ptr);
+
+		/* freed blocks are handed out again on the same thread */
+		uint8_t *again = bmalloc(size);
+		if (size <= 4096)
+			assert_ptr_equal(again, ptr);
+		bfree(again);
+	}
+
+	/* growing keeps the contents and moves between size classes */
+	ptr = bmalloc(10);
+	for (size_t i = 0; i < 10; i++)
+		ptr[i] = (uint8_t)i;
+	for (size_t size = 20; size < 20000; size *= 2) {
+		ptr = brealloc(ptr, size);
+		assert_true(is_aligned(ptr));
+		for (size_t i = 0; i < 10; i++)
+			assert_int_equal(ptr[i], i);
+	}
+	bfree(ptr);
+
+	assert_int_equal(bnum_allocs(), 0);
+}
+
+static void *alloc_thread(void *param)
+{
+	uint32_t seed = (uint32_t)(uintptr_t)param;
+	uint8_t *slots[NUM_SLOTS] = {0};
+	size_t sizes[NUM_SLOTS] = {0};
+
+	for (int i = 0; i < NUM_ROUNDS; i++) {
+		seed = seed * 1103515245 + 12345;
+		size_t slot = (seed >> 8) % NUM_SLOTS;
+
+		if (slots[slot]) {
+			for (size_t j = 0; j < sizes[slot]; j++)
+				assert_int_equal(slots[slot][j], (uint8_t)(sizes[slot] + j));
+			bfree(slots[slot]);
+			slots[slot] = NULL;
+		} else {
+			sizes[slot] = 1 + (seed >> 12) % 6000;
+			slots[slot] = bmalloc(sizes[slot]);
+			for (size_t j = 0; j < sizes[slot]; j++)
+				slots[slot][j] = (uint8_t)(sizes[slot] + j);
+		}
+	}
+
+	for (size_t i = 0; i < NUM_SLOTS; i++)
+		bfree(slots[i]);
+
+	return NULL;
+}
+
+static void bmem_cache_thread_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	pthread_t threads[NUM_THREADS];
+
+	for (uintptr_t i = 0; i < NUM_THREADS; i++)
+		assert_int_equal(pthread_create(&threads[i], NULL, alloc_thread, (void *)(i + 1)), 0);
+	for (size_t i = 0; i < NUM_THREADS; i++)
+		pthread_join(threads[i], NULL);
+
+	assert_int_equal(bnum_allocs(), 0);
+
+	/* the counters of exited threads have been added up */
+	struct bmem_cache_stats stats;
+	uint64_t allocs = 0;
+	bmem_get_cache_stats(&stats);
+	for (size_t i = 0; i < BMEM_CACHE_SIZE_CLASSES + 1; i++)
+		allocs += stats.allocs[i];
+	assert_true(allocs >= NUM_THREADS * NUM_ROUNDS / 2);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(bmem_cache_alloc_test),
+		cmocka_unit_test(bmem_cache_thread_test),
+	};
+
+	/* the allocator can only be changed before anything is allocated */
+	if (!base_set_allocator(bmem_get_cache_allocator()))
+		return 1;
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
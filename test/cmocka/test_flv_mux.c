@@ -0,0 +1,161 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <stdlib.h>
+
+#include <util/array-serializer.h>
+#include <util/bmem.h>
+
+#include "flv-mux.h"
+
+#ifdef ENABLE_HEVC
+#define VIDEO_CODEC CODEC_HEVC
+#else
+#define VIDEO_CODEC CODEC_H264
+#endif
+
+/* one hour of 30 fps video with a keyframe every two seconds, plus two AAC
+ * tracks */
+#define STREAM_SECONDS 3600
+#define FPS 30
+#define KEYFRAME_INTERVAL (2 * FPS)
+#define AUDIO_RATE 48000
+#define AUDIO_FRAME_SIZE 1024
+
+#define KEYFRAME_SIZE (192 * 1024)
+#define MAX_INTER_FRAME_SIZE (48 * 1024)
+#define MAX_AUDIO_FRAME_SIZE 512
+
+/* the buffer only has to grow until it has seen the largest tag */
+#define WARMUP_SECONDS 10
+
+static long num_allocs = 0;
+
+static void *counting_malloc(size_t size)
+{
+	num_allocs++;
+	return malloc(size);
+}
+
+static void *counting_realloc(void *ptr, size_t size)
+{
+	num_allocs++;
+	return realloc(ptr, size);
+}
+
+static const struct base_allocator counting_allocator = {counting_malloc, counting_realloc, free};
+
+static uint8_t packet_data[KEYFRAME_SIZE];
+
+/* every writer appends one complete tag, ending in the size of the tag */
+static void check_tag(struct array_output_data *data, size_t payload_size)
+{
+	const uint8_t *tag = data->bytes.array;
+	size_t size = data->bytes.num;
+
+	assert_true(size > payload_size + 11 + 4);
+
+	uint32_t data_size = ((uint32_t)tag[1] << 16) | ((uint32_t)tag[2] << 8) | tag[3];
+	assert_int_equal(data_size + 11 + 4, size);
+
+	const uint8_t *end = tag + size - 4;
+	uint32_t tag_size = ((uint32_t)end[0] << 24) | ((uint32_t)end[1] << 16) | ((uint32_t)end[2] << 8) | end[3];
+	assert_int_equal(tag_size, size - 4);
+}
+
+static void flv_mux_steady_state_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	struct array_output_data data;
+	struct serializer s;
+	uint32_t seed = 1234;
+
+	struct encoder_packet video = {
+		.data = packet_data,
+		.timebase_num = 1,
+		.timebase_den = FPS,
+		.type = OBS_ENCODER_VIDEO,
+	};
+	struct encoder_packet audio = {
+		.data = packet_data,
+		.timebase_num = 1,
+		.timebase_den = AUDIO_RATE,
+		.type = OBS_ENCODER_AUDIO,
+	};
+
+	array_output_serializer_init(&s, &data);
+
+	/* headers, the same way the RTMP output sends them */
+	video.size = 64;
+	video.keyframe = true;
+	array_output_serializer_reset(&data);
+	flv_packet_start(&video, VIDEO_CODEC, &s, 0);
+	check_tag(&data, video.size);
+
+	audio.size = 2;
+	array_output_serializer_reset(&data);
+	flv_packet_mux(&audio, 0, &s, true);
+	check_tag(&data, audio.size);
+
+	array_output_serializer_reset(&data);
+	flv_packet_audio_start(&audio, AUDIO_CODEC_AAC, &s, 1);
+	check_tag(&data, audio.size);
+
+	long frames = (long)STREAM_SECONDS * FPS;
+	int64_t audio_pts = 0;
+	long warmup_allocs = 0;
+
+	for (long frame = 0; frame < frames; frame++) {
+		if (frame == WARMUP_SECONDS * FPS)
+			warmup_allocs = num_allocs;
+
+		seed = seed * 1664525u + 1013904223u;
+
+		video.keyframe = frame % KEYFRAME_INTERVAL == 0;
+		video.size = video.keyframe ? KEYFRAME_SIZE : 1024 + (seed >> 8) % (MAX_INTER_FRAME_SIZE - 1024);
+		video.dts = frame;
+		/* every other frame has a composition time offset */
+		video.pts = frame + (frame & 1);
+
+		array_output_serializer_reset(&data);
+		flv_packet_frames(&video, VIDEO_CODEC, 0, &s, 0);
+		check_tag(&data, video.size);
+
+		/* audio up to the end of the frame, on both tracks */
+		while (audio_pts * FPS < (int64_t)(frame + 1) * AUDIO_RATE) {
+			audio.size = 256 + (seed >> 4) % (MAX_AUDIO_FRAME_SIZE - 256);
+			audio.pts = audio.dts = audio_pts;
+
+			array_output_serializer_reset(&data);
+			flv_packet_mux(&audio, 0, &s, false);
+			check_tag(&data, audio.size);
+
+			array_output_serializer_reset(&data);
+			flv_packet_audio_frames(&audio, AUDIO_CODEC_AAC, 0, &s, 1);
+			check_tag(&data, audio.size);
+
+			audio_pts += AUDIO_FRAME_SIZE;
+		}
+	}
+
+	assert_true(warmup_allocs > 0);
+	assert_int_equal(num_allocs, warmup_allocs);
+
+	array_output_serializer_free(&data);
+}
+
+int main(void)
+{
+	/* has to happen before anything is allocated */
+	if (!base_set_allocator(&counting_allocator))
+		return 1;
+
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(flv_mux_steady_state_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,225 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <util/platform.h>
+#include <util/darray.h>
+#include <graphics/image-file.h>
+
+#define GIF_PATH "test_image_file.gif"
+#define GIF_CX 128
+#define GIF_CY 128
+#define GIF_FRAMES 500
+#define GIF_BLOCK 16
+
+#define GIF_FULL_SIZE ((uint64_t)GIF_CX * GIF_CY * 4 * GIF_FRAMES)
+#define GIF_BUDGET (2ULL * 1024 * 1024)
+#define GIF_RAM_CEILING (3ULL * 1024 * 1024)
+
+struct lzw_writer {
+	DARRAY(uint8_t) data;
+	uint32_t bits;
+	int bit_count;
+};
+
+static void put_u8(struct darray *d, uint8_t val)
+{
+	darray_push_back(sizeof(uint8_t), d, &val);
+}
+
+static void put_u16(struct darray *d, uint16_t val)
+{
+	put_u8(d, val & 0xFF);
+	put_u8(d, val >> 8);
+}
+
+static void lzw_put_code(struct lzw_writer *w, uint32_t code)
+{
+	w->bits |= code << w->bit_count;
+	w->bit_count += 9;
+
+	while (w->bit_count >= 8) {
+		put_u8(&w->data.da, w->bits & 0xFF);
+		w->bits >>= 8;
+		w->bit_count -= 8;
+	}
+}
+
+/* writes a solid block of pixels as uncompressed 9-bit lzw codes, resetting
+ * the code table often enough that the code size never grows */
+static void put_image_data(struct darray *gif, int pixels, uint8_t index)
+{
+	struct lzw_writer w = {0};
+
+	lzw_put_code(&w, 256);
+	for (int i = 0; i < pixels; i++) {
+		if (i && i % 250 == 0)
+			lzw_put_code(&w, 256);
+		lzw_put_code(&w, index);
+	}
+	lzw_put_code(&w, 257);
+	if (w.bit_count)
+		put_u8(&w.data.da, w.bits & 0xFF);
+
+	put_u8(gif, 8);
+	for (size_t pos = 0; pos < w.data.num; pos += 255) {
+		size_t size = w.data.num - pos;
+		if (size > 255)
+			size = 255;
+
+		put_u8(gif, (uint8_t)size);
+		darray_push_back_array(sizeof(uint8_t), gif, w.data.array + pos, size);
+	}
+	put_u8(gif, 0);
+
+	da_free(w.data);
+}
+
+static inline void get_block_pos(int frame, int *x, int *y)
+{
+	*x = (frame % (GIF_CX / GIF_BLOCK)) * GIF_BLOCK;
+	*y = ((frame / (GIF_CX / GIF_BLOCK)) % (GIF_CY / GIF_BLOCK)) * GIF_BLOCK;
+}
+
+/* frame 0 fills the canvas, every other frame draws one block on top of it */
+static void write_test_gif(void)
+{
+	DARRAY(uint8_t) gif;
+	da_init(gif);
+
+	darray_push_back_array(sizeof(uint8_t), &gif.da, "GIF89a", 6);
+	put_u16(&gif.da, GIF_CX);
+	put_u16(&gif.da, GIF_CY);
+	put_u8(&gif.da, 0xF7);
+	put_u8(&gif.da, 0);
+	put_u8(&gif.da, 0);
+
+	for (int i = 0; i < 256; i++) {
+		put_u8(&gif.da, (uint8_t)i);
+		put_u8(&gif.da, (uint8_t)(255 - i));
+		put_u8(&gif.da, (uint8_t)(i * 7));
+	}
+
+	darray_push_back_array(sizeof(uint8_t), &gif.da, "\x21\xFF\x0BNETSCAPE2.0\x03\x01\x00\x00\x00", 19);
+
+	for (int i = 0; i < GIF_FRAMES; i++) {
+		int x = 0, y = 0, cx = GIF_CX, cy = GIF_CY;
+
+		if (i) {
+			get_block_pos(i, &x, &y);
+			cx = cy = GIF_BLOCK;
+		}
+
+		darray_push_back_array(sizeof(uint8_t), &gif.da, "\x21\xF9\x04\x00", 4);
+		put_u16(&gif.da, 2);
+		put_u8(&gif.da, 0);
+		put_u8(&gif.da, 0);
+
+		put_u8(&gif.da, 0x2C);
+		put_u16(&gif.da, (uint16_t)x);
+		put_u16(&gif.da, (uint16_t)y);
+		put_u16(&gif.da, (uint16_t)cx);
+		put_u16(&gif.da, (uint16_t)cy);
+		put_u8(&gif.da, 0);
+
+		put_image_data(&gif.da, cx * cy, (uint8_t)i);
+	}
+
+	put_u8(&gif.da, 0x3B);
+
+	FILE *file = os_fopen(GIF_PATH, "wb");
+	assert_non_null(file);
+	assert_int_equal(fwrite(gif.array, 1, gif.num, file), gif.num);
+	fclose(file);
+
+	da_free(gif);
+}
+
+static const uint8_t *get_frame_data(gs_image_file5_t *if5)
+{
+	gs_image_file_t *image = &if5->image4.image3.image2.image;
+	return image->animation_frame_cache[image->cur_frame];
+}
+
+static void gif_stream_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	gs_image_file5_t full;
+	gs_image_file5_t streamed;
+	gs_image_file_t *full_image = &full.image4.image3.image2.image;
+	gs_image_file_t *streamed_image = &streamed.image4.image3.image2.image;
+	uint32_t seed = 1;
+	int frames_shown = 0;
+
+	write_test_gif();
+
+	gs_image_file5_init_budget(&full, GIF_PATH, GS_IMAGE_ALPHA_STRAIGHT, 0);
+	gs_image_file5_init_budget(&streamed, GIF_PATH, GS_IMAGE_ALPHA_STRAIGHT, GIF_BUDGET);
+	os_unlink(GIF_PATH);
+
+	assert_true(full_image->loaded);
+	assert_true(streamed_image->loaded);
+	assert_true(streamed_image->is_animated_gif);
+	assert_int_equal(streamed_image->gif.frame_count, GIF_FRAMES);
+
+	assert_null(full.gif_stream);
+	assert_non_null(streamed.gif_stream);
+
+	assert_true(full.image4.image3.image2.mem_usage >= GIF_FULL_SIZE);
+	assert_true(streamed.image4.image3.image2.mem_usage <= GIF_RAM_CEILING);
+
+	/* play through the animation three times with uneven tick intervals
+	 * (some of which skip frames) and make sure the streamed image shows
+	 * exactly the same frames at exactly the same times */
+	while (frames_shown < GIF_FRAMES * 3) {
+		uint64_t elapsed;
+		bool full_updated, streamed_updated;
+		const uint8_t *full_data, *streamed_data;
+		int x, y;
+
+		seed = seed * 1103515245 + 12345;
+		elapsed = 1000000ULL + (seed >> 8) % 50000000ULL;
+
+		full_updated = gs_image_file5_tick(&full, elapsed);
+		streamed_updated = gs_image_file5_tick(&streamed, elapsed);
+
+		assert_int_equal(full_updated, streamed_updated);
+		assert_int_equal(full_image->cur_frame, streamed_image->cur_frame);
+		if (!streamed_updated)
+			continue;
+
+		full_data = get_frame_data(&full);
+		streamed_data = get_frame_data(&streamed);
+		assert_non_null(full_data);
+		assert_non_null(streamed_data);
+		assert_memory_equal(full_data, streamed_data, GIF_CX * GIF_CY * 4);
+
+		/* the block drawn by the current frame uses its own color */
+		get_block_pos(streamed_image->cur_frame, &x, &y);
+		assert_int_equal(streamed_data[(y * GIF_CX + x) * 4], (uint8_t)streamed_image->cur_frame);
+
+		frames_shown++;
+	}
+
+	/* restarting goes back to the first frame and loop */
+	gs_image_file5_restart(&full);
+	gs_image_file5_restart(&streamed);
+	assert_int_equal(streamed_image->cur_frame, 0);
+	assert_int_equal(streamed_image->cur_loop, 0);
+	assert_memory_equal(get_frame_data(&full), get_frame_data(&streamed), GIF_CX * GIF_CY * 4);
+
+	gs_image_file5_free(&full);
+	gs_image_file5_free(&streamed);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(gif_stream_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
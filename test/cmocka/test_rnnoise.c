@@ -0,0 +1,101 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <util/c99defs.h>
+
+#include <rnnoise.h>
+
+#define FRAME_SIZE 480
+#define FRAME_COUNT 300
+#define MAX_STREAMS 6
+
+/* noise plus a tone, different for every stream, in the 16-bit range that
+ * RNNoise expects */
+static void generate_frame(float *frame, int stream, int frame_idx, uint32_t *seed)
+{
+	for (int i = 0; i < FRAME_SIZE; i++) {
+		double t = (double)(frame_idx * FRAME_SIZE + i) / 48000.0;
+
+		*seed = *seed * 1664525u + 1013904223u;
+		float noise = (float)((int32_t)(*seed >> 16) - 32768) / 32768.0f;
+		float tone = (float)sin(2.0 * M_PI * (220.0 + 110.0 * stream) * t);
+
+		frame[i] = (tone * 0.4f + noise * 0.1f) * 32767.0f;
+	}
+}
+
+static void check_batch_matches_single(int streams)
+{
+	DenoiseState *single[MAX_STREAMS];
+	DenoiseState *batch[MAX_STREAMS];
+	float single_buf[MAX_STREAMS][FRAME_SIZE];
+	float batch_buf[MAX_STREAMS][FRAME_SIZE];
+	float *batch_ptr[MAX_STREAMS];
+	float single_vad[MAX_STREAMS];
+	float batch_vad[MAX_STREAMS];
+	uint32_t seeds[MAX_STREAMS];
+
+	for (int c = 0; c < streams; c++) {
+		single[c] = rnnoise_create(NULL);
+		batch[c] = rnnoise_create(NULL);
+		batch_ptr[c] = batch_buf[c];
+		seeds[c] = 1234u + (uint32_t)c;
+	}
+
+	for (int f = 0; f < FRAME_COUNT; f++) {
+		for (int c = 0; c < streams; c++) {
+			/* the last stream starts out silent, which skips the
+			 * network for it */
+			if (c == streams - 1 && f < 50)
+				memset(single_buf[c], 0, sizeof(single_buf[c]));
+			else
+				generate_frame(single_buf[c], c, f, &seeds[c]);
+			memcpy(batch_buf[c], single_buf[c], sizeof(single_buf[c]));
+		}
+
+		for (int c = 0; c < streams; c++)
+			single_vad[c] = rnnoise_process_frame(single[c], single_buf[c], single_buf[c]);
+		rnnoise_process_frames(batch, batch_ptr, (const float **)batch_ptr, batch_vad, streams);
+
+		for (int c = 0; c < streams; c++) {
+			assert_memory_equal(single_buf[c], batch_buf[c], sizeof(single_buf[c]));
+			assert_memory_equal(&single_vad[c], &batch_vad[c], sizeof(float));
+		}
+	}
+
+	for (int c = 0; c < streams; c++) {
+		rnnoise_destroy(single[c]);
+		rnnoise_destroy(batch[c]);
+	}
+}
+
+static void rnnoise_batch_stereo_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	check_batch_matches_single(2);
+}
+
+/* more streams than are run through the network at once */
+static void rnnoise_batch_many_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	check_batch_matches_single(MAX_STREAMS);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(rnnoise_batch_stereo_test),
+		cmocka_unit_test(rnnoise_batch_many_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,155 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <util/spsc-queue.h>
+#include <util/threading.h>
+
+#define QUEUE_CAPACITY 65536
+#define RECORD_COUNT 200000
+#define MAX_RECORD_SIZE 3000
+
+static void spsc_queue_basic_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	spsc_queue_t *q = spsc_queue_create(QUEUE_CAPACITY);
+	uint8_t data[10000];
+	uint8_t out[10000];
+
+	assert_non_null(q);
+	assert_int_equal(spsc_queue_size(q), 0);
+	assert_int_equal(spsc_queue_free_space(q), QUEUE_CAPACITY);
+
+	for (size_t i = 0; i < sizeof(data); i++)
+		data[i] = (uint8_t)(i * 31);
+
+	/* written data is only visible after publishing */
+	assert_true(spsc_queue_write(q, data, sizeof(data)));
+	assert_int_equal(spsc_queue_size(q), 0);
+	assert_int_equal(spsc_queue_free_space(q), QUEUE_CAPACITY - sizeof(data));
+	assert_false(spsc_queue_peek_front(q, out, 1));
+
+	spsc_queue_publish(q);
+	assert_int_equal(spsc_queue_size(q), sizeof(data));
+
+	/* spans several blocks */
+	assert_true(spsc_queue_peek_front(q, out, sizeof(out)));
+	assert_memory_equal(data, out, sizeof(data));
+	assert_int_equal(spsc_queue_size(q), sizeof(data));
+
+	assert_true(spsc_queue_pop_front(q, NULL, 100));
+	assert_true(spsc_queue_pop_front(q, out, sizeof(data) - 100));
+	assert_memory_equal(data + 100, out, sizeof(data) - 100);
+	assert_int_equal(spsc_queue_size(q), 0);
+	assert_false(spsc_queue_pop_front(q, out, 1));
+
+	/* never grows past its capacity */
+	for (int i = 0; i < QUEUE_CAPACITY / (int)sizeof(data); i++)
+		assert_true(spsc_queue_push_back(q, data, sizeof(data)));
+	assert_false(spsc_queue_push_back(q, data, sizeof(data)));
+	assert_false(spsc_queue_wait_space(q, QUEUE_CAPACITY + 1));
+
+	assert_true(spsc_queue_pop_front(q, NULL, sizeof(data)));
+	assert_true(spsc_queue_wait_space(q, sizeof(data)));
+	assert_true(spsc_queue_push_back(q, data, sizeof(data)));
+
+	/* closing keeps the published data readable */
+	spsc_queue_close(q);
+	assert_true(spsc_queue_closed(q));
+	assert_true(spsc_queue_wait_data(q, sizeof(data)));
+	assert_false(spsc_queue_wait_data(q, QUEUE_CAPACITY + 1));
+
+	spsc_queue_destroy(q);
+}
+
+struct record_header {
+	uint32_t seq;
+	uint32_t size;
+};
+
+static inline uint8_t record_byte(uint32_t seq, uint32_t i)
+{
+	return (uint8_t)(seq * 7 + i);
+}
+
+static inline uint32_t record_size(uint32_t seq)
+{
+	return (seq * 2654435761u) % MAX_RECORD_SIZE;
+}
+
+static void *producer_thread(void *param)
+{
+	spsc_queue_t *q = param;
+	uint8_t data[MAX_RECORD_SIZE];
+
+	for (uint32_t seq = 0; seq < RECORD_COUNT; seq++) {
+		struct record_header header = {seq, record_size(seq)};
+
+		for (uint32_t i = 0; i < header.size; i++)
+			data[i] = record_byte(seq, i);
+
+		if (!spsc_queue_wait_space(q, sizeof(header) + header.size))
+			break;
+
+		spsc_queue_write(q, &header, sizeof(header));
+		spsc_queue_write(q, data, header.size);
+
+		/* publish in batches now and then */
+		if (seq % 3 == 0)
+			spsc_queue_publish(q);
+	}
+
+	spsc_queue_publish(q);
+	spsc_queue_close(q);
+	return NULL;
+}
+
+static void spsc_queue_thread_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	spsc_queue_t *q = spsc_queue_create(QUEUE_CAPACITY);
+	uint8_t data[MAX_RECORD_SIZE];
+	uint8_t expected[MAX_RECORD_SIZE];
+	uint32_t expected_seq = 0;
+	pthread_t thread;
+
+	assert_int_equal(pthread_create(&thread, NULL, producer_thread, q), 0);
+
+	while (spsc_queue_wait_data(q, sizeof(struct record_header))) {
+		struct record_header header;
+
+		assert_true(spsc_queue_pop_front(q, &header, sizeof(header)));
+		assert_int_equal(header.seq, expected_seq);
+		assert_int_equal(header.size, record_size(expected_seq));
+
+		/* records are published as a whole */
+		assert_true(spsc_queue_size(q) >= header.size);
+		assert_true(spsc_queue_pop_front(q, data, header.size));
+
+		for (uint32_t i = 0; i < header.size; i++)
+			expected[i] = record_byte(header.seq, i);
+		assert_memory_equal(data, expected, header.size);
+
+		expected_seq++;
+	}
+
+	pthread_join(thread, NULL);
+
+	assert_int_equal(expected_seq, RECORD_COUNT);
+	assert_int_equal(spsc_queue_size(q), 0);
+
+	spsc_queue_destroy(q);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(spsc_queue_basic_test),
+		cmocka_unit_test(spsc_queue_thread_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,213 @@
+/*
+ * Runs a typical mic chain of obs-filters audio filters (noise gate, 3-band
+ * EQ, compressor, limiter) over six stereo sources of speech-like audio, and
+ * reports how long each filter takes per second of audio.
+ *
+ * The filters are built into the benchmark, so it only needs libobs:
+ *
+ *   ./audio-filter-bench [seconds]
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <obs-module.h>
+#include <util/platform.h>
+
+#define NUM_SOURCES 6
+#define CHANNELS 2
+#define SAMPLE_RATE 48000
+#define BLOCK_SIZE AUDIO_OUTPUT_FRAMES
+
+extern struct obs_source_info noise_gate_filter;
+extern struct obs_source_info eq_filter;
+extern struct obs_source_info compressor_filter;
+extern struct obs_source_info limiter_filter;
+
+/* normally provided by obs-filters.c */
+const char *obs_module_text(const char *val)
+{
+	return val;
+}
+
+struct stage {
+	const struct obs_source_info *info;
+	void (*set_settings)(obs_data_t *settings);
+	void *filters[NUM_SOURCES];
+	uint64_t elapsed_ns;
+};
+
+static void eq_settings(obs_data_t *settings)
+{
+	obs_data_set_double(settings, "low", 3.0);
+	obs_data_set_double(settings, "mid", -2.0);
+	obs_data_set_double(settings, "high", 4.0);
+}
+
+static void compressor_settings(obs_data_t *settings)
+{
+	obs_data_set_double(settings, "ratio", 4.0);
+	obs_data_set_double(settings, "threshold", -18.0);
+	obs_data_set_double(settings, "output_gain", 3.0);
+}
+
+static void limiter_settings(obs_data_t *settings)
+{
+	obs_data_set_double(settings, "threshold", -3.0);
+}
+
+static struct stage stages[] = {
+	{&noise_gate_filter, NULL},
+	{&eq_filter, eq_settings},
+	{&compressor_filter, compressor_settings},
+	{&limiter_filter, limiter_settings},
+};
+
+#define NUM_STAGES (sizeof(stages) / sizeof(stages[0]))
+
+/* Voiced bursts with pauses in between and a quiet noise floor, so that the
+ * gate opens and closes and the compressor and limiter both have work to do
+ * on the peaks. Each source gets a different voice and rhythm. */
+static float *generate_audio(int source, size_t frames)
+{
+	float *audio = malloc(sizeof(float) * frames * CHANNELS);
+	double f0 = 110.0 + 30.0 * source;
+	double burst_sec = 0.3 + 0.05 * source;
+	uint32_t seed = 1234 + source;
+
+	for (size_t i = 0; i < frames; i++) {
+		double t = (double)i / SAMPLE_RATE;
+		double phase = fmod(t, burst_sec * 1.6) / burst_sec;
+		double level = phase < 1.0 ? sin(M_PI * phase) : 0.0;
+		double voice = 0.0;
+
+		for (int h = 1; h <= 8; h++)
+			voice += sin(2.0 * M_PI * f0 * h * t) / h;
+
+		for (int c = 0; c < CHANNELS; c++) {
+			seed = seed * 1664525u + 1013904223u;
+			float noise = (float)((int32_t)(seed >> 16) - 32768) / 32768.0f;
+
+			audio[c * frames + i] = (float)(voice * level * 0.5) + noise * 0.003f;
+		}
+	}
+
+	return audio;
+}
+
+static void create_filters(void)
+{
+	for (size_t s = 0; s < NUM_STAGES; s++) {
+		struct stage *stage = &stages[s];
+		obs_data_t *settings = obs_data_create();
+
+		stage->info->get_defaults(settings);
+		if (stage->set_settings)
+			stage->set_settings(settings);
+
+		/* the filters only use their context for logging and for
+		 * listing sidechain sources in their properties */
+		for (int i = 0; i < NUM_SOURCES; i++)
+			stage->filters[i] = stage->info->create(settings, NULL);
+
+		obs_data_release(settings);
+	}
+}
+
+static void destroy_filters(void)
+{
+	for (size_t s = 0; s < NUM_STAGES; s++) {
+		for (int i = 0; i < NUM_SOURCES; i++)
+			stages[s].info->destroy(stages[s].filters[i]);
+	}
+}
+
+static void run(float *sources[NUM_SOURCES], size_t frames)
+{
+	float block[CHANNELS][BLOCK_SIZE];
+	struct obs_audio_data audio = {0};
+
+	for (int c = 0; c < CHANNELS; c++)
+		audio.data[c] = (uint8_t *)block[c];
+
+	for (size_t s = 0; s < NUM_STAGES; s++)
+		stages[s].elapsed_ns = 0;
+
+	for (size_t pos = 0; pos + BLOCK_SIZE <= frames; pos += BLOCK_SIZE) {
+		for (int i = 0; i < NUM_SOURCES; i++) {
+			for (int c = 0; c < CHANNELS; c++)
+				memcpy(block[c], sources[i] + c * frames + pos, sizeof(block[c]));
+
+			audio.frames = BLOCK_SIZE;
+			audio.timestamp = pos * 1000000000ULL / SAMPLE_RATE;
+
+			for (size_t s = 0; s < NUM_STAGES; s++) {
+				struct stage *stage = &stages[s];
+				uint64_t start_ns = os_gettime_ns();
+
+				stage->info->filter_audio(stage->filters[i], &audio);
+				stage->elapsed_ns += os_gettime_ns() - start_ns;
+			}
+		}
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	struct obs_audio_info oai = {
+		.samples_per_sec = SAMPLE_RATE,
+		.speakers = SPEAKERS_STEREO,
+	};
+	float *sources[NUM_SOURCES];
+	int seconds = argc > 1 ? atoi(argv[1]) : 60;
+	int ret = 1;
+
+	if (seconds < 1)
+		seconds = 1;
+
+	size_t frames = (size_t)seconds * SAMPLE_RATE;
+
+	if (!obs_startup("en-US", NULL, NULL)) {
+		fprintf(stderr, "Couldn't start OBS\n");
+		goto fail;
+	}
+
+	/* the filters take their sample rate and channel count from here */
+	if (!obs_reset_audio(&oai)) {
+		fprintf(stderr, "Couldn't initialize audio\n");
+		goto fail;
+	}
+
+	for (int i = 0; i < NUM_SOURCES; i++)
+		sources[i] = generate_audio(i, frames);
+
+	create_filters();
+
+	/* warm up */
+	run(sources, frames / 10);
+
+	run(sources, frames);
+
+	uint64_t total_ns = 0;
+
+	printf("%d sources, %d channels, %d s of audio\n", NUM_SOURCES, CHANNELS, seconds);
+	for (size_t s = 0; s < NUM_STAGES; s++) {
+		total_ns += stages[s].elapsed_ns;
+		printf("  %-20s %.3f ms per second of audio\n", stages[s].info->id,
+		       (double)stages[s].elapsed_ns / 1000000.0 / seconds);
+	}
+	printf("  %-20s %.3f ms per second of audio (%.2f%% of one core)\n", "whole chain",
+	       (double)total_ns / 1000000.0 / seconds, (double)total_ns / 10000000.0 / seconds);
+
+	destroy_filters();
+
+	for (int i = 0; i < NUM_SOURCES; i++)
+		free(sources[i]);
+	ret = 0;
+
+fail:
+	obs_shutdown();
+	return ret;
+}
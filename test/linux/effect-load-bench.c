@@ -0,0 +1,114 @@
+/*
+ * Measures how long it takes to load effects and to link the shader programs
+ * of all their techniques, which is what most of the graphics startup time is
+ * spent on.  Run it twice to compare a cold shader cache with a warm one:
+ *
+ *   ./effect-load-bench /tmp/shader-cache /usr/share/obs/libobs/default.effect ...
+ *
+ * Note that Mesa keeps a shader cache of its own, which can be disabled with
+ * MESA_SHADER_CACHE_DISABLE=true.
+ */
+
+#include <stdio.h>
+
+#include <X11/Xlib.h>
+
+#include <obs.h>
+#include <obs-nix-platform.h>
+#include <graphics/effect.h>
+#include <util/platform.h>
+
+#define TARGET_SIZE 64
+
+static void draw_all_techniques(gs_effect_t *effect)
+{
+	for (size_t i = 0; i < effect->techniques.num; i++) {
+		gs_technique_t *tech = effect->techniques.array + i;
+		size_t passes = gs_technique_begin(tech);
+
+		for (size_t pass = 0; pass < passes; pass++) {
+			if (gs_technique_begin_pass(tech, pass)) {
+				gs_draw_sprite(NULL, 0, TARGET_SIZE, TARGET_SIZE);
+				gs_technique_end_pass(tech);
+			}
+		}
+
+		gs_technique_end(tech);
+	}
+}
+
+static void run_benchmark(int num_files, char *files[])
+{
+	gs_texture_t *target = gs_texture_create(TARGET_SIZE, TARGET_SIZE, GS_RGBA, 1, NULL, GS_RENDER_TARGET);
+	uint64_t load_ns = 0;
+	uint64_t draw_ns = 0;
+	int loaded = 0;
+
+	gs_set_render_target(target, NULL);
+	gs_set_viewport(0, 0, TARGET_SIZE, TARGET_SIZE);
+	gs_ortho(0.0f, (float)TARGET_SIZE, 0.0f, (float)TARGET_SIZE, -100.0f, 100.0f);
+
+	for (int i = 0; i < num_files; i++) {
+		uint64_t start_ns = os_gettime_ns();
+		gs_effect_t *effect = gs_effect_create_from_file(files[i], NULL);
+		uint64_t loaded_ns = os_gettime_ns();
+
+		if (!effect) {
+			fprintf(stderr, "Couldn't load %s\n", files[i]);
+			continue;
+		}
+
+		/* programs are only linked when they are first drawn with */
+		draw_all_techniques(effect);
+		gs_flush();
+
+		load_ns += loaded_ns - start_ns;
+		draw_ns += os_gettime_ns() - loaded_ns;
+		loaded++;
+
+		gs_effect_destroy(effect);
+	}
+
+	gs_set_render_target(NULL, NULL);
+	gs_texture_destroy(target);
+
+	printf("%d effects\n", loaded);
+	printf("  create:     %.1f ms\n", (double)load_ns / 1000000.0);
+	printf("  first draw: %.1f ms\n", (double)draw_ns / 1000000.0);
+	printf("  total:      %.1f ms\n", (double)(load_ns + draw_ns) / 1000000.0);
+}
+
+int main(int argc, char *argv[])
+{
+	graphics_t *graphics = NULL;
+	Display *display;
+
+	if (argc < 3) {
+		fprintf(stderr, "Usage: %s <cache dir> <file.effect>...\n", argv[0]);
+		return 1;
+	}
+
+	display = XOpenDisplay(NULL);
+	if (!display) {
+		fprintf(stderr, "Couldn't open X display\n");
+		return 1;
+	}
+
+	obs_set_nix_platform(OBS_NIX_PLATFORM_X11_EGL);
+	obs_set_nix_platform_display(display);
+
+	if (gs_create(&graphics, "libobs-opengl", 0) != GS_SUCCESS) {
+		fprintf(stderr, "Couldn't create graphics\n");
+		XCloseDisplay(display);
+		return 1;
+	}
+
+	gs_enter_context(graphics);
+	gs_set_shader_cache_path(argv[1]);
+	run_benchmark(argc - 2, argv + 2);
+	gs_leave_context();
+
+	gs_destroy(graphics);
+	XCloseDisplay(display);
+	return 0;
+}
@@ -0,0 +1,228 @@
+/*
+ * Runs the render delay filter of the obs-filters module on a 1080p60 source
+ * with each way of storing frames, and reports how much memory it uses, how
+ * long frames take to render and how late the source actually shows up.
+ *
+ * Runs on any X server, including a virtual one with software rendering:
+ *
+ *   LIBGL_ALWAYS_SOFTWARE=1 xvfb-run ./gpu-delay-bench \
+ *           <path to obs-filters.so> <obs-filters data directory> [delay ms]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <X11/Xlib.h>
+
+#include <obs.h>
+#include <obs-nix-platform.h>
+#include <util/platform.h>
+
+#define WIDTH 1920
+#define HEIGHT 1080
+#define FPS 60
+#define EXTRA_RUN_TIME_MS 2000
+
+struct bench_mode {
+	const char *name;
+	int storage;
+	int vram_budget_mb;
+};
+
+static const struct bench_mode modes[] = {
+	{"full quality, video memory", 0, 16384},
+	{"compact, video memory", 1, 16384},
+	{"full quality, system memory", 0, 64},
+	{"compact, system memory", 1, 64},
+};
+
+static volatile uint64_t first_frame_ts;
+
+static const char *white_source_get_name(void *type_data)
+{
+	UNUSED_PARAMETER(type_data);
+	return "white";
+}
+
+static void *white_source_create(obs_data_t *settings, obs_source_t *source)
+{
+	UNUSED_PARAMETER(settings);
+	return source;
+}
+
+static void white_source_destroy(void *data)
+{
+	UNUSED_PARAMETER(data);
+}
+
+static uint32_t white_source_get_width(void *data)
+{
+	UNUSED_PARAMETER(data);
+	return WIDTH;
+}
+
+static uint32_t white_source_get_height(void *data)
+{
+	UNUSED_PARAMETER(data);
+	return HEIGHT;
+}
+
+static void white_source_render(void *data, gs_effect_t *effect)
+{
+	gs_effect_t *solid = obs_get_base_effect(OBS_EFFECT_SOLID);
+	struct vec4 color;
+
+	vec4_set(&color, 1.0f, 1.0f, 1.0f, 1.0f);
+	gs_effect_set_vec4(gs_effect_get_param_by_name(solid, "color"), &color);
+
+	while (gs_effect_loop(solid, "Solid"))
+		gs_draw_sprite(NULL, 0, WIDTH, HEIGHT);
+
+	UNUSED_PARAMETER(data);
+	UNUSED_PARAMETER(effect);
+}
+
+static struct obs_source_info white_source = {
+	.id = "bench_white_source",
+	.type = OBS_SOURCE_TYPE_INPUT,
+	.output_flags = OBS_SOURCE_VIDEO,
+	.get_name = white_source_get_name,
+	.create = white_source_create,
+	.destroy = white_source_destroy,
+	.get_width = white_source_get_width,
+	.get_height = white_source_get_height,
+	.video_render = white_source_render,
+};
+
+/* the output stays black until the delayed source shows up */
+static void raw_video(void *param, struct video_data *frame)
+{
+	if (frame->data[0][0] && !first_frame_ts)
+		first_frame_ts = frame->timestamp;
+
+	UNUSED_PARAMETER(param);
+}
+
+static void run_benchmark(const struct bench_mode *mode, int delay_ms)
+{
+	obs_source_t *source = obs_source_create_private(white_source.id, "white", NULL);
+	obs_data_t *settings = obs_data_create();
+	obs_source_t *filter;
+	uint32_t lagged_frames;
+	uint64_t start_ns;
+	calldata_t cd = {0};
+
+	obs_data_set_int(settings, "delay_ms", delay_ms);
+	obs_data_set_int(settings, "storage", mode->storage);
+	obs_data_set_int(settings, "vram_budget_mb", mode->vram_budget_mb);
+	obs_data_set_bool(settings, "spill_to_ram", true);
+	filter = obs_source_create_private("gpu_delay", "delay", settings);
+	obs_data_release(settings);
+
+	if (!filter) {
+		fprintf(stderr, "Couldn't create the render delay filter\n");
+		obs_source_release(source);
+		return;
+	}
+
+	obs_source_filter_add(source, filter);
+
+	/* give the filter a tick to allocate its frames */
+	os_sleep_ms(100);
+
+	first_frame_ts = 0;
+	lagged_frames = obs_get_lagged_frames();
+	obs_add_raw_video_callback(NULL, raw_video, NULL);
+
+	start_ns = os_gettime_ns();
+	obs_set_output_source(0, source);
+	os_sleep_ms(delay_ms + EXTRA_RUN_TIME_MS);
+	obs_set_output_source(0, NULL);
+
+	obs_remove_raw_video_callback(raw_video, NULL);
+
+	proc_handler_call(obs_source_get_proc_handler(filter), "get_memory_usage", &cd);
+
+	printf("%s:\n", mode->name);
+	printf("  video memory:  %.1f MB\n", (double)calldata_int(&cd, "video_memory") / (1024.0 * 1024.0));
+	printf("  system memory: %.1f MB\n", (double)calldata_int(&cd, "system_memory") / (1024.0 * 1024.0));
+	printf("  frame time:    %.3f ms, %u lagged frames\n", (double)obs_get_average_frame_time_ns() / 1000000.0,
+	       obs_get_lagged_frames() - lagged_frames);
+	if (first_frame_ts)
+		printf("  delay:         %.0f ms\n", (double)(first_frame_ts - start_ns) / 1000000.0);
+	else
+		printf("  delay:         source never showed up\n");
+
+	calldata_free(&cd);
+
+	obs_source_filter_remove(source, filter);
+	obs_source_release(filter);
+	obs_source_release(source);
+}
+
+int main(int argc, char *argv[])
+{
+	struct obs_video_info ovi = {
+		.graphics_module = "libobs-opengl",
+		.fps_num = FPS,
+		.fps_den = 1,
+		.base_width = WIDTH,
+		.base_height = HEIGHT,
+		.output_width = WIDTH,
+		.output_height = HEIGHT,
+		.output_format = VIDEO_FORMAT_RGBA,
+		.colorspace = VIDEO_CS_SRGB,
+		.range = VIDEO_RANGE_FULL,
+		.scale_type = OBS_SCALE_BILINEAR,
+	};
+	obs_module_t *module;
+	Display *display;
+	int delay_ms;
+	int ret = 1;
+
+	if (argc < 3) {
+		fprintf(stderr, "Usage: %s <path to obs-filters module> <module data directory> [delay ms]\n",
+			argv[0]);
+		return 1;
+	}
+
+	delay_ms = argc > 3 ? atoi(argv[3]) : 2000;
+	if (delay_ms < 100)
+		delay_ms = 100;
+
+	display = XOpenDisplay(NULL);
+	if (!display) {
+		fprintf(stderr, "Couldn't open X display\n");
+		return 1;
+	}
+
+	obs_set_nix_platform(OBS_NIX_PLATFORM_X11_EGL);
+	obs_set_nix_platform_display(display);
+
+	if (!obs_startup("en-US", NULL, NULL)) {
+		fprintf(stderr, "Couldn't start OBS\n");
+		goto fail;
+	}
+
+	if (obs_reset_video(&ovi) != OBS_VIDEO_SUCCESS) {
+		fprintf(stderr, "Couldn't initialize video\n");
+		goto fail;
+	}
+
+	if (obs_open_module(&module, argv[1], argv[2]) != MODULE_SUCCESS || !obs_init_module(module)) {
+		fprintf(stderr, "Couldn't load %s\n", argv[1]);
+		goto fail;
+	}
+
+	obs_register_source(&white_source);
+
+	printf("%d ms delay of %dx%d at %d FPS\n", delay_ms, WIDTH, HEIGHT, FPS);
+	for (size_t i = 0; i < sizeof(modes) / sizeof(modes[0]); i++)
+		run_benchmark(&modes[i], delay_ms);
+	ret = 0;
+
+fail:
+	obs_shutdown();
+	XCloseDisplay(display);
+	return ret;
+}
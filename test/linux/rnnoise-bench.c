@@ -0,0 +1,110 @@
+/*
+ * Measures how long the bundled RNNoise takes to denoise a few seconds of
+ * multi-channel audio, once one channel at a time with
+ * rnnoise_process_frame and once with all channels batched through
+ * rnnoise_process_frames, and checks that both give identical output.
+ *
+ *   ./rnnoise-bench [channels] [seconds]
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <rnnoise.h>
+#include <util/platform.h>
+
+#define FRAME_SIZE 480
+#define SAMPLE_RATE 48000
+#define MAX_CHANNELS 8
+
+static float *generate_audio(int channels, int frames)
+{
+	float *audio = malloc(sizeof(float) * FRAME_SIZE * frames * channels);
+	uint32_t seed = 1234;
+
+	for (int c = 0; c < channels; c++) {
+		float *data = audio + (size_t)c * FRAME_SIZE * frames;
+
+		for (int i = 0; i < FRAME_SIZE * frames; i++) {
+			double t = (double)i / SAMPLE_RATE;
+
+			seed = seed * 1664525u + 1013904223u;
+			float noise = (float)((int32_t)(seed >> 16) - 32768) / 32768.0f;
+			float tone = (float)sin(2.0 * M_PI * (220.0 + 110.0 * c) * t);
+
+			data[i] = (tone * 0.4f + noise * 0.1f) * 32767.0f;
+		}
+	}
+
+	return audio;
+}
+
+static uint64_t run(float *audio, int channels, int frames, bool batched)
+{
+	DenoiseState *states[MAX_CHANNELS];
+	float *buffers[MAX_CHANNELS];
+	uint64_t start_ns;
+
+	for (int c = 0; c < channels; c++)
+		states[c] = rnnoise_create(NULL);
+
+	start_ns = os_gettime_ns();
+
+	for (int f = 0; f < frames; f++) {
+		for (int c = 0; c < channels; c++)
+			buffers[c] = audio + ((size_t)c * frames + f) * FRAME_SIZE;
+
+		if (batched) {
+			rnnoise_process_frames(states, buffers, (const float **)buffers, NULL, channels);
+		} else {
+			for (int c = 0; c < channels; c++)
+				rnnoise_process_frame(states[c], buffers[c], buffers[c]);
+		}
+	}
+
+	uint64_t elapsed_ns = os_gettime_ns() - start_ns;
+
+	for (int c = 0; c < channels; c++)
+		rnnoise_destroy(states[c]);
+
+	return elapsed_ns;
+}
+
+int main(int argc, char *argv[])
+{
+	int channels = argc > 1 ? atoi(argv[1]) : 2;
+	int seconds = argc > 2 ? atoi(argv[2]) : 10;
+
+	if (channels < 1)
+		channels = 1;
+	if (channels > MAX_CHANNELS)
+		channels = MAX_CHANNELS;
+	if (seconds < 1)
+		seconds = 1;
+
+	int frames = seconds * SAMPLE_RATE / FRAME_SIZE;
+	size_t size = sizeof(float) * FRAME_SIZE * frames * channels;
+	float *single = generate_audio(channels, frames);
+	float *batched = malloc(size);
+
+	memcpy(batched, single, size);
+
+	/* warm up */
+	run(single, channels, frames / 10, false);
+	memcpy(single, batched, size);
+
+	uint64_t single_ns = run(single, channels, frames, false);
+	uint64_t batched_ns = run(batched, channels, frames, true);
+
+	printf("%d channels, %d s of audio\n", channels, seconds);
+	printf("  one channel at a time: %.3f ms/frame\n", (double)single_ns / 1000000.0 / frames);
+	printf("  batched:               %.3f ms/frame\n", (double)batched_ns / 1000000.0 / frames);
+	printf("  output:                %s\n", memcmp(single, batched, size) == 0 ? "identical" : "DIFFERENT");
+
+	int ret = memcmp(single, batched, size) == 0 ? 0 : 1;
+	free(single);
+	free(batched);
+	return ret;
+}
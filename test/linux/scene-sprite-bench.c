@@ -0,0 +1,268 @@
+/*
+ * Measures how long it takes to render a scene of 500 small sprites, once
+ * with a source that can be drawn in a batch and once with an otherwise
+ * identical source that can't.
+ *
+ * Needs the libobs data files, and runs on any X server, including a virtual
+ * one with software rendering:
+ *
+ *   LIBGL_ALWAYS_SOFTWARE=1 xvfb-run ./scene-sprite-bench [frames]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <X11/Xlib.h>
+
+#include <obs.h>
+#include <obs-nix-platform.h>
+#include <util/bmem.h>
+#include <util/platform.h>
+
+#define WIDTH 1920
+#define HEIGHT 1080
+#define NUM_SPRITES 500
+#define NUM_IMAGES 4
+#define SPRITE_SIZE 32
+#define WARMUP_FRAMES 10
+
+struct sprite_source {
+	gs_texture_t *texture;
+};
+
+static const char *sprite_source_get_name(void *type_data)
+{
+	return type_data;
+}
+
+static void *sprite_source_create(obs_data_t *settings, obs_source_t *source)
+{
+	struct sprite_source *context = bzalloc(sizeof(struct sprite_source));
+	uint32_t pixels[SPRITE_SIZE * SPRITE_SIZE];
+	const uint8_t *data = (const uint8_t *)pixels;
+	uint32_t color = (uint32_t)obs_data_get_int(settings, "color");
+
+	for (size_t i = 0; i < SPRITE_SIZE * SPRITE_SIZE; i++)
+		pixels[i] = color;
+
+	obs_enter_graphics();
+	context->texture = gs_texture_create(SPRITE_SIZE, SPRITE_SIZE, GS_RGBA, 1, &data, 0);
+	obs_leave_graphics();
+
+	UNUSED_PARAMETER(source);
+	return context;
+}
+
+static void sprite_source_destroy(void *data)
+{
+	struct sprite_source *context = data;
+
+	obs_enter_graphics();
+	gs_texture_destroy(context->texture);
+	obs_leave_graphics();
+
+	bfree(context);
+}
+
+static uint32_t sprite_source_get_size(void *data)
+{
+	UNUSED_PARAMETER(data);
+	return SPRITE_SIZE;
+}
+
+/* draws the same way as the image source */
+static void sprite_source_render(void *data, gs_effect_t *effect)
+{
+	struct sprite_source *context = data;
+
+	const bool previous = gs_framebuffer_srgb_enabled();
+	gs_enable_framebuffer_srgb(true);
+
+	gs_blend_state_push();
+	gs_blend_function(GS_BLEND_ONE, GS_BLEND_INVSRCALPHA);
+
+	gs_effect_set_texture_srgb(gs_effect_get_param_by_name(effect, "image"), context->texture);
+	gs_draw_sprite(context->texture, 0, SPRITE_SIZE, SPRITE_SIZE);
+
+	gs_blend_state_pop();
+
+	gs_enable_framebuffer_srgb(previous);
+}
+
+static gs_texture_t *sprite_source_get_texture(void *data)
+{
+	struct sprite_source *context = data;
+	return context->texture;
+}
+
+static void register_sprite_source(const char *id, bool batched)
+{
+	struct obs_source_info info = {
+		.id = id,
+		.type = OBS_SOURCE_TYPE_INPUT,
+		.output_flags = OBS_SOURCE_VIDEO | OBS_SOURCE_SRGB,
+		.get_name = sprite_source_get_name,
+		.create = sprite_source_create,
+		.destroy = sprite_source_destroy,
+		.get_width = sprite_source_get_size,
+		.get_height = sprite_source_get_size,
+		.video_render = sprite_source_render,
+		.video_get_texture = batched ? sprite_source_get_texture : NULL,
+		.type_data = (void *)id,
+	};
+
+	obs_register_source(&info);
+}
+
+static obs_scene_t *create_sprite_scene(const char *id)
+{
+	obs_scene_t *scene = obs_scene_create_private(id);
+	obs_source_t *images[NUM_IMAGES];
+
+	for (size_t i = 0; i < NUM_IMAGES; i++) {
+		obs_data_t *settings = obs_data_create();
+		obs_data_set_int(settings, "color", 0xFF000000 | (0x3F << (i * 8)));
+		images[i] = obs_source_create_private(id, "sprite", settings);
+		obs_data_release(settings);
+	}
+
+	/* neighbouring items mostly share an image, like repeated logos or
+	 * icons tend to */
+	for (int i = 0; i < NUM_SPRITES; i++) {
+		obs_sceneitem_t *item = obs_scene_add(scene, images[(i / 10) % NUM_IMAGES]);
+		struct vec2 pos;
+
+		vec2_set(&pos, (float)((i * 37) % (WIDTH - SPRITE_SIZE)), (float)((i * 53) % (HEIGHT - SPRITE_SIZE)));
+		obs_sceneitem_set_pos(item, &pos);
+		obs_sceneitem_set_rot(item, (float)(i % 8) * 5.0f);
+	}
+
+	for (size_t i = 0; i < NUM_IMAGES; i++)
+		obs_source_release(images[i]);
+
+	return scene;
+}
+
+static void render_scene(obs_source_t *source, gs_texrender_t *texrender)
+{
+	gs_texrender_reset(texrender);
+	if (gs_texrender_begin(texrender, WIDTH, HEIGHT)) {
+		struct vec4 clear_color;
+
+		vec4_zero(&clear_color);
+		gs_clear(GS_CLEAR_COLOR, &clear_color, 0.0f, 0);
+		gs_ortho(0.0f, (float)WIDTH, 0.0f, (float)HEIGHT, -100.0f, 100.0f);
+
+		obs_source_video_render(source);
+		gs_texrender_end(texrender);
+	}
+}
+
+/* staging the texture waits for all rendering to complete */
+static void wait_for_gpu(gs_stagesurf_t *stagesurf, gs_texrender_t *texrender)
+{
+	uint8_t *data;
+	uint32_t linesize;
+
+	gs_stage_texture(stagesurf, gs_texrender_get_texture(texrender));
+	if (gs_stagesurface_map(stagesurf, &data, &linesize))
+		gs_stagesurface_unmap(stagesurf);
+}
+
+static void run_benchmark(const char *id, int frames)
+{
+	obs_scene_t *scene = create_sprite_scene(id);
+	obs_source_t *source = obs_scene_get_source(scene);
+	uint64_t submit_ns = 0;
+	uint64_t start_ns;
+	uint64_t total_ns;
+
+	obs_enter_graphics();
+
+	gs_texrender_t *texrender = gs_texrender_create(GS_RGBA, GS_ZS_NONE);
+	gs_stagesurf_t *stagesurf = gs_stagesurface_create(WIDTH, HEIGHT, GS_RGBA);
+
+	gs_begin_scene();
+
+	for (int i = 0; i < WARMUP_FRAMES; i++)
+		render_scene(source, texrender);
+	wait_for_gpu(stagesurf, texrender);
+
+	start_ns = os_gettime_ns();
+
+	for (int i = 0; i < frames; i++) {
+		uint64_t frame_start_ns = os_gettime_ns();
+		render_scene(source, texrender);
+		gs_flush();
+		submit_ns += os_gettime_ns() - frame_start_ns;
+	}
+
+	wait_for_gpu(stagesurf, texrender);
+	total_ns = os_gettime_ns() - start_ns;
+
+	gs_end_scene();
+
+	printf("%s: %d frames of %d sprites\n", id, frames, NUM_SPRITES);
+	printf("  submit: %.3f ms/frame\n", (double)submit_ns / 1000000.0 / frames);
+	printf("  total:  %.3f ms/frame\n", (double)total_ns / 1000000.0 / frames);
+
+	gs_stagesurface_destroy(stagesurf);
+	gs_texrender_destroy(texrender);
+
+	obs_leave_graphics();
+
+	obs_scene_release(scene);
+}
+
+int main(int argc, char *argv[])
+{
+	int frames = argc > 1 ? atoi(argv[1]) : 300;
+	struct obs_video_info ovi = {
+		.graphics_module = "libobs-opengl",
+		.fps_num = 60,
+		.fps_den = 1,
+		.base_width = WIDTH,
+		.base_height = HEIGHT,
+		.output_width = WIDTH,
+		.output_height = HEIGHT,
+		.output_format = VIDEO_FORMAT_RGBA,
+		.colorspace = VIDEO_CS_SRGB,
+		.range = VIDEO_RANGE_FULL,
+		.scale_type = OBS_SCALE_BILINEAR,
+	};
+	Display *display;
+	int ret = 1;
+
+	display = XOpenDisplay(NULL);
+	if (!display) {
+		fprintf(stderr, "Couldn't open X display\n");
+		return 1;
+	}
+
+	obs_set_nix_platform(OBS_NIX_PLATFORM_X11_EGL);
+	obs_set_nix_platform_display(display);
+
+	if (!obs_startup("en-US", NULL, NULL)) {
+		fprintf(stderr, "Couldn't start OBS\n");
+		goto fail;
+	}
+
+	if (obs_reset_video(&ovi) != OBS_VIDEO_SUCCESS) {
+		fprintf(stderr, "Couldn't initialize video\n");
+		goto fail;
+	}
+
+	register_sprite_source("unbatched_sprite", false);
+	register_sprite_source("batched_sprite", true);
+
+	if (frames < 1)
+		frames = 1;
+	run_benchmark("unbatched_sprite", frames);
+	run_benchmark("batched_sprite", frames);
+	ret = 0;
+
+fail:
+	obs_shutdown();
+	XCloseDisplay(display);
+	return ret;
+}
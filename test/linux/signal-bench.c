@@ -0,0 +1,203 @@
+/*
+ * Measures how long it takes to emit item_transform for every item of a
+ * 500-item scene being moved, on a signal handler with the same signals as a
+ * scene and one connected callback that reads the parameters.  Compares the
+ * strcmp walk over a list that signal_handler_signal used to do with the
+ * current hashed name lookup and with emitting by signal ID.
+ *
+ *   ./signal-bench [frames]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <callback/calldata.h>
+#include <callback/signal.h>
+#include <util/platform.h>
+#include <util/threading.h>
+
+#define NUM_ITEMS 500
+
+/* the signals of a scene, in the order libobs adds them */
+static const char *scene_signals[] = {
+	"void destroy(ptr source)",
+	"void remove(ptr source)",
+	"void update(ptr source)",
+	"void save(ptr source)",
+	"void load(ptr source)",
+	"void activate(ptr source)",
+	"void deactivate(ptr source)",
+	"void show(ptr source)",
+	"void hide(ptr source)",
+	"void mute(ptr source, bool muted)",
+	"void push_to_mute_changed(ptr source, bool enabled)",
+	"void push_to_mute_delay(ptr source, int delay)",
+	"void push_to_talk_changed(ptr source, bool enabled)",
+	"void push_to_talk_delay(ptr source, int delay)",
+	"void enable(ptr source, bool enabled)",
+	"void rename(ptr source, string new_name, string prev_name)",
+	"void volume(ptr source, in out float volume)",
+	"void update_properties(ptr source)",
+	"void update_flags(ptr source, int flags)",
+	"void audio_sync(ptr source, int out int offset)",
+	"void audio_balance(ptr source, in out float balance)",
+	"void audio_mixers(ptr source, in out int mixers)",
+	"void audio_monitoring(ptr source, int type)",
+	"void audio_activate(ptr source)",
+	"void audio_deactivate(ptr source)",
+	"void filter_add(ptr source, ptr filter)",
+	"void filter_remove(ptr source, ptr filter)",
+	"void reorder_filters(ptr source)",
+	"void transition_start(ptr source)",
+	"void transition_video_stop(ptr source)",
+	"void transition_stop(ptr source)",
+	"void media_play(ptr source)",
+	"void media_pause(ptr source)",
+	"void media_restart(ptr source)",
+	"void media_stopped(ptr source)",
+	"void media_next(ptr source)",
+	"void media_previous(ptr source)",
+	"void media_started(ptr source)",
+	"void media_ended(ptr source)",
+	"void item_add(ptr scene, ptr item)",
+	"void item_remove(ptr scene, ptr item)",
+	"void reorder(ptr scene)",
+	"void refresh(ptr scene)",
+	"void item_visible(ptr scene, ptr item, bool visible)",
+	"void item_select(ptr scene, ptr item)",
+	"void item_deselect(ptr scene, ptr item)",
+	"void item_transform(ptr scene, ptr item)",
+	"void item_locked(ptr scene, ptr item, bool locked)",
+	NULL,
+};
+
+#define NUM_SIGNALS (sizeof(scene_signals) / sizeof(scene_signals[0]) - 1)
+
+enum emit_mode {
+	EMIT_LINEAR,
+	EMIT_NAME,
+	EMIT_ID,
+};
+
+/* how signals used to be found: a list walked under the handler's mutex */
+struct linear_signal {
+	char name[64];
+	signal_id_t *id;
+	struct linear_signal *next;
+};
+
+static struct linear_signal linear_signals[NUM_SIGNALS];
+static pthread_mutex_t linear_mutex;
+
+static signal_handler_t *handler;
+static signal_id_t *item_transform_id;
+static int items[NUM_ITEMS];
+static int scene;
+static long long moved;
+
+static void item_transform(void *data, calldata_t *cd)
+{
+	if (calldata_ptr(cd, "scene") == &scene && calldata_ptr(cd, "item"))
+		moved++;
+
+	UNUSED_PARAMETER(data);
+}
+
+static void init_linear_signals(void)
+{
+	pthread_mutex_init(&linear_mutex, NULL);
+
+	for (size_t i = 0; i < NUM_SIGNALS; i++) {
+		struct linear_signal *sig = &linear_signals[i];
+		const char *name = strchr(scene_signals[i], ' ') + 1;
+
+		strncpy(sig->name, name, strcspn(name, "("));
+		sig->id = signal_handler_get_id(handler, sig->name);
+		sig->next = i + 1 < NUM_SIGNALS ? &linear_signals[i + 1] : NULL;
+	}
+}
+
+static void emit_linear(const char *name, calldata_t *params)
+{
+	struct linear_signal *sig;
+
+	pthread_mutex_lock(&linear_mutex);
+	for (sig = linear_signals; sig; sig = sig->next) {
+		if (strcmp(sig->name, name) == 0)
+			break;
+	}
+	pthread_mutex_unlock(&linear_mutex);
+
+	if (sig)
+		signal_handler_signal_id(handler, sig->id, params);
+}
+
+/* emits the signal the way update_item_transform does */
+static void move_item(enum emit_mode mode, int *item)
+{
+	uint8_t stack[128];
+	struct calldata params;
+
+	calldata_init_fixed(&params, stack, sizeof(stack));
+	calldata_set_ptr(&params, "item", item);
+	calldata_set_ptr(&params, "scene", &scene);
+
+	if (mode == EMIT_LINEAR)
+		emit_linear("item_transform", &params);
+	else if (mode == EMIT_NAME)
+		signal_handler_signal(handler, "item_transform", &params);
+	else
+		signal_handler_signal_id(handler, item_transform_id, &params);
+}
+
+static void move_items(enum emit_mode mode, int frames)
+{
+	for (int f = 0; f < frames; f++) {
+		for (int i = 0; i < NUM_ITEMS; i++)
+			move_item(mode, &items[i]);
+	}
+}
+
+static void run_benchmark(const char *name, enum emit_mode mode, int frames)
+{
+	uint64_t start_ns;
+
+	moved = 0;
+	start_ns = os_gettime_ns();
+	move_items(mode, frames);
+
+	uint64_t elapsed_ns = os_gettime_ns() - start_ns;
+	long long emitted = (long long)frames * NUM_ITEMS;
+
+	printf("  %-20s %.1f ns/emission, %.3f ms/frame%s\n", name, (double)elapsed_ns / emitted,
+	       (double)elapsed_ns / 1000000.0 / frames, moved == emitted ? "" : " (callback missed emissions)");
+}
+
+int main(int argc, char *argv[])
+{
+	int frames = argc > 1 ? atoi(argv[1]) : 2000;
+
+	if (frames < 1)
+		frames = 1;
+
+	handler = signal_handler_create();
+	signal_handler_add_array(handler, scene_signals);
+	signal_handler_connect(handler, "item_transform", item_transform, NULL);
+
+	item_transform_id = signal_handler_get_id(handler, "item_transform");
+	init_linear_signals();
+
+	/* warm up */
+	move_items(EMIT_ID, frames / 10 + 1);
+
+	printf("item_transform for %d items over %d frames, %zu signals\n", NUM_ITEMS, frames, NUM_SIGNALS);
+	run_benchmark("linear search (old)", EMIT_LINEAR, frames);
+	run_benchmark("hashed name", EMIT_NAME, frames);
+	run_benchmark("signal ID", EMIT_ID, frames);
+
+	signal_handler_disconnect(handler, "item_transform", item_transform, NULL);
+	signal_handler_destroy(handler);
+	pthread_mutex_destroy(&linear_mutex);
+	return 0;
+}
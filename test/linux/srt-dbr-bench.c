@@ -0,0 +1,348 @@
+/*
+ * Streams over SRT on the loopback interface through a UDP relay that limits
+ * the bandwidth, and drives the dynamic bitrate logic of the mpegts output
+ * (plugins/obs-ffmpeg/obs-ffmpeg-dbr.h) with the sender stats, the same way
+ * the output does. The link starts out fast enough for the stream, drops
+ * below it and then recovers. Fails if the bitrate doesn't follow the drop or
+ * doesn't get back to the original bitrate afterwards.
+ *
+ *   ./srt-dbr-bench [bitrate kbps] [link kbps] [dropped link kbps]
+ */
+
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <srt/srt.h>
+
+#include <util/c99defs.h>
+#include <util/platform.h>
+#include <util/threading.h>
+
+#include <obs-ffmpeg-dbr.h>
+
+#define AUDIO_BITRATE 160
+#define PACKET_SIZE 1316
+#define SEND_INTERVAL_MS 10
+#define CHECK_INTERVAL_MS 100
+
+/* the relay is a bottleneck with a drop-tail queue of this length */
+#define MAX_QUEUE_MS 100
+#define MAX_QUEUED_PACKETS 4096
+
+/* how long the link stays at each rate, and how long the bitrate may take to
+ * drop below the link rate once it dropped. When the send rate is no use as an
+ * estimate, the bitrate only goes down by 10% every second. */
+#define BEFORE_DROP_SEC 5
+#define DROP_SEC 15
+#define AFTER_DROP_SEC 40
+#define MAX_REACTION_SEC 8
+
+struct relay_packet {
+	uint64_t departure_ns;
+	int size;
+	uint8_t data[1500];
+};
+
+struct relay {
+	int front;
+	int back;
+	struct sockaddr_in sender;
+	bool have_sender;
+
+	volatile long link_kbps;
+	volatile bool stop;
+	pthread_t thread;
+
+	struct relay_packet *queue;
+	size_t head;
+	size_t num;
+	uint64_t link_free_ns;
+	uint64_t dropped;
+};
+
+/* packets from the sender go through a queue that drains at the link rate,
+ * anything from the receiver (ACKs, NAKs) goes back right away */
+static void relay_from_sender(struct relay *relay, const uint8_t *data, int size)
+{
+	uint64_t now = os_gettime_ns();
+	uint64_t tx_ns = (uint64_t)size * 8ULL * 1000000ULL / (uint64_t)os_atomic_load_long(&relay->link_kbps);
+	uint64_t start = relay->link_free_ns > now ? relay->link_free_ns : now;
+
+	if (start - now > MAX_QUEUE_MS * 1000000ULL || relay->num == MAX_QUEUED_PACKETS) {
+		relay->dropped++;
+		return;
+	}
+
+	struct relay_packet *packet = &relay->queue[(relay->head + relay->num++) % MAX_QUEUED_PACKETS];
+	packet->departure_ns = start + tx_ns;
+	packet->size = size;
+	memcpy(packet->data, data, size);
+
+	relay->link_free_ns = packet->departure_ns;
+}
+
+static void relay_drain(struct relay *relay)
+{
+	uint64_t now = os_gettime_ns();
+
+	while (relay->num) {
+		struct relay_packet *packet = &relay->queue[relay->head];
+		if (packet->departure_ns > now)
+			break;
+
+		send(relay->back, packet->data, packet->size, 0);
+		relay->head = (relay->head + 1) % MAX_QUEUED_PACKETS;
+		relay->num--;
+	}
+}
+
+static void *relay_thread(void *data)
+{
+	struct relay *relay = data;
+	struct pollfd fds[2] = {{relay->front, POLLIN, 0}, {relay->back, POLLIN, 0}};
+	uint8_t buf[1500];
+
+	while (!os_atomic_load_bool(&relay->stop)) {
+		if (poll(fds, 2, 1) < 0 && errno != EINTR)
+			break;
+
+		if (fds[0].revents & POLLIN) {
+			socklen_t len = sizeof(relay->sender);
+			int size = (int)recvfrom(relay->front, buf, sizeof(buf), 0, (struct sockaddr *)&relay->sender,
+						 &len);
+			if (size > 0) {
+				relay->have_sender = true;
+				relay_from_sender(relay, buf, size);
+			}
+		}
+
+		if (fds[1].revents & POLLIN) {
+			int size = (int)recv(relay->back, buf, sizeof(buf), 0);
+			if (size > 0 && relay->have_sender)
+				sendto(relay->front, buf, size, 0, (struct sockaddr *)&relay->sender,
+				       sizeof(relay->sender));
+		}
+
+		relay_drain(relay);
+	}
+
+	return NULL;
+}
+
+static bool relay_start(struct relay *relay, const struct sockaddr_in *receiver, struct sockaddr_in *front_addr,
+			long link_kbps)
+{
+	socklen_t len = sizeof(*front_addr);
+
+	memset(relay, 0, sizeof(*relay));
+	relay->link_kbps = link_kbps;
+	relay->queue = calloc(MAX_QUEUED_PACKETS, sizeof(struct relay_packet));
+
+	memset(front_addr, 0, sizeof(*front_addr));
+	front_addr->sin_family = AF_INET;
+	front_addr->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	relay->front = socket(AF_INET, SOCK_DGRAM, 0);
+	relay->back = socket(AF_INET, SOCK_DGRAM, 0);
+	if (relay->front < 0 || relay->back < 0)
+		return false;
+	if (bind(relay->front, (struct sockaddr *)front_addr, sizeof(*front_addr)) != 0)
+		return false;
+	if (getsockname(relay->front, (struct sockaddr *)front_addr, &len) != 0)
+		return false;
+	if (connect(relay->back, (const struct sockaddr *)receiver, sizeof(*receiver)) != 0)
+		return false;
+
+	return pthread_create(&relay->thread, NULL, relay_thread, relay) == 0;
+}
+
+static void relay_stop(struct relay *relay)
+{
+	os_atomic_set_bool(&relay->stop, true);
+	pthread_join(relay->thread, NULL);
+	close(relay->front);
+	close(relay->back);
+	free(relay->queue);
+}
+
+struct receiver {
+	SRTSOCKET listener;
+	SRTSOCKET sock;
+	pthread_t thread;
+	volatile long bytes;
+};
+
+static void *receiver_thread(void *data)
+{
+	struct receiver *receiver = data;
+	char buf[1500];
+	int size;
+
+	receiver->sock = srt_accept(receiver->listener, NULL, NULL);
+	if (receiver->sock == SRT_INVALID_SOCK)
+		return NULL;
+
+	while ((size = srt_recvmsg(receiver->sock, buf, sizeof(buf))) > 0)
+		os_atomic_set_long(&receiver->bytes, os_atomic_load_long(&receiver->bytes) + size);
+
+	return NULL;
+}
+
+static bool receiver_start(struct receiver *receiver, struct sockaddr_in *addr)
+{
+	int len = sizeof(*addr);
+
+	memset(receiver, 0, sizeof(*receiver));
+	receiver->sock = SRT_INVALID_SOCK;
+
+	memset(addr, 0, sizeof(*addr));
+	addr->sin_family = AF_INET;
+	addr->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	receiver->listener = srt_create_socket();
+	if (receiver->listener == SRT_INVALID_SOCK)
+		return false;
+	if (srt_bind(receiver->listener, (struct sockaddr *)addr, sizeof(*addr)) == SRT_ERROR)
+		return false;
+	if (srt_getsockname(receiver->listener, (struct sockaddr *)addr, &len) == SRT_ERROR)
+		return false;
+	if (srt_listen(receiver->listener, 1) == SRT_ERROR)
+		return false;
+
+	return pthread_create(&receiver->thread, NULL, receiver_thread, receiver) == 0;
+}
+
+static void receiver_stop(struct receiver *receiver)
+{
+	srt_close(receiver->listener);
+	if (receiver->sock != SRT_INVALID_SOCK)
+		srt_close(receiver->sock);
+	pthread_join(receiver->thread, NULL);
+}
+
+static long link_rate_at(int sec, long link_kbps, long drop_kbps)
+{
+	return sec >= BEFORE_DROP_SEC && sec < BEFORE_DROP_SEC + DROP_SEC ? drop_kbps : link_kbps;
+}
+
+int main(int argc, char *argv[])
+{
+	long bitrate = argc > 1 ? atol(argv[1]) : 4000;
+	long link_kbps = argc > 2 ? atol(argv[2]) : 8000;
+	long drop_kbps = argc > 3 ? atol(argv[3]) : 2000;
+	int total_sec = BEFORE_DROP_SEC + DROP_SEC + AFTER_DROP_SEC;
+	struct sockaddr_in receiver_addr;
+	struct sockaddr_in relay_addr;
+	struct receiver receiver;
+	struct relay relay;
+	struct dbr_state dbr;
+	char packet[PACKET_SIZE] = {0};
+	int ret = 0;
+
+	if (drop_kbps >= bitrate + AUDIO_BITRATE || link_kbps < bitrate + AUDIO_BITRATE) {
+		fprintf(stderr, "the link has to carry the stream, and the dropped link must not\n");
+		return 1;
+	}
+
+	srt_startup();
+
+	if (!receiver_start(&receiver, &receiver_addr) ||
+	    !relay_start(&relay, &receiver_addr, &relay_addr, link_kbps)) {
+		fprintf(stderr, "failed to set up the loopback link: %s\n", srt_getlasterror_str());
+		return 1;
+	}
+
+	SRTSOCKET sender = srt_create_socket();
+	if (srt_connect(sender, (struct sockaddr *)&relay_addr, sizeof(relay_addr)) == SRT_ERROR) {
+		fprintf(stderr, "failed to connect: %s\n", srt_getlasterror_str());
+		return 1;
+	}
+
+	dbr_state_init(&dbr, bitrate, AUDIO_BITRATE);
+
+	printf("%d s at %ld kbps, %d s at %ld kbps, %d s at %ld kbps, starting at %ld + %d kbps\n", BEFORE_DROP_SEC,
+	       link_kbps, DROP_SEC, drop_kbps, AFTER_DROP_SEC, link_kbps, bitrate, AUDIO_BITRATE);
+	printf("   t  link  bitrate  snd buf ms  rtt ms  congestion  received kbps\n");
+
+	uint64_t start_ns = os_gettime_ns();
+	uint64_t next_send_ns = start_ns;
+	uint64_t next_check_ns = start_ns;
+	double send_budget = 0.0;
+	float congestion = 0.0f;
+	int reaction_sec = -1;
+	int last_sec = -1;
+	long last_received = 0;
+	SRT_TRACEBSTATS perf = {0};
+
+	for (;;) {
+		uint64_t t = os_gettime_ns();
+		int sec = (int)((t - start_ns) / DBR_SEC_TO_NSEC);
+
+		if (sec >= total_sec)
+			break;
+
+		os_atomic_set_long(&relay.link_kbps, link_rate_at(sec, link_kbps, drop_kbps));
+
+		/* the "encoder": constant bitrate at whatever dbr decided */
+		send_budget += (double)(dbr.cur_bitrate + AUDIO_BITRATE) * 1000.0 / 8.0 * SEND_INTERVAL_MS / 1000.0;
+		while (send_budget >= PACKET_SIZE) {
+			srt_sendmsg2(sender, packet, PACKET_SIZE, NULL);
+			send_budget -= PACKET_SIZE;
+		}
+
+		if (t >= next_check_ns) {
+			next_check_ns += CHECK_INTERVAL_MS * 1000000ULL;
+
+			if (srt_bstats(sender, &perf, 0) != SRT_ERROR) {
+				congestion = dbr_srt_congestion(perf.msSndBuf, perf.msRTT);
+				dbr_update(&dbr, congestion, (long)(perf.mbpsSendRate * 1000.0), t);
+			}
+
+			if (reaction_sec < 0 && sec >= BEFORE_DROP_SEC &&
+			    dbr.cur_bitrate + AUDIO_BITRATE <= drop_kbps)
+				reaction_sec = sec - BEFORE_DROP_SEC;
+		}
+
+		if (sec != last_sec) {
+			long received = os_atomic_load_long(&receiver.bytes);
+			long received_kbps = (received - last_received) * 8 / 1000;
+			long link = link_rate_at(sec, link_kbps, drop_kbps);
+
+			printf("%4d  %4ld  %7ld  %10d  %6.1f  %10.2f  %13ld\n", sec, link, dbr.cur_bitrate,
+			       perf.msSndBuf, perf.msRTT, congestion, received_kbps);
+			last_received = received;
+			last_sec = sec;
+		}
+
+		next_send_ns += SEND_INTERVAL_MS * 1000000ULL;
+		os_sleepto_ns(next_send_ns);
+	}
+
+	srt_close(sender);
+	relay_stop(&relay);
+	receiver_stop(&receiver);
+	srt_cleanup();
+
+	printf("packets dropped by the link: %llu\n", (unsigned long long)relay.dropped);
+
+	if (reaction_sec < 0 || reaction_sec > MAX_REACTION_SEC) {
+		printf("FAILED: the bitrate did not drop below the link rate within %d s\n", MAX_REACTION_SEC);
+		ret = 1;
+	} else {
+		printf("bitrate dropped below the link rate after %d s\n", reaction_sec);
+	}
+
+	if (dbr.cur_bitrate != dbr.orig_bitrate) {
+		printf("FAILED: the bitrate did not recover, it is %ld kbps\n", dbr.cur_bitrate);
+		ret = 1;
+	}
+
+	return ret;
+}
@@ -0,0 +1,204 @@
+/*
+ * Creates a number of lower-third style text sources in the same font with
+ * the text-freetype2 module and reports how much memory and time they take.
+ * Then switches them all to a large font size with different text each, so
+ * that the shared glyph atlas fills up and has to start over while the
+ * sources are shown.
+ *
+ * Memory is the resident size of the process, which also covers textures
+ * when rendering in software.  Runs on any X server, including a virtual one:
+ *
+ *   LIBGL_ALWAYS_SOFTWARE=1 xvfb-run ./text-atlas-bench \
+ *           <path to text-freetype2.so> <text-freetype2 data directory> [sources]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <X11/Xlib.h>
+
+#include <obs.h>
+#include <obs-nix-platform.h>
+#include <util/dstr.h>
+#include <util/platform.h>
+
+#define WIDTH 1920
+#define HEIGHT 1080
+#define FPS 60
+#define MAX_SOURCES 1000
+
+#define SMALL_SIZE 48
+#define LARGE_SIZE 400
+#define LARGE_TEXT_LEN 16
+
+/* what every source used to allocate for itself, not counting the texture */
+#define ATLAS_SIZE (2048 * 2048)
+
+static obs_source_t *sources[MAX_SOURCES];
+
+static void set_text(obs_data_t *settings, int size, const char *text)
+{
+	obs_data_t *font = obs_data_create();
+
+	obs_data_set_string(font, "face", "Sans Serif");
+	obs_data_set_string(font, "style", "Regular");
+	obs_data_set_int(font, "size", size);
+	obs_data_set_int(font, "flags", 0);
+
+	obs_data_set_obj(settings, "font", font);
+	obs_data_set_string(settings, "text", text);
+	obs_data_release(font);
+}
+
+static double resident_mb(void)
+{
+	return (double)os_get_proc_resident_size() / (1024.0 * 1024.0);
+}
+
+/* each source gets its own run of printable ASCII characters, so that
+ * together they need more glyphs than fit in one atlas at this size */
+static void large_text(struct dstr *text, int source)
+{
+	dstr_free(text);
+
+	for (int i = 0; i < LARGE_TEXT_LEN; i++) {
+		int c = 0x21 + (source * 7 + i) % (0x7f - 0x21);
+		dstr_cat_ch(text, (char)c);
+	}
+}
+
+static void run_benchmark(int num_sources)
+{
+	obs_scene_t *scene = obs_scene_create_private("text");
+	struct dstr text = {0};
+	uint64_t start_ns;
+	double start_mb;
+
+	obs_set_output_source(0, obs_scene_get_source(scene));
+
+	start_mb = resident_mb();
+	start_ns = os_gettime_ns();
+
+	for (int i = 0; i < num_sources; i++) {
+		obs_data_t *settings = obs_data_create();
+
+		dstr_printf(&text, "Speaker %d - Lower third title", i + 1);
+		set_text(settings, SMALL_SIZE, text.array);
+
+		dstr_printf(&text, "lower third %d", i + 1);
+		sources[i] = obs_source_create_private("text_ft2_source_v2", text.array, settings);
+		obs_scene_add(scene, sources[i]);
+
+		obs_data_release(settings);
+	}
+
+	uint64_t create_ns = os_gettime_ns() - start_ns;
+
+	os_sleep_ms(500);
+
+	double created_mb = resident_mb();
+
+	printf("%d text sources at %d px\n", num_sources, SMALL_SIZE);
+	printf("  create:             %.3f ms/source\n", (double)create_ns / 1000000.0 / num_sources);
+	printf("  resident memory:    %.1f MB, %.1f KB/source\n", created_mb - start_mb,
+	       (created_mb - start_mb) * 1024.0 / num_sources);
+	printf("  unshared atlases:   %.1f MB of glyph buffers alone\n",
+	       (double)ATLAS_SIZE * num_sources / (1024.0 * 1024.0));
+
+	uint32_t lagged_frames = obs_get_lagged_frames();
+
+	start_ns = os_gettime_ns();
+
+	for (int i = 0; i < num_sources; i++) {
+		obs_data_t *settings = obs_data_create();
+
+		large_text(&text, i);
+		set_text(settings, LARGE_SIZE, text.array);
+		obs_source_update(sources[i], settings);
+
+		obs_data_release(settings);
+	}
+
+	uint64_t update_ns = os_gettime_ns() - start_ns;
+
+	/* let the sources catch up with the atlas resets */
+	os_sleep_ms(1000);
+
+	printf("%d text sources at %d px, %d different glyphs each\n", num_sources, LARGE_SIZE, LARGE_TEXT_LEN);
+	printf("  update:             %.3f ms/source\n", (double)update_ns / 1000000.0 / num_sources);
+	printf("  resident memory:    %.1f MB\n", resident_mb() - start_mb);
+	printf("  frame time:         %.3f ms, %u lagged frames\n",
+	       (double)obs_get_average_frame_time_ns() / 1000000.0, obs_get_lagged_frames() - lagged_frames);
+
+	obs_set_output_source(0, NULL);
+
+	for (int i = 0; i < num_sources; i++)
+		obs_source_release(sources[i]);
+	obs_scene_release(scene);
+	dstr_free(&text);
+}
+
+int main(int argc, char *argv[])
+{
+	struct obs_video_info ovi = {
+		.graphics_module = "libobs-opengl",
+		.fps_num = FPS,
+		.fps_den = 1,
+		.base_width = WIDTH,
+		.base_height = HEIGHT,
+		.output_width = WIDTH,
+		.output_height = HEIGHT,
+		.output_format = VIDEO_FORMAT_RGBA,
+		.colorspace = VIDEO_CS_SRGB,
+		.range = VIDEO_RANGE_FULL,
+		.scale_type = OBS_SCALE_BILINEAR,
+	};
+	obs_module_t *module;
+	Display *display;
+	int num_sources;
+	int ret = 1;
+
+	if (argc < 3) {
+		fprintf(stderr, "Usage: %s <path to text-freetype2 module> <module data directory> [sources]\n",
+			argv[0]);
+		return 1;
+	}
+
+	num_sources = argc > 3 ? atoi(argv[3]) : 80;
+	if (num_sources < 1)
+		num_sources = 1;
+	if (num_sources > MAX_SOURCES)
+		num_sources = MAX_SOURCES;
+
+	display = XOpenDisplay(NULL);
+	if (!display) {
+		fprintf(stderr, "Couldn't open X display\n");
+		return 1;
+	}
+
+	obs_set_nix_platform(OBS_NIX_PLATFORM_X11_EGL);
+	obs_set_nix_platform_display(display);
+
+	if (!obs_startup("en-US", NULL, NULL)) {
+		fprintf(stderr, "Couldn't start OBS\n");
+		goto fail;
+	}
+
+	if (obs_reset_video(&ovi) != OBS_VIDEO_SUCCESS) {
+		fprintf(stderr, "Couldn't initialize video\n");
+		goto fail;
+	}
+
+	if (obs_open_module(&module, argv[1], argv[2]) != MODULE_SUCCESS || !obs_init_module(module)) {
+		fprintf(stderr, "Couldn't load %s\n", argv[1]);
+		goto fail;
+	}
+
+	run_benchmark(num_sources);
+	ret = 0;
+
+fail:
+	obs_shutdown();
+	XCloseDisplay(display);
+	return ret;
+}
@@ -0,0 +1,116 @@
+/*
+ * Measures how long it takes to upload async source frames through dynamic
+ * textures, the way obs_source_update_async_video does.
+ *
+ * Runs on any X server, including a virtual one with software rendering:
+ *
+ *   LIBGL_ALWAYS_SOFTWARE=1 xvfb-run ./texture-upload-bench [ticks]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <X11/Xlib.h>
+
+#include <obs.h>
+#include <obs-nix-platform.h>
+#include <util/base.h>
+#include <util/bmem.h>
+#include <util/platform.h>
+
+#define NUM_TEXTURES 4
+#define WIDTH 1920
+#define HEIGHT 1080
+#define WARMUP_TICKS 10
+
+static void upload_frames(gs_texture_t **textures, const uint8_t *frame, uint32_t linesize)
+{
+	for (size_t i = 0; i < NUM_TEXTURES; i++)
+		gs_texture_set_image(textures[i], frame, linesize, false);
+	gs_flush();
+}
+
+/* staging a texture waits for every upload before it to complete */
+static void wait_for_gpu(gs_stagesurf_t *stagesurf, gs_texture_t *texture)
+{
+	uint8_t *data;
+	uint32_t linesize;
+
+	gs_stage_texture(stagesurf, texture);
+	if (gs_stagesurface_map(stagesurf, &data, &linesize))
+		gs_stagesurface_unmap(stagesurf);
+}
+
+static void run_benchmark(int ticks)
+{
+	gs_texture_t *textures[NUM_TEXTURES];
+	gs_stagesurf_t *stagesurf;
+	uint32_t linesize = WIDTH * 4;
+	uint8_t *frame = bmalloc(linesize * HEIGHT);
+	uint64_t submit_ns = 0;
+	uint64_t start_ns;
+	uint64_t total_ns;
+
+	for (size_t i = 0; i < linesize * HEIGHT; i++)
+		frame[i] = (uint8_t)(i * 7);
+
+	for (size_t i = 0; i < NUM_TEXTURES; i++)
+		textures[i] = gs_texture_create(WIDTH, HEIGHT, GS_BGRA, 1, NULL, GS_DYNAMIC);
+	stagesurf = gs_stagesurface_create(WIDTH, HEIGHT, GS_BGRA);
+
+	for (int i = 0; i < WARMUP_TICKS; i++)
+		upload_frames(textures, frame, linesize);
+	wait_for_gpu(stagesurf, textures[0]);
+
+	start_ns = os_gettime_ns();
+
+	for (int i = 0; i < ticks; i++) {
+		uint64_t tick_start_ns = os_gettime_ns();
+		upload_frames(textures, frame, linesize);
+		submit_ns += os_gettime_ns() - tick_start_ns;
+	}
+
+	wait_for_gpu(stagesurf, textures[0]);
+	total_ns = os_gettime_ns() - start_ns;
+
+	printf("%d ticks of %d %dx%d frames\n", ticks, NUM_TEXTURES, WIDTH, HEIGHT);
+	printf("  submit: %.2f ms/tick\n", (double)submit_ns / 1000000.0 / ticks);
+	printf("  total:  %.2f ms/tick, %.0f MB/s\n", (double)total_ns / 1000000.0 / ticks,
+	       (double)linesize * HEIGHT * NUM_TEXTURES * ticks / ((double)total_ns / 1000.0));
+
+	gs_stagesurface_destroy(stagesurf);
+	for (size_t i = 0; i < NUM_TEXTURES; i++)
+		gs_texture_destroy(textures[i]);
+	bfree(frame);
+}
+
+int main(int argc, char *argv[])
+{
+	int ticks = argc > 1 ? atoi(argv[1]) : 300;
+	graphics_t *graphics = NULL;
+	Display *display;
+
+	display = XOpenDisplay(NULL);
+	if (!display) {
+		fprintf(stderr, "Couldn't open X display\n");
+		return 1;
+	}
+
+	obs_set_nix_platform(OBS_NIX_PLATFORM_X11_EGL);
+	obs_set_nix_platform_display(display);
+
+	if (gs_create(&graphics, "libobs-opengl", 0) != GS_SUCCESS) {
+		fprintf(stderr, "Couldn't create graphics\n");
+		XCloseDisplay(display);
+		return 1;
+	}
+
+	gs_enter_context(graphics);
+	run_benchmark(ticks > 0 ? ticks : 1);
+	gs_leave_context();
+
+	gs_destroy(graphics);
+	XCloseDisplay(display);
+	return 0;
+}